@@ -0,0 +1,112 @@
+/*
+ * Copyright (C) 2024 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#pragma once
+
+#include <android-base/unique_fd.h>
+#include <input/InputTransport.h>
+#include <utils/Errors.h>
+
+#include <cstdint>
+#include <memory>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+namespace android {
+
+/*
+ * A region of shared memory that carries motion samples from an InputPublisher to an
+ * InputConsumer, next to their input channel.
+ *
+ * High-rate motion streams produce one message per sample. When the channel has a sample ring, the
+ * publisher writes the motion message into a free slot of the ring, and only sends a small
+ * MOTION_SAMPLE message that references the slot over the socket. When that message is received,
+ * the input channel copies the motion message out of the ring, so the consumers see a regular
+ * MOTION message.
+ *
+ * The publisher writes sanitized copies of the messages, the same ones it would have sent over the
+ * socket. The consumer maps the ring read-only, and validates every message that it reads from it.
+ *
+ * A slot is owned by the event that was written into it until the consumer has finished that
+ * event. When the ring is full, the publisher falls back to sending the motion message over the
+ * socket. The publishing side of the ring is not thread-safe.
+ */
+class InputSampleRing {
+public:
+    ~InputSampleRing();
+
+    /* Creates a new, writable sample ring with the given number of slots.
+     * Returns nullptr if the shared memory could not be allocated.
+     */
+    static std::unique_ptr<InputSampleRing> create(const std::string& name, uint32_t capacity);
+
+    /* Maps a sample ring created by another process, read-only.
+     * Returns nullptr if the file descriptor does not refer to a valid sample ring.
+     */
+    static std::unique_ptr<InputSampleRing> map(android::base::unique_fd fd);
+
+    /* Returns a duplicate of the file descriptor of the shared memory. */
+    android::base::unique_fd dupFd() const;
+
+    uint32_t getCapacity() const { return mCapacity; }
+    bool isWritable() const { return mWritable; }
+
+    /* Writes a sanitized copy of the given MOTION message into a free slot.
+     *
+     * On success, returns true and stores in outReference the MOTION_SAMPLE message that has to
+     * be sent to the consumer in place of the original message. Returns false if there is no
+     * free slot; the message should then be sent on its own.
+     */
+    bool writeSample(const InputMessage& msg, InputMessage& outReference);
+
+    /* Releases the slot used by the event with the given sequence number, if any. */
+    void releaseSample(uint32_t seq);
+
+    /* Returns the number of slots that are currently owned by unfinished events. */
+    size_t getUsedSlotCount() const { return mSlotBySeq.size(); }
+
+    /* Reads the motion message that is referenced by the given MOTION_SAMPLE message.
+     *
+     * Return OK on success.
+     * Return BAD_VALUE if the reference or the message that it refers to is invalid.
+     */
+    status_t readSample(const InputMessage& reference, InputMessage& outMsg) const;
+
+private:
+    struct Header;
+    struct Slot;
+
+    InputSampleRing(android::base::unique_fd fd, void* data, size_t size, uint32_t capacity,
+                    bool writable);
+
+    static size_t getSlotsOffset();
+    static size_t getRingSize(uint32_t capacity);
+    Slot& getSlot(uint32_t index) const;
+
+    const android::base::unique_fd mFd;
+    void* const mData;
+    const size_t mSize;
+    const uint32_t mCapacity;
+    const bool mWritable;
+
+    // State of the publishing side.
+    std::vector<uint32_t> mFreeSlots;
+    std::unordered_map<uint32_t /*seq*/, uint32_t /*slot*/> mSlotBySeq;
+    uint32_t mNextGeneration = 1;
+};
+
+} // namespace android
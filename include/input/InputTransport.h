@@ -28,8 +28,11 @@
  * The InputConsumer is used by the application to receive events from the input dispatcher.
  */
 
+#include <deque>
+#include <span>
 #include <string>
 #include <unordered_map>
+#include <vector>
 
 #include <android-base/chrono_utils.h>
 #include <android-base/result.h>
@@ -71,8 +74,9 @@ struct InputMessage {
         DRAG,
         TIMELINE,
         TOUCH_MODE,
+        MOTION_SAMPLE,
 
-        ftl_last = TOUCH_MODE
+        ftl_last = MOTION_SAMPLE
     };
 
     struct Header {
@@ -217,6 +221,14 @@ struct InputMessage {
 
             inline size_t size() const { return sizeof(TouchMode); }
         } touchMode;
+
+        // A motion message that was written to the sample ring of the channel.
+        struct MotionSample {
+            uint32_t slot;
+            uint32_t generation;
+
+            inline size_t size() const { return sizeof(MotionSample); }
+        } motionSample;
     } __attribute__((aligned(8))) body;
 
     bool isValid(size_t actualSize) const;
@@ -233,6 +245,8 @@ struct InputMessage {
  *
  * The input channel is closed when all references to it are released.
  */
+class InputSampleRing;
+
 class InputChannel : private android::os::InputChannelCore {
 public:
     static std::unique_ptr<InputChannel> create(android::os::InputChannelCore&& parceledChannel);
@@ -243,11 +257,16 @@ public:
      * The two returned input channels are equivalent, and are labeled as "server" and "client"
      * for convenience. The two input channels share the same token.
      *
+     * If motionSampleRingCapacity is not 0, the channels also share a sample ring with that many
+     * slots, that the server uses to publish motion events (see InputSampleRing). If the ring
+     * cannot be allocated, the channels are created without it.
+     *
      * Return OK on success.
      */
     static status_t openInputChannelPair(const std::string& name,
                                          std::unique_ptr<InputChannel>& outServerChannel,
-                                         std::unique_ptr<InputChannel>& outClientChannel);
+                                         std::unique_ptr<InputChannel>& outClientChannel,
+                                         uint32_t motionSampleRingCapacity = 0);
 
     inline std::string getName() const { return name; }
     inline int getFd() const { return fd.get(); }
@@ -270,6 +289,9 @@ public:
      * If there is no message present, try again after poll() indicates that the fd
      * is readable.
      *
+     * A MOTION_SAMPLE message is replaced with the MOTION message that it refers to, read from the
+     * sample ring of the channel.
+     *
      * Return OK on success.
      * Return WOULD_BLOCK if there is no message present.
      * Return DEAD_OBJECT if the channel's peer has been closed.
@@ -277,6 +299,39 @@ public:
      */
     status_t receiveMessage(InputMessage* msg);
 
+    /* Send several messages to the other endpoint, in order, with as few system calls as possible.
+     *
+     * The messages are sent one after the other until either all of them have been sent, or one
+     * of them could not be sent. The number of messages that were sent is stored in
+     * outSentCount; the messages that follow were not sent at all. If the channel becomes full,
+     * the first message that did not fit is guaranteed not to have been sent, same as with
+     * sendMessage.
+     *
+     * Return OK if all of the messages were sent.
+     * Return WOULD_BLOCK if the channel is full.
+     * Return DEAD_OBJECT if the channel's peer has been closed.
+     * Other errors probably indicate that the channel is broken.
+     */
+    status_t sendMessages(std::span<const InputMessage> msgs, size_t& outSentCount);
+
+    /* Receive up to msgs.size() messages sent by the other endpoint, with as few system calls
+     * as possible.
+     *
+     * The number of messages that were received is stored in outReceivedCount. An error is
+     * only returned if no message could be received. If the peer was closed or an invalid message
+     * was received after some valid messages, those are returned first and the error is returned
+     * by the next call. The messages that were read from the socket along with an invalid message
+     * and follow it are kept in the channel, and returned by the next calls before any message
+     * that is still in the socket.
+     *
+     * Return OK if at least one message was received.
+     * Return WOULD_BLOCK if there is no message present.
+     * Return DEAD_OBJECT if the channel's peer has been closed.
+     * Return BAD_VALUE if an invalid message was received.
+     * Other errors probably indicate that the channel is broken.
+     */
+    status_t receiveMessages(std::span<InputMessage> msgs, size_t& outReceivedCount);
+
     /* Tells whether there is a message in the channel available to be received.
      *
      * This is only a performance hint and may return false negative results. Clients should not
@@ -284,6 +339,12 @@ public:
      */
     bool probablyHasInput() const;
 
+    /* Tells whether receiveMessages has kept messages that it read from the socket along with an
+     * invalid message. The socket does not signal these, so a client that waits for the socket
+     * to become readable should receive them first.
+     */
+    bool hasUnprocessedMessages() const { return !mUnprocessedMessages.empty(); }
+
     /* Wait until there is a message in the channel.
      *
      * The |timeout| specifies how long to block waiting for an input event to appear. Negative
@@ -323,11 +384,29 @@ public:
      */
     sp<IBinder> getConnectionToken() const;
 
+    /* Return the sample ring shared with the other endpoint, or nullptr if there is none. */
+    InputSampleRing* getMotionSampleRing() const { return mMotionSampleRing.get(); }
+
 private:
     static std::unique_ptr<InputChannel> create(const std::string& name,
-                                                android::base::unique_fd fd, sp<IBinder> token);
+                                                android::base::unique_fd fd, sp<IBinder> token,
+                                                std::shared_ptr<InputSampleRing> sampleRing);
+
+    InputChannel(const std::string name, android::base::unique_fd fd, sp<IBinder> token,
+                 std::shared_ptr<InputSampleRing> sampleRing);
 
-    InputChannel(const std::string name, android::base::unique_fd fd, sp<IBinder> token);
+    // Replace a received MOTION_SAMPLE message with the message that it refers to.
+    status_t resolveMotionSample(InputMessage& msg) const;
+
+    std::shared_ptr<InputSampleRing> mMotionSampleRing;
+    struct UnprocessedMessage {
+        InputMessage msg;
+        // The length of the message as it was read from the socket, before it was validated.
+        size_t length;
+    };
+    // Messages that receiveMessages read from the socket along with an invalid message, but did
+    // not return yet, in order. They include the invalid message if valid messages preceded it.
+    std::deque<UnprocessedMessage> mUnprocessedMessages;
 };
 
 /*
@@ -447,9 +526,44 @@ public:
      */
     android::base::Result<ConsumerResponse> receiveConsumerResponse();
 
+    /* Starts a batch of events.
+     *
+     * Until flushBatch is called, the publish methods validate the events and stage them instead
+     * of writing them to the input channel, and return OK unless the event itself is invalid.
+     * This lets a caller that has several events ready write all of them with a single system
+     * call.
+     */
+    void beginBatch();
+
+    /* Writes all of the events staged since beginBatch to the input channel, in order, and ends
+     * the batch.
+     *
+     * The number of events that were published is stored in outPublishedCount. The events that
+     * follow were not published at all and have been discarded; the caller is expected to publish
+     * them again later, the same way it would retry an event that failed to publish on its own.
+     *
+     * Returns OK if all of the staged events were published.
+     * Returns WOULD_BLOCK if the channel is full.
+     * Returns DEAD_OBJECT if the channel's peer has been closed.
+     * Other errors probably indicate that the channel is broken.
+     */
+    status_t flushBatch(size_t& outPublishedCount);
+
 private:
     std::shared_ptr<InputChannel> mChannel;
     InputVerifier mInputVerifier;
+    bool mBatching = false;
+    std::vector<InputMessage> mBatch;
+    // Whether the events of the current batch are verified, decided when the batch starts.
+    bool mVerifyBatch = false;
+    // The staged messages as they were published, before any of them was replaced by a reference
+    // to the sample ring. Only kept when the events of the batch are verified.
+    std::vector<InputMessage> mBatchToVerify;
+
+    status_t sendOrStageMessage(const InputMessage& msg);
+    // Runs the verifier on a message once it has been written to the input channel, so that an
+    // event that failed to be sent and is published again later is only verified once.
+    void verifySentMessage(const InputMessage& msg);
 };
 
 } // namespace android
@@ -149,6 +149,10 @@ private:
     void allocateTensors();
     void attachInputTensors();
     void attachOutputTensors();
+    void updateTensorBuffers();
+    // Whether the buffers of the attached tensors differ from the cached buffers. The tensors must
+    // have been attached since the last invocation.
+    bool tensorBuffersChanged() const;
 
     TfLiteTensor* mInputR = nullptr;
     TfLiteTensor* mInputPhi = nullptr;
@@ -160,6 +164,19 @@ private:
     const TfLiteTensor* mOutputPhi = nullptr;
     const TfLiteTensor* mOutputPressure = nullptr;
 
+    // The buffers of the tensors above. The tensors are looked up again after every invocation,
+    // since the interpreter might reallocate them, but their buffers are only fetched again if the
+    // interpreter moved them.
+    std::span<float> mInputRBuffer;
+    std::span<float> mInputPhiBuffer;
+    std::span<float> mInputPressureBuffer;
+    std::span<float> mInputTiltBuffer;
+    std::span<float> mInputOrientationBuffer;
+
+    std::span<const float> mOutputRBuffer;
+    std::span<const float> mOutputPhiBuffer;
+    std::span<const float> mOutputPressureBuffer;
+
     std::unique_ptr<android::base::MappedFile> mFlatBuffer;
     std::unique_ptr<tflite::ErrorReporter> mErrorReporter;
     std::unique_ptr<tflite::FlatBufferModel> mModel;
@@ -47,9 +47,11 @@ public:
         INT1 = android::os::IInputConstants::VELOCITY_TRACKER_STRATEGY_INT1,
         INT2 = android::os::IInputConstants::VELOCITY_TRACKER_STRATEGY_INT2,
         LEGACY = android::os::IInputConstants::VELOCITY_TRACKER_STRATEGY_LEGACY,
+        LSQ2_INCREMENTAL =
+                android::os::IInputConstants::VELOCITY_TRACKER_STRATEGY_LSQ2_INCREMENTAL,
         MIN = IMPULSE,
-        MAX = LEGACY,
-        ftl_last = LEGACY,
+        MAX = LSQ2_INCREMENTAL,
+        ftl_last = LSQ2_INCREMENTAL,
     };
 
     /*
@@ -233,6 +235,65 @@ private:
     const Weighting mWeighting;
 };
 
+/*
+ * Velocity tracker algorithm based on unweighted quadratic least-squares regression, like
+ * LeastSquaresVelocityTrackerStrategy with degree 2 and Weighting::NONE.
+ *
+ * Instead of rebuilding the least-squares system from the whole history on every query, the sums
+ * of the system are updated as movements are added and dropped from the history, so getting the
+ * velocity takes constant time regardless of the number of retained movements.
+ */
+class IncrementalLeastSquaresVelocityTrackerStrategy : public VelocityTrackerStrategy {
+public:
+    IncrementalLeastSquaresVelocityTrackerStrategy();
+    ~IncrementalLeastSquaresVelocityTrackerStrategy() override;
+
+    void clearPointer(int32_t pointerId) override;
+    void addMovement(nsecs_t eventTime, int32_t pointerId, float position) override;
+    std::optional<float> getVelocity(int32_t pointerId) const override;
+
+private:
+    struct Movement {
+        nsecs_t eventTime;
+        float position;
+    };
+
+    // Sums of the powers of the movement times (in seconds) and of the positions, both measured
+    // relative to the origin of the pointer.
+    struct Sums {
+        double x = 0;
+        double x2 = 0;
+        double x3 = 0;
+        double x4 = 0;
+        double y = 0;
+        double xy = 0;
+        double x2y = 0;
+    };
+
+    struct PointerState {
+        explicit PointerState(size_t historySize) : movements(historySize) {}
+
+        RingBuffer<Movement> movements;
+        // Time and position that the sums are relative to. Keeping the origin close to the
+        // retained movements keeps the magnitude of the sums, and their rounding errors, small.
+        nsecs_t originTime = 0;
+        float originPosition = 0;
+        Sums sums;
+    };
+
+    // Same history and horizon as LeastSquaresVelocityTrackerStrategy, so both fit the same data.
+    static constexpr uint32_t HISTORY_SIZE = 20;
+    static constexpr nsecs_t HORIZON = 100 * 1000000; // 100 ms
+
+    // Adds (sign = 1) or removes (sign = -1) the contribution of the movement to the sums.
+    static void accumulate(PointerState& state, const Movement& movement, double sign);
+    // Moves the origin to the newest movement, and recomputes the sums from the history. This also
+    // discards the rounding errors accumulated by removing movements from the sums.
+    static void rebase(PointerState& state);
+
+    std::map<int32_t /*pointerId*/, PointerState> mPointerStates;
+};
+
 /*
  * Velocity tracker algorithm that uses an IIR filter.
  */
@@ -38,6 +38,7 @@
 #include <gui/IProducerListener.h>
 #include <gui/Surface.h>
 #include <gui/TraceUtils.h>
+#include <gui/TransactionAggregator.h>
 #include <utils/Singleton.h>
 #include <utils/Trace.h>
 
@@ -244,6 +245,9 @@ BLASTBufferQueue::~BLASTBufferQueue() {
     /* QTI_END */
 
     TransactionCompletedListener::getInstance()->removeQueueStallListener(this);
+    if (mCoalesceTransactions) {
+        TransactionAggregator::getInstance().unregisterQueue(this);
+    }
     if (mPendingTransactions.empty()) {
         return;
     }
@@ -251,8 +255,7 @@ BLASTBufferQueue::~BLASTBufferQueue() {
              static_cast<uint32_t>(mPendingTransactions.size()));
     SurfaceComposerClient::Transaction t;
     mergePendingTransactions(&t, std::numeric_limits<uint64_t>::max() /* frameNumber */);
-    // All transactions on our apply token are one-way. See comment on mAppliedLastTransaction
-    t.setApplyToken(mApplyToken).apply(false, true);
+    applyLocked(t);
 
     if (mTransactionReadyCallback) {
         mTransactionReadyCallback(mSyncTransaction);
@@ -304,8 +307,7 @@ void BLASTBufferQueue::update(const sp<SurfaceControl>& surface, uint32_t width,
         }
     }
     if (applyTransaction) {
-        // All transactions on our apply token are one-way. See comment on mAppliedLastTransaction
-        t.setApplyToken(mApplyToken).apply(false, true);
+        applyLocked(t);
     }
 
     /* QTI_BEGIN */
@@ -574,12 +576,17 @@ status_t BLASTBufferQueue::acquireNextBufferLocked(
         return NAME_NOT_FOUND;
     }
 
-    SurfaceComposerClient::Transaction localTransaction;
+    // Buffers are acquired for every frame, so the local transaction comes from the pool of the
+    // thread and reuses the storage of the previous ones.
+    SurfaceComposerClient::Transaction::PooledTransaction localTransaction;
     bool applyTransaction = true;
-    SurfaceComposerClient::Transaction* t = &localTransaction;
+    SurfaceComposerClient::Transaction* t;
     if (transaction) {
         t = *transaction;
         applyTransaction = false;
+    } else {
+        localTransaction = SurfaceComposerClient::Transaction::obtain();
+        t = localTransaction.get();
     }
 
     BufferItem bufferItem;
@@ -691,20 +698,30 @@ status_t BLASTBufferQueue::acquireNextBufferLocked(
         mPendingFrameTimelines.pop();
     }
 
+    int64_t vsyncId = FrameTimelineInfo::INVALID_VSYNC_ID;
     if (!mPendingFrameTimelines.empty() &&
         mPendingFrameTimelines.front().first == bufferItem.mFrameNumber) {
         ATRACE_FORMAT_INSTANT("Transaction::setFrameTimelineInfo frameNumber: %" PRIu64
                               " vsyncId: %" PRId64,
                               bufferItem.mFrameNumber,
                               mPendingFrameTimelines.front().second.vsyncId);
+        vsyncId = mPendingFrameTimelines.front().second.vsyncId;
         t->setFrameTimelineInfo(mPendingFrameTimelines.front().second);
         mPendingFrameTimelines.pop();
     }
 
     mergePendingTransactions(t, bufferItem.mFrameNumber);
     if (applyTransaction) {
-        // All transactions on our apply token are one-way. See comment on mAppliedLastTransaction
-        t->setApplyToken(mApplyToken).apply(false, true);
+        if (mApplyTokenChanged) {
+            t->setBufferHasBarrier(mSurfaceControl, mLastAppliedFrameNumber);
+            mApplyTokenChanged = false;
+        }
+        // A desired present time is not kept when transactions are merged.
+        if (mCoalesceTransactions && bufferItem.mIsAutoTimestamp) {
+            TransactionAggregator::getInstance().add(this, std::move(*t), vsyncId);
+        } else {
+            applyLocked(*t);
+        }
         mAppliedLastTransaction = true;
         mLastAppliedFrameNumber = bufferItem.mFrameNumber;
         /* QTI_BEGIN */
@@ -715,6 +732,10 @@ status_t BLASTBufferQueue::acquireNextBufferLocked(
     } else {
         t->setBufferHasBarrier(mSurfaceControl, mLastAppliedFrameNumber);
         mAppliedLastTransaction = false;
+        if (mCoalesceTransactions) {
+            // Do not hold back the frame that the sync transaction waits for.
+            TransactionAggregator::getInstance().flush();
+        }
     }
 
     BQA_LOGV("acquireNextBufferLocked size=%dx%d mFrameNumber=%" PRIu64
@@ -1039,8 +1060,21 @@ void BLASTBufferQueue::applyPendingTransactions(uint64_t frameNumber) {
 
     SurfaceComposerClient::Transaction t;
     mergePendingTransactions(&t, frameNumber);
+    applyLocked(t);
+}
+
+void BLASTBufferQueue::applyLocked(SurfaceComposerClient::Transaction& t) {
+    if (mCoalesceTransactions) {
+        // Our last buffer may still be waiting in the aggregator, and must be applied first.
+        TransactionAggregator::getInstance().flush();
+    }
     // All transactions on our apply token are one-way. See comment on mAppliedLastTransaction
-    t.setApplyToken(mApplyToken).apply(false, true);
+    t.setApplyToken(getApplyTokenLocked()).apply(false, true);
+}
+
+sp<IBinder> BLASTBufferQueue::getApplyTokenLocked() const {
+    return mCoalesceTransactions ? TransactionAggregator::getInstance().getApplyToken()
+                                 : mApplyToken;
 }
 
 void BLASTBufferQueue::mergePendingTransactions(SurfaceComposerClient::Transaction* t,
@@ -1262,4 +1296,20 @@ void BLASTBufferQueue::setTransactionHangCallback(
     mTransactionHangCallback = callback;
 }
 
+void BLASTBufferQueue::setTransactionCoalescing(bool enabled) {
+    std::lock_guard _lock{mMutex};
+    if (mCoalesceTransactions == enabled) {
+        return;
+    }
+    auto& aggregator = TransactionAggregator::getInstance();
+    if (enabled) {
+        aggregator.registerQueue(this);
+    } else {
+        aggregator.unregisterQueue(this);
+    }
+    mCoalesceTransactions = enabled;
+    mApplyTokenChanged = mLastAppliedFrameNumber != 0;
+    BQA_LOGV("setTransactionCoalescing %s", boolToString(enabled));
+}
+
 } // namespace android
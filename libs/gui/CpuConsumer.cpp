@@ -21,6 +21,7 @@
 #include <gui/CpuConsumer.h>
 
 #include <gui/BufferItem.h>
+#include <ui/GraphicBufferMapper.h>
 #include <utils/Log.h>
 
 #define CC_LOGV(x, ...) ALOGV("[%s] " x, mName.c_str(), ##__VA_ARGS__)
@@ -88,15 +89,16 @@ static bool isPossiblyYUV(PixelFormat format) {
     }
 }
 
-status_t CpuConsumer::lockBufferItem(const BufferItem& item, LockedBuffer* outBuffer) const {
+status_t CpuConsumer::lockBuffer(const sp<GraphicBuffer>& buffer, const Rect& bounds,
+                                 const sp<Fence>& fence, LockedBuffer* outBuffer) const {
     android_ycbcr ycbcr = android_ycbcr();
 
-    PixelFormat format = item.mGraphicBuffer->getPixelFormat();
+    PixelFormat format = buffer->getPixelFormat();
     PixelFormat flexFormat = format;
     if (isPossiblyYUV(format)) {
-        int fenceFd = item.mFence.get() ? item.mFence->dup() : -1;
-        status_t err = item.mGraphicBuffer->lockAsyncYCbCr(GraphicBuffer::USAGE_SW_READ_OFTEN,
-                                                           item.mCrop, &ycbcr, fenceFd);
+        int fenceFd = fence.get() ? fence->dup() : -1;
+        status_t err = buffer->lockAsyncYCbCr(GraphicBuffer::USAGE_SW_READ_OFTEN, bounds, &ycbcr,
+                                              fenceFd);
         if (err == OK) {
             flexFormat = HAL_PIXEL_FORMAT_YCbCr_420_888;
             if (format != HAL_PIXEL_FORMAT_YCbCr_420_888) {
@@ -118,27 +120,36 @@ status_t CpuConsumer::lockBufferItem(const BufferItem& item, LockedBuffer* outBu
     } else {
         // not flexible YUV; try lockAsync
         void* bufferPointer = nullptr;
-        int fenceFd = item.mFence.get() ? item.mFence->dup() : -1;
-        status_t err = item.mGraphicBuffer->lockAsync(GraphicBuffer::USAGE_SW_READ_OFTEN,
-                                                      item.mCrop, &bufferPointer, fenceFd);
+        int fenceFd = fence.get() ? fence->dup() : -1;
+        status_t err = buffer->lockAsync(GraphicBuffer::USAGE_SW_READ_OFTEN, bounds,
+                                         &bufferPointer, fenceFd);
         if (err != OK) {
             CC_LOGE("Unable to lock buffer for CPU reading: %s (%d)", strerror(-err), err);
             return err;
         }
 
         outBuffer->data = reinterpret_cast<uint8_t*>(bufferPointer);
-        outBuffer->stride = item.mGraphicBuffer->getStride();
+        outBuffer->stride = buffer->getStride();
         outBuffer->dataCb = nullptr;
         outBuffer->dataCr = nullptr;
         outBuffer->chromaStride = 0;
         outBuffer->chromaStep = 0;
     }
 
-    outBuffer->width = item.mGraphicBuffer->getWidth();
-    outBuffer->height = item.mGraphicBuffer->getHeight();
+    outBuffer->width = buffer->getWidth();
+    outBuffer->height = buffer->getHeight();
     outBuffer->format = format;
     outBuffer->flexFormat = flexFormat;
 
+    return OK;
+}
+
+status_t CpuConsumer::lockBufferItem(const BufferItem& item, LockedBuffer* outBuffer) const {
+    status_t err = lockBuffer(item.mGraphicBuffer, item.mCrop, item.mFence, outBuffer);
+    if (err != OK) {
+        return err;
+    }
+
     outBuffer->crop = item.mCrop;
     outBuffer->transform = item.mTransform;
     outBuffer->scalingMode = item.mScalingMode;
@@ -149,6 +160,106 @@ status_t CpuConsumer::lockBufferItem(const BufferItem& item, LockedBuffer* outBu
     return OK;
 }
 
+status_t CpuConsumer::lockBufferItemPersistentLocked(const BufferItem& item,
+                                                     LockedBuffer* outBuffer) {
+    PersistentMapping& mapping = mPersistentMappings[item.mSlot];
+    const sp<GraphicBuffer>& buffer = item.mGraphicBuffer;
+    // The whole buffer is locked, since the crop may change from frame to frame.
+    const Rect bounds(buffer->getWidth(), buffer->getHeight());
+
+    if (mapping.mGraphicBuffer == buffer) {
+        // The mapping only needs to observe what the producer wrote once it is done.
+        if (item.mFence.get()) {
+            status_t err = item.mFence->waitForever("CpuConsumer::lockNextBuffer");
+            if (err != OK) {
+                CC_LOGE("Error waiting for the acquire fence: %s (%d)", strerror(-err), err);
+                return err;
+            }
+        }
+        if (!mRereadLockedBufferFailed) {
+            status_t err = GraphicBufferMapper::get().rereadLockedBuffer(buffer->handle);
+            if (err != OK) {
+                // The mapper is not expected to support it for the next buffers either.
+                CC_LOGW("Unable to reread locked buffers (%d), locking them again instead", err);
+                mRereadLockedBufferFailed = true;
+            }
+        }
+        if (mRereadLockedBufferFailed) {
+            // Fall back to mapping the buffer again.
+            unmapLocked(item.mSlot);
+        }
+    } else if (mapping.mGraphicBuffer != nullptr) {
+        unmapLocked(item.mSlot);
+    }
+
+    if (mapping.mGraphicBuffer == nullptr) {
+        status_t err = lockBuffer(buffer, bounds, item.mFence, &mapping.mLockedBuffer);
+        if (err != OK) {
+            return err;
+        }
+        mapping.mGraphicBuffer = buffer;
+    }
+
+    const LockedBuffer& locked = mapping.mLockedBuffer;
+    outBuffer->data = locked.data;
+    outBuffer->stride = locked.stride;
+    outBuffer->dataCb = locked.dataCb;
+    outBuffer->dataCr = locked.dataCr;
+    outBuffer->chromaStride = locked.chromaStride;
+    outBuffer->chromaStep = locked.chromaStep;
+    outBuffer->width = locked.width;
+    outBuffer->height = locked.height;
+    outBuffer->format = locked.format;
+    outBuffer->flexFormat = locked.flexFormat;
+
+    outBuffer->crop = item.mCrop;
+    outBuffer->transform = item.mTransform;
+    outBuffer->scalingMode = item.mScalingMode;
+    outBuffer->timestamp = item.mTimestamp;
+    outBuffer->dataSpace = item.mDataSpace;
+    outBuffer->frameNumber = item.mFrameNumber;
+
+    return OK;
+}
+
+void CpuConsumer::unmapLocked(int slot) {
+    PersistentMapping& mapping = mPersistentMappings[slot];
+    if (mapping.mGraphicBuffer == nullptr) {
+        return;
+    }
+
+    bool acquired = false;
+    for (size_t i = 0; i < mMaxLockedBuffers; i++) {
+        AcquiredBuffer& ab = mAcquiredBuffers.editItemAt(i);
+        if (ab.mPersistent && ab.mGraphicBuffer == mapping.mGraphicBuffer) {
+            // The user still reads from the buffer, so unlock it on release.
+            ab.mPersistent = false;
+            acquired = true;
+        }
+    }
+    if (!acquired) {
+        GraphicBufferMapper::get().unlock(mapping.mGraphicBuffer->handle);
+    }
+
+    mapping.mGraphicBuffer.clear();
+    mapping.mLockedBuffer = LockedBuffer();
+}
+
+void CpuConsumer::setPersistentMappingsEnabled(bool enabled) {
+    Mutex::Autolock _l(mMutex);
+    mPersistentMappingsEnabled = enabled;
+    if (!enabled) {
+        for (int slot = 0; slot < BufferQueueDefs::NUM_BUFFER_SLOTS; slot++) {
+            unmapLocked(slot);
+        }
+    }
+}
+
+void CpuConsumer::freeBufferLocked(int slotIndex) {
+    unmapLocked(slotIndex);
+    ConsumerBase::freeBufferLocked(slotIndex);
+}
+
 status_t CpuConsumer::lockNextBuffer(LockedBuffer *nativeBuffer) {
     status_t err;
 
@@ -177,7 +288,8 @@ status_t CpuConsumer::lockNextBuffer(LockedBuffer *nativeBuffer) {
         b.mGraphicBuffer = mSlots[b.mSlot].mGraphicBuffer;
     }
 
-    err = lockBufferItem(b, nativeBuffer);
+    err = mPersistentMappingsEnabled ? lockBufferItemPersistentLocked(b, nativeBuffer)
+                                     : lockBufferItem(b, nativeBuffer);
     if (err != OK) {
         return err;
     }
@@ -190,6 +302,7 @@ status_t CpuConsumer::lockNextBuffer(LockedBuffer *nativeBuffer) {
     ab.mSlot = b.mSlot;
     ab.mGraphicBuffer = b.mGraphicBuffer;
     ab.mLockedBufferId = getLockedBufferId(*nativeBuffer);
+    ab.mPersistent = mPersistentMappingsEnabled;
 
     mCurrentLockedBuffers++;
 
@@ -209,16 +322,19 @@ status_t CpuConsumer::unlockBuffer(const LockedBuffer &nativeBuffer) {
 
     AcquiredBuffer& ab = mAcquiredBuffers.editItemAt(lockedIdx);
 
-    int fenceFd = -1;
-    status_t err = ab.mGraphicBuffer->unlockAsync(&fenceFd);
-    if (err != OK) {
-        CC_LOGE("%s: Unable to unlock graphic buffer %zd", __FUNCTION__,
-                lockedIdx);
-        return err;
-    }
+    // A persistent mapping stays locked, and the CPU is done reading from it.
+    if (!ab.mPersistent) {
+        int fenceFd = -1;
+        status_t err = ab.mGraphicBuffer->unlockAsync(&fenceFd);
+        if (err != OK) {
+            CC_LOGE("%s: Unable to unlock graphic buffer %zd", __FUNCTION__,
+                    lockedIdx);
+            return err;
+        }
 
-    sp<Fence> fence(fenceFd >= 0 ? new Fence(fenceFd) : Fence::NO_FENCE);
-    addReleaseFenceLocked(ab.mSlot, ab.mGraphicBuffer, fence);
+        sp<Fence> fence(fenceFd >= 0 ? new Fence(fenceFd) : Fence::NO_FENCE);
+        addReleaseFenceLocked(ab.mSlot, ab.mGraphicBuffer, fence);
+    }
     releaseBufferLocked(ab.mSlot, ab.mGraphicBuffer);
 
     ab.reset();
@@ -22,6 +22,7 @@
 
 #include <gui/DisplayEventReceiver.h>
 #include <gui/VsyncEventData.h>
+#include <gui/VsyncTimeline.h>
 
 #include <private/gui/ComposerServiceAIDL.h>
 
@@ -96,6 +97,9 @@ status_t DisplayEventReceiver::requestNextVsync() {
 
 status_t DisplayEventReceiver::getLatestVsyncEventData(
         ParcelableVsyncEventData* outVsyncEventData) const {
+    if (readVsyncTimeline(systemTime(), &outVsyncEventData->vsync) == NO_ERROR) {
+        return NO_ERROR;
+    }
     if (mEventConnection != nullptr) {
         auto status = mEventConnection->getLatestVsyncEventData(outVsyncEventData);
         if (!status.isOk()) {
@@ -107,9 +111,53 @@ status_t DisplayEventReceiver::getLatestVsyncEventData(
     return NO_INIT;
 }
 
+status_t DisplayEventReceiver::readVsyncTimeline(nsecs_t now,
+                                                 VsyncEventData* outVsyncEventData) const {
+    if (mEventConnection == nullptr) {
+        return NO_INIT;
+    }
+    // The frame timelines of the vsync timeline are only valid for the clients that receive vsync
+    // events with the same frame interval, e.g. not for the ones that have a frame rate override.
+    const int64_t frameInterval = mLastFrameInterval.load(std::memory_order_relaxed);
+    if (frameInterval == 0) {
+        return NOT_ENOUGH_DATA;
+    }
+
+    gui::VsyncTimeline::Snapshot snapshot;
+    {
+        std::scoped_lock lock(mVsyncTimelineMutex);
+        if (!mVsyncTimelineRequested) {
+            mVsyncTimelineRequested = true;
+            os::ParcelFileDescriptor fd;
+            if (auto status = mEventConnection->getVsyncTimeline(&fd); status.isOk()) {
+                mVsyncTimeline = gui::VsyncTimeline::map(fd.release());
+            } else {
+                ALOGD("Vsync timeline is not available: %s", status.toString8().c_str());
+            }
+        }
+        if (mVsyncTimeline == nullptr || mVsyncTimeline->read(&snapshot) != NO_ERROR) {
+            return NOT_ENOUGH_DATA;
+        }
+    }
+
+    if (snapshot.vsyncData.frameInterval != frameInterval ||
+        !gui::VsyncTimeline::predict(snapshot, now, outVsyncEventData)) {
+        return NOT_ENOUGH_DATA;
+    }
+    return NO_ERROR;
+}
+
 ssize_t DisplayEventReceiver::getEvents(DisplayEventReceiver::Event* events,
         size_t count) {
-    return DisplayEventReceiver::getEvents(mDataChannel.get(), events, count);
+    const ssize_t n = DisplayEventReceiver::getEvents(mDataChannel.get(), events, count);
+    for (ssize_t i = n - 1; i >= 0; i--) {
+        if (events[i].header.type == DISPLAY_EVENT_VSYNC) {
+            mLastFrameInterval.store(events[i].vsync.vsyncData.frameInterval,
+                                     std::memory_order_relaxed);
+            break;
+        }
+    }
+    return n;
 }
 
 ssize_t DisplayEventReceiver::getEvents(gui::BitTube* dataChannel,
@@ -423,7 +423,9 @@ void ConsumerFrameEventHistory::addQueue(const NewFrameEventsEntry& newEntry) {
     newTimestamps.requestedPresentTime = newEntry.requestedPresentTime;
     newTimestamps.acquireFence = newEntry.acquireFence;
     newTimestamps.valid = true;
-    mFrames[mQueueOffset] = newTimestamps;
+    // Moved rather than copied, so that the fence references of the new frame
+    // are handed over instead of being taken again.
+    mFrames[mQueueOffset] = std::move(newTimestamps);
 
     // Note: We avoid sending the acquire fence back to the caller since
     // they have the original one already, so there is no need to set the
@@ -592,23 +594,30 @@ FrameEventsDelta::FrameEventsDelta(
     }
 }
 
+namespace {
+
+// Flags of the delta, flattened in a single byte.
+constexpr uint8_t ADD_POST_COMPOSITE_CALLED = 1 << 0;
+constexpr uint8_t ADD_RELEASE_CALLED = 1 << 1;
+
+} // namespace
+
 constexpr size_t FrameEventsDelta::minFlattenedSize() {
     return sizeof(FrameEventsDelta::mFrameNumber) +
             sizeof(uint16_t) + // mIndex
-            sizeof(uint8_t) + // mAddPostCompositeCalled
-            sizeof(uint8_t) + // mAddReleaseCalled
-            sizeof(FrameEventsDelta::mPostedTime) +
-            sizeof(FrameEventsDelta::mRequestedPresentTime) +
-            sizeof(FrameEventsDelta::mLatchTime) +
-            sizeof(FrameEventsDelta::mFirstRefreshStartTime) +
-            sizeof(FrameEventsDelta::mLastRefreshStartTime) +
-            sizeof(FrameEventsDelta::mDequeueReadyTime);
+            sizeof(uint8_t) + // flags
+            sizeof(uint8_t); // mask of the timestamps that follow
 }
 
 // Flattenable implementation
 size_t FrameEventsDelta::getFlattenedSize() const {
+    auto timestamps = allTimestamps(this);
     auto fences = allFences(this);
     return minFlattenedSize() +
+            static_cast<size_t>(std::count_if(timestamps.begin(), timestamps.end(),
+                    [](const nsecs_t* t) {
+                            return *t != FrameEvents::TIMESTAMP_PENDING;
+                    })) * sizeof(nsecs_t) +
             std::accumulate(fences.begin(), fences.end(), size_t(0),
                     [](size_t a, const FenceTime::Snapshot* fence) {
                             return a + fence->getFlattenedSize();
@@ -637,17 +646,26 @@ status_t FrameEventsDelta::flatten(void*& buffer, size_t& size, int*& fds,
 
     // These are static_cast to uint16_t/uint8_t for alignment.
     FlattenableUtils::write(buffer, size, static_cast<uint16_t>(mIndex));
-    FlattenableUtils::write(
-            buffer, size, static_cast<uint8_t>(mAddPostCompositeCalled));
-    FlattenableUtils::write(
-            buffer, size, static_cast<uint8_t>(mAddReleaseCalled));
-
-    FlattenableUtils::write(buffer, size, mPostedTime);
-    FlattenableUtils::write(buffer, size, mRequestedPresentTime);
-    FlattenableUtils::write(buffer, size, mLatchTime);
-    FlattenableUtils::write(buffer, size, mFirstRefreshStartTime);
-    FlattenableUtils::write(buffer, size, mLastRefreshStartTime);
-    FlattenableUtils::write(buffer, size, mDequeueReadyTime);
+    uint8_t flags = 0;
+    if (mAddPostCompositeCalled) flags |= ADD_POST_COMPOSITE_CALLED;
+    if (mAddReleaseCalled) flags |= ADD_RELEASE_CALLED;
+    FlattenableUtils::write(buffer, size, flags);
+
+    // Most timestamps of a delta are still pending, so only the others are
+    // written, after a mask of the ones that were.
+    auto timestamps = allTimestamps(this);
+    uint8_t timestampMask = 0;
+    for (size_t i = 0; i < timestamps.size(); i++) {
+        if (*timestamps[i] != FrameEvents::TIMESTAMP_PENDING) {
+            timestampMask |= 1 << i;
+        }
+    }
+    FlattenableUtils::write(buffer, size, timestampMask);
+    for (auto timestamp : timestamps) {
+        if (*timestamp != FrameEvents::TIMESTAMP_PENDING) {
+            FlattenableUtils::write(buffer, size, *timestamp);
+        }
+    }
 
     // Fences
     for (auto fence : allFences(this)) {
@@ -674,18 +692,27 @@ status_t FrameEventsDelta::unflatten(void const*& buffer, size_t& size,
     if (mIndex >= UINT8_MAX) {
         return BAD_VALUE;
     }
-    uint8_t temp8 = 0;
-    FlattenableUtils::read(buffer, size, temp8);
-    mAddPostCompositeCalled = static_cast<bool>(temp8);
-    FlattenableUtils::read(buffer, size, temp8);
-    mAddReleaseCalled = static_cast<bool>(temp8);
-
-    FlattenableUtils::read(buffer, size, mPostedTime);
-    FlattenableUtils::read(buffer, size, mRequestedPresentTime);
-    FlattenableUtils::read(buffer, size, mLatchTime);
-    FlattenableUtils::read(buffer, size, mFirstRefreshStartTime);
-    FlattenableUtils::read(buffer, size, mLastRefreshStartTime);
-    FlattenableUtils::read(buffer, size, mDequeueReadyTime);
+    uint8_t flags = 0;
+    FlattenableUtils::read(buffer, size, flags);
+    mAddPostCompositeCalled = (flags & ADD_POST_COMPOSITE_CALLED) != 0;
+    mAddReleaseCalled = (flags & ADD_RELEASE_CALLED) != 0;
+
+    uint8_t timestampMask = 0;
+    FlattenableUtils::read(buffer, size, timestampMask);
+    auto timestamps = allTimestamps(this);
+    if ((timestampMask >> timestamps.size()) != 0) {
+        return BAD_VALUE;
+    }
+    if (size < static_cast<size_t>(__builtin_popcount(timestampMask)) * sizeof(nsecs_t)) {
+        return NO_MEMORY;
+    }
+    for (size_t i = 0; i < timestamps.size(); i++) {
+        if (timestampMask & (1 << i)) {
+            FlattenableUtils::read(buffer, size, *timestamps[i]);
+        } else {
+            *timestamps[i] = FrameEvents::TIMESTAMP_PENDING;
+        }
+    }
 
     // Fences
     for (auto fence : allFences(this)) {
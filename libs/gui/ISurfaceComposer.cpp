@@ -37,6 +37,8 @@
 #include <ui/HdrCapabilities.h>
 #include <utils/Log.h>
 
+#include <optional>
+
 // ---------------------------------------------------------------------------
 
 using namespace aidl::android::hardware::graphics;
@@ -50,6 +52,46 @@ using gui::IWindowInfosListener;
 using gui::LayerCaptureArgs;
 using ui::ColorMode;
 
+namespace {
+
+struct ThreadTransactionStateParcel {
+    Parcel parcel;
+    bool inUse = false;
+};
+thread_local ThreadTransactionStateParcel tTransactionStateParcel;
+
+// setTransactionState is called for every frame of every surface, so the parcel that it is
+// written into is kept per thread, with the capacity that it grew to. A call nested in another one
+// on the same thread, from an incoming binder call, gets a parcel of its own.
+class TransactionStateParcel {
+public:
+    TransactionStateParcel() {
+        if (!tTransactionStateParcel.inUse) {
+            tTransactionStateParcel.inUse = true;
+            mParcel = &tTransactionStateParcel.parcel;
+        } else {
+            mParcel = &mLocalParcel.emplace();
+        }
+    }
+
+    ~TransactionStateParcel() {
+        if (mParcel == &tTransactionStateParcel.parcel) {
+            // Releases the binders that were written, but keeps the data buffer.
+            mParcel->setDataSize(0);
+            mParcel->setDataPosition(0);
+            tTransactionStateParcel.inUse = false;
+        }
+    }
+
+    Parcel& get() { return *mParcel; }
+
+private:
+    std::optional<Parcel> mLocalParcel;
+    Parcel* mParcel;
+};
+
+} // namespace
+
 class BpSurfaceComposer : public BpInterface<ISurfaceComposer>
 {
 public:
@@ -67,7 +109,9 @@ public:
             const std::vector<client_cache_t>& uncacheBuffers, bool hasListenerCallbacks,
             const std::vector<ListenerCallbacks>& listenerCallbacks, uint64_t transactionId,
             const std::vector<uint64_t>& mergedTransactionIds) override {
-        Parcel data, reply;
+        TransactionStateParcel dataParcel;
+        Parcel& data = dataParcel.get();
+        Parcel reply;
         data.writeInterfaceToken(ISurfaceComposer::getInterfaceDescriptor());
 
         frameTimelineInfo.writeToParcel(&data);
@@ -95,6 +95,10 @@ int64_t generateId() {
 }
 
 void emptyCallback(nsecs_t, const sp<Fence>&, const std::vector<SurfaceControlStats>&) {}
+
+// Threads that build transactions usually have at most a couple of them in flight.
+constexpr size_t MAX_POOLED_TRANSACTIONS = 4;
+thread_local std::vector<std::unique_ptr<SurfaceComposerClient::Transaction>> tTransactionPool;
 } // namespace
 
 const std::string SurfaceComposerClient::kEmpty{};
@@ -140,6 +144,12 @@ bool ComposerService::connectLocked() {
     return instance.mComposerService;
 }
 
+/*static*/ void ComposerService::setComposerService(const sp<ISurfaceComposer>& composerService) {
+    ComposerService& instance = ComposerService::getInstance();
+    Mutex::Autolock _l(instance.mLock);
+    instance.mComposerService = composerService;
+}
+
 void ComposerService::composerServiceDied()
 {
     Mutex::Autolock _l(mLock);
@@ -737,9 +747,31 @@ SurfaceComposerClient::Transaction::Transaction(const Transaction& other)
     mTransactionCompletedListener = TransactionCompletedListener::getInstance();
 }
 
+SurfaceComposerClient::Transaction::PooledTransaction SurfaceComposerClient::Transaction::obtain() {
+    if (tTransactionPool.empty()) {
+        return PooledTransaction(new Transaction());
+    }
+    PooledTransaction t(tTransactionPool.back().release());
+    tTransactionPool.pop_back();
+    return t;
+}
+
+void SurfaceComposerClient::Transaction::Recycler::operator()(Transaction* t) const {
+    if (tTransactionPool.size() >= MAX_POOLED_TRANSACTIONS) {
+        delete t;
+        return;
+    }
+    // A transaction that was merged into another one was cleared without being applied, so it
+    // still has the id that the other transaction recorded.
+    t->clear();
+    t->mId = generateId();
+    t->mStatus = NO_ERROR;
+    tTransactionPool.emplace_back(t);
+}
+
 void SurfaceComposerClient::Transaction::sanitize(int pid, int uid) {
     uint32_t permissions = LayerStatePermissions::getTransactionPermissions(pid, uid);
-    for (auto & [handle, composerState] : mComposerStates) {
+    for (auto& composerState : mComposerStates) {
         composerState.state.sanitize(permissions);
     }
     if (!mInputWindowCommands.empty() &&
@@ -819,8 +851,12 @@ status_t SurfaceComposerClient::Transaction::readFromParcel(const Parcel* parcel
     if (count > parcel->dataSize()) {
         return BAD_VALUE;
     }
-    std::unordered_map<sp<IBinder>, ComposerState, IBinderHash> composerStates;
+    std::vector<ComposerState> composerStates;
     composerStates.reserve(count);
+    // The parcel comes from the client, so look up duplicate handles in a map rather than
+    // scanning the states read so far, which would be quadratic in the number of entries.
+    std::unordered_map<sp<IBinder>, size_t, IBinderHash> composerStateIndices;
+    composerStateIndices.reserve(count);
     for (size_t i = 0; i < count; i++) {
         sp<IBinder> surfaceControlHandle;
         SAFE_PARCEL(parcel->readStrongBinder, &surfaceControlHandle);
@@ -829,7 +865,14 @@ status_t SurfaceComposerClient::Transaction::readFromParcel(const Parcel* parcel
         if (composerState.read(*parcel) == BAD_VALUE) {
             return BAD_VALUE;
         }
-        composerStates[surfaceControlHandle] = composerState;
+        composerState.state.surface = surfaceControlHandle;
+        const auto [it, inserted] =
+                composerStateIndices.try_emplace(surfaceControlHandle, composerStates.size());
+        if (inserted) {
+            composerStates.push_back(std::move(composerState));
+        } else {
+            composerStates[it->second] = std::move(composerState);
+        }
     }
 
     InputWindowCommands inputWindowCommands;
@@ -867,7 +910,7 @@ status_t SurfaceComposerClient::Transaction::readFromParcel(const Parcel* parcel
     mFrameTimelineInfo = frameTimelineInfo;
     mDisplayStates = displayStates;
     mListenerCallbacks = listenerCallbacks;
-    mComposerStates = composerStates;
+    mComposerStates = std::move(composerStates);
     mInputWindowCommands = inputWindowCommands;
     mApplyToken = applyToken;
     mUncacheBuffers = std::move(uncacheBuffers);
@@ -917,8 +960,8 @@ status_t SurfaceComposerClient::Transaction::writeToParcel(Parcel* parcel) const
     }
 
     parcel->writeUint32(static_cast<uint32_t>(mComposerStates.size()));
-    for (auto const& [handle, composerState] : mComposerStates) {
-        SAFE_PARCEL(parcel->writeStrongBinder, handle);
+    for (auto const& composerState : mComposerStates) {
+        SAFE_PARCEL(parcel->writeStrongBinder, composerState.state.surface);
         composerState.write(*parcel);
     }
 
@@ -975,14 +1018,15 @@ SurfaceComposerClient::Transaction& SurfaceComposerClient::Transaction::merge(Tr
     }
     mMergedTransactionIds.insert(mMergedTransactionIds.begin(), other.mId);
 
-    for (auto const& [handle, composerState] : other.mComposerStates) {
-        if (mComposerStates.count(handle) == 0) {
-            mComposerStates[handle] = composerState;
+    for (auto& composerState : other.mComposerStates) {
+        ComposerState* current = findComposerState(composerState.state.surface);
+        if (current == nullptr) {
+            mComposerStates.push_back(std::move(composerState));
         } else {
             if (composerState.state.what & layer_state_t::eBufferChanged) {
-                releaseBufferIfOverwriting(mComposerStates[handle].state);
+                releaseBufferIfOverwriting(current->state);
             }
-            mComposerStates[handle].state.merge(composerState.state);
+            current->state.merge(composerState.state);
         }
     }
 
@@ -1083,8 +1127,8 @@ void SurfaceComposerClient::Transaction::cacheBuffers() {
     }
 
     size_t count = 0;
-    for (auto& [handle, cs] : mComposerStates) {
-        layer_state_t* s = &(mComposerStates[handle].state);
+    for (auto& cs : mComposerStates) {
+        layer_state_t* s = &cs.state;
         if (!(s->what & layer_state_t::eBufferChanged)) {
             continue;
         } else if (s->bufferData &&
@@ -1213,8 +1257,9 @@ status_t SurfaceComposerClient::Transaction::apply(bool synchronous, bool oneWay
     Vector<DisplayState> displayStates;
     uint32_t flags = 0;
 
-    for (auto const& kv : mComposerStates) {
-        composerStates.add(kv.second);
+    composerStates.setCapacity(mComposerStates.size());
+    for (auto const& composerState : mComposerStates) {
+        composerStates.add(composerState);
     }
 
     displayStates = std::move(mDisplayStates);
@@ -1367,17 +1412,24 @@ void SurfaceComposerClient::Transaction::setEarlyWakeupEnd() {
 layer_state_t* SurfaceComposerClient::Transaction::getLayerState(const sp<SurfaceControl>& sc) {
     auto handle = sc->getLayerStateHandle();
 
-    if (mComposerStates.count(handle) == 0) {
-        // we don't have it, add an initialized layer_state to our list
-        ComposerState s;
+    if (ComposerState* composerState = findComposerState(handle)) {
+        return &composerState->state;
+    }
 
-        s.state.surface = handle;
-        s.state.layerId = sc->getLayerId();
+    // we don't have it, add an initialized layer_state to our list
+    ComposerState& s = mComposerStates.emplace_back();
+    s.state.surface = handle;
+    s.state.layerId = sc->getLayerId();
+    return &s.state;
+}
 
-        mComposerStates[handle] = s;
+ComposerState* SurfaceComposerClient::Transaction::findComposerState(const sp<IBinder>& handle) {
+    for (auto& composerState : mComposerStates) {
+        if (composerState.state.surface == handle) {
+            return &composerState;
+        }
     }
-
-    return &(mComposerStates[handle].state);
+    return nullptr;
 }
 
 void SurfaceComposerClient::Transaction::registerSurfaceControlForCallback(
@@ -0,0 +1,143 @@
+/*
+ * Copyright 2024 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#define LOG_TAG "TransactionAggregator"
+#define ATRACE_TAG ATRACE_TAG_GRAPHICS
+
+#include <pthread.h>
+
+#include <android/gui/FrameTimelineInfo.h>
+#include <gui/TransactionAggregator.h>
+#include <utils/Trace.h>
+
+namespace android {
+
+ANDROID_SINGLETON_STATIC_INSTANCE(TransactionAggregator);
+
+TransactionAggregator::TransactionAggregator()
+      : Singleton<TransactionAggregator>(),
+        mMaxDelay(kDefaultMaxDelay),
+        mPendingVsyncId(FrameTimelineInfo::INVALID_VSYNC_ID) {
+    mThread = std::thread(&TransactionAggregator::run, this);
+    pthread_setname_np(mThread.native_handle(), "TxnAggregator");
+}
+
+TransactionAggregator::~TransactionAggregator() {
+    {
+        std::lock_guard lock(mMutex);
+        flushLocked();
+        mDone = true;
+    }
+    mCondition.notify_all();
+    if (mThread.joinable()) {
+        mThread.join();
+    }
+}
+
+void TransactionAggregator::registerQueue(const void* queue) {
+    std::lock_guard lock(mMutex);
+    mQueues.insert(queue);
+}
+
+void TransactionAggregator::unregisterQueue(const void* queue) {
+    std::lock_guard lock(mMutex);
+    if (mPendingQueues.count(queue) != 0) {
+        flushLocked();
+    }
+    mQueues.erase(queue);
+    // The remaining queues may all have contributed already.
+    if (!mPendingQueues.empty() && mPendingQueues.size() >= mQueues.size()) {
+        flushLocked();
+    }
+}
+
+void TransactionAggregator::add(const void* queue, SurfaceComposerClient::Transaction&& t,
+                                int64_t vsyncId) {
+    std::lock_guard lock(mMutex);
+    mStats.transactionCount++;
+
+    // A second frame of the same queue would replace the first one, and frames of different vsyncs
+    // would have to share a single frame timeline.
+    const bool otherVsync = vsyncId != FrameTimelineInfo::INVALID_VSYNC_ID &&
+            mPendingVsyncId != FrameTimelineInfo::INVALID_VSYNC_ID && vsyncId != mPendingVsyncId;
+    if (mPendingQueues.count(queue) != 0 || otherVsync) {
+        flushLocked();
+    }
+
+    if (mPendingQueues.empty()) {
+        mPendingSince = std::chrono::steady_clock::now();
+        mCondition.notify_one();
+    }
+    mPendingTransaction.merge(std::move(t));
+    mPendingQueues.insert(queue);
+    if (vsyncId != FrameTimelineInfo::INVALID_VSYNC_ID) {
+        mPendingVsyncId = vsyncId;
+    }
+
+    if (mPendingQueues.size() >= mQueues.size()) {
+        flushLocked();
+    }
+}
+
+void TransactionAggregator::flush() {
+    std::lock_guard lock(mMutex);
+    flushLocked();
+}
+
+void TransactionAggregator::flushLocked() {
+    if (mPendingQueues.empty()) {
+        return;
+    }
+    ATRACE_FORMAT("%s queues=%zu", __func__, mPendingQueues.size());
+    // The transaction is applied while holding the lock, so that transactions reach SurfaceFlinger
+    // in the order in which they were added. The call is one-way and does not wait for
+    // SurfaceFlinger.
+    mPendingTransaction.setApplyToken(mApplyToken).apply(false, true);
+    mPendingTransaction.clear();
+    mPendingQueues.clear();
+    mPendingVsyncId = FrameTimelineInfo::INVALID_VSYNC_ID;
+    mStats.applyCount++;
+}
+
+void TransactionAggregator::setMaxDelay(std::chrono::nanoseconds maxDelay) {
+    std::lock_guard lock(mMutex);
+    mMaxDelay = maxDelay;
+    mCondition.notify_one();
+}
+
+TransactionAggregator::Stats TransactionAggregator::getStats() const {
+    std::lock_guard lock(mMutex);
+    return mStats;
+}
+
+void TransactionAggregator::run() {
+    std::unique_lock lock(mMutex);
+    base::ScopedLockAssertion assumeLocked(mMutex);
+    while (!mDone) {
+        if (mPendingQueues.empty()) {
+            mCondition.wait(lock);
+            continue;
+        }
+        const auto deadline = mPendingSince + mMaxDelay;
+        if (std::chrono::steady_clock::now() >= deadline) {
+            flushLocked();
+            continue;
+        }
+        mCondition.wait_until(lock, deadline);
+    }
+}
+
+} // namespace android
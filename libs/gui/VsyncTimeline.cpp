@@ -0,0 +1,206 @@
+/*
+ * Copyright 2024 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#define LOG_TAG "VsyncTimeline"
+
+#include <fcntl.h>
+#include <inttypes.h>
+#include <sys/mman.h>
+
+#include <atomic>
+#include <cstring>
+#include <new>
+
+#include <cutils/ashmem.h>
+#include <log/log.h>
+
+#include <gui/VsyncTimeline.h>
+
+namespace android::gui {
+
+namespace {
+
+// "VSTL", to detect file descriptors that do not refer to a vsync timeline.
+constexpr uint32_t PAGE_MAGIC = 0x5653544c;
+// Incremented whenever the layout of the page changes.
+constexpr uint32_t PAGE_VERSION = 1;
+// The number of times a reader copies the page before giving up on a publisher that keeps
+// updating it. Updates happen once per vsync, so a single retry is almost always enough.
+constexpr int MAX_READ_ATTEMPTS = 3;
+
+} // namespace
+
+/**
+ * The sequence is odd while the page is being written, and is incremented twice per update. The
+ * valid flag and the snapshot may only be used if the sequence was even and did not change while
+ * they were copied.
+ */
+struct VsyncTimeline::Page {
+    uint32_t magic;
+    uint32_t version;
+    uint32_t snapshotSize;
+    std::atomic<uint32_t> sequence;
+    uint32_t valid;
+    Snapshot snapshot;
+};
+
+// The page is shared between processes, so its atomics must not rely on a lock.
+static_assert(std::atomic<uint32_t>::is_always_lock_free);
+
+VsyncTimeline::VsyncTimeline(android::base::unique_fd fd, void* data, size_t size, bool writable)
+      : mFd(std::move(fd)), mData(data), mSize(size), mWritable(writable) {}
+
+VsyncTimeline::~VsyncTimeline() {
+    munmap(mData, mSize);
+}
+
+std::unique_ptr<VsyncTimeline> VsyncTimeline::create(const std::string& name) {
+    const size_t size = sizeof(Page);
+    android::base::unique_fd fd(ashmem_create_region(name.c_str(), size));
+    if (!fd.ok()) {
+        ALOGE("Could not allocate a vsync timeline of %zu bytes for '%s': %s", size, name.c_str(),
+              strerror(errno));
+        return nullptr;
+    }
+    void* data = mmap(nullptr, size, PROT_READ | PROT_WRITE, MAP_SHARED, fd.get(), 0);
+    if (data == MAP_FAILED) {
+        ALOGE("Could not map the vsync timeline for '%s': %s", name.c_str(), strerror(errno));
+        return nullptr;
+    }
+    // Any other mapping of the page, including the ones of the clients, is read-only.
+    if (ashmem_set_prot_region(fd.get(), PROT_READ) != 0) {
+        ALOGE("Could not restrict the protection of the vsync timeline for '%s': %s",
+              name.c_str(), strerror(errno));
+        munmap(data, size);
+        return nullptr;
+    }
+
+    Page* page = static_cast<Page*>(data);
+    page->magic = PAGE_MAGIC;
+    page->version = PAGE_VERSION;
+    page->snapshotSize = sizeof(Snapshot);
+    new (&page->sequence) std::atomic<uint32_t>(0);
+    page->valid = 0;
+    // using 'new' to access a non-public constructor
+    return std::unique_ptr<VsyncTimeline>(
+            new VsyncTimeline(std::move(fd), data, size, /*writable=*/true));
+}
+
+std::unique_ptr<VsyncTimeline> VsyncTimeline::map(android::base::unique_fd fd) {
+    const int size = ashmem_get_size_region(fd.get());
+    if (size < 0 || static_cast<size_t>(size) < sizeof(Page)) {
+        ALOGE("Invalid vsync timeline size %d", size);
+        return nullptr;
+    }
+    void* data = mmap(nullptr, size, PROT_READ, MAP_SHARED, fd.get(), 0);
+    if (data == MAP_FAILED) {
+        ALOGE("Could not map the vsync timeline: %s", strerror(errno));
+        return nullptr;
+    }
+    const Page& page = *static_cast<const Page*>(data);
+    if (page.magic != PAGE_MAGIC || page.version != PAGE_VERSION ||
+        page.snapshotSize != sizeof(Snapshot)) {
+        ALOGE("Invalid vsync timeline: magic=0x%08" PRIx32 ", version=%" PRIu32
+              ", snapshotSize=%" PRIu32,
+              page.magic, page.version, page.snapshotSize);
+        munmap(data, size);
+        return nullptr;
+    }
+    // using 'new' to access a non-public constructor
+    return std::unique_ptr<VsyncTimeline>(
+            new VsyncTimeline(std::move(fd), data, size, /*writable=*/false));
+}
+
+android::base::unique_fd VsyncTimeline::dupFd() const {
+    android::base::unique_fd newFd(fcntl(mFd.get(), F_DUPFD_CLOEXEC, 0));
+    if (!newFd.ok()) {
+        ALOGE("Could not duplicate the vsync timeline fd %d: %s", mFd.get(), strerror(errno));
+    }
+    return newFd;
+}
+
+void VsyncTimeline::publish(const Snapshot& snapshot) {
+    write(&snapshot);
+}
+
+void VsyncTimeline::invalidate() {
+    write(nullptr);
+}
+
+void VsyncTimeline::write(const Snapshot* snapshot) {
+    LOG_ALWAYS_FATAL_IF(!mWritable, "Attempted to write to a read-only vsync timeline");
+    Page& page = getPage();
+    const uint32_t sequence = page.sequence.load(std::memory_order_relaxed);
+    page.sequence.store(sequence + 1, std::memory_order_relaxed);
+    std::atomic_thread_fence(std::memory_order_release);
+    page.valid = snapshot != nullptr ? 1 : 0;
+    if (snapshot != nullptr) {
+        memcpy(&page.snapshot, snapshot, sizeof(Snapshot));
+    }
+    page.sequence.store(sequence + 2, std::memory_order_release);
+}
+
+status_t VsyncTimeline::read(Snapshot* outSnapshot) const {
+    const Page& page = getPage();
+    for (int attempt = 0; attempt < MAX_READ_ATTEMPTS; attempt++) {
+        const uint32_t sequence = page.sequence.load(std::memory_order_acquire);
+        if (sequence % 2 != 0) {
+            continue;
+        }
+        const uint32_t valid = page.valid;
+        memcpy(outSnapshot, &page.snapshot, sizeof(Snapshot));
+        std::atomic_thread_fence(std::memory_order_acquire);
+        if (page.sequence.load(std::memory_order_relaxed) != sequence) {
+            continue;
+        }
+        return valid != 0 ? OK : NOT_ENOUGH_DATA;
+    }
+    return WOULD_BLOCK;
+}
+
+bool VsyncTimeline::predict(const Snapshot& snapshot, nsecs_t now,
+                            VsyncEventData* outVsyncEventData) {
+    const VsyncEventData& published = snapshot.vsyncData;
+    if (published.frameTimelinesLength > VsyncEventData::kFrameTimelinesCapacity) {
+        ALOGE("Invalid vsync timeline with %" PRIu32 " frame timelines",
+              published.frameTimelinesLength);
+        return false;
+    }
+
+    // Same as the vsync that SurfaceFlinger anticipates for a frame that starts now.
+    const nsecs_t earliestPresentationTime = now + snapshot.workDuration + snapshot.readyDuration;
+    uint32_t length = 0;
+    bool hasPreferred = false;
+    for (uint32_t i = 0; i < published.frameTimelinesLength; i++) {
+        const auto& frameTimeline = published.frameTimelines[i];
+        if (frameTimeline.deadlineTimestamp <= now) {
+            continue;
+        }
+        if (!hasPreferred && frameTimeline.expectedPresentationTime >= earliestPresentationTime) {
+            outVsyncEventData->preferredFrameTimelineIndex = length;
+            hasPreferred = true;
+        }
+        outVsyncEventData->frameTimelines[length++] = frameTimeline;
+    }
+    if (!hasPreferred) {
+        return false;
+    }
+    outVsyncEventData->frameInterval = published.frameInterval;
+    outVsyncEventData->frameTimelinesLength = length;
+    return true;
+}
+
+} // namespace android::gui
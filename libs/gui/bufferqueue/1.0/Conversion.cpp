@@ -657,15 +657,37 @@ status_t unflatten(
 constexpr size_t minFlattenedSize(
         HGraphicBufferProducer::FrameEventsDelta const& /* t */) {
     return sizeof(uint64_t) + // mFrameNumber
-            sizeof(uint8_t) + // mIndex
-            sizeof(uint8_t) + // mAddPostCompositeCalled
-            sizeof(uint8_t) + // mAddRetireCalled
-            sizeof(uint8_t) + // mAddReleaseCalled
-            sizeof(nsecs_t) + // mPostedTime
-            sizeof(nsecs_t) + // mRequestedPresentTime
-            sizeof(nsecs_t) + // mLatchTime
-            sizeof(nsecs_t) + // mFirstRefreshStartTime
-            sizeof(nsecs_t); // mLastRefreshStartTime
+            sizeof(uint16_t) + // mIndex
+            sizeof(uint8_t) + // flags
+            sizeof(uint8_t); // mask of the timestamps that follow
+}
+
+// The flags and the timestamps of `FrameEventsDelta`, in the order in which
+// the timestamps are flattened. Only the timestamps that are not pending are
+// flattened, after a mask of the ones that are.
+constexpr uint8_t kAddPostCompositeCalled = 1 << 0;
+constexpr uint8_t kAddReleaseCalled = 1 << 1;
+constexpr int64_t kTimestampPending = -2;
+
+template <typename DeltaT>
+inline auto allTimestamps(DeltaT* t) ->
+        std::array<decltype(&t->postedTimeNs), 6> {
+    return {{
+        &t->postedTimeNs, &t->requestedPresentTimeNs, &t->latchTimeNs,
+        &t->firstRefreshStartTimeNs, &t->lastRefreshStartTimeNs,
+        &t->dequeueReadyTime
+    }};
+}
+
+inline size_t getTimestampsFlattenedSize(
+        HGraphicBufferProducer::FrameEventsDelta const& t) {
+    size_t size = 0;
+    for (auto timestamp : allTimestamps(&t)) {
+        if (*timestamp != kTimestampPending) {
+            size += sizeof(nsecs_t);
+        }
+    }
+    return size;
 }
 
 /**
@@ -678,6 +700,7 @@ constexpr size_t minFlattenedSize(
 size_t getFlattenedSize(
         HGraphicBufferProducer::FrameEventsDelta const& t) {
     return minFlattenedSize(t) +
+            getTimestampsFlattenedSize(t) +
             getFlattenedSize(t.gpuCompositionDoneFence) +
             getFlattenedSize(t.displayPresentFence) +
             getFlattenedSize(t.displayRetireFence) +
@@ -722,23 +745,32 @@ status_t unflatten(HGraphicBufferProducer::FrameEventsDelta* t,
     }
     FlattenableUtils::read(buffer, size, t->frameNumber);
 
-    // These were written as uint8_t for alignment.
-    uint8_t temp = 0;
-    FlattenableUtils::read(buffer, size, temp);
-    t->index = static_cast<uint32_t>(temp);
-    FlattenableUtils::read(buffer, size, temp);
-    t->addPostCompositeCalled = static_cast<bool>(temp);
-    FlattenableUtils::read(buffer, size, temp);
-    t->addRetireCalled = static_cast<bool>(temp);
-    FlattenableUtils::read(buffer, size, temp);
-    t->addReleaseCalled = static_cast<bool>(temp);
-
-    FlattenableUtils::read(buffer, size, t->postedTimeNs);
-    FlattenableUtils::read(buffer, size, t->requestedPresentTimeNs);
-    FlattenableUtils::read(buffer, size, t->latchTimeNs);
-    FlattenableUtils::read(buffer, size, t->firstRefreshStartTimeNs);
-    FlattenableUtils::read(buffer, size, t->lastRefreshStartTimeNs);
-    FlattenableUtils::read(buffer, size, t->dequeueReadyTime);
+    // These were written as uint16_t/uint8_t for alignment.
+    uint16_t index = 0;
+    FlattenableUtils::read(buffer, size, index);
+    t->index = static_cast<uint32_t>(index);
+    uint8_t flags = 0;
+    FlattenableUtils::read(buffer, size, flags);
+    t->addPostCompositeCalled = (flags & kAddPostCompositeCalled) != 0;
+    t->addRetireCalled = false;
+    t->addReleaseCalled = (flags & kAddReleaseCalled) != 0;
+
+    uint8_t timestampMask = 0;
+    FlattenableUtils::read(buffer, size, timestampMask);
+    auto timestamps = allTimestamps(t);
+    if ((timestampMask >> timestamps.size()) != 0) {
+        return BAD_VALUE;
+    }
+    for (size_t i = 0; i < timestamps.size(); ++i) {
+        if ((timestampMask & (1 << i)) == 0) {
+            *timestamps[i] = kTimestampPending;
+            continue;
+        }
+        if (size < sizeof(nsecs_t)) {
+            return NO_MEMORY;
+        }
+        FlattenableUtils::read(buffer, size, *timestamps[i]);
+    }
 
     // Fences
     HGraphicBufferProducer::FenceTimeSnapshot* tSnapshot[4];
@@ -787,21 +819,26 @@ status_t flatten(HGraphicBufferProducer::FrameEventsDelta const& t,
 
     FlattenableUtils::write(buffer, size, t.frameNumber);
 
-    // These are static_cast to uint8_t for alignment.
-    FlattenableUtils::write(buffer, size, static_cast<uint8_t>(t.index));
-    FlattenableUtils::write(
-            buffer, size, static_cast<uint8_t>(t.addPostCompositeCalled));
-    FlattenableUtils::write(
-            buffer, size, static_cast<uint8_t>(t.addRetireCalled));
-    FlattenableUtils::write(
-            buffer, size, static_cast<uint8_t>(t.addReleaseCalled));
-
-    FlattenableUtils::write(buffer, size, t.postedTimeNs);
-    FlattenableUtils::write(buffer, size, t.requestedPresentTimeNs);
-    FlattenableUtils::write(buffer, size, t.latchTimeNs);
-    FlattenableUtils::write(buffer, size, t.firstRefreshStartTimeNs);
-    FlattenableUtils::write(buffer, size, t.lastRefreshStartTimeNs);
-    FlattenableUtils::write(buffer, size, t.dequeueReadyTime);
+    // These are static_cast to uint16_t/uint8_t for alignment.
+    FlattenableUtils::write(buffer, size, static_cast<uint16_t>(t.index));
+    uint8_t flags = 0;
+    if (t.addPostCompositeCalled) flags |= kAddPostCompositeCalled;
+    if (t.addReleaseCalled) flags |= kAddReleaseCalled;
+    FlattenableUtils::write(buffer, size, flags);
+
+    auto timestamps = allTimestamps(&t);
+    uint8_t timestampMask = 0;
+    for (size_t i = 0; i < timestamps.size(); ++i) {
+        if (*timestamps[i] != kTimestampPending) {
+            timestampMask |= 1 << i;
+        }
+    }
+    FlattenableUtils::write(buffer, size, timestampMask);
+    for (auto timestamp : timestamps) {
+        if (*timestamp != kTimestampPending) {
+            FlattenableUtils::write(buffer, size, *timestamp);
+        }
+    }
 
     // Fences
     HGraphicBufferProducer::FenceTimeSnapshot const* tSnapshot[4];
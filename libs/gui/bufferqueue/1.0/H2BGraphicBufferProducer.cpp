@@ -662,15 +662,37 @@ inline status_t flatten(HGraphicBufferProducer::FenceTimeSnapshot const& t,
 constexpr size_t minFlattenedSize(
         HGraphicBufferProducer::FrameEventsDelta const& /* t */) {
     return sizeof(uint64_t) + // mFrameNumber
-            sizeof(uint8_t) + // mIndex
-            sizeof(uint8_t) + // mAddPostCompositeCalled
-            sizeof(uint8_t) + // mAddRetireCalled
-            sizeof(uint8_t) + // mAddReleaseCalled
-            sizeof(nsecs_t) + // mPostedTime
-            sizeof(nsecs_t) + // mRequestedPresentTime
-            sizeof(nsecs_t) + // mLatchTime
-            sizeof(nsecs_t) + // mFirstRefreshStartTime
-            sizeof(nsecs_t); // mLastRefreshStartTime
+            sizeof(uint16_t) + // mIndex
+            sizeof(uint8_t) + // flags
+            sizeof(uint8_t); // mask of the timestamps that follow
+}
+
+// The flags and the timestamps of `FrameEventsDelta`, in the order in which
+// the timestamps are flattened. Only the timestamps that are not pending are
+// flattened, after a mask of the ones that are.
+constexpr uint8_t kAddPostCompositeCalled = 1 << 0;
+constexpr uint8_t kAddReleaseCalled = 1 << 1;
+constexpr int64_t kTimestampPending = -2;
+
+template <typename DeltaT>
+inline auto allTimestamps(DeltaT* t) ->
+        std::array<decltype(&t->postedTimeNs), 6> {
+    return {{
+        &t->postedTimeNs, &t->requestedPresentTimeNs, &t->latchTimeNs,
+        &t->firstRefreshStartTimeNs, &t->lastRefreshStartTimeNs,
+        &t->dequeueReadyTime
+    }};
+}
+
+inline size_t getTimestampsFlattenedSize(
+        HGraphicBufferProducer::FrameEventsDelta const& t) {
+    size_t size = 0;
+    for (auto timestamp : allTimestamps(&t)) {
+        if (*timestamp != kTimestampPending) {
+            size += sizeof(nsecs_t);
+        }
+    }
+    return size;
 }
 
 /**
@@ -683,6 +705,7 @@ constexpr size_t minFlattenedSize(
 inline size_t getFlattenedSize(
         HGraphicBufferProducer::FrameEventsDelta const& t) {
     return minFlattenedSize(t) +
+            getTimestampsFlattenedSize(t) +
             getFlattenedSize(t.gpuCompositionDoneFence) +
             getFlattenedSize(t.displayPresentFence) +
             getFlattenedSize(t.displayRetireFence) +
@@ -731,21 +754,26 @@ inline status_t flatten(HGraphicBufferProducer::FrameEventsDelta const& t,
 
     FlattenableUtils::write(buffer, size, t.frameNumber);
 
-    // These are static_cast to uint8_t for alignment.
-    FlattenableUtils::write(buffer, size, static_cast<uint8_t>(t.index));
-    FlattenableUtils::write(
-            buffer, size, static_cast<uint8_t>(t.addPostCompositeCalled));
-    FlattenableUtils::write(
-            buffer, size, static_cast<uint8_t>(t.addRetireCalled));
-    FlattenableUtils::write(
-            buffer, size, static_cast<uint8_t>(t.addReleaseCalled));
-
-    FlattenableUtils::write(buffer, size, t.postedTimeNs);
-    FlattenableUtils::write(buffer, size, t.requestedPresentTimeNs);
-    FlattenableUtils::write(buffer, size, t.latchTimeNs);
-    FlattenableUtils::write(buffer, size, t.firstRefreshStartTimeNs);
-    FlattenableUtils::write(buffer, size, t.lastRefreshStartTimeNs);
-    FlattenableUtils::write(buffer, size, t.dequeueReadyTime);
+    // These are static_cast to uint16_t/uint8_t for alignment.
+    FlattenableUtils::write(buffer, size, static_cast<uint16_t>(t.index));
+    uint8_t flags = 0;
+    if (t.addPostCompositeCalled) flags |= kAddPostCompositeCalled;
+    if (t.addReleaseCalled) flags |= kAddReleaseCalled;
+    FlattenableUtils::write(buffer, size, flags);
+
+    auto timestamps = allTimestamps(&t);
+    uint8_t timestampMask = 0;
+    for (size_t i = 0; i < timestamps.size(); ++i) {
+        if (*timestamps[i] != kTimestampPending) {
+            timestampMask |= 1 << i;
+        }
+    }
+    FlattenableUtils::write(buffer, size, timestampMask);
+    for (auto timestamp : timestamps) {
+        if (*timestamp != kTimestampPending) {
+            FlattenableUtils::write(buffer, size, *timestamp);
+        }
+    }
 
     // Fences
     HGraphicBufferProducer::FenceTimeSnapshot const* tSnapshot[4];
@@ -155,6 +155,14 @@ public:
      */
     void setTransactionHangCallback(std::function<void(const std::string&)> callback);
 
+    /**
+     * Hand the buffer transactions of this queue to the TransactionAggregator of the process, so
+     * that they are applied together with the ones of the other queues that opted in. This saves
+     * binder calls to SurfaceFlinger when a process updates several surfaces every frame. Frames
+     * with a desired present time and frames handed to a sync transaction are not coalesced.
+     */
+    void setTransactionCoalescing(bool enabled);
+
     virtual ~BLASTBufferQueue();
 
 private:
@@ -182,6 +190,9 @@ private:
     static PixelFormat convertBufferFormat(PixelFormat& format);
     void mergePendingTransactions(SurfaceComposerClient::Transaction* t, uint64_t frameNumber)
             REQUIRES(mMutex);
+    // Applies a transaction one-way on the apply token of this queue.
+    void applyLocked(SurfaceComposerClient::Transaction& t) REQUIRES(mMutex);
+    sp<IBinder> getApplyTokenLocked() const REQUIRES(mMutex);
 
     void flushShadowQueue() REQUIRES(mMutex);
     void acquireAndReleaseBuffer() REQUIRES(mMutex);
@@ -292,6 +303,14 @@ private:
     // transactions from other parts of the client from blocking this transaction.
     const sp<IBinder> mApplyToken GUARDED_BY(mMutex) = sp<BBinder>::make();
 
+    // True if buffer transactions are coalesced by the TransactionAggregator. All of our
+    // transactions are then applied on the apply token of the aggregator instead of mApplyToken,
+    // after the pending transaction of the aggregator. See getApplyTokenLocked().
+    bool mCoalesceTransactions GUARDED_BY(mMutex) = false;
+    // True if the apply token changed since the last applied buffer. Transactions on different
+    // tokens are not ordered, so the next buffer has a barrier on the last applied frame.
+    bool mApplyTokenChanged GUARDED_BY(mMutex) = false;
+
     // Guards access to mDequeueTimestamps since we cannot hold to mMutex in onFrameDequeued or
     // we will deadlock.
     std::mutex mTimestampMutex;
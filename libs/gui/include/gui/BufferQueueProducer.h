@@ -24,6 +24,7 @@
 #define ANDROID_GUI_BUFFERQUEUEPRODUCER_H
 
 #include <gui/AdditionalOptions.h>
+#include <gui/BufferItem.h>
 #include <gui/BufferQueueDefs.h>
 
 #include <gui/IGraphicBufferProducer.h>
@@ -39,6 +40,7 @@ class QtiBufferQueueProducerExtension;
 /* QTI_END */
 
 class IBinder;
+class IConsumerListener;
 struct BufferSlot;
 
 #ifndef NO_BINDER
@@ -68,6 +70,11 @@ public:
     // flags indicating that previously-returned buffers are no longer valid.
     virtual status_t requestBuffer(int slot, sp<GraphicBuffer>* buf);
 
+    // See IGraphicBufferProducer::requestBuffers. All of the requests are
+    // handled while holding the BufferQueue lock once.
+    virtual status_t requestBuffers(const std::vector<int32_t>& slots,
+                                    std::vector<RequestBufferOutput>* outputs) override;
+
     // see IGraphicsBufferProducer::setMaxDequeuedBufferCount
     virtual status_t setMaxDequeuedBufferCount(int maxDequeuedBuffers);
 
@@ -142,6 +149,12 @@ public:
     virtual status_t queueBuffer(int slot,
             const QueueBufferInput& input, QueueBufferOutput* output);
 
+    // See IGraphicBufferProducer::queueBuffers. All of the buffers are queued
+    // while holding the BufferQueue lock once, and the consumer is then
+    // notified of the frames in the order in which they were queued.
+    virtual status_t queueBuffers(const std::vector<QueueBufferInput>& inputs,
+                                  std::vector<QueueBufferOutput>* outputs) override;
+
     // cancelBuffer returns a dequeued buffer to the BufferQueue, but doesn't
     // queue it for use by the consumer.
     //
@@ -149,6 +162,11 @@ public:
     // will usually be the one obtained from dequeueBuffer.
     virtual status_t cancelBuffer(int slot, const sp<Fence>& fence);
 
+    // See IGraphicBufferProducer::cancelBuffers. All of the buffers are
+    // cancelled while holding the BufferQueue lock once.
+    virtual status_t cancelBuffers(const std::vector<CancelBufferInput>& inputs,
+                                   std::vector<status_t>* results) override;
+
     // Query native window attributes.  The "what" values are enumerated in
     // window.h (e.g. NATIVE_WINDOW_FORMAT).
     virtual int query(int what, int* outValue);
@@ -254,6 +272,52 @@ private:
     void addAndGetFrameTimestamps(const NewFrameEventsEntry* newTimestamps,
             FrameEventHistoryDelta* outDelta);
 
+    // The body of requestBuffer. Must be called with mCore->mMutex held.
+    status_t requestBufferLocked(int slot, sp<GraphicBuffer>* buf);
+
+    // The body of cancelBuffer, without the notifications. Must be called with
+    // mCore->mMutex held. If the consumer has to be told about the cancelled
+    // frame, the id of its buffer is stored in outCancelledBufferId.
+    status_t cancelBufferLocked(int slot, const sp<Fence>& fence,
+                                std::optional<uint64_t>* outCancelledBufferId);
+
+    // The state of a queueBuffer call that is carried from one of its phases
+    // to the next.
+    struct QueuedFrame {
+        int slot = BufferItem::INVALID_BUFFER_SLOT;
+        int64_t requestedPresentTimestamp = 0;
+        bool isAutoTimestamp = false;
+        android_dataspace dataSpace = HAL_DATASPACE_UNKNOWN;
+        Rect crop = Rect::EMPTY_RECT;
+        int scalingMode = 0;
+        uint32_t transform = 0;
+        uint32_t stickyTransform = 0;
+        sp<Fence> acquireFence;
+        std::shared_ptr<FenceTime> acquireFenceTime;
+        bool getFrameTimestamps = false;
+        // These point into the QueueBufferInput, which outlives the call.
+        const Region* surfaceDamage = nullptr;
+        const HdrMetadata* hdrMetadata = nullptr;
+
+        BufferItem item;
+        uint64_t currentFrameNumber = 0;
+        int callbackTicket = 0;
+        int connectedApi = 0;
+        sp<Fence> lastQueuedFence;
+        sp<IConsumerListener> consumerListener;
+        sp<IConsumerListener> frameAvailableListener;
+        sp<IConsumerListener> frameReplacedListener;
+    };
+
+    // queueBuffer is split in three phases, so that queueBuffers can hold
+    // mCore->mMutex once for all of its buffers:
+    // - prepareQueueBuffer validates the input, without the lock held.
+    // - queueBufferLocked adds the buffer to the queue, with mCore->mMutex held.
+    // - finishQueueBuffer notifies the consumer, without the lock held.
+    status_t prepareQueueBuffer(int slot, const QueueBufferInput& input, QueuedFrame* frame);
+    status_t queueBufferLocked(QueuedFrame* frame, QueueBufferOutput* output);
+    void finishQueueBuffer(QueuedFrame* frame, QueueBufferOutput* output);
+
     // waitForFreeSlotThenRelock finds the oldest slot in the FREE state. It may
     // block if there are no available slots and we are not in non-blocking
     // mode (producer and consumer controlled by the application). If it blocks,
@@ -0,0 +1,203 @@
+/*
+ * Copyright 2024 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#ifndef ANDROID_GUI_BUFFERSLOTSET_H
+#define ANDROID_GUI_BUFFERSLOTSET_H
+
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <iterator>
+
+#include <log/log.h>
+#include <ui/BufferQueueDefs.h>
+
+namespace android {
+
+// BufferSlotSet is an ordered set of buffer slot indices, stored as a bit mask
+// of NUM_BUFFER_SLOTS bits. It has the subset of the std::set<int> interface
+// that BufferQueueCore uses, but never allocates, and insertion, removal and
+// lookup are single bit operations. Iteration is in increasing slot order.
+class BufferSlotSet {
+public:
+    static_assert(BufferQueueDefs::NUM_BUFFER_SLOTS <= 64,
+                  "BufferSlotSet stores the slots in a 64-bit mask");
+
+    class const_iterator {
+    public:
+        using iterator_category = std::forward_iterator_tag;
+        using value_type = int;
+        using difference_type = std::ptrdiff_t;
+        using pointer = const int*;
+        using reference = int;
+
+        const_iterator() = default;
+        int operator*() const { return __builtin_ctzll(mRemaining); }
+        const_iterator& operator++() {
+            mRemaining &= mRemaining - 1;
+            return *this;
+        }
+        const_iterator operator++(int) {
+            const_iterator previous = *this;
+            ++*this;
+            return previous;
+        }
+        bool operator==(const const_iterator& other) const {
+            return mRemaining == other.mRemaining;
+        }
+        bool operator!=(const const_iterator& other) const { return !(*this == other); }
+
+    private:
+        friend class BufferSlotSet;
+        explicit const_iterator(uint64_t remaining) : mRemaining(remaining) {}
+
+        // The slots that have not been visited yet.
+        uint64_t mRemaining = 0;
+    };
+    using iterator = const_iterator;
+
+    const_iterator begin() const { return const_iterator(mBits); }
+    const_iterator end() const { return const_iterator(0); }
+
+    bool empty() const { return mBits == 0; }
+    size_t size() const { return static_cast<size_t>(__builtin_popcountll(mBits)); }
+    size_t count(int slot) const { return isValid(slot) && (mBits & bit(slot)) != 0 ? 1 : 0; }
+
+    void insert(int slot) {
+        LOG_ALWAYS_FATAL_IF(!isValid(slot), "BufferSlotSet: invalid slot %d", slot);
+        mBits |= bit(slot);
+    }
+    void erase(int slot) {
+        if (isValid(slot)) {
+            mBits &= ~bit(slot);
+        }
+    }
+    void erase(const_iterator it) { erase(*it); }
+    void clear() { mBits = 0; }
+
+private:
+    static bool isValid(int slot) {
+        return slot >= 0 && slot < BufferQueueDefs::NUM_BUFFER_SLOTS;
+    }
+    static uint64_t bit(int slot) { return uint64_t(1) << slot; }
+
+    uint64_t mBits = 0;
+};
+
+// BufferSlotList is an ordered sequence of buffer slot indices, stored in a
+// fixed-size ring. It has the subset of the std::list<int> interface that
+// BufferQueueCore uses, but never allocates. A slot is in at most one list at a
+// time, so a list never holds more than NUM_BUFFER_SLOTS entries.
+class BufferSlotList {
+public:
+    class const_iterator {
+    public:
+        using iterator_category = std::forward_iterator_tag;
+        using value_type = int;
+        using difference_type = std::ptrdiff_t;
+        using pointer = const int*;
+        using reference = const int&;
+
+        const_iterator() = default;
+        const int& operator*() const { return mList->at(mIndex); }
+        const_iterator& operator++() {
+            mIndex++;
+            return *this;
+        }
+        const_iterator operator++(int) {
+            const_iterator previous = *this;
+            ++*this;
+            return previous;
+        }
+        bool operator==(const const_iterator& other) const {
+            return mList == other.mList && mIndex == other.mIndex;
+        }
+        bool operator!=(const const_iterator& other) const { return !(*this == other); }
+
+    private:
+        friend class BufferSlotList;
+        const_iterator(const BufferSlotList* list, size_t index) : mList(list), mIndex(index) {}
+
+        const BufferSlotList* mList = nullptr;
+        size_t mIndex = 0;
+    };
+    using iterator = const_iterator;
+
+    const_iterator begin() const { return const_iterator(this, 0); }
+    const_iterator end() const { return const_iterator(this, mSize); }
+    const_iterator cbegin() const { return begin(); }
+    const_iterator cend() const { return end(); }
+
+    bool empty() const { return mSize == 0; }
+    size_t size() const { return mSize; }
+
+    int front() const { return at(0); }
+    int back() const { return at(mSize - 1); }
+
+    void push_front(int slot) {
+        LOG_ALWAYS_FATAL_IF(mSize == CAPACITY, "BufferSlotList: full when adding slot %d", slot);
+        mHead = (mHead + CAPACITY - 1) % CAPACITY;
+        mSlots[mHead] = slot;
+        mSize++;
+    }
+    void push_back(int slot) {
+        LOG_ALWAYS_FATAL_IF(mSize == CAPACITY, "BufferSlotList: full when adding slot %d", slot);
+        mSlots[(mHead + mSize) % CAPACITY] = slot;
+        mSize++;
+    }
+    void pop_front() {
+        if (mSize > 0) {
+            mHead = (mHead + 1) % CAPACITY;
+            mSize--;
+        }
+    }
+    void pop_back() {
+        if (mSize > 0) {
+            mSize--;
+        }
+    }
+
+    // Removes every occurrence of the given slot, keeping the order of the
+    // other slots.
+    void remove(int slot) {
+        size_t kept = 0;
+        for (size_t i = 0; i < mSize; i++) {
+            const int s = mSlots[(mHead + i) % CAPACITY];
+            if (s != slot) {
+                mSlots[(mHead + kept) % CAPACITY] = s;
+                kept++;
+            }
+        }
+        mSize = kept;
+    }
+    void clear() {
+        mHead = 0;
+        mSize = 0;
+    }
+
+private:
+    static constexpr size_t CAPACITY = BufferQueueDefs::NUM_BUFFER_SLOTS;
+
+    const int& at(size_t index) const { return mSlots[(mHead + index) % CAPACITY]; }
+
+    std::array<int, CAPACITY> mSlots{};
+    size_t mHead = 0;
+    size_t mSize = 0;
+};
+
+} // namespace android
+
+#endif // ANDROID_GUI_BUFFERSLOTSET_H
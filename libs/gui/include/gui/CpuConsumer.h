@@ -21,9 +21,12 @@
 
 #include <gui/ConsumerBase.h>
 #include <gui/BufferQueue.h>
+#include <ui/BufferQueueDefs.h>
 
 #include <utils/Vector.h>
 
+#include <array>
+
 
 namespace android {
 
@@ -111,6 +114,25 @@ class CpuConsumer : public ConsumerBase
     // lockNextBuffer.
     status_t unlockBuffer(const LockedBuffer &nativeBuffer);
 
+    // Enables or disables persistent mappings, which are disabled by default.
+    //
+    // When enabled, a buffer stays locked for CPU reading from the first time
+    // it is acquired until it is freed, instead of being locked in
+    // lockNextBuffer and unlocked in unlockBuffer. lockNextBuffer then only
+    // waits for the acquire fence and makes the mapping observe the new
+    // content of the buffer with GraphicBufferMapper::rereadLockedBuffer, or
+    // maps the buffer again if the mapper does not support it. The data
+    // pointers of a buffer therefore stay the same from frame to frame.
+    //
+    // This is meant for producers that write to the buffers with a device,
+    // like camera and screen recording pipelines that cycle through a few
+    // buffers, since producers that lock the buffers for CPU writing would
+    // do so while the consumer still has them locked.
+    void setPersistentMappingsEnabled(bool enabled);
+
+  protected:
+    void freeBufferLocked(int slotIndex) override;
+
   private:
     // Maximum number of buffers that can be locked at a time
     const size_t mMaxLockedBuffers;
@@ -125,22 +147,49 @@ class CpuConsumer : public ConsumerBase
         int mSlot;
         sp<GraphicBuffer> mGraphicBuffer;
         uintptr_t mLockedBufferId;
+        // Whether the buffer is locked by a persistent mapping, which stays
+        // locked when the buffer is released.
+        bool mPersistent;
 
         AcquiredBuffer() :
                 mSlot(BufferQueue::INVALID_BUFFER_SLOT),
-                mLockedBufferId(kUnusedId) {
+                mLockedBufferId(kUnusedId),
+                mPersistent(false) {
         }
 
         void reset() {
             mSlot = BufferQueue::INVALID_BUFFER_SLOT;
             mGraphicBuffer.clear();
             mLockedBufferId = kUnusedId;
+            mPersistent = false;
         }
     };
 
+    // A buffer that is kept locked while persistent mappings are enabled.
+    struct PersistentMapping {
+        sp<GraphicBuffer> mGraphicBuffer;
+        // The data pointers, strides and flexible format of the buffer.
+        LockedBuffer mLockedBuffer;
+    };
+
     size_t findAcquiredBufferLocked(uintptr_t id) const;
 
+    // Locks a buffer and sets the data pointers, strides and format of the
+    // locked buffer structure.
+    status_t lockBuffer(const sp<GraphicBuffer>& buffer, const Rect& bounds,
+                        const sp<Fence>& fence, LockedBuffer* outBuffer) const;
     status_t lockBufferItem(const BufferItem& item, LockedBuffer* outBuffer) const;
+    status_t lockBufferItemPersistentLocked(const BufferItem& item, LockedBuffer* outBuffer);
+
+    // Unlocks the persistent mapping of a slot, or hands it over to the
+    // acquired buffer that still uses it, which then unlocks it on release.
+    void unmapLocked(int slot);
+
+    bool mPersistentMappingsEnabled = false;
+    // Set when the mapper first fails to reread a locked buffer, after which
+    // persistent mappings are locked again on every frame instead.
+    bool mRereadLockedBufferFailed = false;
+    std::array<PersistentMapping, BufferQueueDefs::NUM_BUFFER_SLOTS> mPersistentMappings;
 
     Vector<AcquiredBuffer> mAcquiredBuffers;
 
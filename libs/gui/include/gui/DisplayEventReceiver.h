@@ -32,6 +32,10 @@
 
 #include <ui/DisplayId.h>
 
+#include <atomic>
+#include <memory>
+#include <mutex>
+
 // ----------------------------------------------------------------------------
 
 namespace android {
@@ -46,6 +50,7 @@ using gui::VsyncEventData;
 
 namespace gui {
 class BitTube;
+class VsyncTimeline;
 } // namespace gui
 
 static inline constexpr uint32_t fourcc(char c1, char c2, char c3, char c4) {
@@ -184,14 +189,33 @@ public:
     status_t requestNextVsync();
 
     /**
-     * getLatestVsyncEventData() gets the latest vsync event data.
+     * getLatestVsyncEventData() gets the latest vsync event data. It is read from the vsync
+     * timeline when possible, see readVsyncTimeline(), and requested from SurfaceFlinger
+     * otherwise.
      */
     status_t getLatestVsyncEventData(ParcelableVsyncEventData* outVsyncEventData) const;
 
+    /**
+     * readVsyncTimeline() computes the vsync event data at the given time from the vsync timeline
+     * that SurfaceFlinger shares with its clients, without a binder call. This is only possible
+     * after a vsync event was received with getEvents(), and while SurfaceFlinger publishes frame
+     * timelines with the frame interval of that event.
+     * Returns NOT_ENOUGH_DATA if the vsync event data cannot be computed this way.
+     */
+    status_t readVsyncTimeline(nsecs_t now, VsyncEventData* outVsyncEventData) const;
+
 private:
     sp<IDisplayEventConnection> mEventConnection;
     std::unique_ptr<gui::BitTube> mDataChannel;
     std::optional<status_t> mInitError;
+
+    // The frame interval of the last vsync event that was received, or 0 if there was none.
+    std::atomic<int64_t> mLastFrameInterval = 0;
+
+    // Mapped on first use. The vsync timeline is not requested again once it failed.
+    mutable std::mutex mVsyncTimelineMutex;
+    mutable std::unique_ptr<gui::VsyncTimeline> mVsyncTimeline;
+    mutable bool mVsyncTimelineRequested = false;
 };
 
 inline bool operator==(DisplayEventReceiver::Event::FrameRateOverride lhs,
@@ -290,6 +290,18 @@ private:
             &fed->mReleaseFence
         }};
     }
+
+    // The timestamps in the order in which they are flattened. Only the ones that are not
+    // TIMESTAMP_PENDING are written, preceded by a mask of the ones that were.
+    template <typename ThisT>
+    static inline auto allTimestamps(ThisT fed) ->
+            std::array<decltype(&fed->mPostedTime), 6> {
+        return {{
+            &fed->mPostedTime, &fed->mRequestedPresentTime, &fed->mLatchTime,
+            &fed->mFirstRefreshStartTime, &fed->mLastRefreshStartTime,
+            &fed->mDequeueReadyTime
+        }};
+    }
 };
 
 
@@ -434,7 +434,10 @@ public:
         sp<TransactionCompletedListener> mTransactionCompletedListener = nullptr;
 
     protected:
-        std::unordered_map<sp<IBinder>, ComposerState, IBinderHash> mComposerStates;
+        // One state per layer, in the order in which the layers were first modified. Transactions
+        // rarely modify more than a few layers, so a linear search is cheaper than hashing, and the
+        // storage is kept when the transaction is cleared.
+        std::vector<ComposerState> mComposerStates;
         SortedVector<DisplayState> mDisplayStates;
         std::unordered_map<sp<ITransactionCompletedListener>, CallbackInfo, TCLHash>
                 mListenerCallbacks;
@@ -484,6 +487,7 @@ public:
         int mStatus = NO_ERROR;
 
         layer_state_t* getLayerState(const sp<SurfaceControl>& sc);
+        ComposerState* findComposerState(const sp<IBinder>& handle);
         DisplayState& getDisplayState(const sp<IBinder>& token);
 
         void cacheBuffers();
@@ -491,10 +495,20 @@ public:
         void setReleaseBufferCallback(BufferData*, ReleaseBufferCallback);
 
     public:
+        // Returns pooled transactions to the pool of the thread that releases them.
+        struct Recycler {
+            void operator()(Transaction* t) const;
+        };
+        using PooledTransaction = std::unique_ptr<Transaction, Recycler>;
+
         Transaction();
         virtual ~Transaction() = default;
         Transaction(Transaction const& other);
 
+        // Returns an empty transaction from a small per-thread pool. Recycled transactions keep
+        // the storage they grew, so that building and applying them does not allocate again.
+        static PooledTransaction obtain();
+
         // Factory method that creates a new Transaction instance from the parcel.
         static std::unique_ptr<Transaction> createFromParcel(const Parcel* parcel);
 
@@ -0,0 +1,101 @@
+/*
+ * Copyright 2024 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#pragma once
+
+#include <android-base/thread_annotations.h>
+#include <binder/Binder.h>
+#include <gui/SurfaceComposerClient.h>
+#include <utils/Singleton.h>
+
+#include <chrono>
+#include <condition_variable>
+#include <mutex>
+#include <thread>
+#include <unordered_set>
+
+namespace android {
+
+/*
+ * Merges the buffer transactions of several BLASTBufferQueues of a process, so that the frames they
+ * produce for the same vsync reach SurfaceFlinger in a single setTransactionState call.
+ *
+ * A pending merged transaction is applied once every registered queue has contributed to it, when a
+ * queue contributes a second frame or a frame for another vsync, or when the oldest transaction in
+ * it has waited for the maximum delay. All transactions are applied one-way on the apply token of
+ * the aggregator, which the participating queues must use for their other transactions as well, so
+ * that SurfaceFlinger applies them in order.
+ *
+ * The aggregator never calls back into the queues, so they may hold their own locks while they
+ * call it.
+ */
+class TransactionAggregator : public Singleton<TransactionAggregator> {
+public:
+    struct Stats {
+        // The number of transactions added by the queues.
+        uint64_t transactionCount = 0;
+        // The number of transactions applied to SurfaceFlinger.
+        uint64_t applyCount = 0;
+    };
+
+    // Frames that the queues of a process produce for the same vsync are usually queued within a
+    // couple of milliseconds of each other. Waiting longer would add latency to the frames of a
+    // queue whose siblings did not produce a frame for that vsync.
+    static constexpr std::chrono::nanoseconds kDefaultMaxDelay = std::chrono::milliseconds(2);
+
+    TransactionAggregator();
+    ~TransactionAggregator();
+
+    const sp<IBinder>& getApplyToken() const { return mApplyToken; }
+
+    void registerQueue(const void* queue);
+    /* Applies the pending transaction if the queue contributed to it. */
+    void unregisterQueue(const void* queue);
+
+    /* Merges the transaction of a registered queue into the pending transaction. The vsync id is
+     * the one of the frame timeline of the transaction, or FrameTimelineInfo::INVALID_VSYNC_ID.
+     */
+    void add(const void* queue, SurfaceComposerClient::Transaction&& t, int64_t vsyncId);
+
+    /* Applies the pending transaction, if any. */
+    void flush();
+
+    void setMaxDelay(std::chrono::nanoseconds maxDelay);
+    Stats getStats() const;
+
+private:
+    void run();
+    void flushLocked() REQUIRES(mMutex);
+
+    const sp<IBinder> mApplyToken = sp<BBinder>::make();
+
+    mutable std::mutex mMutex;
+    std::condition_variable mCondition;
+    std::thread mThread;
+    bool mDone GUARDED_BY(mMutex) = false;
+
+    std::chrono::nanoseconds mMaxDelay GUARDED_BY(mMutex);
+    std::unordered_set<const void*> mQueues GUARDED_BY(mMutex);
+
+    SurfaceComposerClient::Transaction mPendingTransaction GUARDED_BY(mMutex);
+    std::unordered_set<const void*> mPendingQueues GUARDED_BY(mMutex);
+    int64_t mPendingVsyncId GUARDED_BY(mMutex);
+    std::chrono::steady_clock::time_point mPendingSince GUARDED_BY(mMutex);
+
+    Stats mStats GUARDED_BY(mMutex);
+};
+
+} // namespace android
@@ -0,0 +1,109 @@
+/*
+ * Copyright 2024 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#pragma once
+
+#include <android-base/unique_fd.h>
+#include <gui/VsyncEventData.h>
+#include <utils/Errors.h>
+#include <utils/Timers.h>
+
+#include <cstdint>
+#include <memory>
+#include <string>
+
+namespace android::gui {
+
+/*
+ * A page of shared memory in which SurfaceFlinger publishes the vsync model of a display and the
+ * frame timelines of the last vsync event that it dispatched.
+ *
+ * Clients map the page read-only, and can get the frame timelines that are still ahead of them
+ * without a binder call to IDisplayEventConnection::getLatestVsyncEventData. The page is protected
+ * by a sequence lock: the publisher never waits for the readers, and a reader retries if the page
+ * was updated while it was being copied.
+ *
+ * The frame timelines are the ones of the vsync event, including their vsync ids, so they only
+ * apply to the clients that received vsync events with the same frame interval. The publishing
+ * side of the page is not thread-safe.
+ */
+class VsyncTimeline {
+public:
+    struct Snapshot {
+        // The period of the display vsync, as predicted by the vsync tracker. Clients that only
+        // need to estimate when they will next have to wake up can extrapolate with it.
+        int64_t vsyncPeriod;
+
+        // The durations that SurfaceFlinger uses to pick the preferred frame timeline.
+        int64_t workDuration;
+        int64_t readyDuration;
+
+        // The vsync data of the last vsync event, with the frame interval of that event.
+        VsyncEventData vsyncData;
+    };
+
+    ~VsyncTimeline();
+
+    /* Creates a new, writable page. Returns nullptr if the shared memory could not be allocated. */
+    static std::unique_ptr<VsyncTimeline> create(const std::string& name);
+
+    /* Maps a page created by another process, read-only.
+     * Returns nullptr if the file descriptor does not refer to a valid page.
+     */
+    static std::unique_ptr<VsyncTimeline> map(android::base::unique_fd fd);
+
+    /* Returns a duplicate of the file descriptor of the shared memory. */
+    android::base::unique_fd dupFd() const;
+
+    bool isWritable() const { return mWritable; }
+
+    /* Replaces the content of the page. */
+    void publish(const Snapshot& snapshot);
+
+    /* Marks the content of the page as no longer valid, until the next call to publish(). */
+    void invalidate();
+
+    /* Copies the content of the page.
+     *
+     * Return OK on success.
+     * Return NOT_ENOUGH_DATA if nothing is published.
+     * Return WOULD_BLOCK if the page kept changing while it was being read.
+     */
+    status_t read(Snapshot* outSnapshot) const;
+
+    /* Computes the vsync data that SurfaceFlinger would return at the given time from a snapshot:
+     * the frame timelines whose deadline is after that time, with the first one that leaves
+     * enough time for the work and ready durations as the preferred one.
+     *
+     * Returns false if the snapshot has no such frame timeline, because it is too old.
+     */
+    static bool predict(const Snapshot& snapshot, nsecs_t now, VsyncEventData* outVsyncEventData);
+
+private:
+    struct Page;
+
+    VsyncTimeline(android::base::unique_fd fd, void* data, size_t size, bool writable);
+
+    Page& getPage() const { return *static_cast<Page*>(mData); }
+    void write(const Snapshot* snapshot);
+
+    const android::base::unique_fd mFd;
+    void* const mData;
+    const size_t mSize;
+    const bool mWritable;
+};
+
+} // namespace android::gui
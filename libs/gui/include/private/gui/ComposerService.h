@@ -52,6 +52,10 @@ public:
     // Get a connection to the Composer Service.  This will block until
     // a connection is established. Returns null if permission is denied.
     static sp<ISurfaceComposer> getComposerService();
+
+    // Replaces the connection to the Composer Service, for tests and benchmarks. Passing null
+    // connects to the Composer Service again on the next call to getComposerService().
+    static void setComposerService(const sp<ISurfaceComposer>& composerService);
 };
 
 // ---------------------------------------------------------------------------
@@ -18,8 +18,10 @@
 
 #include <gui/BLASTBufferQueue.h>
 
+#include <android-base/scopeguard.h>
 #include <android-base/thread_annotations.h>
 #include <android/hardware/graphics/common/1.2/types.h>
+#include <binder/Binder.h>
 #include <gui/AidlStatusUtil.h>
 #include <gui/BufferQueueCore.h>
 #include <gui/BufferQueueProducer.h>
@@ -29,6 +31,7 @@
 #include <gui/Surface.h>
 #include <gui/SurfaceComposerClient.h>
 #include <gui/SyncScreenCaptureListener.h>
+#include <gui/TransactionAggregator.h>
 #include <gui/test/CallbackUtils.h>
 #include <private/gui/ComposerService.h>
 #include <private/gui/ComposerServiceAIDL.h>
@@ -43,6 +46,8 @@
 
 #include <gtest/gtest.h>
 
+#include <atomic>
+
 #include <com_android_graphics_libgui_flags.h>
 
 using namespace std::chrono_literals;
@@ -77,6 +82,47 @@ private:
     int32_t mNumReleased GUARDED_BY(mMutex) = 0;
 };
 
+// Forwards the calls of ISurfaceComposer to SurfaceFlinger, and counts the setTransactionState calls
+// among them. ISurfaceComposer::asInterface does not find a local interface in it, so the calls are
+// still written to a parcel by BpSurfaceComposer.
+class CountingComposerBinder : public BBinder {
+public:
+    explicit CountingComposerBinder(sp<IBinder> composer) : mComposer(std::move(composer)) {}
+
+    size_t getSetTransactionStateCount() const { return mSetTransactionStateCount; }
+
+protected:
+    status_t onTransact(uint32_t code, const Parcel& data, Parcel* reply,
+                        uint32_t flags) override {
+        if (code == ISurfaceComposer::SET_TRANSACTION_STATE) {
+            mSetTransactionStateCount++;
+        }
+        return mComposer->transact(code, data, reply, flags);
+    }
+
+private:
+    const sp<IBinder> mComposer;
+    std::atomic<size_t> mSetTransactionStateCount = 0;
+};
+
+// Routes the ISurfaceComposer calls of the process through a CountingComposerBinder while in scope.
+class CountingComposer {
+public:
+    CountingComposer()
+          : mComposer(ComposerService::getComposerService()),
+            mBinder(sp<CountingComposerBinder>::make(IInterface::asBinder(mComposer))) {
+        ComposerService::setComposerService(interface_cast<ISurfaceComposer>(mBinder));
+    }
+
+    ~CountingComposer() { ComposerService::setComposerService(mComposer); }
+
+    size_t getSetTransactionStateCount() const { return mBinder->getSetTransactionStateCount(); }
+
+private:
+    const sp<ISurfaceComposer> mComposer;
+    const sp<CountingComposerBinder> mBinder;
+};
+
 class TestBLASTBufferQueue : public BLASTBufferQueue {
 public:
     TestBLASTBufferQueue(const std::string& name, const sp<SurfaceControl>& surface, int width,
@@ -136,6 +182,10 @@ public:
 
     void clearSyncTransaction() { mBlastBufferQueueAdapter->clearSyncTransaction(); }
 
+    void setTransactionCoalescing(bool enabled) {
+        mBlastBufferQueueAdapter->setTransactionCoalescing(enabled);
+    }
+
     int getWidth() {
         std::scoped_lock lock(mBlastBufferQueueAdapter->mMutex);
         return mBlastBufferQueueAdapter->mSize.width;
@@ -510,6 +560,58 @@ TEST_F(BLASTBufferQueueTest, TripleBuffering) {
     adapter.waitForCallbacks();
 }
 
+TEST_F(BLASTBufferQueueTest, CoalescedTransactions) {
+    sp<SurfaceControl> secondSurface =
+            mClient->createSurface(String8("SecondTestSurface"), mDisplayWidth, mDisplayHeight,
+                                   PIXEL_FORMAT_RGBA_8888,
+                                   ISurfaceComposerClient::eFXSurfaceBufferState,
+                                   /*parent*/ mRootSurfaceControl->getHandle());
+    BLASTBufferQueueHelper adapter1(mSurfaceControl, mDisplayWidth, mDisplayHeight);
+    BLASTBufferQueueHelper adapter2(secondSurface, mDisplayWidth, mDisplayHeight);
+    sp<IGraphicBufferProducer> igbProducer1;
+    sp<IGraphicBufferProducer> igbProducer2;
+    setUpProducer(adapter1, igbProducer1);
+    setUpProducer(adapter2, igbProducer2);
+
+    auto queueAutoTimestampBuffer = [&](const sp<IGraphicBufferProducer>& igbProducer) {
+        int slot;
+        sp<Fence> fence;
+        sp<GraphicBuffer> buf;
+        auto ret = igbProducer->dequeueBuffer(&slot, &fence, mDisplayWidth, mDisplayHeight,
+                                              PIXEL_FORMAT_RGBA_8888, GRALLOC_USAGE_SW_WRITE_OFTEN,
+                                              nullptr, nullptr);
+        ASSERT_TRUE(ret == IGraphicBufferProducer::BUFFER_NEEDS_REALLOCATION || ret == NO_ERROR);
+        ASSERT_EQ(OK, igbProducer->requestBuffer(slot, &buf));
+        IGraphicBufferProducer::QueueBufferOutput qbOutput;
+        IGraphicBufferProducer::QueueBufferInput input(systemTime(), true /* autotimestamp */,
+                                                       HAL_DATASPACE_UNKNOWN,
+                                                       Rect(mDisplayWidth, mDisplayHeight),
+                                                       NATIVE_WINDOW_SCALING_MODE_FREEZE, 0,
+                                                       Fence::NO_FENCE);
+        ASSERT_EQ(OK, igbProducer->queueBuffer(slot, input, &qbOutput));
+    };
+
+    // Only apply the transactions once both queues have contributed a frame.
+    auto& aggregator = TransactionAggregator::getInstance();
+    aggregator.setMaxDelay(5s);
+    const auto restoreMaxDelay = base::make_scope_guard(
+            [&] { aggregator.setMaxDelay(TransactionAggregator::kDefaultMaxDelay); });
+    adapter1.setTransactionCoalescing(true);
+    adapter2.setTransactionCoalescing(true);
+
+    constexpr int kFrameCount = 10;
+    CountingComposer composer;
+    for (int frameNumber = 1; frameNumber <= kFrameCount; frameNumber++) {
+        ASSERT_NO_FATAL_FAILURE(queueAutoTimestampBuffer(igbProducer1));
+        ASSERT_NO_FATAL_FAILURE(queueAutoTimestampBuffer(igbProducer2));
+        adapter1.waitForCallback(frameNumber);
+        adapter2.waitForCallback(frameNumber);
+    }
+
+    // Each queue would otherwise have sent one transaction to SurfaceFlinger per frame.
+    EXPECT_EQ(static_cast<size_t>(kFrameCount), composer.getSetTransactionStateCount());
+}
+
 TEST_F(BLASTBufferQueueTest, SetCrop_Item) {
     uint8_t r = 255;
     uint8_t g = 0;
@@ -0,0 +1,130 @@
+/*
+ * Copyright 2024 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "MockConsumer.h"
+
+#include <benchmark/benchmark.h>
+#include <gui/BufferItem.h>
+#include <gui/BufferQueue.h>
+#include <gui/IProducerListener.h>
+#include <ui/GraphicBuffer.h>
+
+#include <atomic>
+#include <thread>
+
+namespace android {
+
+namespace {
+
+const IGraphicBufferProducer::QueueBufferInput QUEUE_INPUT(0, false, HAL_DATASPACE_UNKNOWN,
+                                                           Rect(0, 0, 1, 1),
+                                                           NATIVE_WINDOW_SCALING_MODE_FREEZE, 0,
+                                                           Fence::NO_FENCE);
+
+struct BufferQueuePair {
+    sp<IGraphicBufferProducer> producer;
+    sp<IGraphicBufferConsumer> consumer;
+
+    BufferQueuePair(int maxDequeuedBuffers) {
+        BufferQueue::createBufferQueue(&producer, &consumer);
+        consumer->consumerConnect(sp<MockConsumer>::make(), false);
+        IGraphicBufferProducer::QueueBufferOutput output;
+        producer->connect(sp<StubProducerListener>::make(), NATIVE_WINDOW_API_CPU, false, &output);
+        producer->setMaxDequeuedBufferCount(maxDequeuedBuffers);
+    }
+
+    ~BufferQueuePair() {
+        producer->disconnect(NATIVE_WINDOW_API_CPU);
+        consumer->consumerDisconnect();
+    }
+
+    status_t dequeueAndQueue() {
+        int slot;
+        sp<Fence> fence;
+        status_t result = producer->dequeueBuffer(&slot, &fence, 1, 1, 0,
+                                                  GRALLOC_USAGE_SW_READ_OFTEN, nullptr, nullptr);
+        if (result < 0) {
+            return result;
+        }
+        if (result & IGraphicBufferProducer::BUFFER_NEEDS_REALLOCATION) {
+            sp<GraphicBuffer> buffer;
+            if (status_t err = producer->requestBuffer(slot, &buffer); err != OK) {
+                return err;
+            }
+        }
+        IGraphicBufferProducer::QueueBufferOutput output;
+        return producer->queueBuffer(slot, QUEUE_INPUT, &output);
+    }
+
+    status_t acquireAndRelease() {
+        BufferItem item;
+        status_t result = consumer->acquireBuffer(&item, 0);
+        if (result != OK) {
+            return result;
+        }
+        return consumer->releaseBuffer(item.mSlot, item.mFrameNumber, EGL_NO_DISPLAY,
+                                       EGL_NO_SYNC_KHR, Fence::NO_FENCE);
+    }
+};
+
+} // namespace
+
+// A full round trip of a buffer through the queue on a single thread: the
+// cost of the slot bookkeeping without any contention on the core mutex.
+static void BM_BufferQueueRoundTrip(benchmark::State& state) {
+    BufferQueuePair queue(2);
+    for (auto _ : state) {
+        if (queue.dequeueAndQueue() != OK || queue.acquireAndRelease() != OK) {
+            state.SkipWithError("Buffer round trip failed");
+            return;
+        }
+    }
+}
+BENCHMARK(BM_BufferQueueRoundTrip);
+
+// The producer dequeues and queues buffers while a consumer thread acquires
+// and releases them as fast as it can, so the two sides contend on the core
+// mutex the way they do at high frame rates. The argument is the maximum
+// number of dequeued buffers.
+static void BM_BufferQueueContention(benchmark::State& state) {
+    BufferQueuePair queue(static_cast<int>(state.range(0)));
+    std::atomic<bool> running = true;
+    std::atomic<int64_t> consumed = 0;
+    std::thread consumerThread([&]() {
+        while (running.load(std::memory_order_relaxed)) {
+            if (queue.acquireAndRelease() == OK) {
+                consumed.fetch_add(1, std::memory_order_relaxed);
+            } else {
+                std::this_thread::yield();
+            }
+        }
+    });
+
+    for (auto _ : state) {
+        if (queue.dequeueAndQueue() != OK) {
+            state.SkipWithError("Could not dequeue and queue a buffer");
+            break;
+        }
+    }
+
+    running = false;
+    consumerThread.join();
+    state.counters["consumed"] =
+            benchmark::Counter(static_cast<double>(consumed.load()), benchmark::Counter::kIsRate);
+}
+BENCHMARK(BM_BufferQueueContention)->Arg(1)->Arg(2)->Arg(3)->UseRealTime();
+
+} // namespace android
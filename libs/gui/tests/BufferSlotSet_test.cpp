@@ -0,0 +1,110 @@
+/*
+ * Copyright 2024 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include <gui/BufferSlotSet.h>
+
+#include <gmock/gmock.h>
+#include <gtest/gtest.h>
+
+#include <algorithm>
+#include <vector>
+
+using testing::ElementsAre;
+using testing::IsEmpty;
+
+namespace android {
+
+TEST(BufferSlotSetTest, IteratesInIncreasingOrder) {
+    BufferSlotSet set;
+    ASSERT_TRUE(set.empty());
+
+    set.insert(63);
+    set.insert(5);
+    set.insert(0);
+    set.insert(5);
+    ASSERT_EQ(3u, set.size());
+    ASSERT_THAT(std::vector<int>(set.begin(), set.end()), ElementsAre(0, 5, 63));
+    ASSERT_EQ(0, *set.begin());
+}
+
+TEST(BufferSlotSetTest, EraseAndCount) {
+    BufferSlotSet set;
+    set.insert(1);
+    set.insert(2);
+    set.insert(3);
+
+    set.erase(set.begin());
+    set.erase(3);
+    set.erase(-1);
+    set.erase(64);
+    ASSERT_THAT(std::vector<int>(set.begin(), set.end()), ElementsAre(2));
+    ASSERT_EQ(0u, set.count(1));
+    ASSERT_EQ(1u, set.count(2));
+    ASSERT_EQ(0u, set.count(64));
+
+    set.clear();
+    ASSERT_TRUE(set.empty());
+}
+
+TEST(BufferSlotListTest, KeepsInsertionOrder) {
+    BufferSlotList list;
+    list.push_back(1);
+    list.push_back(2);
+    list.push_front(0);
+    ASSERT_THAT(std::vector<int>(list.begin(), list.end()), ElementsAre(0, 1, 2));
+    ASSERT_EQ(0, list.front());
+    ASSERT_EQ(2, list.back());
+
+    list.pop_front();
+    list.pop_back();
+    ASSERT_THAT(std::vector<int>(list.begin(), list.end()), ElementsAre(1));
+
+    list.pop_back();
+    list.pop_back();
+    ASSERT_TRUE(list.empty());
+}
+
+TEST(BufferSlotListTest, RemoveKeepsOrderOfOtherSlots) {
+    BufferSlotList list;
+    // Wrap around the end of the ring.
+    for (int s = 0; s < 10; s++) {
+        list.push_front(s);
+    }
+    list.remove(4);
+    list.remove(42);
+    ASSERT_THAT(std::vector<int>(list.begin(), list.end()),
+                ElementsAre(9, 8, 7, 6, 5, 3, 2, 1, 0));
+    ASSERT_NE(list.cend(), std::find(list.cbegin(), list.cend(), 3));
+    ASSERT_EQ(list.cend(), std::find(list.cbegin(), list.cend(), 4));
+}
+
+TEST(BufferSlotListTest, HoldsAllSlots) {
+    BufferSlotList list;
+    for (int s = 0; s < BufferQueueDefs::NUM_BUFFER_SLOTS; s++) {
+        list.push_back(s);
+    }
+    ASSERT_EQ(static_cast<size_t>(BufferQueueDefs::NUM_BUFFER_SLOTS), list.size());
+    for (int s = 0; s < BufferQueueDefs::NUM_BUFFER_SLOTS; s++) {
+        ASSERT_EQ(s, list.front());
+        list.pop_front();
+        list.push_back(s);
+    }
+    ASSERT_EQ(0, list.front());
+    list.clear();
+    ASSERT_THAT(std::vector<int>(list.begin(), list.end()), IsEmpty());
+}
+
+} // namespace android
@@ -25,6 +25,7 @@
 #endif
 
 #include <gtest/gtest.h>
+#include <inttypes.h>
 #include <gui/CpuConsumer.h>
 #include <gui/Surface.h>
 #include <ui/GraphicBuffer.h>
@@ -33,6 +34,10 @@
 #include <utils/Mutex.h>
 #include <utils/Condition.h>
 
+#include <chrono>
+#include <map>
+#include <set>
+#include <string>
 #include <thread>
 #include <vector>
 #define CPU_CONSUMER_TEST_FORMAT_RAW 0
@@ -474,10 +479,14 @@ void configureANW(const sp<ANativeWindow>& anw,
 }
 
 // Produce one frame of image data; assumes format and resolution configuration
-// is already done.
+// is already done. If writtenBufferIds is set, the image data is only written
+// to the buffers that are not in it yet, which are then added to it, and the ID
+// of the queued buffer is stored in outBufferId.
 void produceOneFrame(const sp<ANativeWindow>& anw,
         const CpuConsumerTestParams& params,
-        int64_t timestamp, uint32_t *stride) {
+        int64_t timestamp, uint32_t *stride,
+        std::set<uint64_t>* writtenBufferIds = nullptr,
+        uint64_t* outBufferId = nullptr) {
     status_t err;
     ANativeWindowBuffer* anb;
     ALOGVV("Dequeue buffer from %p", anw.get());
@@ -489,6 +498,16 @@ void produceOneFrame(const sp<ANativeWindow>& anw,
     sp<GraphicBuffer> buf(GraphicBuffer::from(anb));
 
     *stride = buf->getStride();
+    if (outBufferId) {
+        *outBufferId = buf->getId();
+    }
+    if (writtenBufferIds && !writtenBufferIds->insert(buf->getId()).second) {
+        err = native_window_set_buffers_timestamp(anw.get(), timestamp);
+        ASSERT_NO_ERROR(err, "set_buffers_timestamp error: ");
+        err = anw->queueBuffer(anw.get(), buf->getNativeBuffer(), -1);
+        ASSERT_NO_ERROR(err, "queueBuffer error:");
+        return;
+    }
     uint8_t* img = nullptr;
 
     ALOGVV("Lock buffer from %p for write", anw.get());
@@ -691,6 +710,78 @@ TEST_P(CpuConsumerTest, FromCpuInvalid) {
     ASSERT_EQ(BAD_VALUE, err) << "unlockBuffer did not fail";
 }
 
+// Produces and consumes frames one at a time, and returns the average time
+// that lockNextBuffer and unlockBuffer took per frame.
+//
+// With persistentMappings, the producer only writes each buffer once, before
+// the consumer first maps it, like a producer that writes with a device would
+// not lock it for CPU writing while the consumer keeps it mapped. The data
+// pointers of each buffer must then stay the same.
+static std::chrono::nanoseconds consumeFrames(const sp<ANativeWindow>& anw,
+        const sp<CpuConsumer>& cc, const CpuConsumerTestParams& params,
+        int frameCount, bool persistentMappings) {
+    std::chrono::nanoseconds lockDuration(0);
+    std::set<uint64_t> writtenBufferIds;
+    std::map<uint64_t, void*> dataByBufferId;
+    for (int i = 0; i < frameCount; i++) {
+        uint32_t stride;
+        uint64_t bufferId;
+        produceOneFrame(anw, params, i + 1, &stride,
+                persistentMappings ? &writtenBufferIds : nullptr, &bufferId);
+        if (::testing::Test::HasFatalFailure()) {
+            return lockDuration;
+        }
+
+        CpuConsumer::LockedBuffer b;
+        auto start = std::chrono::steady_clock::now();
+        status_t err = cc->lockNextBuffer(&b);
+        lockDuration += std::chrono::steady_clock::now() - start;
+        EXPECT_EQ(OK, err) << "lockNextBuffer error: " << strerror(-err);
+        if (err != OK) {
+            return lockDuration;
+        }
+
+        EXPECT_EQ(stride, b.stride);
+        EXPECT_EQ(i + 1, b.timestamp);
+        checkAnyBuffer(b, params.format);
+        if (persistentMappings) {
+            const auto [it, inserted] = dataByBufferId.emplace(bufferId, b.data);
+            EXPECT_EQ(it->second, b.data) << "the mapping of the buffer changed";
+        }
+
+        start = std::chrono::steady_clock::now();
+        err = cc->unlockBuffer(b);
+        lockDuration += std::chrono::steady_clock::now() - start;
+        EXPECT_EQ(OK, err) << "unlockBuffer error: " << strerror(-err);
+    }
+    return lockDuration / frameCount;
+}
+
+TEST_P(CpuConsumerTest, FromCpuPersistentMappings) {
+    CpuConsumerTestParams params = GetParam();
+    ASSERT_NO_FATAL_FAILURE(configureANW(mANW, params, params.maxLockedBuffers));
+
+    const int frameCount = 30;
+    const auto lockCost = consumeFrames(mANW, mCC, params, frameCount,
+            /*persistentMappings*/ false);
+    ASSERT_FALSE(HasFailure());
+
+    // The content of every frame must still be visible through the mappings
+    // that are kept from frame to frame.
+    mCC->setPersistentMappingsEnabled(true);
+    const auto persistentLockCost = consumeFrames(mANW, mCC, params, frameCount,
+            /*persistentMappings*/ true);
+    ASSERT_FALSE(HasFailure());
+    mCC->setPersistentMappingsEnabled(false);
+
+    ALOGD("Lock cost per frame: %" PRId64 " ns, with persistent mappings: %" PRId64 " ns",
+          static_cast<int64_t>(lockCost.count()),
+          static_cast<int64_t>(persistentLockCost.count()));
+    RecordProperty("lock_ns_per_frame", std::to_string(lockCost.count()));
+    RecordProperty("persistent_lock_ns_per_frame",
+                   std::to_string(persistentLockCost.count()));
+}
+
 TEST_P(CpuConsumerTest, FromCpuMultiThread) {
     CpuConsumerTestParams params = GetParam();
     ASSERT_NO_FATAL_FAILURE(configureANW(mANW, params, params.maxLockedBuffers + 1));
@@ -22,16 +22,20 @@
 
 #include <gtest/gtest.h>
 
+#include <binder/Binder.h>
+
 #include <utils/String8.h>
 #include <utils/threads.h>
 
 #include <ui/GraphicBuffer.h>
 
+#include <gui/BufferItem.h>
 #include <gui/BufferQueue.h>
 #include <gui/IProducerListener.h>
 
 #include <system/window.h>
 
+#include <chrono>
 #include <vector>
 
 #define ASSERT_OK(x) ASSERT_EQ(OK, (x))
@@ -70,6 +74,26 @@ namespace {
     const bool QUEUE_BUFFER_INPUT_GET_TIMESTAMPS = 0;
     const int QUEUE_BUFFER_INPUT_SLOT = -1;
 
+    // Forwards the transactions it receives to another binder, and counts
+    // them. A BpGraphicBufferProducer that talks to it marshals every call
+    // the way it would across processes.
+    class CountingBinder : public BBinder {
+    public:
+        explicit CountingBinder(sp<IBinder> target) : mTarget(std::move(target)) {}
+
+        status_t onTransact(uint32_t code, const Parcel& data, Parcel* reply,
+                            uint32_t flags) override {
+            mTransactionCount++;
+            return mTarget->transact(code, data, reply, flags);
+        }
+
+        size_t getTransactionCount() const { return mTransactionCount; }
+
+    private:
+        const sp<IBinder> mTarget;
+        size_t mTransactionCount = 0;
+    };
+
     // Enums to control which IGraphicBufferProducer backend to test.
     enum IGraphicBufferProducerTestCode {
         USE_BUFFER_QUEUE_PRODUCER = 0,
@@ -1091,6 +1115,174 @@ TEST_P(IGraphicBufferProducerTest, DetachThenAttach_Succeeds) {
     }
 }
 
+TEST_P(IGraphicBufferProducerTest, BatchedQueue_KeepsFrameOrder) {
+    ASSERT_NO_FATAL_FAILURE(ConnectProducer());
+    constexpr size_t BATCH_SIZE = 4;
+    ASSERT_OK(mProducer->setMaxDequeuedBufferCount(BATCH_SIZE));
+
+    IGraphicBufferProducer::DequeueBufferInput dequeueInput;
+    dequeueInput.width = DEFAULT_WIDTH;
+    dequeueInput.height = DEFAULT_HEIGHT;
+    dequeueInput.format = DEFAULT_FORMAT;
+    dequeueInput.usage = TEST_PRODUCER_USAGE_BITS;
+    dequeueInput.getTimestamps = false;
+    std::vector<IGraphicBufferProducer::DequeueBufferOutput> dequeueOutputs;
+    ASSERT_OK(mProducer->dequeueBuffers(std::vector(BATCH_SIZE, dequeueInput), &dequeueOutputs));
+    ASSERT_EQ(BATCH_SIZE, dequeueOutputs.size());
+
+    std::vector<int32_t> slots;
+    for (const auto& dequeueOutput : dequeueOutputs) {
+        ASSERT_OK(~IGraphicBufferProducer::BUFFER_NEEDS_REALLOCATION & dequeueOutput.result);
+        slots.push_back(dequeueOutput.slot);
+    }
+    std::vector<IGraphicBufferProducer::RequestBufferOutput> requestOutputs;
+    ASSERT_OK(mProducer->requestBuffers(slots, &requestOutputs));
+    ASSERT_EQ(BATCH_SIZE, requestOutputs.size());
+    for (const auto& requestOutput : requestOutputs) {
+        ASSERT_OK(requestOutput.result);
+        ASSERT_NE(nullptr, requestOutput.buffer);
+    }
+
+    std::vector<IGraphicBufferProducer::QueueBufferInput> queueInputs;
+    for (int32_t slot : slots) {
+        queueInputs.push_back(QueueBufferInputBuilder().setSlot(slot).build());
+    }
+    std::vector<IGraphicBufferProducer::QueueBufferOutput> queueOutputs;
+    ASSERT_OK(mProducer->queueBuffers(queueInputs, &queueOutputs));
+    ASSERT_EQ(BATCH_SIZE, queueOutputs.size());
+    for (size_t i = 0; i < BATCH_SIZE; i++) {
+        EXPECT_OK(queueOutputs[i].result);
+        EXPECT_EQ(i + 1, queueOutputs[i].numPendingBuffers);
+        EXPECT_EQ(i + 2, queueOutputs[i].nextFrameNumber);
+    }
+
+    // The consumer sees the frames in the order of the batch.
+    for (size_t i = 0; i < BATCH_SIZE; i++) {
+        BufferItem item;
+        ASSERT_OK(mConsumer->acquireBuffer(&item, 0));
+        EXPECT_EQ(slots[i], item.mSlot);
+        EXPECT_EQ(i + 1, item.mFrameNumber);
+        ASSERT_OK(mConsumer->releaseBuffer(item.mSlot, item.mFrameNumber, EGL_NO_DISPLAY,
+                                           EGL_NO_SYNC_KHR, Fence::NO_FENCE));
+    }
+
+    // A failure in the batch doesn't prevent the other buffers from being queued.
+    ASSERT_OK(mProducer->dequeueBuffers(std::vector(2, dequeueInput), &dequeueOutputs));
+    ASSERT_EQ(2u, dequeueOutputs.size());
+    slots = {dequeueOutputs[0].slot, dequeueOutputs[1].slot};
+    ASSERT_OK(mProducer->requestBuffers(slots, &requestOutputs));
+    queueInputs = {QueueBufferInputBuilder().setSlot(slots[0]).build(),
+                   QueueBufferInputBuilder().setSlot(BufferQueue::NUM_BUFFER_SLOTS).build(),
+                   QueueBufferInputBuilder().setSlot(slots[1]).build()};
+    ASSERT_OK(mProducer->queueBuffers(queueInputs, &queueOutputs));
+    ASSERT_EQ(3u, queueOutputs.size());
+    EXPECT_OK(queueOutputs[0].result);
+    EXPECT_EQ(BAD_VALUE, queueOutputs[1].result);
+    EXPECT_OK(queueOutputs[2].result);
+}
+
+TEST_P(IGraphicBufferProducerTest, BatchedOperations_UseOneTransactionPerBatch) {
+    ASSERT_NO_FATAL_FAILURE(ConnectProducer());
+    constexpr size_t BATCH_SIZE = 4;
+    constexpr int ITERATIONS = 50;
+    ASSERT_OK(mProducer->setMaxDequeuedBufferCount(BATCH_SIZE));
+    ASSERT_OK(mProducer->setAsyncMode(true));
+
+    sp<CountingBinder> binder = sp<CountingBinder>::make(IInterface::asBinder(mProducer));
+    sp<IGraphicBufferProducer> remoteProducer = interface_cast<IGraphicBufferProducer>(binder);
+    ASSERT_NE(nullptr, remoteProducer);
+
+    IGraphicBufferProducer::DequeueBufferInput dequeueInput;
+    dequeueInput.width = DEFAULT_WIDTH;
+    dequeueInput.height = DEFAULT_HEIGHT;
+    dequeueInput.format = DEFAULT_FORMAT;
+    dequeueInput.usage = TEST_PRODUCER_USAGE_BITS;
+    dequeueInput.getTimestamps = false;
+    const std::vector<IGraphicBufferProducer::DequeueBufferInput> dequeueInputs(BATCH_SIZE,
+                                                                                 dequeueInput);
+
+    // One frame of a stream that moves BATCH_SIZE buffers: dequeue all of them, request them,
+    // queue all but the last one, and cancel the last one.
+    auto runBatched = [&]() {
+        std::vector<IGraphicBufferProducer::DequeueBufferOutput> dequeueOutputs;
+        ASSERT_OK(remoteProducer->dequeueBuffers(dequeueInputs, &dequeueOutputs));
+        std::vector<int32_t> slots;
+        for (const auto& dequeueOutput : dequeueOutputs) {
+            ASSERT_OK(~IGraphicBufferProducer::BUFFER_NEEDS_REALLOCATION & dequeueOutput.result);
+            slots.push_back(dequeueOutput.slot);
+        }
+        std::vector<IGraphicBufferProducer::RequestBufferOutput> requestOutputs;
+        ASSERT_OK(remoteProducer->requestBuffers(slots, &requestOutputs));
+        std::vector<IGraphicBufferProducer::QueueBufferInput> queueInputs;
+        for (size_t i = 0; i + 1 < BATCH_SIZE; i++) {
+            queueInputs.push_back(QueueBufferInputBuilder().setSlot(slots[i]).build());
+        }
+        std::vector<IGraphicBufferProducer::QueueBufferOutput> queueOutputs;
+        ASSERT_OK(remoteProducer->queueBuffers(queueInputs, &queueOutputs));
+        for (const auto& queueOutput : queueOutputs) {
+            ASSERT_OK(queueOutput.result);
+        }
+        IGraphicBufferProducer::CancelBufferInput cancelInput;
+        cancelInput.slot = slots.back();
+        cancelInput.fence = Fence::NO_FENCE;
+        std::vector<status_t> cancelResults;
+        ASSERT_OK(remoteProducer->cancelBuffers({cancelInput}, &cancelResults));
+        ASSERT_OK(cancelResults[0]);
+    };
+    auto runSingle = [&]() {
+        std::vector<int> slots;
+        for (size_t i = 0; i < BATCH_SIZE; i++) {
+            int slot;
+            sp<Fence> fence;
+            ASSERT_OK(~IGraphicBufferProducer::BUFFER_NEEDS_REALLOCATION &
+                      remoteProducer->dequeueBuffer(&slot, &fence, DEFAULT_WIDTH, DEFAULT_HEIGHT,
+                                                    DEFAULT_FORMAT, TEST_PRODUCER_USAGE_BITS,
+                                                    nullptr, nullptr));
+            slots.push_back(slot);
+        }
+        for (int slot : slots) {
+            sp<GraphicBuffer> buffer;
+            ASSERT_OK(remoteProducer->requestBuffer(slot, &buffer));
+        }
+        for (size_t i = 0; i + 1 < BATCH_SIZE; i++) {
+            IGraphicBufferProducer::QueueBufferOutput queueOutput;
+            ASSERT_OK(remoteProducer->queueBuffer(slots[i], CreateBufferInput(), &queueOutput));
+        }
+        ASSERT_OK(remoteProducer->cancelBuffer(slots.back(), Fence::NO_FENCE));
+    };
+
+    // Allocate the buffers before measuring.
+    ASSERT_NO_FATAL_FAILURE(runSingle());
+
+    size_t transactionsBefore = binder->getTransactionCount();
+    auto start = std::chrono::steady_clock::now();
+    for (int i = 0; i < ITERATIONS; i++) {
+        ASSERT_NO_FATAL_FAILURE(runSingle());
+    }
+    const auto singleDuration = std::chrono::steady_clock::now() - start;
+    const size_t singleTransactions = binder->getTransactionCount() - transactionsBefore;
+
+    transactionsBefore = binder->getTransactionCount();
+    start = std::chrono::steady_clock::now();
+    for (int i = 0; i < ITERATIONS; i++) {
+        ASSERT_NO_FATAL_FAILURE(runBatched());
+    }
+    const auto batchedDuration = std::chrono::steady_clock::now() - start;
+    const size_t batchedTransactions = binder->getTransactionCount() - transactionsBefore;
+
+    EXPECT_EQ(ITERATIONS * (3 * BATCH_SIZE), singleTransactions);
+    EXPECT_EQ(ITERATIONS * 4u, batchedTransactions);
+
+    using std::chrono::duration_cast;
+    using std::chrono::nanoseconds;
+    RecordProperty("single_transactions_per_frame", singleTransactions / ITERATIONS);
+    RecordProperty("batched_transactions_per_frame", batchedTransactions / ITERATIONS);
+    RecordProperty("single_ns_per_frame",
+                   duration_cast<nanoseconds>(singleDuration).count() / ITERATIONS);
+    RecordProperty("batched_ns_per_frame",
+                   duration_cast<nanoseconds>(batchedDuration).count() / ITERATIONS);
+}
+
 INSTANTIATE_TEST_CASE_P(IGraphicBufferProducerBackends, IGraphicBufferProducerTest,
                         ::testing::Values(USE_BUFFER_QUEUE_PRODUCER));
 
@@ -42,6 +42,7 @@
 #include <utils/Errors.h>
 #include <utils/String8.h>
 
+#include <chrono>
 #include <limits>
 #include <thread>
 
@@ -2034,6 +2035,129 @@ TEST_F(GetFrameTimestampsTest, PresentUnsupportedNoSync) {
     EXPECT_EQ(-1, outDisplayPresentTime);
 }
 
+// Flattens a delta and unflattens it into another one, as it is sent from the
+// consumer to the producer. Returns the number of bytes that were flattened.
+static size_t sendFrameEventHistoryDelta(const FrameEventHistoryDelta& delta,
+        FrameEventHistoryDelta* outDelta) {
+    const size_t flattenedSize = delta.getFlattenedSize();
+    std::vector<uint8_t> data(flattenedSize);
+    std::vector<int> fds(delta.getFdCount());
+
+    void* buffer = data.data();
+    size_t size = data.size();
+    int* fdBuffer = fds.data();
+    size_t fdCount = fds.size();
+    EXPECT_EQ(NO_ERROR, delta.flatten(buffer, size, fdBuffer, fdCount));
+    EXPECT_EQ(0u, size);
+
+    const void* constBuffer = data.data();
+    size = data.size();
+    const int* constFds = fds.data();
+    fdCount = fds.size();
+    EXPECT_EQ(NO_ERROR, outDelta->unflatten(constBuffer, size, constFds, fdCount));
+    EXPECT_EQ(0u, size);
+    return flattenedSize;
+}
+
+// Verifies that the timestamps that are still pending are not flattened, and
+// that they are still pending once the delta has been applied by the producer.
+TEST_F(GetFrameTimestampsTest, DeltaOmitsPendingTimestamps) {
+    ConsumerFrameEventHistory consumerHistory;
+    FakeProducerFrameEventHistory producerHistory(&mFenceMap);
+
+    NewFrameEventsEntry newEntry;
+    newEntry.frameNumber = 1;
+    newEntry.postedTime = mFrames[0].kPostedTime;
+    newEntry.requestedPresentTime = mFrames[0].kRequestedPresentTime;
+    consumerHistory.addQueue(newEntry);
+
+    FrameEventHistoryDelta queueDelta;
+    consumerHistory.getAndResetDelta(&queueDelta);
+    FrameEventHistoryDelta receivedQueueDelta;
+    const size_t queueDeltaSize =
+            sendFrameEventHistoryDelta(queueDelta, &receivedQueueDelta);
+    producerHistory.applyDelta(receivedQueueDelta);
+
+    consumerHistory.addLatch(1, mFrames[0].kLatchTime);
+    FrameEventHistoryDelta latchDelta;
+    consumerHistory.getAndResetDelta(&latchDelta);
+    FrameEventHistoryDelta receivedLatchDelta;
+    const size_t latchDeltaSize =
+            sendFrameEventHistoryDelta(latchDelta, &receivedLatchDelta);
+    producerHistory.applyDelta(receivedLatchDelta);
+
+    // Only the latch time was added, so the second delta is one timestamp
+    // larger than the first one.
+    EXPECT_EQ(queueDeltaSize + sizeof(nsecs_t), latchDeltaSize);
+
+    const ::android::FrameEvents* frame = producerHistory.getFrame(1);
+    ASSERT_NE(nullptr, frame);
+    EXPECT_EQ(mFrames[0].kPostedTime, frame->postedTime);
+    EXPECT_EQ(mFrames[0].kRequestedPresentTime, frame->requestedPresentTime);
+    EXPECT_EQ(mFrames[0].kLatchTime, frame->latchTime);
+    EXPECT_EQ(::android::FrameEvents::TIMESTAMP_PENDING,
+            frame->firstRefreshStartTime);
+    EXPECT_EQ(::android::FrameEvents::TIMESTAMP_PENDING,
+            frame->lastRefreshStartTime);
+    EXPECT_EQ(::android::FrameEvents::TIMESTAMP_PENDING,
+            frame->dequeueReadyTime);
+}
+
+// Measures the cost of the frame timestamps of a frame once they are enabled:
+// recording its events in the consumer history, and sending the deltas that
+// the producer gets on queue and dequeue.
+TEST_F(GetFrameTimestampsTest, EnabledTimestampsOverhead) {
+    constexpr uint64_t kFrameCount = 10000;
+    ConsumerFrameEventHistory consumerHistory;
+    FakeProducerFrameEventHistory producerHistory(&mFenceMap);
+    const CompositorTiming compositorTiming = makeCompositorTiming();
+
+    size_t flattenedSize = 0;
+    const auto start = std::chrono::steady_clock::now();
+    for (uint64_t frameNumber = 1; frameNumber <= kFrameCount; frameNumber++) {
+        const nsecs_t frameTime = static_cast<nsecs_t>(frameNumber) * 1000;
+        NewFrameEventsEntry newEntry;
+        newEntry.frameNumber = frameNumber;
+        newEntry.postedTime = frameTime;
+        newEntry.requestedPresentTime = frameTime + 1;
+        consumerHistory.addQueue(newEntry);
+
+        FrameEventHistoryDelta queueDelta;
+        consumerHistory.getAndResetDelta(&queueDelta);
+        FrameEventHistoryDelta receivedQueueDelta;
+        flattenedSize += sendFrameEventHistoryDelta(queueDelta, &receivedQueueDelta);
+        producerHistory.applyDelta(receivedQueueDelta);
+
+        consumerHistory.addLatch(frameNumber, frameTime + 2);
+        consumerHistory.addPreComposition(frameNumber, frameTime + 3);
+        consumerHistory.addPostComposition(frameNumber, FenceTime::NO_FENCE,
+                FenceTime::NO_FENCE, compositorTiming);
+        if (frameNumber > 1) {
+            consumerHistory.addRelease(frameNumber - 1, frameTime + 4,
+                    std::shared_ptr<FenceTime>(FenceTime::NO_FENCE));
+        }
+
+        FrameEventHistoryDelta dequeueDelta;
+        consumerHistory.getAndResetDelta(&dequeueDelta);
+        FrameEventHistoryDelta receivedDequeueDelta;
+        flattenedSize += sendFrameEventHistoryDelta(dequeueDelta, &receivedDequeueDelta);
+        producerHistory.applyDelta(receivedDequeueDelta);
+    }
+    const auto elapsed = std::chrono::steady_clock::now() - start;
+
+    const ::android::FrameEvents* frame = producerHistory.getFrame(kFrameCount);
+    ASSERT_NE(nullptr, frame);
+    const nsecs_t lastFrameTime = static_cast<nsecs_t>(kFrameCount) * 1000;
+    EXPECT_EQ(lastFrameTime + 2, frame->latchTime);
+    EXPECT_EQ(lastFrameTime + 3, frame->lastRefreshStartTime);
+
+    const auto nsPerFrame =
+            std::chrono::duration_cast<std::chrono::nanoseconds>(elapsed).count() /
+            static_cast<int64_t>(kFrameCount);
+    RecordProperty("ns_per_frame", std::to_string(nsPerFrame));
+    RecordProperty("bytes_per_frame", std::to_string(flattenedSize / kFrameCount));
+}
+
 TEST_F(SurfaceTest, DequeueWithConsumerDrivenSize) {
     sp<IGraphicBufferProducer> producer;
     sp<IGraphicBufferConsumer> consumer;
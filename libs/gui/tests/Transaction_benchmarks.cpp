@@ -0,0 +1,147 @@
+/*
+ * Copyright 2024 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include <benchmark/benchmark.h>
+#include <binder/Binder.h>
+#include <gui/ISurfaceComposer.h>
+#include <gui/SurfaceComposerClient.h>
+#include <gui/SurfaceControl.h>
+#include <private/gui/ComposerService.h>
+
+#include <string>
+#include <vector>
+
+namespace android {
+
+namespace {
+
+using Transaction = SurfaceComposerClient::Transaction;
+
+// Swallows the transactions that it receives. ISurfaceComposer::asInterface does not find a local
+// interface in it, so the transactions are still written to a parcel by BpSurfaceComposer.
+class FakeComposerBinder : public BBinder {
+public:
+    size_t getTransactionCount() const { return mTransactionCount; }
+
+protected:
+    status_t onTransact(uint32_t, const Parcel&, Parcel*, uint32_t) override {
+        mTransactionCount++;
+        return NO_ERROR;
+    }
+
+private:
+    size_t mTransactionCount = 0;
+};
+
+class FakeComposer {
+public:
+    FakeComposer() : mBinder(sp<FakeComposerBinder>::make()) {
+        ComposerService::setComposerService(interface_cast<ISurfaceComposer>(mBinder));
+    }
+
+    ~FakeComposer() { ComposerService::setComposerService(nullptr); }
+
+    size_t getTransactionCount() const { return mBinder->getTransactionCount(); }
+
+private:
+    const sp<FakeComposerBinder> mBinder;
+};
+
+std::vector<sp<SurfaceControl>> createSurfaceControls(size_t count) {
+    std::vector<sp<SurfaceControl>> surfaceControls;
+    surfaceControls.reserve(count);
+    for (size_t i = 0; i < count; i++) {
+        surfaceControls.push_back(sp<SurfaceControl>::make(nullptr, sp<BBinder>::make(),
+                                                           static_cast<int32_t>(i),
+                                                           "Layer#" + std::to_string(i)));
+    }
+    return surfaceControls;
+}
+
+} // namespace
+
+// Builds a transaction that moves the given number of layers.
+static void BM_TransactionSetPosition(benchmark::State& state) {
+    const auto surfaceControls = createSurfaceControls(static_cast<size_t>(state.range(0)));
+    Transaction t;
+    float position = 0.f;
+    for (auto _ : state) {
+        for (const auto& sc : surfaceControls) {
+            t.setPosition(sc, position, position);
+        }
+        position += 1.f;
+        benchmark::DoNotOptimize(t);
+        t.clear();
+    }
+}
+BENCHMARK(BM_TransactionSetPosition)->Arg(1)->Arg(8)->Arg(64);
+
+// Merges a transaction that moves the given number of layers into one that moves the same layers.
+static void BM_TransactionMerge(benchmark::State& state) {
+    const auto surfaceControls = createSurfaceControls(static_cast<size_t>(state.range(0)));
+    Transaction t;
+    Transaction other;
+    for (auto _ : state) {
+        state.PauseTiming();
+        for (const auto& sc : surfaceControls) {
+            t.setPosition(sc, 1.f, 1.f);
+            other.setPosition(sc, 2.f, 2.f);
+        }
+        state.ResumeTiming();
+        t.merge(std::move(other));
+        benchmark::DoNotOptimize(t);
+        state.PauseTiming();
+        t.clear();
+        state.ResumeTiming();
+    }
+}
+BENCHMARK(BM_TransactionMerge)->Arg(1)->Arg(8)->Arg(64);
+
+// Builds and applies a new transaction per iteration, as most clients do.
+static void BM_TransactionApply(benchmark::State& state) {
+    FakeComposer composer;
+    const auto surfaceControls = createSurfaceControls(static_cast<size_t>(state.range(0)));
+    for (auto _ : state) {
+        Transaction t;
+        for (const auto& sc : surfaceControls) {
+            t.setPosition(sc, 1.f, 1.f);
+        }
+        t.apply(/*synchronous=*/false, /*oneWay=*/true);
+    }
+    if (composer.getTransactionCount() != static_cast<size_t>(state.iterations())) {
+        state.SkipWithError("The fake composer did not receive every transaction");
+    }
+}
+BENCHMARK(BM_TransactionApply)->Arg(1)->Arg(8)->Arg(64);
+
+// Same as BM_TransactionApply, with transactions from the pool of the thread.
+static void BM_TransactionApplyPooled(benchmark::State& state) {
+    FakeComposer composer;
+    const auto surfaceControls = createSurfaceControls(static_cast<size_t>(state.range(0)));
+    for (auto _ : state) {
+        auto t = Transaction::obtain();
+        for (const auto& sc : surfaceControls) {
+            t->setPosition(sc, 1.f, 1.f);
+        }
+        t->apply(/*synchronous=*/false, /*oneWay=*/true);
+    }
+    if (composer.getTransactionCount() != static_cast<size_t>(state.iterations())) {
+        state.SkipWithError("The fake composer did not receive every transaction");
+    }
+}
+BENCHMARK(BM_TransactionApplyPooled)->Arg(1)->Arg(8)->Arg(64);
+
+} // namespace android
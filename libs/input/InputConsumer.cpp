@@ -361,7 +361,8 @@ status_t InputConsumer::consume(InputEventFactoryInterface* factory, bool consum
             }
 
             case InputMessage::Type::FINISHED:
-            case InputMessage::Type::TIMELINE: {
+            case InputMessage::Type::TIMELINE:
+            case InputMessage::Type::MOTION_SAMPLE: {
                 LOG(FATAL) << "Consumed a " << ftl::enum_string(mMsg.header.type)
                            << " message, which should never be seen by "
                               "InputConsumer on "
@@ -955,6 +956,12 @@ std::string InputConsumer::dump() const {
                                                        toString(msg.body.touchMode.isInTouchMode));
                     break;
                 }
+                case InputMessage::Type::MOTION_SAMPLE: {
+                    out += android::base::StringPrintf("slot=%" PRIu32 ", generation=%" PRIu32,
+                                                       msg.body.motionSample.slot,
+                                                       msg.body.motionSample.generation);
+                    break;
+                }
             }
             out += "\n";
         }
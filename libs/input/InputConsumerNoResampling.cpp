@@ -44,6 +44,12 @@ namespace {
 const bool DEBUG_TRANSPORT_CONSUMER =
         __android_log_is_loggable(ANDROID_LOG_DEBUG, LOG_TAG "Consumer", ANDROID_LOG_INFO);
 
+/**
+ * The number of messages that readAllMessages tries to read from the channel with each system
+ * call.
+ */
+constexpr size_t MESSAGE_READ_BATCH_SIZE = 8;
+
 std::unique_ptr<KeyEvent> createKeyEvent(const InputMessage& msg) {
     std::unique_ptr<KeyEvent> event = std::make_unique<KeyEvent>();
     event->initialize(msg.body.key.eventId, msg.body.key.deviceId, msg.body.key.source,
@@ -362,20 +368,33 @@ void InputConsumerNoResampling::handleMessages(std::vector<InputMessage>&& messa
 std::vector<InputMessage> InputConsumerNoResampling::readAllMessages() {
     std::vector<InputMessage> messages;
     while (true) {
-        InputMessage msg;
-        status_t result = mChannel->receiveMessage(&msg);
+        // Read the pending messages in batches, directly into the returned vector.
+        const size_t offset = messages.size();
+        messages.resize(offset + MESSAGE_READ_BATCH_SIZE);
+        size_t receivedCount;
+        status_t result = mChannel->receiveMessages(std::span(messages).subspan(offset),
+                                                    receivedCount);
+        messages.resize(offset + receivedCount);
+        const nsecs_t consumeTime = systemTime(SYSTEM_TIME_MONOTONIC);
+        for (size_t i = offset; i < messages.size(); i++) {
+            const InputMessage& msg = messages[i];
+            const auto [_, inserted] = mConsumeTimes.emplace(msg.header.seq, consumeTime);
+            LOG_ALWAYS_FATAL_IF(!inserted, "Already have a consume time for seq=%" PRIu32,
+                                msg.header.seq);
+
+            // Trace the event processing timeline - event was just read from the socket
+            // TODO(b/329777420): distinguish between multiple instances of InputConsumer
+            // in the same process.
+            ATRACE_ASYNC_BEGIN("InputConsumer processing", /*cookie=*/msg.header.seq);
+        }
         switch (result) {
             case OK: {
-                const auto [_, inserted] =
-                        mConsumeTimes.emplace(msg.header.seq, systemTime(SYSTEM_TIME_MONOTONIC));
-                LOG_ALWAYS_FATAL_IF(!inserted, "Already have a consume time for seq=%" PRIu32,
-                                    msg.header.seq);
-
-                // Trace the event processing timeline - event was just read from the socket
-                // TODO(b/329777420): distinguish between multiple instances of InputConsumer
-                // in the same process.
-                ATRACE_ASYNC_BEGIN("InputConsumer processing", /*cookie=*/msg.header.seq);
-                messages.push_back(msg);
+                if (receivedCount < MESSAGE_READ_BATCH_SIZE &&
+                    !mChannel->hasUnprocessedMessages()) {
+                    // The socket has been drained. Avoid an extra system call that would only
+                    // return WOULD_BLOCK.
+                    return messages;
+                }
                 break;
             }
             case WOULD_BLOCK: {
@@ -412,7 +431,8 @@ void InputConsumerNoResampling::handleMessage(const InputMessage& msg) const {
         }
 
         case InputMessage::Type::FINISHED:
-        case InputMessage::Type::TIMELINE: {
+        case InputMessage::Type::TIMELINE:
+        case InputMessage::Type::MOTION_SAMPLE: {
             LOG(FATAL) << "Consumed a " << ftl::enum_string(msg.header.type)
                        << " message, which should never be seen by InputConsumer on "
                        << mChannel->getName();
@@ -0,0 +1,248 @@
+/*
+ * Copyright (C) 2024 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#define LOG_TAG "InputSampleRing"
+
+#include <fcntl.h>
+#include <inttypes.h>
+#include <sys/mman.h>
+
+#include <atomic>
+#include <cstddef>
+#include <cstring>
+#include <new>
+
+#include <android-base/logging.h>
+#include <cutils/ashmem.h>
+#include <log/log.h>
+
+#include <input/InputSampleRing.h>
+
+namespace android {
+
+namespace {
+
+// "INSR", to detect file descriptors that do not refer to a sample ring.
+constexpr uint32_t RING_MAGIC = 0x494e5352;
+// Incremented whenever the layout of the ring changes.
+constexpr uint32_t RING_VERSION = 1;
+// Keep the amount of shared memory per channel bounded, even if a large capacity is requested.
+constexpr uint32_t MAX_RING_CAPACITY = 256;
+
+} // namespace
+
+struct InputSampleRing::Header {
+    uint32_t magic;
+    uint32_t version;
+    uint32_t capacity;
+    uint32_t slotSize;
+};
+
+/**
+ * A slot holds one motion message. The generation identifies the message that is stored in the
+ * slot, and is 0 while the slot is being written.
+ */
+struct InputSampleRing::Slot {
+    std::atomic<uint32_t> generation;
+    uint32_t size;
+    InputMessage message;
+};
+
+// The ring is shared between processes, so its atomics must not rely on a lock.
+static_assert(std::atomic<uint32_t>::is_always_lock_free);
+
+size_t InputSampleRing::getSlotsOffset() {
+    return (sizeof(Header) + alignof(Slot) - 1) / alignof(Slot) * alignof(Slot);
+}
+
+size_t InputSampleRing::getRingSize(uint32_t capacity) {
+    return getSlotsOffset() + sizeof(Slot) * capacity;
+}
+
+InputSampleRing::InputSampleRing(android::base::unique_fd fd, void* data, size_t size,
+                                 uint32_t capacity, bool writable)
+      : mFd(std::move(fd)), mData(data), mSize(size), mCapacity(capacity), mWritable(writable) {
+    if (mWritable) {
+        mFreeSlots.reserve(mCapacity);
+        // Hand out the slots in increasing order.
+        for (uint32_t i = mCapacity; i > 0; i--) {
+            mFreeSlots.push_back(i - 1);
+        }
+    }
+}
+
+InputSampleRing::~InputSampleRing() {
+    munmap(mData, mSize);
+}
+
+std::unique_ptr<InputSampleRing> InputSampleRing::create(const std::string& name,
+                                                         uint32_t capacity) {
+    if (capacity == 0 || capacity > MAX_RING_CAPACITY) {
+        ALOGE("Invalid sample ring capacity %" PRIu32 " for '%s'", capacity, name.c_str());
+        return nullptr;
+    }
+    const size_t size = getRingSize(capacity);
+    android::base::unique_fd fd(ashmem_create_region(name.c_str(), size));
+    if (!fd.ok()) {
+        ALOGE("Could not allocate a sample ring of %zu bytes for '%s': %s", size, name.c_str(),
+              strerror(errno));
+        return nullptr;
+    }
+    void* data = mmap(nullptr, size, PROT_READ | PROT_WRITE, MAP_SHARED, fd.get(), 0);
+    if (data == MAP_FAILED) {
+        ALOGE("Could not map the sample ring for '%s': %s", name.c_str(), strerror(errno));
+        return nullptr;
+    }
+    // Any other mapping of the ring, including the one of the consumer, is read-only.
+    if (ashmem_set_prot_region(fd.get(), PROT_READ) != 0) {
+        ALOGE("Could not restrict the protection of the sample ring for '%s': %s", name.c_str(),
+              strerror(errno));
+        munmap(data, size);
+        return nullptr;
+    }
+
+    new (data) Header{.magic = RING_MAGIC,
+                      .version = RING_VERSION,
+                      .capacity = capacity,
+                      .slotSize = sizeof(Slot)};
+    std::byte* slots = static_cast<std::byte*>(data) + getSlotsOffset();
+    for (uint32_t i = 0; i < capacity; i++) {
+        Slot* slot = reinterpret_cast<Slot*>(slots + sizeof(Slot) * i);
+        new (&slot->generation) std::atomic<uint32_t>(0);
+        slot->size = 0;
+    }
+    // using 'new' to access a non-public constructor
+    return std::unique_ptr<InputSampleRing>(
+            new InputSampleRing(std::move(fd), data, size, capacity, /*writable=*/true));
+}
+
+std::unique_ptr<InputSampleRing> InputSampleRing::map(android::base::unique_fd fd) {
+    const int size = ashmem_get_size_region(fd.get());
+    if (size < 0 || static_cast<size_t>(size) < sizeof(Header)) {
+        ALOGE("Invalid sample ring size %d", size);
+        return nullptr;
+    }
+    void* data = mmap(nullptr, size, PROT_READ, MAP_SHARED, fd.get(), 0);
+    if (data == MAP_FAILED) {
+        ALOGE("Could not map the sample ring: %s", strerror(errno));
+        return nullptr;
+    }
+    const Header& header = *static_cast<const Header*>(data);
+    if (header.magic != RING_MAGIC || header.version != RING_VERSION ||
+        header.slotSize != sizeof(Slot) || header.capacity == 0 ||
+        header.capacity > MAX_RING_CAPACITY ||
+        getRingSize(header.capacity) > static_cast<size_t>(size)) {
+        ALOGE("Invalid sample ring: magic=0x%08" PRIx32 ", version=%" PRIu32
+              ", capacity=%" PRIu32 ", slotSize=%" PRIu32 ", size=%d",
+              header.magic, header.version, header.capacity, header.slotSize, size);
+        munmap(data, size);
+        return nullptr;
+    }
+    // using 'new' to access a non-public constructor
+    return std::unique_ptr<InputSampleRing>(
+            new InputSampleRing(std::move(fd), data, size, header.capacity, /*writable=*/false));
+}
+
+android::base::unique_fd InputSampleRing::dupFd() const {
+    android::base::unique_fd newFd(fcntl(mFd.get(), F_DUPFD_CLOEXEC, 0));
+    if (!newFd.ok()) {
+        ALOGE("Could not duplicate the sample ring fd %d: %s", mFd.get(), strerror(errno));
+    }
+    return newFd;
+}
+
+InputSampleRing::Slot& InputSampleRing::getSlot(uint32_t index) const {
+    std::byte* slots = static_cast<std::byte*>(mData) + getSlotsOffset();
+    return *reinterpret_cast<Slot*>(slots + sizeof(Slot) * index);
+}
+
+bool InputSampleRing::writeSample(const InputMessage& msg, InputMessage& outReference) {
+    LOG_IF(FATAL, !mWritable) << "Attempted to write to a read-only sample ring";
+    if (msg.header.type != InputMessage::Type::MOTION || mFreeSlots.empty() ||
+        mSlotBySeq.find(msg.header.seq) != mSlotBySeq.end()) {
+        return false;
+    }
+    const uint32_t index = mFreeSlots.back();
+    mFreeSlots.pop_back();
+    mSlotBySeq.emplace(msg.header.seq, index);
+
+    const uint32_t generation = mNextGeneration;
+    mNextGeneration = mNextGeneration == UINT32_MAX ? 1 : mNextGeneration + 1;
+
+    Slot& slot = getSlot(index);
+    slot.generation.store(0, std::memory_order_relaxed);
+    std::atomic_thread_fence(std::memory_order_release);
+    msg.getSanitizedCopy(&slot.message);
+    slot.size = msg.size();
+    slot.generation.store(generation, std::memory_order_release);
+
+    outReference = {};
+    outReference.header.type = InputMessage::Type::MOTION_SAMPLE;
+    outReference.header.seq = msg.header.seq;
+    outReference.body.motionSample.slot = index;
+    outReference.body.motionSample.generation = generation;
+    return true;
+}
+
+void InputSampleRing::releaseSample(uint32_t seq) {
+    auto it = mSlotBySeq.find(seq);
+    if (it == mSlotBySeq.end()) {
+        return;
+    }
+    mFreeSlots.push_back(it->second);
+    mSlotBySeq.erase(it);
+}
+
+status_t InputSampleRing::readSample(const InputMessage& reference, InputMessage& outMsg) const {
+    if (reference.header.type != InputMessage::Type::MOTION_SAMPLE) {
+        return BAD_VALUE;
+    }
+    // The reference may be the same object as outMsg.
+    const uint32_t seq = reference.header.seq;
+    const uint32_t index = reference.body.motionSample.slot;
+    const uint32_t generation = reference.body.motionSample.generation;
+    if (index >= mCapacity || generation == 0) {
+        ALOGE("Received invalid MOTION_SAMPLE: slot=%" PRIu32 ", generation=%" PRIu32, index,
+              generation);
+        return BAD_VALUE;
+    }
+
+    const Slot& slot = getSlot(index);
+    if (slot.generation.load(std::memory_order_acquire) != generation) {
+        ALOGE("Sample ring slot %" PRIu32 " does not hold generation %" PRIu32, index, generation);
+        return BAD_VALUE;
+    }
+    const size_t size = slot.size;
+    if (size > sizeof(InputMessage)) {
+        ALOGE("Sample ring slot %" PRIu32 " has invalid size %zu", index, size);
+        return BAD_VALUE;
+    }
+    memcpy(&outMsg, &slot.message, size);
+    std::atomic_thread_fence(std::memory_order_acquire);
+    if (slot.generation.load(std::memory_order_relaxed) != generation) {
+        ALOGE("Sample ring slot %" PRIu32 " was overwritten while being read", index);
+        return BAD_VALUE;
+    }
+
+    if (outMsg.header.type != InputMessage::Type::MOTION || outMsg.header.seq != seq ||
+        !outMsg.isValid(size)) {
+        ALOGE("Sample ring slot %" PRIu32 " holds an invalid message", index);
+        return BAD_VALUE;
+    }
+    return OK;
+}
+
+} // namespace android
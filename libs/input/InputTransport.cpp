@@ -14,6 +14,9 @@
 #include <sys/socket.h>
 #include <sys/types.h>
 #include <unistd.h>
+#include <algorithm>
+#include <array>
+#include <iterator>
 
 #include <android-base/logging.h>
 #include <android-base/properties.h>
@@ -25,6 +28,7 @@
 #include <utils/Trace.h>
 
 #include <com_android_input_flags.h>
+#include <input/InputSampleRing.h>
 #include <input/InputTransport.h>
 #include <input/PrintTools.h>
 #include <input/TraceTools.h>
@@ -73,6 +77,13 @@ bool debugTransportPublisher() {
     return __android_log_is_loggable(ANDROID_LOG_DEBUG, LOG_TAG "Publisher", ANDROID_LOG_INFO);
 }
 
+/**
+ * The maximum number of messages that are sent or received with a single system call by
+ * InputChannel::sendMessages and InputChannel::receiveMessages. The socket buffer only fits a
+ * handful of large messages, so larger batches would rarely be filled.
+ */
+constexpr size_t MAX_MESSAGE_BATCH_SIZE = 8;
+
 android::base::unique_fd dupChannelFd(int fd) {
     android::base::unique_fd newFd(::dup(fd));
     if (!newFd.ok()) {
@@ -132,6 +143,7 @@ bool InputMessage::isValid(size_t actualSize) const {
         case Type::CAPTURE:
         case Type::DRAG:
         case Type::TOUCH_MODE:
+        case Type::MOTION_SAMPLE:
             return true;
         case Type::TIMELINE: {
             const nsecs_t gpuCompletedTime =
@@ -169,6 +181,8 @@ size_t InputMessage::size() const {
             return sizeof(Header) + body.timeline.size();
         case Type::TOUCH_MODE:
             return sizeof(Header) + body.touchMode.size();
+        case Type::MOTION_SAMPLE:
+            return sizeof(Header) + body.motionSample.size();
     }
     return sizeof(Header);
 }
@@ -317,6 +331,12 @@ void InputMessage::getSanitizedCopy(InputMessage* msg) const {
         case InputMessage::Type::TOUCH_MODE: {
             msg->body.touchMode.eventId = body.touchMode.eventId;
             msg->body.touchMode.isInTouchMode = body.touchMode.isInTouchMode;
+            break;
+        }
+        case InputMessage::Type::MOTION_SAMPLE: {
+            msg->body.motionSample.slot = body.motionSample.slot;
+            msg->body.motionSample.generation = body.motionSample.generation;
+            break;
         }
     }
 }
@@ -324,7 +344,8 @@ void InputMessage::getSanitizedCopy(InputMessage* msg) const {
 // --- InputChannel ---
 
 std::unique_ptr<InputChannel> InputChannel::create(const std::string& name,
-                                                   android::base::unique_fd fd, sp<IBinder> token) {
+                                                   android::base::unique_fd fd, sp<IBinder> token,
+                                                   std::shared_ptr<InputSampleRing> sampleRing) {
     const int result = fcntl(fd, F_SETFL, O_NONBLOCK);
     if (result != 0) {
         LOG_ALWAYS_FATAL("channel '%s' ~ Could not make socket non-blocking: %s", name.c_str(),
@@ -332,16 +353,29 @@ std::unique_ptr<InputChannel> InputChannel::create(const std::string& name,
         return nullptr;
     }
     // using 'new' to access a non-public constructor
-    return std::unique_ptr<InputChannel>(new InputChannel(name, std::move(fd), token));
+    return std::unique_ptr<InputChannel>(
+            new InputChannel(name, std::move(fd), token, std::move(sampleRing)));
 }
 
 std::unique_ptr<InputChannel> InputChannel::create(
         android::os::InputChannelCore&& parceledChannel) {
+    std::shared_ptr<InputSampleRing> sampleRing;
+    if (parceledChannel.motionSampleRing) {
+        sampleRing = InputSampleRing::map(
+                android::base::unique_fd(parceledChannel.motionSampleRing->release()));
+        if (sampleRing == nullptr) {
+            ALOGE("channel '%s' ~ Could not map the motion sample ring",
+                  parceledChannel.name.c_str());
+            return nullptr;
+        }
+    }
     return InputChannel::create(parceledChannel.name, parceledChannel.fd.release(),
-                                parceledChannel.token);
+                                parceledChannel.token, std::move(sampleRing));
 }
 
-InputChannel::InputChannel(const std::string name, android::base::unique_fd fd, sp<IBinder> token) {
+InputChannel::InputChannel(const std::string name, android::base::unique_fd fd, sp<IBinder> token,
+                           std::shared_ptr<InputSampleRing> sampleRing)
+      : mMotionSampleRing(std::move(sampleRing)) {
     this->name = std::move(name);
     this->fd.reset(std::move(fd));
     this->token = std::move(token);
@@ -356,7 +390,8 @@ InputChannel::~InputChannel() {
 
 status_t InputChannel::openInputChannelPair(const std::string& name,
                                             std::unique_ptr<InputChannel>& outServerChannel,
-                                            std::unique_ptr<InputChannel>& outClientChannel) {
+                                            std::unique_ptr<InputChannel>& outClientChannel,
+                                            uint32_t motionSampleRingCapacity) {
     int sockets[2];
     if (socketpair(AF_UNIX, SOCK_SEQPACKET, 0, sockets)) {
         status_t result = -errno;
@@ -375,13 +410,31 @@ status_t InputChannel::openInputChannelPair(const std::string& name,
 
     sp<IBinder> token = sp<BBinder>::make();
 
+    // The server writes to the sample ring, and the client maps it read-only, the same way it
+    // would if the channel was sent to it over binder.
+    std::shared_ptr<InputSampleRing> serverSampleRing;
+    std::shared_ptr<InputSampleRing> clientSampleRing;
+    if (motionSampleRingCapacity > 0) {
+        serverSampleRing = InputSampleRing::create(name, motionSampleRingCapacity);
+        if (serverSampleRing != nullptr) {
+            clientSampleRing = InputSampleRing::map(serverSampleRing->dupFd());
+        }
+        if (clientSampleRing == nullptr) {
+            ALOGW("channel '%s' ~ Could not create a motion sample ring, continuing without it",
+                  name.c_str());
+            serverSampleRing = nullptr;
+        }
+    }
+
     std::string serverChannelName = name + " (server)";
     android::base::unique_fd serverFd(sockets[0]);
-    outServerChannel = InputChannel::create(serverChannelName, std::move(serverFd), token);
+    outServerChannel = InputChannel::create(serverChannelName, std::move(serverFd), token,
+                                            std::move(serverSampleRing));
 
     std::string clientChannelName = name + " (client)";
     android::base::unique_fd clientFd(sockets[1]);
-    outClientChannel = InputChannel::create(clientChannelName, std::move(clientFd), token);
+    outClientChannel = InputChannel::create(clientChannelName, std::move(clientFd), token,
+                                            std::move(clientSampleRing));
     return OK;
 }
 
@@ -425,6 +478,10 @@ status_t InputChannel::sendMessage(const InputMessage* msg) {
 }
 
 status_t InputChannel::receiveMessage(InputMessage* msg) {
+    if (!mUnprocessedMessages.empty()) {
+        size_t receivedCount;
+        return receiveMessages(std::span(msg, 1), receivedCount);
+    }
     ssize_t nRead;
     do {
         nRead = ::recv(getFd(), msg, sizeof(InputMessage), MSG_DONTWAIT);
@@ -454,6 +511,12 @@ status_t InputChannel::receiveMessage(InputMessage* msg) {
         return BAD_VALUE;
     }
 
+    if (msg->header.type == InputMessage::Type::MOTION_SAMPLE) {
+        if (status_t status = resolveMotionSample(*msg); status != OK) {
+            return status;
+        }
+    }
+
     ALOGD_IF(DEBUG_CHANNEL_MESSAGES, "channel '%s' ~ received message of type %s", name.c_str(),
              ftl::enum_string(msg->header.type).c_str());
     if (ATRACE_ENABLED()) {
@@ -467,7 +530,171 @@ status_t InputChannel::receiveMessage(InputMessage* msg) {
     return OK;
 }
 
+status_t InputChannel::sendMessages(std::span<const InputMessage> msgs, size_t& outSentCount) {
+    ATRACE_NAME_IF(ATRACE_ENABLED(),
+                   StringPrintf("sendMessages(inputChannel=%s, count=%zu)", name.c_str(),
+                                msgs.size()));
+    outSentCount = 0;
+    while (outSentCount < msgs.size()) {
+        const size_t batchSize = std::min(msgs.size() - outSentCount, MAX_MESSAGE_BATCH_SIZE);
+        std::array<InputMessage, MAX_MESSAGE_BATCH_SIZE> cleanMsgs;
+        std::array<iovec, MAX_MESSAGE_BATCH_SIZE> iovecs;
+        std::array<mmsghdr, MAX_MESSAGE_BATCH_SIZE> headers{};
+        for (size_t i = 0; i < batchSize; i++) {
+            const InputMessage& msg = msgs[outSentCount + i];
+            msg.getSanitizedCopy(&cleanMsgs[i]);
+            iovecs[i].iov_base = &cleanMsgs[i];
+            iovecs[i].iov_len = msg.size();
+            headers[i].msg_hdr.msg_iov = &iovecs[i];
+            headers[i].msg_hdr.msg_iovlen = 1;
+        }
+
+        int nSent;
+        do {
+            nSent = ::sendmmsg(getFd(), headers.data(), batchSize, MSG_DONTWAIT | MSG_NOSIGNAL);
+        } while (nSent == -1 && errno == EINTR);
+
+        if (nSent < 0) {
+            int error = errno;
+            ALOGD_IF(DEBUG_CHANNEL_MESSAGES,
+                     "channel '%s' ~ error sending message of type %s, %s", name.c_str(),
+                     ftl::enum_string(msgs[outSentCount].header.type).c_str(), strerror(error));
+            if (error == EAGAIN || error == EWOULDBLOCK) {
+                return WOULD_BLOCK;
+            }
+            if (error == EPIPE || error == ENOTCONN || error == ECONNREFUSED ||
+                error == ECONNRESET) {
+                return DEAD_OBJECT;
+            }
+            return -error;
+        }
+
+        for (int i = 0; i < nSent; i++) {
+            if (headers[i].msg_len != iovecs[i].iov_len) {
+                ALOGD_IF(DEBUG_CHANNEL_MESSAGES,
+                         "channel '%s' ~ error sending message type %s, send was incomplete",
+                         name.c_str(), ftl::enum_string(cleanMsgs[i].header.type).c_str());
+                return DEAD_OBJECT;
+            }
+            ALOGD_IF(DEBUG_CHANNEL_MESSAGES, "channel '%s' ~ sent message of type %s",
+                     name.c_str(), ftl::enum_string(cleanMsgs[i].header.type).c_str());
+            outSentCount++;
+        }
+        // If only a part of the batch was sent, the next iteration retries the first message that
+        // was not sent, so that the caller gets the error that prevented it from being sent.
+    }
+    return OK;
+}
+
+status_t InputChannel::receiveMessages(std::span<InputMessage> msgs, size_t& outReceivedCount) {
+    outReceivedCount = 0;
+    if (msgs.empty()) {
+        return OK;
+    }
+    const size_t batchSize = std::min(msgs.size(), MAX_MESSAGE_BATCH_SIZE);
+    std::array<size_t, MAX_MESSAGE_BATCH_SIZE> lengths;
+    size_t count = 0;
+    if (!mUnprocessedMessages.empty()) {
+        // Messages that were read along with an invalid message come before the ones that are
+        // still in the socket.
+        count = std::min(batchSize, mUnprocessedMessages.size());
+        for (size_t i = 0; i < count; i++) {
+            msgs[i] = mUnprocessedMessages.front().msg;
+            lengths[i] = mUnprocessedMessages.front().length;
+            mUnprocessedMessages.pop_front();
+        }
+    } else {
+        std::array<iovec, MAX_MESSAGE_BATCH_SIZE> iovecs;
+        std::array<mmsghdr, MAX_MESSAGE_BATCH_SIZE> headers{};
+        for (size_t i = 0; i < batchSize; i++) {
+            iovecs[i].iov_base = &msgs[i];
+            iovecs[i].iov_len = sizeof(InputMessage);
+            headers[i].msg_hdr.msg_iov = &iovecs[i];
+            headers[i].msg_hdr.msg_iovlen = 1;
+        }
+
+        int nReceived;
+        do {
+            nReceived = ::recvmmsg(getFd(), headers.data(), batchSize, MSG_DONTWAIT,
+                                   /*timeout=*/nullptr);
+        } while (nReceived == -1 && errno == EINTR);
+
+        if (nReceived < 0) {
+            int error = errno;
+            ALOGD_IF(DEBUG_CHANNEL_MESSAGES, "channel '%s' ~ receive messages failed, errno=%d",
+                     name.c_str(), errno);
+            if (error == EAGAIN || error == EWOULDBLOCK) {
+                return WOULD_BLOCK;
+            }
+            if (error == EPIPE || error == ENOTCONN || error == ECONNREFUSED) {
+                return DEAD_OBJECT;
+            }
+            return -error;
+        }
+        count = static_cast<size_t>(nReceived);
+        for (size_t i = 0; i < count; i++) {
+            lengths[i] = headers[i].msg_len;
+        }
+    }
+
+    for (size_t i = 0; i < count; i++) {
+        const size_t length = lengths[i];
+        if (length == 0) { // check for EOF
+            ALOGD_IF(DEBUG_CHANNEL_MESSAGES,
+                     "channel '%s' ~ receive message failed because peer was closed",
+                     name.c_str());
+            // Report the messages that were received before the peer was closed. The next call
+            // returns DEAD_OBJECT.
+            return outReceivedCount > 0 ? OK : DEAD_OBJECT;
+        }
+        status_t status = OK;
+        if (!msgs[i].isValid(length)) {
+            ALOGE("channel '%s' ~ received invalid message of size %zu", name.c_str(), length);
+            status = BAD_VALUE;
+        } else if (msgs[i].header.type == InputMessage::Type::MOTION_SAMPLE) {
+            status = resolveMotionSample(msgs[i]);
+        }
+        if (status != OK) {
+            // The messages that follow were already read from the socket, so keep them for the
+            // next calls. If valid messages precede the invalid one, report those first, and the
+            // invalid one on the next call.
+            const size_t firstUnprocessed = outReceivedCount > 0 ? i : i + 1;
+            auto insertPos = mUnprocessedMessages.begin();
+            for (size_t j = firstUnprocessed; j < count; j++) {
+                insertPos = std::next(
+                        mUnprocessedMessages.insert(insertPos,
+                                                    {.msg = msgs[j], .length = lengths[j]}));
+            }
+            return outReceivedCount > 0 ? OK : status;
+        }
+        ALOGD_IF(DEBUG_CHANNEL_MESSAGES, "channel '%s' ~ received message of type %s",
+                 name.c_str(), ftl::enum_string(msgs[i].header.type).c_str());
+        if (ATRACE_ENABLED()) {
+            // Add an additional trace point to include data about the received message.
+            std::string message =
+                    StringPrintf("receiveMessage(inputChannel=%s, seq=0x%" PRIx32 ", type=%s)",
+                                 name.c_str(), msgs[i].header.seq,
+                                 ftl::enum_string(msgs[i].header.type).c_str());
+            ATRACE_NAME(message.c_str());
+        }
+        outReceivedCount++;
+    }
+    return OK;
+}
+
+status_t InputChannel::resolveMotionSample(InputMessage& msg) const {
+    if (mMotionSampleRing == nullptr) {
+        ALOGE("channel '%s' ~ received a MOTION_SAMPLE message, but there is no sample ring",
+              name.c_str());
+        return BAD_VALUE;
+    }
+    return mMotionSampleRing->readSample(msg, msg);
+}
+
 bool InputChannel::probablyHasInput() const {
+    if (!mUnprocessedMessages.empty()) {
+        return true;
+    }
     struct pollfd pfds = {.fd = fd.get(), .events = POLLIN};
     if (::poll(&pfds, /*nfds=*/1, /*timeout=*/0) <= 0) {
         // This can be a false negative because EINTR and ENOMEM are not handled. The latter should
@@ -487,6 +714,9 @@ void InputChannel::waitForMessage(std::chrono::milliseconds timeout) const {
     if (timeout < 0ms) {
         LOG(FATAL) << "Timeout cannot be negative, received " << timeout.count();
     }
+    if (!mUnprocessedMessages.empty()) {
+        return;
+    }
     struct pollfd pfds = {.fd = fd.get(), .events = POLLIN};
     int ret;
     std::chrono::time_point<std::chrono::steady_clock> stopTime =
@@ -501,13 +731,18 @@ void InputChannel::waitForMessage(std::chrono::milliseconds timeout) const {
 
 std::unique_ptr<InputChannel> InputChannel::dup() const {
     base::unique_fd newFd(dupChannelFd(fd.get()));
-    return InputChannel::create(getName(), std::move(newFd), getConnectionToken());
+    return InputChannel::create(getName(), std::move(newFd), getConnectionToken(),
+                                mMotionSampleRing);
 }
 
 void InputChannel::copyTo(android::os::InputChannelCore& outChannel) const {
     outChannel.name = getName();
     outChannel.fd.reset(dupChannelFd(fd.get()));
     outChannel.token = getConnectionToken();
+    outChannel.motionSampleRing.reset();
+    if (mMotionSampleRing != nullptr) {
+        outChannel.motionSampleRing.emplace(mMotionSampleRing->dupFd());
+    }
 }
 
 void InputChannel::moveChannel(std::unique_ptr<InputChannel> from,
@@ -515,6 +750,10 @@ void InputChannel::moveChannel(std::unique_ptr<InputChannel> from,
     outChannel.name = from->getName();
     outChannel.fd = android::os::ParcelFileDescriptor(std::move(from->fd));
     outChannel.token = from->getConnectionToken();
+    outChannel.motionSampleRing.reset();
+    if (from->mMotionSampleRing != nullptr) {
+        outChannel.motionSampleRing.emplace(from->mMotionSampleRing->dupFd());
+    }
 }
 
 sp<IBinder> InputChannel::getConnectionToken() const {
@@ -568,7 +807,7 @@ status_t InputPublisher::publishKeyEvent(uint32_t seq, int32_t eventId, int32_t
     msg.body.key.repeatCount = repeatCount;
     msg.body.key.downTime = downTime;
     msg.body.key.eventTime = eventTime;
-    return mChannel->sendMessage(&msg);
+    return sendOrStageMessage(msg);
 }
 
 status_t InputPublisher::publishMotionEvent(
@@ -584,14 +823,6 @@ status_t InputPublisher::publishMotionEvent(
                    StringPrintf("publishMotionEvent(inputChannel=%s, action=%s)",
                                 mChannel->getName().c_str(),
                                 MotionEvent::actionToString(action).c_str()));
-    if (verifyEvents()) {
-        Result<void> result =
-                mInputVerifier.processMovement(deviceId, source, action, pointerCount,
-                                               pointerProperties, pointerCoords, flags);
-        if (!result.ok()) {
-            LOG(FATAL) << "Bad stream: " << result.error();
-        }
-    }
     if (debugTransportPublisher()) {
         std::string transformString;
         transform.dump(transformString, "transform", "        ");
@@ -658,7 +889,7 @@ status_t InputPublisher::publishMotionEvent(
         msg.body.motion.pointers[i].coords = pointerCoords[i];
     }
 
-    return mChannel->sendMessage(&msg);
+    return sendOrStageMessage(msg);
 }
 
 status_t InputPublisher::publishFocusEvent(uint32_t seq, int32_t eventId, bool hasFocus) {
@@ -673,7 +904,7 @@ status_t InputPublisher::publishFocusEvent(uint32_t seq, int32_t eventId, bool h
     msg.header.seq = seq;
     msg.body.focus.eventId = eventId;
     msg.body.focus.hasFocus = hasFocus;
-    return mChannel->sendMessage(&msg);
+    return sendOrStageMessage(msg);
 }
 
 status_t InputPublisher::publishCaptureEvent(uint32_t seq, int32_t eventId,
@@ -690,7 +921,7 @@ status_t InputPublisher::publishCaptureEvent(uint32_t seq, int32_t eventId,
     msg.header.seq = seq;
     msg.body.capture.eventId = eventId;
     msg.body.capture.pointerCaptureEnabled = pointerCaptureEnabled;
-    return mChannel->sendMessage(&msg);
+    return sendOrStageMessage(msg);
 }
 
 status_t InputPublisher::publishDragEvent(uint32_t seq, int32_t eventId, float x, float y,
@@ -709,7 +940,7 @@ status_t InputPublisher::publishDragEvent(uint32_t seq, int32_t eventId, float x
     msg.body.drag.isExiting = isExiting;
     msg.body.drag.x = x;
     msg.body.drag.y = y;
-    return mChannel->sendMessage(&msg);
+    return sendOrStageMessage(msg);
 }
 
 status_t InputPublisher::publishTouchModeEvent(uint32_t seq, int32_t eventId, bool isInTouchMode) {
@@ -725,7 +956,93 @@ status_t InputPublisher::publishTouchModeEvent(uint32_t seq, int32_t eventId, bo
     msg.header.seq = seq;
     msg.body.touchMode.eventId = eventId;
     msg.body.touchMode.isInTouchMode = isInTouchMode;
-    return mChannel->sendMessage(&msg);
+    return sendOrStageMessage(msg);
+}
+
+void InputPublisher::beginBatch() {
+    LOG_IF(FATAL, mBatching) << "channel '" << mChannel->getName()
+                             << "' publisher ~ beginBatch called while a batch is in progress";
+    mBatching = true;
+    mBatch.clear();
+    mBatchToVerify.clear();
+    mVerifyBatch = verifyEvents();
+}
+
+status_t InputPublisher::flushBatch(size_t& outPublishedCount) {
+    LOG_IF(FATAL, !mBatching) << "channel '" << mChannel->getName()
+                              << "' publisher ~ flushBatch called without a batch in progress";
+    mBatching = false;
+    const status_t status = mChannel->sendMessages(mBatch, outPublishedCount);
+    if (mVerifyBatch) {
+        for (size_t i = 0; i < outPublishedCount; i++) {
+            verifySentMessage(mBatchToVerify[i]);
+        }
+        mBatchToVerify.clear();
+    }
+    if (debugTransportPublisher()) {
+        ALOGD("channel '%s' publisher ~ %s: published %zu of %zu messages, status=%s",
+              mChannel->getName().c_str(), __func__, outPublishedCount, mBatch.size(),
+              statusToString(status).c_str());
+    }
+    // The events that were not published will be published again later, and must not hold on to
+    // their slot in the sample ring in the meantime.
+    if (InputSampleRing* sampleRing = mChannel->getMotionSampleRing(); sampleRing != nullptr) {
+        for (size_t i = outPublishedCount; i < mBatch.size(); i++) {
+            sampleRing->releaseSample(mBatch[i].header.seq);
+        }
+    }
+    mBatch.clear();
+    return status;
+}
+
+status_t InputPublisher::sendOrStageMessage(const InputMessage& msg) {
+    // Motion events go through the sample ring when there is one, and it has room for them.
+    InputSampleRing* sampleRing = mChannel->getMotionSampleRing();
+    InputMessage reference;
+    const bool inSampleRing = sampleRing != nullptr &&
+            msg.header.type == InputMessage::Type::MOTION &&
+            sampleRing->writeSample(msg, reference);
+    const InputMessage& outMsg = inSampleRing ? reference : msg;
+
+    if (mBatching) {
+        mBatch.push_back(outMsg);
+        if (mVerifyBatch) {
+            mBatchToVerify.push_back(msg);
+        }
+        return OK;
+    }
+    const status_t status = mChannel->sendMessage(&outMsg);
+    if (status != OK) {
+        if (inSampleRing) {
+            sampleRing->releaseSample(msg.header.seq);
+        }
+        return status;
+    }
+    if (verifyEvents()) {
+        verifySentMessage(msg);
+    }
+    return OK;
+}
+
+void InputPublisher::verifySentMessage(const InputMessage& msg) {
+    if (msg.header.type != InputMessage::Type::MOTION) {
+        return;
+    }
+    const uint32_t pointerCount = msg.body.motion.pointerCount;
+    std::array<PointerProperties, MAX_POINTERS> pointerProperties;
+    std::array<PointerCoords, MAX_POINTERS> pointerCoords;
+    for (uint32_t i = 0; i < pointerCount; i++) {
+        pointerProperties[i] = msg.body.motion.pointers[i].properties;
+        pointerCoords[i] = msg.body.motion.pointers[i].coords;
+    }
+    Result<void> result =
+            mInputVerifier.processMovement(msg.body.motion.deviceId, msg.body.motion.source,
+                                           msg.body.motion.action, pointerCount,
+                                           pointerProperties.data(), pointerCoords.data(),
+                                           msg.body.motion.flags);
+    if (!result.ok()) {
+        LOG(FATAL) << "Bad stream: " << result.error();
+    }
 }
 
 android::base::Result<InputPublisher::ConsumerResponse> InputPublisher::receiveConsumerResponse() {
@@ -743,6 +1060,10 @@ android::base::Result<InputPublisher::ConsumerResponse> InputPublisher::receiveC
                  "channel '%s' publisher ~ %s: finished: seq=%u, handled=%s",
                  mChannel->getName().c_str(), __func__, msg.header.seq,
                  toString(msg.body.finished.handled));
+        // The consumer has copied the event out of the sample ring by now.
+        if (InputSampleRing* sampleRing = mChannel->getMotionSampleRing(); sampleRing != nullptr) {
+            sampleRing->releaseSample(msg.header.seq);
+        }
         return Finished{
                 .seq = msg.header.seq,
                 .handled = msg.body.finished.handled,
@@ -31,6 +31,8 @@
 #include <utils/Timers.h>
 #include <utils/Tokenizer.h>
 
+#include "ParsedFileCache.h"
+
 // Enables debug output for the parser.
 #define DEBUG_PARSER 0
 
@@ -80,12 +82,32 @@ static String8 toString(const char16_t* chars, size_t numChars) {
 #endif
 
 
+// Maximum number of parsed key character map files to keep.
+static constexpr size_t KEY_CHARACTER_MAP_CACHE_SIZE = 32;
+
+static ParsedFileCache<std::shared_ptr<const KeyCharacterMap>>& getCache() {
+    static auto* sCache =
+            new ParsedFileCache<std::shared_ptr<const KeyCharacterMap>>(KEY_CHARACTER_MAP_CACHE_SIZE);
+    return *sCache;
+}
+
 // --- KeyCharacterMap ---
 
 KeyCharacterMap::KeyCharacterMap(const std::string& filename) : mLoadFileName(filename) {}
 
 base::Result<std::shared_ptr<KeyCharacterMap>> KeyCharacterMap::load(const std::string& filename,
                                                                      Format format) {
+    const std::optional<FileStamp> stamp = FileStamp::of(filename);
+    if (stamp) {
+        std::optional<std::shared_ptr<const KeyCharacterMap>> cached =
+                getCache().get(filename, static_cast<int32_t>(format), *stamp);
+        if (cached) {
+            // Key character maps are modified by overlays and remappings, so each caller gets its
+            // own copy of the cached map.
+            return std::make_shared<KeyCharacterMap>(**cached);
+        }
+    }
+
     Tokenizer* tokenizer;
     status_t status = Tokenizer::open(String8(filename.c_str()), &tokenizer);
     if (status) {
@@ -100,6 +122,10 @@ base::Result<std::shared_ptr<KeyCharacterMap>> KeyCharacterMap::load(const std::
     std::unique_ptr<Tokenizer> t(tokenizer);
     status = map->load(t.get(), format);
     if (status == OK) {
+        if (stamp) {
+            getCache().put(filename, static_cast<int32_t>(format), *stamp,
+                           std::make_shared<const KeyCharacterMap>(*map));
+        }
         return map;
     }
     return Errorf("Load KeyCharacterMap failed {}.", status);
@@ -155,6 +181,21 @@ void KeyCharacterMap::clear() {
 
 status_t KeyCharacterMap::reloadBaseFromFile() {
     clear();
+    // The base map is usually still cached from when this map was loaded.
+    const std::optional<FileStamp> stamp = FileStamp::of(mLoadFileName);
+    if (stamp) {
+        std::optional<std::shared_ptr<const KeyCharacterMap>> cached =
+                getCache().get(mLoadFileName, static_cast<int32_t>(Format::BASE), *stamp);
+        if (cached) {
+            const KeyCharacterMap& base = **cached;
+            mKeys = base.mKeys;
+            mType = base.mType;
+            mKeysByScanCode = base.mKeysByScanCode;
+            mKeysByUsageCode = base.mKeysByUsageCode;
+            return OK;
+        }
+    }
+
     Tokenizer* tokenizer;
     status_t status = Tokenizer::open(String8(mLoadFileName.c_str()), &tokenizer);
     if (status) {
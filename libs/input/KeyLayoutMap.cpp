@@ -34,6 +34,8 @@
 #include <string_view>
 #include <unordered_map>
 
+#include "ParsedFileCache.h"
+
 /**
  * Log debug output for the parser.
  * Enable this via "adb shell setprop log.tag.KeyLayoutMapParser DEBUG" (requires restart)
@@ -125,6 +127,21 @@ bool kernelConfigsArePresent(const std::set<std::string>& configs) {
 #endif
 }
 
+// Maximum number of parsed key layout files to keep.
+constexpr size_t KEY_LAYOUT_CACHE_SIZE = 32;
+
+struct CachedKeyLayout {
+    std::shared_ptr<KeyLayoutMap> map;
+    // Kernel configs do not change at runtime, so the outcome of the check is cached as well.
+    bool kernelConfigsPresent;
+};
+
+ParsedFileCache<CachedKeyLayout>& getKeyLayoutCache() {
+    static ParsedFileCache<CachedKeyLayout>* sCache =
+            new ParsedFileCache<CachedKeyLayout>(KEY_LAYOUT_CACHE_SIZE);
+    return *sCache;
+}
+
 } // namespace
 
 KeyLayoutMap::KeyLayoutMap() = default;
@@ -137,6 +154,23 @@ base::Result<std::shared_ptr<KeyLayoutMap>> KeyLayoutMap::loadContents(const std
 
 base::Result<std::shared_ptr<KeyLayoutMap>> KeyLayoutMap::load(const std::string& filename,
                                                                const char* contents) {
+    // A loaded map is immutable, so maps that were loaded from files are shared.
+    std::optional<FileStamp> stamp;
+    if (contents == nullptr) {
+        stamp = FileStamp::of(filename);
+    }
+    if (stamp) {
+        std::optional<CachedKeyLayout> cached = getKeyLayoutCache().get(filename, 0, *stamp);
+        if (cached) {
+            if (!cached->kernelConfigsPresent) {
+                ALOGI("Not loading %s because the required kernel configs are not set",
+                      filename.c_str());
+                return Errorf("Missing kernel config");
+            }
+            return cached->map;
+        }
+    }
+
     Tokenizer* tokenizer;
     status_t status;
     if (contents == nullptr) {
@@ -155,11 +189,16 @@ base::Result<std::shared_ptr<KeyLayoutMap>> KeyLayoutMap::load(const std::string
     }
     const std::shared_ptr<KeyLayoutMap>& map = *ret;
     LOG_ALWAYS_FATAL_IF(map == nullptr, "Returned map should not be null if there's no error");
-    if (!kernelConfigsArePresent(map->mRequiredKernelConfigs)) {
+    map->mLoadFileName = filename;
+    const bool kernelConfigsPresent = kernelConfigsArePresent(map->mRequiredKernelConfigs);
+    if (stamp) {
+        getKeyLayoutCache().put(filename, 0, *stamp,
+                                {.map = map, .kernelConfigsPresent = kernelConfigsPresent});
+    }
+    if (!kernelConfigsPresent) {
         ALOGI("Not loading %s because the required kernel configs are not set", filename.c_str());
         return Errorf("Missing kernel config");
     }
-    map->mLoadFileName = filename;
     return ret;
 }
 
@@ -0,0 +1,130 @@
+/*
+ * Copyright (C) 2024 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#pragma once
+
+#include <android-base/thread_annotations.h>
+#include <sys/stat.h>
+
+#include <cstdint>
+#include <map>
+#include <mutex>
+#include <optional>
+#include <string>
+#include <utility>
+
+namespace android {
+
+/**
+ * Identifies the contents of a file without reading it. A file that is replaced or modified gets a
+ * different stamp.
+ */
+struct FileStamp {
+    dev_t device;
+    ino_t inode;
+    off_t size;
+    int64_t modificationTimeNanos;
+
+    bool operator==(const FileStamp&) const = default;
+
+    /* Returns the stamp of the file at the given path, or nullopt if it cannot be stat'ed. */
+    static std::optional<FileStamp> of(const std::string& path) {
+        struct stat st;
+        if (stat(path.c_str(), &st) != 0) {
+            return std::nullopt;
+        }
+        return FileStamp{.device = st.st_dev,
+                         .inode = st.st_ino,
+                         .size = st.st_size,
+                         .modificationTimeNanos =
+                                 static_cast<int64_t>(st.st_mtim.tv_sec) * 1'000'000'000 +
+                                 st.st_mtim.tv_nsec};
+    }
+};
+
+/**
+ * A thread-safe cache of values parsed from files.
+ *
+ * Input devices of the same kind use the same configuration files, so devices that are added
+ * together (for example, the interfaces of a composite keyboard) would otherwise parse the same
+ * files over and over. Entries are keyed by the path of the file and by a variant (such as the
+ * format the file was parsed with). An entry is only returned while the file still has the stamp
+ * it had when it was parsed; the stamp must be taken before the file is read, so that a file that
+ * changes while it is being parsed is parsed again on the next lookup. When the cache is full, the
+ * least recently used entry is evicted.
+ */
+template <typename T>
+class ParsedFileCache {
+public:
+    explicit ParsedFileCache(size_t capacity) : mCapacity(capacity) {}
+
+    std::optional<T> get(const std::string& path, int32_t variant, const FileStamp& stamp) {
+        std::scoped_lock lock(mLock);
+        auto it = mEntries.find(std::make_pair(path, variant));
+        if (it == mEntries.end()) {
+            return std::nullopt;
+        }
+        if (it->second.stamp != stamp) {
+            // The file has changed since it was parsed.
+            mEntries.erase(it);
+            return std::nullopt;
+        }
+        it->second.lastUse = ++mUseCount;
+        return it->second.value;
+    }
+
+    void put(const std::string& path, int32_t variant, const FileStamp& stamp, T value) {
+        std::scoped_lock lock(mLock);
+        if (mCapacity == 0) {
+            return;
+        }
+        Key key = std::make_pair(path, variant);
+        if (mEntries.find(key) == mEntries.end() && mEntries.size() >= mCapacity) {
+            auto leastRecentlyUsed = mEntries.begin();
+            for (auto it = mEntries.begin(); it != mEntries.end(); it++) {
+                if (it->second.lastUse < leastRecentlyUsed->second.lastUse) {
+                    leastRecentlyUsed = it;
+                }
+            }
+            mEntries.erase(leastRecentlyUsed);
+        }
+        mEntries.insert_or_assign(std::move(key),
+                                  Entry{.stamp = stamp,
+                                        .value = std::move(value),
+                                        .lastUse = ++mUseCount});
+    }
+
+    size_t size() {
+        std::scoped_lock lock(mLock);
+        return mEntries.size();
+    }
+
+private:
+    using Key = std::pair<std::string /*path*/, int32_t /*variant*/>;
+
+    struct Entry {
+        FileStamp stamp;
+        T value;
+        uint64_t lastUse;
+    };
+
+    const size_t mCapacity;
+    std::mutex mLock;
+    std::map<Key, Entry> mEntries GUARDED_BY(mLock);
+    uint64_t mUseCount GUARDED_BY(mLock) = 0;
+};
+
+} // namespace android
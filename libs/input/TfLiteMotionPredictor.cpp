@@ -332,6 +332,8 @@ void TfLiteMotionPredictorModel::allocateTensors() {
     checkTensor<float>(mOutputPhi);
     checkTensor<float>(mOutputPressure);
 
+    updateTensorBuffers();
+
     const auto checkInputTensorSize = [this](const TfLiteTensor* tensor) {
         const size_t size = getTensorBuffer<const float>(tensor).size();
         LOG_ALWAYS_FATAL_IF(size != inputLength(),
@@ -360,6 +362,37 @@ void TfLiteMotionPredictorModel::attachOutputTensors() {
     mOutputPressure = findOutputTensor(OUTPUT_PRESSURE, mRunner);
 }
 
+void TfLiteMotionPredictorModel::updateTensorBuffers() {
+    mInputRBuffer = getTensorBuffer<float>(mInputR);
+    mInputPhiBuffer = getTensorBuffer<float>(mInputPhi);
+    mInputPressureBuffer = getTensorBuffer<float>(mInputPressure);
+    mInputTiltBuffer = getTensorBuffer<float>(mInputTilt);
+    mInputOrientationBuffer = getTensorBuffer<float>(mInputOrientation);
+
+    mOutputRBuffer = getTensorBuffer<const float>(mOutputR);
+    mOutputPhiBuffer = getTensorBuffer<const float>(mOutputPhi);
+    mOutputPressureBuffer = getTensorBuffer<const float>(mOutputPressure);
+
+    if (mOutputRBuffer.size() != mOutputPhiBuffer.size() ||
+        mOutputRBuffer.size() != mOutputPressureBuffer.size()) {
+        LOG_ALWAYS_FATAL("Output size mismatch: (r: %zu, phi: %zu, pressure: %zu)",
+                         mOutputRBuffer.size(), mOutputPhiBuffer.size(),
+                         mOutputPressureBuffer.size());
+    }
+}
+
+bool TfLiteMotionPredictorModel::tensorBuffersChanged() const {
+    const auto changed = [](const TfLiteTensor* tensor, std::span<const float> buffer) {
+        return tensor->data.data != buffer.data() || tensor->bytes != buffer.size_bytes();
+    };
+    return changed(mInputR, mInputRBuffer) || changed(mInputPhi, mInputPhiBuffer) ||
+            changed(mInputPressure, mInputPressureBuffer) ||
+            changed(mInputTilt, mInputTiltBuffer) ||
+            changed(mInputOrientation, mInputOrientationBuffer) ||
+            changed(mOutputR, mOutputRBuffer) || changed(mOutputPhi, mOutputPhiBuffer) ||
+            changed(mOutputPressure, mOutputPressureBuffer);
+}
+
 bool TfLiteMotionPredictorModel::invoke() {
     ATRACE_BEGIN("TfLiteMotionPredictorModel::invoke");
     TfLiteStatus result = mRunner->Invoke();
@@ -369,56 +402,56 @@ bool TfLiteMotionPredictorModel::invoke() {
         return false;
     }
 
-    // Invoke() might reallocate tensors, so they need to be reattached.
+    // Invoke() might reallocate tensors, so the tensors must be looked up again before they are
+    // read. The model has static shapes, so their buffers normally stay in place and the cached
+    // buffers only need to be fetched again if the interpreter moved one of them.
     attachInputTensors();
     attachOutputTensors();
-
-    if (outputR().size() != outputPhi().size() || outputR().size() != outputPressure().size()) {
-        LOG_ALWAYS_FATAL("Output size mismatch: (r: %zu, phi: %zu, pressure: %zu)",
-                         outputR().size(), outputPhi().size(), outputPressure().size());
+    if (tensorBuffersChanged()) {
+        updateTensorBuffers();
     }
 
     return true;
 }
 
 size_t TfLiteMotionPredictorModel::inputLength() const {
-    return getTensorBuffer<const float>(mInputR).size();
+    return mInputRBuffer.size();
 }
 
 size_t TfLiteMotionPredictorModel::outputLength() const {
-    return getTensorBuffer<const float>(mOutputR).size();
+    return mOutputRBuffer.size();
 }
 
 std::span<float> TfLiteMotionPredictorModel::inputR() {
-    return getTensorBuffer<float>(mInputR);
+    return mInputRBuffer;
 }
 
 std::span<float> TfLiteMotionPredictorModel::inputPhi() {
-    return getTensorBuffer<float>(mInputPhi);
+    return mInputPhiBuffer;
 }
 
 std::span<float> TfLiteMotionPredictorModel::inputPressure() {
-    return getTensorBuffer<float>(mInputPressure);
+    return mInputPressureBuffer;
 }
 
 std::span<float> TfLiteMotionPredictorModel::inputTilt() {
-    return getTensorBuffer<float>(mInputTilt);
+    return mInputTiltBuffer;
 }
 
 std::span<float> TfLiteMotionPredictorModel::inputOrientation() {
-    return getTensorBuffer<float>(mInputOrientation);
+    return mInputOrientationBuffer;
 }
 
 std::span<const float> TfLiteMotionPredictorModel::outputR() const {
-    return getTensorBuffer<const float>(mOutputR);
+    return mOutputRBuffer;
 }
 
 std::span<const float> TfLiteMotionPredictorModel::outputPhi() const {
-    return getTensorBuffer<const float>(mOutputPhi);
+    return mOutputPhiBuffer;
 }
 
 std::span<const float> TfLiteMotionPredictorModel::outputPressure() const {
-    return getTensorBuffer<const float>(mOutputPressure);
+    return mOutputPressureBuffer;
 }
 
 } // namespace android
@@ -206,6 +206,9 @@ std::unique_ptr<VelocityTrackerStrategy> VelocityTracker::createStrategy(
         case VelocityTracker::Strategy::LEGACY:
             return std::make_unique<LegacyVelocityTrackerStrategy>();
 
+        case VelocityTracker::Strategy::LSQ2_INCREMENTAL:
+            return std::make_unique<IncrementalLeastSquaresVelocityTrackerStrategy>();
+
         default:
             break;
     }
@@ -756,6 +759,128 @@ float LeastSquaresVelocityTrackerStrategy::chooseWeight(int32_t pointerId, uint3
     }
 }
 
+// --- IncrementalLeastSquaresVelocityTrackerStrategy ---
+
+IncrementalLeastSquaresVelocityTrackerStrategy::IncrementalLeastSquaresVelocityTrackerStrategy() {}
+
+IncrementalLeastSquaresVelocityTrackerStrategy::~IncrementalLeastSquaresVelocityTrackerStrategy() {}
+
+void IncrementalLeastSquaresVelocityTrackerStrategy::clearPointer(int32_t pointerId) {
+    mPointerStates.erase(pointerId);
+}
+
+void IncrementalLeastSquaresVelocityTrackerStrategy::accumulate(PointerState& state,
+                                                                const Movement& movement,
+                                                                double sign) {
+    const double x = (movement.eventTime - state.originTime) * 1E-9;
+    const double y = static_cast<double>(movement.position) - state.originPosition;
+    const double x2 = x * x;
+
+    Sums& sums = state.sums;
+    sums.x += sign * x;
+    sums.x2 += sign * x2;
+    sums.x3 += sign * x2 * x;
+    sums.x4 += sign * x2 * x2;
+    sums.y += sign * y;
+    sums.xy += sign * x * y;
+    sums.x2y += sign * x2 * y;
+}
+
+void IncrementalLeastSquaresVelocityTrackerStrategy::rebase(PointerState& state) {
+    const Movement& newestMovement = state.movements.back();
+    state.originTime = newestMovement.eventTime;
+    state.originPosition = newestMovement.position;
+    state.sums = {};
+    for (const Movement& movement : state.movements) {
+        accumulate(state, movement, 1);
+    }
+}
+
+void IncrementalLeastSquaresVelocityTrackerStrategy::addMovement(nsecs_t eventTime,
+                                                                 int32_t pointerId,
+                                                                 float position) {
+    auto [stateIt, _] = mPointerStates.try_emplace(pointerId, HISTORY_SIZE);
+    PointerState& state = stateIt->second;
+    RingBuffer<Movement>& movements = state.movements;
+
+    if (movements.empty()) {
+        state.originTime = eventTime;
+        state.originPosition = position;
+        state.sums = {};
+    } else if (movements.back().eventTime == eventTime) {
+        // Replace the movement reported for the same time, see
+        // AccumulatingVelocityTrackerStrategy::addMovement.
+        accumulate(state, movements.popBack(), -1);
+    }
+    if (movements.size() == movements.capacity()) {
+        accumulate(state, movements.popFront(), -1);
+    }
+    movements.pushBack({eventTime, position});
+    accumulate(state, movements.back(), 1);
+
+    // Drop the movements that do not fall within the horizon of the latest movement.
+    while (eventTime - movements.front().eventTime > HORIZON) {
+        accumulate(state, movements.popFront(), -1);
+    }
+
+    // Bound the distance between the origin and the retained movements. This recomputes at most
+    // HISTORY_SIZE terms once per HORIZON, so the amortized cost of an addition stays constant.
+    if (eventTime - state.originTime > HORIZON) {
+        rebase(state);
+    }
+}
+
+std::optional<float> IncrementalLeastSquaresVelocityTrackerStrategy::getVelocity(
+        int32_t pointerId) const {
+    const auto stateIt = mPointerStates.find(pointerId);
+    if (stateIt == mPointerStates.end()) {
+        return std::nullopt; // no data
+    }
+    const PointerState& state = stateIt->second;
+    const size_t count = state.movements.size();
+    if (count < 2) {
+        return std::nullopt;
+    }
+
+    // The velocity is the slope of the fit at the time of the newest movement. Shift the sums so
+    // that they are relative to that time, which is where solveUnweightedLeastSquaresDeg2 puts the
+    // origin, using the binomial expansion of the powers of (x - d).
+    const Sums& s = state.sums;
+    const double n = count;
+    const double d = (state.movements.back().eventTime - state.originTime) * 1E-9;
+    const double d2 = d * d;
+    const double d3 = d2 * d;
+    const double sxi = s.x - d * n;
+    const double sxi2 = s.x2 - 2 * d * s.x + d2 * n;
+    const double sxi3 = s.x3 - 3 * d * s.x2 + 3 * d2 * s.x - d3 * n;
+    const double sxi4 = s.x4 - 4 * d * s.x3 + 6 * d2 * s.x2 - 4 * d3 * s.x + d2 * d2 * n;
+    const double syi = s.y;
+    const double sxiyi = s.xy - d * s.y;
+    const double sxi2yi = s.x2y - 2 * d * s.xy + d2 * s.y;
+
+    const double Sxx = sxi2 - sxi * sxi / n;
+    const double Sxy = sxiyi - sxi * syi / n;
+    if (count == 2) {
+        // Not enough movements for a quadratic fit, use a linear one instead, like
+        // LeastSquaresVelocityTrackerStrategy.
+        if (Sxx <= 0) {
+            return std::nullopt;
+        }
+        return Sxy / Sxx;
+    }
+
+    const double Sxx2 = sxi3 - sxi * sxi2 / n;
+    const double Sx2y = sxi2yi - sxi2 * syi / n;
+    const double Sx2x2 = sxi4 - sxi2 * sxi2 / n;
+
+    const double denominator = Sxx * Sx2x2 - Sxx2 * Sxx2;
+    if (denominator <= 0) {
+        ALOGW("division by 0 when computing velocity, Sxx=%f, Sx2x2=%f, Sxx2=%f", Sxx, Sx2x2, Sxx2);
+        return std::nullopt;
+    }
+    return (Sxy * Sx2x2 - Sx2y * Sxx2) / denominator;
+}
+
 // --- IntegratingVelocityTrackerStrategy ---
 
 IntegratingVelocityTrackerStrategy::IntegratingVelocityTrackerStrategy(uint32_t degree) :
@@ -15,7 +15,9 @@
  */
 
 #include <array>
+#include <vector>
 
+#include <sys/socket.h>
 #include <unistd.h>
 #include <time.h>
 #include <errno.h>
@@ -226,6 +228,128 @@ TEST_F(InputChannelTest, SendAndReceive_MotionClassification) {
     }
 }
 
+TEST_F(InputChannelTest, SendMessagesAndReceiveMessages_PreserveOrder) {
+    std::unique_ptr<InputChannel> serverChannel, clientChannel;
+    status_t result =
+            InputChannel::openInputChannelPair("channel name", serverChannel, clientChannel);
+    ASSERT_EQ(OK, result) << "should have successfully opened a channel pair";
+
+    // Send more messages than fit in a single system call.
+    std::vector<InputMessage> sentMsgs(20);
+    for (size_t i = 0; i < sentMsgs.size(); i++) {
+        sentMsgs[i] = {};
+        sentMsgs[i].header.type = InputMessage::Type::FINISHED;
+        sentMsgs[i].header.seq = i + 1;
+        sentMsgs[i].body.finished.handled = i % 2 == 0;
+    }
+    size_t sentCount;
+    ASSERT_EQ(OK, clientChannel->sendMessages(sentMsgs, sentCount));
+    ASSERT_EQ(sentMsgs.size(), sentCount);
+
+    std::vector<InputMessage> receivedMsgs;
+    std::array<InputMessage, 6> batch;
+    size_t receivedCount;
+    while (serverChannel->receiveMessages(batch, receivedCount) == OK) {
+        ASSERT_GT(receivedCount, 0u);
+        receivedMsgs.insert(receivedMsgs.end(), batch.begin(), batch.begin() + receivedCount);
+    }
+    ASSERT_EQ(sentMsgs.size(), receivedMsgs.size());
+    for (size_t i = 0; i < sentMsgs.size(); i++) {
+        EXPECT_EQ(InputMessage::Type::FINISHED, receivedMsgs[i].header.type);
+        EXPECT_EQ(sentMsgs[i].header.seq, receivedMsgs[i].header.seq);
+        EXPECT_EQ(sentMsgs[i].body.finished.handled, receivedMsgs[i].body.finished.handled);
+    }
+}
+
+TEST_F(InputChannelTest, ReceiveMessages_InvalidMessage_KeepsMessagesInOrder) {
+    std::unique_ptr<InputChannel> serverChannel, clientChannel;
+    status_t result =
+            InputChannel::openInputChannelPair("channel name", serverChannel, clientChannel);
+    ASSERT_EQ(OK, result) << "should have successfully opened a channel pair";
+
+    InputMessage msg{};
+    msg.header.type = InputMessage::Type::FINISHED;
+    msg.header.seq = 1;
+    ASSERT_EQ(OK, clientChannel->sendMessage(&msg));
+    msg.header.seq = 2;
+    ASSERT_EQ(OK, clientChannel->sendMessage(&msg));
+    // A message that is too short to hold a header.
+    const uint8_t invalidMsg = 0;
+    ASSERT_EQ(1, ::send(clientChannel->getFd(), &invalidMsg, sizeof(invalidMsg), MSG_DONTWAIT));
+    msg.header.seq = 3;
+    ASSERT_EQ(OK, clientChannel->sendMessage(&msg));
+
+    std::array<InputMessage, 6> batch;
+    size_t receivedCount;
+    ASSERT_EQ(OK, serverChannel->receiveMessages(batch, receivedCount));
+    ASSERT_EQ(2u, receivedCount);
+    EXPECT_EQ(1u, batch[0].header.seq);
+    EXPECT_EQ(2u, batch[1].header.seq);
+
+    EXPECT_TRUE(serverChannel->hasUnprocessedMessages());
+
+    EXPECT_EQ(BAD_VALUE, serverChannel->receiveMessages(batch, receivedCount));
+    EXPECT_EQ(0u, receivedCount);
+
+    // The message that followed the invalid one was read along with it, and is not lost.
+    ASSERT_EQ(OK, serverChannel->receiveMessages(batch, receivedCount));
+    ASSERT_EQ(1u, receivedCount);
+    EXPECT_EQ(3u, batch[0].header.seq);
+    EXPECT_FALSE(serverChannel->hasUnprocessedMessages());
+
+    EXPECT_EQ(WOULD_BLOCK, serverChannel->receiveMessages(batch, receivedCount));
+}
+
+TEST_F(InputChannelTest, SendMessages_WhenChannelIsFull_ReportsSentCount) {
+    std::unique_ptr<InputChannel> serverChannel, clientChannel;
+    status_t result =
+            InputChannel::openInputChannelPair("channel name", serverChannel, clientChannel);
+    ASSERT_EQ(OK, result) << "should have successfully opened a channel pair";
+
+    // The messages are much larger than the socket buffer in total.
+    std::vector<InputMessage> sentMsgs(100);
+    for (size_t i = 0; i < sentMsgs.size(); i++) {
+        sentMsgs[i] = {};
+        sentMsgs[i].header.type = InputMessage::Type::MOTION;
+        sentMsgs[i].header.seq = i + 1;
+        sentMsgs[i].body.motion.pointerCount = MAX_POINTERS;
+    }
+    size_t sentCount;
+    ASSERT_EQ(WOULD_BLOCK, serverChannel->sendMessages(sentMsgs, sentCount));
+    ASSERT_GT(sentCount, 0u);
+    ASSERT_LT(sentCount, sentMsgs.size());
+
+    // Exactly the messages that were reported as sent can be received.
+    InputMessage msg;
+    for (size_t i = 0; i < sentCount; i++) {
+        ASSERT_EQ(OK, clientChannel->receiveMessage(&msg));
+        EXPECT_EQ(sentMsgs[i].header.seq, msg.header.seq);
+    }
+    EXPECT_EQ(WOULD_BLOCK, clientChannel->receiveMessage(&msg));
+}
+
+TEST_F(InputChannelTest, SendMessages_WhenPeerClosed_ReturnsAnError) {
+    std::unique_ptr<InputChannel> serverChannel, clientChannel;
+    status_t result =
+            InputChannel::openInputChannelPair("channel name", serverChannel, clientChannel);
+    ASSERT_EQ(OK, result) << "should have successfully opened a channel pair";
+
+    serverChannel.reset(); // close server channel
+
+    std::array<InputMessage, 2> msgs{};
+    msgs[0].header.type = InputMessage::Type::KEY;
+    msgs[1].header.type = InputMessage::Type::KEY;
+    size_t sentCount;
+    EXPECT_EQ(DEAD_OBJECT, clientChannel->sendMessages(msgs, sentCount))
+            << "sendMessages should have returned DEAD_OBJECT";
+    EXPECT_EQ(0u, sentCount);
+
+    size_t receivedCount;
+    EXPECT_EQ(DEAD_OBJECT, clientChannel->receiveMessages(msgs, receivedCount))
+            << "receiveMessages should have returned DEAD_OBJECT";
+    EXPECT_EQ(0u, receivedCount);
+}
+
 TEST_F(InputChannelTest, DuplicateChannelAndAssertEqual) {
     std::unique_ptr<InputChannel> serverChannel, clientChannel;
 
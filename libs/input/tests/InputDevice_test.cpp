@@ -202,6 +202,53 @@ TEST(InputDeviceKeyLayoutTest, HidUsageCodesFallbackMapping) {
     }
 }
 
+TEST(InputDeviceKeyLayoutTest, LoadingTheSameFileSharesTheMap) {
+    std::string klPath = base::GetExecutableDirectory() + "/data/hid_fallback_mapping.kl";
+    base::Result<std::shared_ptr<KeyLayoutMap>> first = KeyLayoutMap::load(klPath);
+    ASSERT_TRUE(first.ok()) << "Unable to load KeyLayout at " << klPath;
+    base::Result<std::shared_ptr<KeyLayoutMap>> second = KeyLayoutMap::load(klPath);
+    ASSERT_TRUE(second.ok()) << "Unable to load KeyLayout at " << klPath;
+    // The file is only parsed once.
+    ASSERT_EQ(first->get(), second->get());
+}
+
+TEST(InputDeviceKeyLayoutTest, ChangedFileIsParsedAgain) {
+    base::TemporaryFile klFile;
+    ASSERT_TRUE(base::WriteStringToFile("key 1 ESCAPE\n", klFile.path));
+    base::Result<std::shared_ptr<KeyLayoutMap>> ret = KeyLayoutMap::load(klFile.path);
+    ASSERT_TRUE(ret.ok()) << "Unable to load KeyLayout at " << klFile.path;
+    int32_t keyCode;
+    uint32_t flags;
+    ASSERT_EQ(OK, (*ret)->mapKey(/*scanCode=*/1, /*usageCode=*/0, &keyCode, &flags));
+    ASSERT_EQ(AKEYCODE_ESCAPE, keyCode);
+
+    ASSERT_TRUE(base::WriteStringToFile("key 1 BACK\n", klFile.path));
+    ret = KeyLayoutMap::load(klFile.path);
+    ASSERT_TRUE(ret.ok()) << "Unable to load KeyLayout at " << klFile.path;
+    ASSERT_EQ(OK, (*ret)->mapKey(/*scanCode=*/1, /*usageCode=*/0, &keyCode, &flags));
+    ASSERT_EQ(AKEYCODE_BACK, keyCode);
+}
+
+TEST(InputDeviceKeyCharacterMapTest, LoadingTheSameFileReturnsIndependentMaps) {
+    std::string kcmPath = base::GetExecutableDirectory() + "/data/german.kcm";
+    base::Result<std::shared_ptr<KeyCharacterMap>> first =
+            KeyCharacterMap::load(kcmPath, KeyCharacterMap::Format::OVERLAY);
+    ASSERT_TRUE(first.ok()) << "Cannot load KeyCharacterMap at " << kcmPath;
+    base::Result<std::shared_ptr<KeyCharacterMap>> second =
+            KeyCharacterMap::load(kcmPath, KeyCharacterMap::Format::OVERLAY);
+    ASSERT_TRUE(second.ok()) << "Cannot load KeyCharacterMap at " << kcmPath;
+    ASSERT_NE(first->get(), second->get());
+    ASSERT_EQ(**first, **second);
+
+    // Modifying one of the maps does not affect the other.
+    (*first)->addKeyRemapping(AKEYCODE_A, AKEYCODE_B);
+    ASSERT_NE(**first, **second);
+    base::Result<std::shared_ptr<KeyCharacterMap>> third =
+            KeyCharacterMap::load(kcmPath, KeyCharacterMap::Format::OVERLAY);
+    ASSERT_TRUE(third.ok()) << "Cannot load KeyCharacterMap at " << kcmPath;
+    ASSERT_EQ(**second, **third);
+}
+
 TEST(InputDeviceKeyLayoutTest, DoesNotLoadWhenRequiredKernelConfigIsMissing) {
 #if !defined(__ANDROID__)
     GTEST_SKIP() << "Can't check kernel configs on host";
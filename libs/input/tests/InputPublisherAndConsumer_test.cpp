@@ -17,6 +17,7 @@
 #include <attestation/HmacKeyManager.h>
 #include <gtest/gtest.h>
 #include <input/InputConsumer.h>
+#include <input/InputSampleRing.h>
 #include <input/InputTransport.h>
 
 using android::base::Result;
@@ -698,4 +699,147 @@ TEST_F(InputPublisherAndConsumerTest, PublishMultipleEvents_EndToEnd) {
     ASSERT_NO_FATAL_FAILURE(publishAndConsumeTouchModeEvent());
 }
 
+TEST_F(InputPublisherAndConsumerTest, PublishBatch_EndToEnd) {
+    mPublisher->beginBatch();
+    ASSERT_EQ(OK, mPublisher->publishFocusEvent(/*seq=*/1, InputEvent::nextId(),
+                                                /*hasFocus=*/true));
+    ASSERT_EQ(OK,
+              mPublisher->publishTouchModeEvent(/*seq=*/2, InputEvent::nextId(),
+                                                /*isInTouchMode=*/true));
+    ASSERT_EQ(OK, mPublisher->publishFocusEvent(/*seq=*/3, InputEvent::nextId(),
+                                                /*hasFocus=*/false));
+
+    // Nothing is written to the channel until the batch is flushed.
+    uint32_t consumeSeq;
+    InputEvent* event;
+    ASSERT_EQ(WOULD_BLOCK,
+              mConsumer->consume(&mEventFactory, /*consumeBatches=*/true, -1, &consumeSeq, &event));
+
+    size_t publishedCount;
+    ASSERT_EQ(OK, mPublisher->flushBatch(publishedCount));
+    ASSERT_EQ(3u, publishedCount);
+
+    const std::array<InputEventType, 3> expectedTypes = {InputEventType::FOCUS,
+                                                         InputEventType::TOUCH_MODE,
+                                                         InputEventType::FOCUS};
+    for (uint32_t i = 0; i < expectedTypes.size(); i++) {
+        ASSERT_EQ(OK,
+                  mConsumer->consume(&mEventFactory, /*consumeBatches=*/true, -1, &consumeSeq,
+                                     &event));
+        EXPECT_EQ(i + 1, consumeSeq);
+        EXPECT_EQ(expectedTypes[i], event->getType());
+        ASSERT_EQ(OK, mConsumer->sendFinishedSignal(consumeSeq, true));
+    }
+
+    // Outside of a batch, events are published immediately again.
+    ASSERT_EQ(OK, mPublisher->publishFocusEvent(/*seq=*/4, InputEvent::nextId(),
+                                                /*hasFocus=*/true));
+    ASSERT_EQ(OK,
+              mConsumer->consume(&mEventFactory, /*consumeBatches=*/true, -1, &consumeSeq, &event));
+    EXPECT_EQ(4u, consumeSeq);
+}
+
+// --- InputPublisherAndConsumerWithSampleRingTest ---
+
+class InputPublisherAndConsumerWithSampleRingTest : public InputPublisherAndConsumerTest {
+protected:
+    static constexpr uint32_t SAMPLE_RING_CAPACITY = 2;
+
+    void SetUp() override {
+        std::unique_ptr<InputChannel> serverChannel, clientChannel;
+        status_t result = InputChannel::openInputChannelPair("channel name", serverChannel,
+                                                             clientChannel, SAMPLE_RING_CAPACITY);
+        ASSERT_EQ(OK, result);
+        ASSERT_NE(nullptr, serverChannel->getMotionSampleRing());
+        ASSERT_NE(nullptr, clientChannel->getMotionSampleRing());
+
+        mPublisher = std::make_unique<InputPublisher>(std::move(serverChannel));
+        mConsumer = std::make_unique<InputConsumer>(std::move(clientChannel));
+    }
+
+    size_t getUsedSampleRingSlotCount() const {
+        return mPublisher->getChannel().getMotionSampleRing()->getUsedSlotCount();
+    }
+
+    void consumeMotionEvent(const PublishMotionArgs& args, nsecs_t publishTime) {
+        uint32_t consumeSeq;
+        InputEvent* event;
+        status_t status = mConsumer->consume(&mEventFactory, /*consumeBatches=*/true, -1,
+                                             &consumeSeq, &event);
+        ASSERT_EQ(OK, status) << "consumer consume should return OK";
+        ASSERT_NE(nullptr, event);
+        ASSERT_EQ(InputEventType::MOTION, event->getType());
+        EXPECT_EQ(args.seq, consumeSeq);
+        verifyArgsEqualToEvent(args, static_cast<const MotionEvent&>(*event));
+        sendAndVerifyFinishedSignal(*mConsumer, *mPublisher, args.seq, publishTime);
+    }
+};
+
+TEST_F(InputPublisherAndConsumerWithSampleRingTest, ConsumerMapsTheRingReadOnly) {
+    EXPECT_TRUE(mPublisher->getChannel().getMotionSampleRing()->isWritable());
+    EXPECT_FALSE(mConsumer->getChannel()->getMotionSampleRing()->isWritable());
+}
+
+TEST_F(InputPublisherAndConsumerWithSampleRingTest, SampleRingIsSentWithTheChannel) {
+    android::os::InputChannelCore parceledChannel;
+    mConsumer->getChannel()->copyTo(parceledChannel);
+    ASSERT_TRUE(parceledChannel.motionSampleRing.has_value());
+
+    std::unique_ptr<InputChannel> channel = InputChannel::create(std::move(parceledChannel));
+    ASSERT_NE(nullptr, channel);
+    ASSERT_NE(nullptr, channel->getMotionSampleRing());
+    EXPECT_EQ(SAMPLE_RING_CAPACITY, channel->getMotionSampleRing()->getCapacity());
+    EXPECT_FALSE(channel->getMotionSampleRing()->isWritable());
+}
+
+TEST_F(InputPublisherAndConsumerWithSampleRingTest, PublishMotionEvent_EndToEnd) {
+    const nsecs_t downTime = systemTime(SYSTEM_TIME_MONOTONIC);
+    const PublishMotionArgs args(AMOTION_EVENT_ACTION_DOWN, downTime,
+                                 {Pointer{.id = 0, .x = 20, .y = 30}}, /*seq=*/1);
+    const nsecs_t publishTime = systemTime(SYSTEM_TIME_MONOTONIC);
+    publishMotionEvent(*mPublisher, args);
+    // The slot stays in use until the consumer has finished the event.
+    ASSERT_EQ(1u, getUsedSampleRingSlotCount());
+
+    ASSERT_NO_FATAL_FAILURE(consumeMotionEvent(args, publishTime));
+    ASSERT_EQ(0u, getUsedSampleRingSlotCount());
+}
+
+TEST_F(InputPublisherAndConsumerWithSampleRingTest, FullRing_FallsBackToTheSocket) {
+    const nsecs_t downTime = systemTime(SYSTEM_TIME_MONOTONIC);
+    const PublishMotionArgs args1(AMOTION_EVENT_ACTION_DOWN, downTime,
+                                  {Pointer{.id = 0, .x = 20, .y = 30}}, /*seq=*/1);
+    const PublishMotionArgs args2(POINTER_1_DOWN, downTime,
+                                  {Pointer{.id = 0, .x = 20, .y = 30},
+                                   Pointer{.id = 1, .x = 200, .y = 300}},
+                                  /*seq=*/2);
+    const PublishMotionArgs args3(POINTER_2_DOWN, downTime,
+                                  {Pointer{.id = 0, .x = 20, .y = 30},
+                                   Pointer{.id = 1, .x = 200, .y = 300},
+                                   Pointer{.id = 2, .x = 300, .y = 400}},
+                                  /*seq=*/3);
+    const nsecs_t publishTime = systemTime(SYSTEM_TIME_MONOTONIC);
+    publishMotionEvent(*mPublisher, args1);
+    publishMotionEvent(*mPublisher, args2);
+    // There is no room left in the ring for this one.
+    publishMotionEvent(*mPublisher, args3);
+    ASSERT_EQ(SAMPLE_RING_CAPACITY, getUsedSampleRingSlotCount());
+
+    ASSERT_NO_FATAL_FAILURE(consumeMotionEvent(args1, publishTime));
+    ASSERT_NO_FATAL_FAILURE(consumeMotionEvent(args2, publishTime));
+    ASSERT_NO_FATAL_FAILURE(consumeMotionEvent(args3, publishTime));
+    ASSERT_EQ(0u, getUsedSampleRingSlotCount());
+}
+
+TEST_F(InputPublisherAndConsumerWithSampleRingTest, PublishMultipleEvents_EndToEnd) {
+    const nsecs_t downTime = systemTime(SYSTEM_TIME_MONOTONIC);
+
+    ASSERT_NO_FATAL_FAILURE(publishAndConsumeMotionDown(downTime));
+    ASSERT_NO_FATAL_FAILURE(publishAndConsumeKeyEvent());
+    ASSERT_NO_FATAL_FAILURE(publishAndConsumeFocusEvent());
+    // The consumer copies the sample out of the ring when it adds it to a batch.
+    ASSERT_NO_FATAL_FAILURE(publishAndConsumeBatchedMotionMove(downTime));
+    ASSERT_EQ(0u, getUsedSampleRingSlotCount());
+}
+
 } // namespace android
@@ -0,0 +1,104 @@
+/*
+ * Copyright (C) 2024 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include <benchmark/benchmark.h>
+
+#include <android-base/file.h>
+#include <input/InputDevice.h>
+#include <input/KeyCharacterMap.h>
+#include <input/KeyLayoutMap.h>
+
+namespace android {
+
+namespace {
+
+// The files that are loaded for every keyboard that does not have a device-specific configuration.
+std::string getGenericFilePath(InputDeviceConfigurationFileType type) {
+    return getInputDeviceConfigurationFilePathByName("Generic", type);
+}
+
+/**
+ * Loads the generic key layout the way an input device does when it is configured. After the first
+ * iteration, the parsed layout is found in the cache.
+ */
+void benchmarkLoadGenericKeyLayout(benchmark::State& state) {
+    const std::string path = getGenericFilePath(InputDeviceConfigurationFileType::KEY_LAYOUT);
+    for (auto _ : state) {
+        base::Result<std::shared_ptr<KeyLayoutMap>> map = KeyLayoutMap::load(path);
+        if (!map.ok()) {
+            state.SkipWithError("Could not load the generic key layout");
+            break;
+        }
+        benchmark::DoNotOptimize(map);
+    }
+}
+
+/**
+ * Parses the generic key layout every time, which is the cost of configuring a device without the
+ * cache.
+ */
+void benchmarkParseGenericKeyLayout(benchmark::State& state) {
+    const std::string path = getGenericFilePath(InputDeviceConfigurationFileType::KEY_LAYOUT);
+    std::string contents;
+    if (!base::ReadFileToString(path, &contents)) {
+        state.SkipWithError("Could not read the generic key layout");
+        return;
+    }
+    for (auto _ : state) {
+        base::Result<std::shared_ptr<KeyLayoutMap>> map =
+                KeyLayoutMap::loadContents(path, contents.c_str());
+        benchmark::DoNotOptimize(map);
+    }
+}
+
+void benchmarkLoadGenericKeyCharacterMap(benchmark::State& state) {
+    const std::string path =
+            getGenericFilePath(InputDeviceConfigurationFileType::KEY_CHARACTER_MAP);
+    for (auto _ : state) {
+        base::Result<std::shared_ptr<KeyCharacterMap>> map =
+                KeyCharacterMap::load(path, KeyCharacterMap::Format::BASE);
+        if (!map.ok()) {
+            state.SkipWithError("Could not load the generic key character map");
+            break;
+        }
+        benchmark::DoNotOptimize(map);
+    }
+}
+
+void benchmarkParseGenericKeyCharacterMap(benchmark::State& state) {
+    const std::string path =
+            getGenericFilePath(InputDeviceConfigurationFileType::KEY_CHARACTER_MAP);
+    std::string contents;
+    if (!base::ReadFileToString(path, &contents)) {
+        state.SkipWithError("Could not read the generic key character map");
+        return;
+    }
+    for (auto _ : state) {
+        base::Result<std::shared_ptr<KeyCharacterMap>> map =
+                KeyCharacterMap::loadContents(path, contents.c_str(),
+                                              KeyCharacterMap::Format::BASE);
+        benchmark::DoNotOptimize(map);
+    }
+}
+
+} // namespace
+
+BENCHMARK(benchmarkLoadGenericKeyLayout);
+BENCHMARK(benchmarkParseGenericKeyLayout);
+BENCHMARK(benchmarkLoadGenericKeyCharacterMap);
+BENCHMARK(benchmarkParseGenericKeyCharacterMap);
+
+} // namespace android
@@ -107,6 +107,9 @@ void TestInputMessageAlignment() {
   CHECK_OFFSET(InputMessage::Body::TouchMode, eventId, 0);
   CHECK_OFFSET(InputMessage::Body::TouchMode, isInTouchMode, 4);
   CHECK_OFFSET(InputMessage::Body::TouchMode, empty, 5);
+
+  CHECK_OFFSET(InputMessage::Body::MotionSample, slot, 0);
+  CHECK_OFFSET(InputMessage::Body::MotionSample, generation, 4);
 }
 
 void TestHeaderSize() {
@@ -126,6 +129,7 @@ void TestBodySize() {
     static_assert(sizeof(InputMessage::Body::Capture) == 8);
     static_assert(sizeof(InputMessage::Body::Drag) == 16);
     static_assert(sizeof(InputMessage::Body::TouchMode) == 8);
+    static_assert(sizeof(InputMessage::Body::MotionSample) == 8);
     // Timeline
     static_assert(GraphicsTimeline::SIZE == 2);
     static_assert(sizeof(InputMessage::Body::Timeline) == 24);
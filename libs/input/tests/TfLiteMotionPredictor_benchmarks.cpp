@@ -0,0 +1,73 @@
+/*
+ * Copyright (C) 2024 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include <algorithm>
+#include <chrono>
+#include <memory>
+#include <vector>
+
+#include <benchmark/benchmark.h>
+
+#include <input/TfLiteMotionPredictor.h>
+
+namespace android {
+
+namespace {
+
+/**
+ * Returns the given percentile of the latencies, in microseconds. Sorts the latencies.
+ */
+double percentileMicros(std::vector<std::chrono::nanoseconds>& latencies, double percentile) {
+    if (latencies.empty()) {
+        return 0;
+    }
+    std::sort(latencies.begin(), latencies.end());
+    const size_t index = std::min(latencies.size() - 1,
+                                  static_cast<size_t>(percentile / 100 * latencies.size()));
+    return std::chrono::duration<double, std::micro>(latencies[index]).count();
+}
+
+/**
+ * Runs the model on the inputs of TfLiteMotionPredictorTest.ModelOutput, the same way as
+ * MotionPredictor::predict does, and reports the median and tail latencies of a prediction.
+ */
+void benchmarkModelInvoke(benchmark::State& state) {
+    std::unique_ptr<TfLiteMotionPredictorModel> model = TfLiteMotionPredictorModel::create();
+    TfLiteMotionPredictorBuffers buffers(model->inputLength());
+    buffers.pushSample(/*timestamp=*/1, {.position = {.x = 100, .y = 200}, .pressure = 0.2});
+    buffers.pushSample(/*timestamp=*/2, {.position = {.x = 150, .y = 250}, .pressure = 0.4});
+    buffers.pushSample(/*timestamp=*/3, {.position = {.x = 180, .y = 280}, .pressure = 0.6});
+
+    std::vector<std::chrono::nanoseconds> latencies;
+    for (auto _ : state) {
+        const auto start = std::chrono::steady_clock::now();
+        buffers.copyTo(*model);
+        if (!model->invoke()) {
+            state.SkipWithError("Failed to invoke the model");
+            break;
+        }
+        benchmark::DoNotOptimize(model->outputR().data());
+        latencies.push_back(std::chrono::steady_clock::now() - start);
+    }
+    state.counters["p50_us"] = percentileMicros(latencies, 50);
+    state.counters["p99_us"] = percentileMicros(latencies, 99);
+}
+
+} // namespace
+
+BENCHMARK(benchmarkModelInvoke);
+
+} // namespace android
@@ -20,6 +20,7 @@
 #include <ios>
 #include <iterator>
 #include <string>
+#include <vector>
 
 #include <gmock/gmock.h>
 #include <gtest/gtest.h>
@@ -30,6 +31,7 @@ namespace {
 
 using ::testing::Each;
 using ::testing::ElementsAre;
+using ::testing::ElementsAreArray;
 using ::testing::FloatNear;
 
 TEST(TfLiteMotionPredictorTest, BuffersReadiness) {
@@ -165,5 +167,28 @@ TEST(TfLiteMotionPredictorTest, ModelOutput) {
             std::all_of(model->outputPressure().begin(), model->outputPressure().end(), is_valid));
 }
 
+TEST(TfLiteMotionPredictorTest, ModelBuffersAreReusedAcrossInvocations) {
+    std::unique_ptr<TfLiteMotionPredictorModel> model = TfLiteMotionPredictorModel::create();
+    TfLiteMotionPredictorBuffers buffers(model->inputLength());
+
+    buffers.pushSample(/*timestamp=*/1, {.position = {.x = 100, .y = 200}, .pressure = 0.2});
+    buffers.pushSample(/*timestamp=*/2, {.position = {.x = 150, .y = 250}, .pressure = 0.4});
+    buffers.pushSample(/*timestamp=*/3, {.position = {.x = 180, .y = 280}, .pressure = 0.6});
+    buffers.copyTo(*model);
+    ASSERT_TRUE(model->invoke());
+
+    const std::span<const float> outputR = model->outputR();
+    const std::vector<float> firstR(outputR.begin(), outputR.end());
+    const float* inputR = model->inputR().data();
+
+    // Running the model again on the same input reuses the same buffers, and produces the same
+    // predictions.
+    buffers.copyTo(*model);
+    ASSERT_TRUE(model->invoke());
+    ASSERT_EQ(inputR, model->inputR().data());
+    ASSERT_EQ(outputR.data(), model->outputR().data());
+    ASSERT_THAT(model->outputR(), ElementsAreArray(firstR));
+}
+
 } // namespace
 } // namespace android
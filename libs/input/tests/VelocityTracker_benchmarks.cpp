@@ -0,0 +1,65 @@
+/*
+ * Copyright (C) 2024 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include <benchmark/benchmark.h>
+
+#include <input/VelocityTracker.h>
+
+namespace android {
+
+namespace {
+
+constexpr size_t POINTER_COUNT = 10;
+// 120 Hz.
+constexpr nsecs_t SAMPLE_INTERVAL = 8333333;
+
+/**
+ * Simulates a fling of POINTER_COUNT pointers, and queries the velocity of every pointer after
+ * every sample, like an app that tracks the velocity of all pointers while they move.
+ */
+void benchmarkFling(benchmark::State& state, VelocityTracker::Strategy strategy) {
+    VelocityTracker tracker(strategy);
+    nsecs_t eventTime = 0;
+    float positions[POINTER_COUNT] = {};
+    for (auto _ : state) {
+        eventTime += SAMPLE_INTERVAL;
+        for (size_t id = 0; id < POINTER_COUNT; id++) {
+            positions[id] += 10.0f + id;
+            tracker.addMovement(eventTime, id, AMOTION_EVENT_AXIS_X, positions[id]);
+            tracker.addMovement(eventTime, id, AMOTION_EVENT_AXIS_Y, -positions[id]);
+        }
+        for (size_t id = 0; id < POINTER_COUNT; id++) {
+            benchmark::DoNotOptimize(tracker.getVelocity(AMOTION_EVENT_AXIS_X, id));
+            benchmark::DoNotOptimize(tracker.getVelocity(AMOTION_EVENT_AXIS_Y, id));
+        }
+    }
+    state.SetItemsProcessed(state.iterations() * POINTER_COUNT);
+}
+
+void benchmarkFlingLsq2(benchmark::State& state) {
+    benchmarkFling(state, VelocityTracker::Strategy::LSQ2);
+}
+
+void benchmarkFlingLsq2Incremental(benchmark::State& state) {
+    benchmarkFling(state, VelocityTracker::Strategy::LSQ2_INCREMENTAL);
+}
+
+} // namespace
+
+BENCHMARK(benchmarkFlingLsq2);
+BENCHMARK(benchmarkFlingLsq2Incremental);
+
+} // namespace android
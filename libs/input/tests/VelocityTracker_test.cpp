@@ -23,6 +23,7 @@
 
 #include <android-base/stringprintf.h>
 #include <attestation/HmacKeyManager.h>
+#include <ftl/enum.h>
 #include <gtest/gtest.h>
 #include <input/VelocityTracker.h>
 
@@ -269,17 +270,64 @@ static void computeAndCheckAxisScrollVelocity(
 
 static void computeAndCheckQuadraticVelocity(const std::vector<PlanarMotionEventEntry>& motions,
                                              float velocity) {
-    std::optional<float> velocityX =
-            computePlanarVelocity(VelocityTracker::Strategy::LSQ2, motions, AMOTION_EVENT_AXIS_X,
-                                  DEFAULT_POINTER_ID);
-    std::optional<float> velocityY =
-            computePlanarVelocity(VelocityTracker::Strategy::LSQ2, motions, AMOTION_EVENT_AXIS_Y,
-                                  DEFAULT_POINTER_ID);
-    ASSERT_TRUE(velocityX);
-    ASSERT_TRUE(velocityY);
+    for (const VelocityTracker::Strategy strategy :
+         {VelocityTracker::Strategy::LSQ2, VelocityTracker::Strategy::LSQ2_INCREMENTAL}) {
+        SCOPED_TRACE(ftl::enum_string(strategy));
+        std::optional<float> velocityX =
+                computePlanarVelocity(strategy, motions, AMOTION_EVENT_AXIS_X, DEFAULT_POINTER_ID);
+        std::optional<float> velocityY =
+                computePlanarVelocity(strategy, motions, AMOTION_EVENT_AXIS_Y, DEFAULT_POINTER_ID);
+        ASSERT_TRUE(velocityX);
+        ASSERT_TRUE(velocityY);
+
+        EXPECT_NEAR_BY_FRACTION(*velocityX, velocity, QUADRATIC_VELOCITY_TOLERANCE);
+        EXPECT_NEAR_BY_FRACTION(*velocityY, velocity, QUADRATIC_VELOCITY_TOLERANCE);
+    }
+}
 
-    EXPECT_NEAR_BY_FRACTION(*velocityX, velocity, QUADRATIC_VELOCITY_TOLERANCE);
-    EXPECT_NEAR_BY_FRACTION(*velocityY, velocity, QUADRATIC_VELOCITY_TOLERANCE);
+/**
+ * Feeds a fling of several pointers, sampled at the given interval, into a LSQ2 and a
+ * LSQ2_INCREMENTAL tracker, and checks that both report the same velocities after every sample.
+ * Each pointer moves along a parabola with its own initial velocity and deceleration.
+ */
+static void checkIncrementalMatchesLeastSquares(size_t pointerCount,
+                                                std::chrono::nanoseconds interval,
+                                                size_t sampleCount) {
+    VelocityTracker lsq2(VelocityTracker::Strategy::LSQ2);
+    VelocityTracker incremental(VelocityTracker::Strategy::LSQ2_INCREMENTAL);
+
+    const std::chrono::nanoseconds downTime = 1234567890ns;
+    for (size_t i = 0; i < sampleCount; i++) {
+        const std::chrono::nanoseconds elapsed = interval * static_cast<int64_t>(i);
+        const nsecs_t eventTime = (downTime + elapsed).count();
+        const float t = std::chrono::duration<float>(elapsed).count();
+        for (size_t id = 0; id < pointerCount; id++) {
+            const float velocityX = 500.0f + 300.0f * id;
+            const float velocityY = -800.0f + 150.0f * id;
+            const float deceleration = -2000.0f * (id + 1);
+            const float x = 100.0f + 60.0f * id + velocityX * t + 0.5f * deceleration * t * t;
+            const float y = 2000.0f - 90.0f * id + velocityY * t - 0.5f * deceleration * t * t;
+            lsq2.addMovement(eventTime, id, AMOTION_EVENT_AXIS_X, x);
+            lsq2.addMovement(eventTime, id, AMOTION_EVENT_AXIS_Y, y);
+            incremental.addMovement(eventTime, id, AMOTION_EVENT_AXIS_X, x);
+            incremental.addMovement(eventTime, id, AMOTION_EVENT_AXIS_Y, y);
+        }
+
+        for (size_t id = 0; id < pointerCount; id++) {
+            for (int32_t axis : {AMOTION_EVENT_AXIS_X, AMOTION_EVENT_AXIS_Y}) {
+                SCOPED_TRACE(StringPrintf("sample %zu, pointer %zu, axis %s", i, id,
+                                          MotionEvent::getLabel(axis)));
+                const std::optional<float> expected = lsq2.getVelocity(axis, id);
+                const std::optional<float> actual = incremental.getVelocity(axis, id);
+                ASSERT_EQ(expected.has_value(), actual.has_value());
+                if (expected) {
+                    // LSQ2 accumulates its sums in single precision, so allow for its rounding
+                    // errors when the velocity gets close to zero.
+                    EXPECT_NEAR(*actual, *expected, std::max(1.0f, fabsf(*expected) * 1E-3f));
+                }
+            }
+        }
+    }
 }
 
 /*
@@ -1334,6 +1382,32 @@ TEST_F(VelocityTrackerTest, LeastSquaresVelocityTrackerStrategy_Parabolic3) {
     computeAndCheckQuadraticVelocity(motions, 0E3);
 }
 
+TEST_F(VelocityTrackerTest, IncrementalLeastSquares_TenPointerFling) {
+    // 60 Hz: the history is limited by the horizon.
+    checkIncrementalMatchesLeastSquares(/*pointerCount=*/10, 16666667ns, /*sampleCount=*/40);
+    // 120 Hz.
+    checkIncrementalMatchesLeastSquares(/*pointerCount=*/10, 8333333ns, /*sampleCount=*/80);
+    // 500 Hz: the history is limited by its size, and not by the horizon.
+    checkIncrementalMatchesLeastSquares(/*pointerCount=*/10, 2ms, /*sampleCount=*/200);
+}
+
+TEST_F(VelocityTrackerTest, IncrementalLeastSquares_ReplacesMovementWithSameEventTime) {
+    VelocityTracker vt(VelocityTracker::Strategy::LSQ2_INCREMENTAL);
+    vt.addMovement(0, DEFAULT_POINTER_ID, AMOTION_EVENT_AXIS_X, 0);
+    vt.addMovement(10'000'000, DEFAULT_POINTER_ID, AMOTION_EVENT_AXIS_X, 100);
+    vt.addMovement(20'000'000, DEFAULT_POINTER_ID, AMOTION_EVENT_AXIS_X, 900);
+    // Only the last position reported for a given time is used.
+    vt.addMovement(20'000'000, DEFAULT_POINTER_ID, AMOTION_EVENT_AXIS_X, 200);
+    ASSERT_TRUE(vt.getVelocity(AMOTION_EVENT_AXIS_X, DEFAULT_POINTER_ID));
+    EXPECT_NEAR_BY_FRACTION(*vt.getVelocity(AMOTION_EVENT_AXIS_X, DEFAULT_POINTER_ID), 10000,
+                            QUADRATIC_VELOCITY_TOLERANCE);
+
+    // A single movement is not enough to compute a velocity.
+    vt.clearPointer(DEFAULT_POINTER_ID);
+    vt.addMovement(30'000'000, DEFAULT_POINTER_ID, AMOTION_EVENT_AXIS_X, 300);
+    EXPECT_FALSE(vt.getVelocity(AMOTION_EVENT_AXIS_X, DEFAULT_POINTER_ID));
+}
+
 // Recorded by hand on sailfish, but only the diffs are taken to test cumulative axis velocity.
 TEST_F(VelocityTrackerTest, AxisScrollVelocity) {
     std::vector<std::pair<std::chrono::nanoseconds, float>> motions = {
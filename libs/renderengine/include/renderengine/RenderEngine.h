@@ -54,6 +54,15 @@
  */
 #define PROPERTY_DEBUG_RENDERENGINE_BLUR_ALGORITHM "debug.renderengine.blur_algorithm"
 
+/**
+ * Limits the memory of the buffers that RenderEngine keeps imported as textures, in megabytes. The
+ * least recently used textures are released when the limit is exceeded, and imported again when
+ * they are drawn. 0, the default, means no limit. Read by SurfaceFlinger, which passes it to
+ * RenderEngineCreationArgs::Builder::setTextureCacheBudget().
+ */
+#define PROPERTY_DEBUG_RENDERENGINE_TEXTURE_CACHE_BUDGET_MB \
+    "debug.renderengine.texture_cache_budget_mb"
+
 /**
  * Allows recording of Skia drawing commands with systrace.
  */
@@ -306,6 +315,9 @@ struct RenderEngineCreationArgs {
     bool enableProtectedContext;
     bool precacheToneMapperShaderOnly;
     RenderEngine::BlurAlgorithm blurAlgorithm;
+    // The memory, in bytes, of the buffers that RenderEngine keeps imported as textures, or 0 for
+    // no limit.
+    size_t textureCacheBudget;
     RenderEngine::ContextPriority contextPriority;
     RenderEngine::Threaded threaded;
     RenderEngine::GraphicsApi graphicsApi;
@@ -318,6 +330,7 @@ private:
     RenderEngineCreationArgs(int _pixelFormat, uint32_t _imageCacheSize,
                              bool _enableProtectedContext, bool _precacheToneMapperShaderOnly,
                              RenderEngine::BlurAlgorithm _blurAlgorithm,
+                             size_t _textureCacheBudget,
                              RenderEngine::ContextPriority _contextPriority,
                              RenderEngine::Threaded _threaded,
                              RenderEngine::GraphicsApi _graphicsApi,
@@ -327,6 +340,7 @@ private:
             enableProtectedContext(_enableProtectedContext),
             precacheToneMapperShaderOnly(_precacheToneMapperShaderOnly),
             blurAlgorithm(_blurAlgorithm),
+            textureCacheBudget(_textureCacheBudget),
             contextPriority(_contextPriority),
             threaded(_threaded),
             graphicsApi(_graphicsApi),
@@ -357,6 +371,10 @@ struct RenderEngineCreationArgs::Builder {
         this->blurAlgorithm = blurAlgorithm;
         return *this;
     }
+    Builder& setTextureCacheBudget(size_t textureCacheBudget) {
+        this->textureCacheBudget = textureCacheBudget;
+        return *this;
+    }
     Builder& setContextPriority(RenderEngine::ContextPriority contextPriority) {
         this->contextPriority = contextPriority;
         return *this;
@@ -376,7 +394,8 @@ struct RenderEngineCreationArgs::Builder {
     RenderEngineCreationArgs build() const {
         return RenderEngineCreationArgs(pixelFormat, imageCacheSize, enableProtectedContext,
                                         precacheToneMapperShaderOnly, blurAlgorithm,
-                                        contextPriority, threaded, graphicsApi, skiaBackend);
+                                        textureCacheBudget, contextPriority, threaded, graphicsApi,
+                                        skiaBackend);
     }
 
 private:
@@ -386,6 +405,7 @@ private:
     bool enableProtectedContext = false;
     bool precacheToneMapperShaderOnly = false;
     RenderEngine::BlurAlgorithm blurAlgorithm = RenderEngine::BlurAlgorithm::NONE;
+    size_t textureCacheBudget = 0;
     RenderEngine::ContextPriority contextPriority = RenderEngine::ContextPriority::MEDIUM;
     RenderEngine::Threaded threaded = RenderEngine::Threaded::YES;
     RenderEngine::GraphicsApi graphicsApi = RenderEngine::GraphicsApi::GL;
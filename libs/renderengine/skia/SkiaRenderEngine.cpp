@@ -246,6 +246,19 @@ namespace skia {
 
 using base::StringAppendF;
 
+// The GPU may still read the textures of the frames that were drawn last, so these are not evicted
+// from the texture cache.
+static constexpr uint64_t kTextureCacheFramesInFlight = 2;
+
+// Estimates the memory of a buffer. bytesPerPixel() does not know YUV formats, most of which are
+// 4:2:0 with 1.5 bytes per pixel.
+static size_t estimateBufferBytes(const sp<GraphicBuffer>& buffer) {
+    const size_t pixels = static_cast<size_t>(buffer->getStride()) * buffer->getHeight() *
+            buffer->getLayerCount();
+    const uint32_t bpp = bytesPerPixel(buffer->getPixelFormat());
+    return bpp ? pixels * bpp : pixels * 3 / 2;
+}
+
 std::future<void> SkiaRenderEngine::primeCache(PrimeCacheConfig config) {
     Cache::primeShaderCache(this, config);
     return {};
@@ -273,8 +286,10 @@ void SkiaRenderEngine::setEnableTracing(bool tracingEnabled) {
 }
 
 SkiaRenderEngine::SkiaRenderEngine(Threaded threaded, PixelFormat pixelFormat,
-                                   BlurAlgorithm blurAlgorithm)
-      : RenderEngine(threaded), mDefaultPixelFormat(pixelFormat) {
+                                   BlurAlgorithm blurAlgorithm, size_t textureCacheBudget)
+      : RenderEngine(threaded),
+        mDefaultPixelFormat(pixelFormat),
+        mTextureCacheBudget(textureCacheBudget) {
     switch (blurAlgorithm) {
         case BlurAlgorithm::GAUSSIAN: {
             ALOGD("Background Blurs Enabled (Gaussian algorithm)");
@@ -436,7 +451,12 @@ void SkiaRenderEngine::mapExternalTextureBuffer(const sp<GraphicBuffer>& buffer,
         auto imageTextureRef =
                 std::make_shared<AutoBackendTexture::LocalRef>(std::move(backendTexture),
                                                                mTextureCleanupMgr);
-        cache.insert({buffer->getId(), imageTextureRef});
+        CachedTexture& cached = cache[buffer->getId()];
+        cached.isRenderable = isRenderable;
+        cached.bytes = estimateBufferBytes(buffer);
+        setCachedTexture(buffer->getId(), cached, std::move(imageTextureRef));
+        useCachedTexture(cached);
+        evictCachedTextures();
     }
 }
 
@@ -466,7 +486,10 @@ void SkiaRenderEngine::unmapExternalTextureBuffer(sp<GraphicBuffer>&& buffer) {
         useProtectedContext(buffer->getUsage() & GRALLOC_USAGE_PROTECTED);
 
         if (iter->second == 0) {
-            mTextureCache.erase(buffer->getId());
+            if (const auto& it = mTextureCache.find(buffer->getId()); it != mTextureCache.end()) {
+                releaseCachedTexture(it->second);
+                mTextureCache.erase(it);
+            }
             mGraphicBufferExternalRefs.erase(buffer->getId());
         }
 
@@ -483,7 +506,23 @@ std::shared_ptr<AutoBackendTexture::LocalRef> SkiaRenderEngine::getOrCreateBacke
     // Do not lookup the buffer in the cache for protected contexts
     if (!isProtected()) {
         if (const auto& it = mTextureCache.find(buffer->getId()); it != mTextureCache.end()) {
-            return it->second;
+            CachedTexture& cached = it->second;
+            if (cached.texture) {
+                mTextureCacheStats.hits++;
+                useCachedTexture(cached);
+                return cached.texture;
+            }
+            // The texture was evicted while the buffer stayed mapped.
+            mTextureCacheStats.misses++;
+            std::unique_ptr<SkiaBackendTexture> backendTexture =
+                    getActiveContext()->makeBackendTexture(buffer->toAHardwareBuffer(),
+                                                           cached.isRenderable || isOutputBuffer);
+            auto texture = std::make_shared<AutoBackendTexture::LocalRef>(std::move(backendTexture),
+                                                                          mTextureCleanupMgr);
+            setCachedTexture(it->first, cached, std::move(texture));
+            useCachedTexture(cached);
+            evictCachedTextures();
+            return cached.texture;
         }
     }
     std::unique_ptr<SkiaBackendTexture> backendTexture =
@@ -492,6 +531,45 @@ std::shared_ptr<AutoBackendTexture::LocalRef> SkiaRenderEngine::getOrCreateBacke
                                                           mTextureCleanupMgr);
 }
 
+void SkiaRenderEngine::setCachedTexture(GraphicBufferId id, CachedTexture& cached,
+                                        std::shared_ptr<AutoBackendTexture::LocalRef> texture) {
+    cached.texture = std::move(texture);
+    cached.lruPosition = mTextureLru.insert(mTextureLru.begin(), id);
+    mTextureCacheStats.bytes += cached.bytes;
+    mTextureCacheStats.peakBytes =
+            std::max(mTextureCacheStats.peakBytes, mTextureCacheStats.bytes);
+}
+
+void SkiaRenderEngine::useCachedTexture(CachedTexture& cached) {
+    cached.lastUsedFrame = mFrameCount;
+    mTextureLru.splice(mTextureLru.begin(), mTextureLru, cached.lruPosition);
+}
+
+void SkiaRenderEngine::releaseCachedTexture(CachedTexture& cached) {
+    if (!cached.texture) {
+        return;
+    }
+    // If a frame is being drawn, the texture is deleted by cleanupPostRender.
+    cached.texture.reset();
+    mTextureLru.erase(cached.lruPosition);
+    mTextureCacheStats.bytes -= cached.bytes;
+}
+
+void SkiaRenderEngine::evictCachedTextures() {
+    if (mTextureCacheBudget == 0) {
+        return;
+    }
+    while (mTextureCacheStats.bytes > mTextureCacheBudget && !mTextureLru.empty()) {
+        CachedTexture& cached = mTextureCache.at(mTextureLru.back());
+        // The textures before it in the list were used at least as recently.
+        if (mFrameCount - cached.lastUsedFrame < kTextureCacheFramesInFlight) {
+            break;
+        }
+        releaseCachedTexture(cached);
+        mTextureCacheStats.evictions++;
+    }
+}
+
 bool SkiaRenderEngine::canSkipPostRenderCleanup() const {
     std::lock_guard<std::mutex> lock(mRenderingMutex);
     return mTextureCleanupMgr.isEmpty();
@@ -701,6 +779,7 @@ void SkiaRenderEngine::drawLayersInternal(
 
     // any AutoBackendTexture deletions will now be deferred until cleanupPostRender is called
     DeferTextureCleanup dtc(mTextureCleanupMgr);
+    mFrameCount++;
 
     auto surfaceTextureRef = getOrCreateBackendTexture(buffer->getBuffer(), true);
 
@@ -1269,12 +1348,38 @@ void SkiaRenderEngine::dump(std::string& result) {
         }
         StringAppendF(&result, "RenderEngine AHB/BackendTexture cache size: %zu\n",
                       mTextureCache.size());
+        StringAppendF(&result,
+                      "RenderEngine texture cache: %.2f MB (peak %.2f MB) of %.2f MB budget, "
+                      "%" PRIu64 " hits, %" PRIu64 " misses, %" PRIu64 " evictions\n",
+                      mTextureCacheStats.bytes / (1024.0 * 1024.0),
+                      mTextureCacheStats.peakBytes / (1024.0 * 1024.0),
+                      mTextureCacheBudget / (1024.0 * 1024.0), mTextureCacheStats.hits,
+                      mTextureCacheStats.misses, mTextureCacheStats.evictions);
         StringAppendF(&result, "Dumping buffer ids...\n");
-        // TODO(178539829): It would be nice to know which layer these are coming from and what
-        // the texture sizes are.
-        for (const auto& [id, unused] : mTextureCache) {
-            StringAppendF(&result, "- 0x%" PRIx64 "\n", id);
+        // TODO(178539829): It would be nice to know which layer these are coming from.
+        const std::vector<ResourcePair> textureCacheResourceMap = {
+                {"renderengine/texture_cache", "Cached buffer textures"},
+        };
+        SkiaMemoryReporter textureCacheReporter(textureCacheResourceMap, true);
+        for (const auto& [id, cached] : mTextureCache) {
+            StringAppendF(&result, "- 0x%" PRIx64 "%s\n", id, cached.texture ? "" : " (evicted)");
+            if (!cached.texture) {
+                continue;
+            }
+            const uint64_t framesSinceUse = mFrameCount - cached.lastUsedFrame;
+            const std::string name =
+                    base::StringPrintf("renderengine/texture_cache/0x%" PRIx64, id);
+            textureCacheReporter.dumpNumericValue(name.c_str(), "size", "bytes", cached.bytes);
+            if (framesSinceUse >= kTextureCacheFramesInFlight) {
+                textureCacheReporter.dumpNumericValue(name.c_str(), "purgeable_size", "bytes",
+                                                      cached.bytes);
+            }
+            textureCacheReporter.dumpNumericValue(name.c_str(), "frames_since_use", "frames",
+                                                  framesSinceUse);
         }
+        StringAppendF(&result, "RenderEngine Texture Cache: ");
+        textureCacheReporter.logTotals(result);
+        textureCacheReporter.logOutput(result);
         StringAppendF(&result, "\n");
 
         SkiaMemoryReporter gpuProtectedReporter(gpuResourceMap, true);
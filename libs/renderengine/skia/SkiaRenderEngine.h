@@ -27,6 +27,7 @@
 #include <renderengine/RenderEngine.h>
 #include <sys/types.h>
 
+#include <list>
 #include <memory>
 #include <mutex>
 #include <unordered_map>
@@ -59,7 +60,7 @@ class BlurFilter;
 class SkiaRenderEngine : public RenderEngine {
 public:
     static std::unique_ptr<SkiaRenderEngine> create(const RenderEngineCreationArgs& args);
-    SkiaRenderEngine(Threaded, PixelFormat pixelFormat, BlurAlgorithm);
+    SkiaRenderEngine(Threaded, PixelFormat pixelFormat, BlurAlgorithm, size_t textureCacheBudget);
     ~SkiaRenderEngine() override;
 
     std::future<void> primeCache(PrimeCacheConfig config) override final;
@@ -169,11 +170,50 @@ private:
     // textures or shaders
     using GraphicBufferId = uint64_t;
 
+    // A texture of a mapped buffer. Its texture is released when the cache exceeds its budget,
+    // and imported again the next time the buffer is drawn.
+    struct CachedTexture {
+        std::shared_ptr<AutoBackendTexture::LocalRef> texture;
+        bool isRenderable = false;
+        // The estimated memory of the buffer.
+        size_t bytes = 0;
+        // The value of mFrameCount when the texture was last mapped or drawn.
+        uint64_t lastUsedFrame = 0;
+        // The position in mTextureLru, while the texture is not released.
+        std::list<GraphicBufferId>::iterator lruPosition;
+    };
+
+    struct TextureCacheStats {
+        // The memory of the buffers whose textures are not released.
+        size_t bytes = 0;
+        size_t peakBytes = 0;
+        // Draws of mapped buffers whose textures were cached or had to be imported again.
+        uint64_t hits = 0;
+        uint64_t misses = 0;
+        uint64_t evictions = 0;
+    };
+
+    void setCachedTexture(GraphicBufferId id, CachedTexture& cached,
+                          std::shared_ptr<AutoBackendTexture::LocalRef> texture)
+            REQUIRES(mRenderingMutex);
+    void useCachedTexture(CachedTexture& cached) REQUIRES(mRenderingMutex);
+    void releaseCachedTexture(CachedTexture& cached) REQUIRES(mRenderingMutex);
+    // Releases the least recently used textures until the cache is within its budget, except
+    // for the textures of the frames that the GPU may still be working on.
+    void evictCachedTextures() REQUIRES(mRenderingMutex);
+
     // Number of external holders of ExternalTexture references, per GraphicBuffer ID.
     std::unordered_map<GraphicBufferId, int32_t> mGraphicBufferExternalRefs
             GUARDED_BY(mRenderingMutex);
-    std::unordered_map<GraphicBufferId, std::shared_ptr<AutoBackendTexture::LocalRef>> mTextureCache
-            GUARDED_BY(mRenderingMutex);
+    std::unordered_map<GraphicBufferId, CachedTexture> mTextureCache GUARDED_BY(mRenderingMutex);
+    // The buffer IDs of the textures in mTextureCache that are not released, the most recently
+    // used first.
+    std::list<GraphicBufferId> mTextureLru GUARDED_BY(mRenderingMutex);
+    TextureCacheStats mTextureCacheStats GUARDED_BY(mRenderingMutex);
+    // 0 if the texture cache has no budget.
+    const size_t mTextureCacheBudget;
+    // The number of frames drawn so far.
+    uint64_t mFrameCount GUARDED_BY(mRenderingMutex) = 0;
     std::unordered_map<shaders::LinearEffect, sk_sp<SkRuntimeEffect>, shaders::LinearEffectHasher>
             mRuntimeEffects;
     AutoBackendTexture::CleanupManager mTextureCleanupMgr GUARDED_BY(mRenderingMutex);
@@ -22,8 +22,10 @@
 #pragma clang diagnostic ignored "-Wconversion"
 #pragma clang diagnostic ignored "-Wextra"
 
+#include <android-base/stringprintf.h>
 #include <com_android_graphics_surfaceflinger_flags.h>
 #include <cutils/properties.h>
+#include <gmock/gmock.h>
 #include <gtest/gtest.h>
 #include <renderengine/ExternalTexture.h>
 #include <renderengine/RenderEngine.h>
@@ -118,7 +120,7 @@ public:
     virtual renderengine::RenderEngine::GraphicsApi graphicsApi() = 0;
     virtual renderengine::RenderEngine::SkiaBackend skiaBackend() = 0;
     bool apiSupported() { return renderengine::RenderEngine::canSupport(graphicsApi()); }
-    std::unique_ptr<renderengine::RenderEngine> createRenderEngine() {
+    std::unique_ptr<renderengine::RenderEngine> createRenderEngine(size_t textureCacheBudget = 0) {
         renderengine::RenderEngineCreationArgs reCreationArgs =
                 renderengine::RenderEngineCreationArgs::Builder()
                         .setPixelFormat(static_cast<int>(ui::PixelFormat::RGBA_8888))
@@ -126,6 +128,7 @@ public:
                         .setEnableProtectedContext(false)
                         .setPrecacheToneMapperShaderOnly(false)
                         .setBlurAlgorithm(renderengine::RenderEngine::BlurAlgorithm::KAWASE)
+                        .setTextureCacheBudget(textureCacheBudget)
                         .setContextPriority(renderengine::RenderEngine::ContextPriority::MEDIUM)
                         .setThreaded(renderengine::RenderEngine::Threaded::NO)
                         .setGraphicsApi(graphicsApi())
@@ -596,15 +599,53 @@ public:
     void tonemap(ui::Dataspace sourceDataspace, std::function<vec3(vec3)> eotf,
                  std::function<vec3(vec3, float)> scaleOotf);
 
-    void initializeRenderEngine();
+    void initializeRenderEngine(size_t textureCacheBudget = 0);
+
+    // The memory that RenderEngine accounts to the texture of an RGBA_8888 buffer.
+    static size_t estimateTextureBytes(uint32_t width, uint32_t height, uint64_t usage) {
+        const auto buffer = sp<GraphicBuffer>::make(width, height, HAL_PIXEL_FORMAT_RGBA_8888, 1,
+                                                    usage, "estimate");
+        return static_cast<size_t>(buffer->getStride()) * height * 4;
+    }
+
+    // Draws the buffer over the whole display, or nothing if it is null.
+    void drawTextureCacheFrame(const std::shared_ptr<renderengine::ExternalTexture>& buffer) {
+        renderengine::DisplaySettings settings;
+        settings.physicalDisplay = fullscreenRect();
+        settings.clip = fullscreenRect();
+        settings.outputDataspace = ui::Dataspace::V0_SRGB_LINEAR;
+
+        std::vector<renderengine::LayerSettings> layers;
+        if (buffer) {
+            renderengine::LayerSettings layer;
+            layer.sourceDataspace = ui::Dataspace::V0_SRGB_LINEAR;
+            layer.geometry.boundaries = fullscreenRect().toFloatRect();
+            layer.source.buffer.buffer = buffer;
+            layer.source.buffer.isOpaque = true;
+            layer.alpha = 1.0f;
+            layers.push_back(layer);
+        }
+        invokeDraw(settings, layers);
+    }
+
+    std::string dumpRenderEngine() {
+        std::string result;
+        mRE->dump(result);
+        return result;
+    }
+
+    static std::string evictedTextureLine(
+            const std::shared_ptr<renderengine::ExternalTexture>& buffer) {
+        return base::StringPrintf("- 0x%" PRIx64 " (evicted)\n", buffer->getBuffer()->getId());
+    }
 
     std::unique_ptr<renderengine::RenderEngine> mRE;
     std::shared_ptr<renderengine::ExternalTexture> mBuffer;
 };
 
-void RenderEngineTest::initializeRenderEngine() {
+void RenderEngineTest::initializeRenderEngine(size_t textureCacheBudget) {
     const auto& renderEngineFactory = GetParam();
-    mRE = renderEngineFactory->createRenderEngine();
+    mRE = renderEngineFactory->createRenderEngine(textureCacheBudget);
     mBuffer = allocateDefaultBuffer();
 }
 
@@ -2272,6 +2313,113 @@ TEST_P(RenderEngineTest, cleanupPostRender_cleansUpOnce) {
     }
 }
 
+// The textures of the last two frames are never evicted from the texture cache.
+constexpr size_t kTextureCacheFramesInFlight = 2;
+constexpr uint32_t kTextureCacheSourceSize = 64;
+
+// The texture cache budget, in textures of kTextureCacheSourceSize sources, next to the output
+// buffer that every frame draws into.
+static size_t textureCacheBudgetFor(size_t sourceCount) {
+    const size_t outputBytes =
+            RenderEngineTest::estimateTextureBytes(DEFAULT_DISPLAY_WIDTH, DEFAULT_DISPLAY_HEIGHT,
+                                                   GRALLOC_USAGE_SW_READ_OFTEN |
+                                                           GRALLOC_USAGE_SW_WRITE_OFTEN |
+                                                           GRALLOC_USAGE_HW_RENDER |
+                                                           GRALLOC_USAGE_HW_TEXTURE);
+    const size_t sourceBytes =
+            RenderEngineTest::estimateTextureBytes(kTextureCacheSourceSize,
+                                                   kTextureCacheSourceSize,
+                                                   GRALLOC_USAGE_SW_READ_OFTEN |
+                                                           GRALLOC_USAGE_SW_WRITE_OFTEN |
+                                                           GRALLOC_USAGE_HW_TEXTURE);
+    return outputBytes + sourceCount * sourceBytes;
+}
+
+TEST_P(RenderEngineTest, textureCache_evictsLeastRecentlyUsedPastBudget) {
+    if (!GetParam()->apiSupported()) {
+        GTEST_SKIP();
+    }
+    initializeRenderEngine(textureCacheBudgetFor(2));
+
+    const auto first = allocateSourceBuffer(kTextureCacheSourceSize, kTextureCacheSourceSize);
+    const auto second = allocateSourceBuffer(kTextureCacheSourceSize, kTextureCacheSourceSize);
+    for (size_t i = 0; i < kTextureCacheFramesInFlight; i++) {
+        drawTextureCacheFrame(second);
+    }
+    EXPECT_THAT(dumpRenderEngine(), ::testing::HasSubstr(" 0 evictions\n"));
+
+    // The third texture exceeds the budget, and the first one was used least recently.
+    const auto third = allocateSourceBuffer(kTextureCacheSourceSize, kTextureCacheSourceSize);
+    const std::string dump = dumpRenderEngine();
+    EXPECT_THAT(dump, ::testing::HasSubstr(" 1 evictions\n"));
+    EXPECT_THAT(dump, ::testing::HasSubstr(evictedTextureLine(first)));
+    EXPECT_THAT(dump, ::testing::Not(::testing::HasSubstr(evictedTextureLine(second))));
+    EXPECT_THAT(dump, ::testing::Not(::testing::HasSubstr(evictedTextureLine(third))));
+}
+
+TEST_P(RenderEngineTest, textureCache_keepsTexturesOfFramesInFlight) {
+    if (!GetParam()->apiSupported()) {
+        GTEST_SKIP();
+    }
+    initializeRenderEngine(textureCacheBudgetFor(1));
+
+    const auto first = allocateSourceBuffer(kTextureCacheSourceSize, kTextureCacheSourceSize);
+    const auto second = allocateSourceBuffer(kTextureCacheSourceSize, kTextureCacheSourceSize);
+    drawTextureCacheFrame(first);
+    drawTextureCacheFrame(second);
+
+    // Both textures exceed the budget, but were drawn by the frames that may still be in flight.
+    const auto third = allocateSourceBuffer(kTextureCacheSourceSize, kTextureCacheSourceSize);
+    std::string dump = dumpRenderEngine();
+    EXPECT_THAT(dump, ::testing::HasSubstr(" 0 evictions\n"));
+
+    // Once another frame is drawn, the first texture is no longer in flight.
+    drawTextureCacheFrame(nullptr);
+    const auto fourth = allocateSourceBuffer(kTextureCacheSourceSize, kTextureCacheSourceSize);
+    dump = dumpRenderEngine();
+    EXPECT_THAT(dump, ::testing::HasSubstr(evictedTextureLine(first)));
+    EXPECT_THAT(dump, ::testing::Not(::testing::HasSubstr(evictedTextureLine(second))));
+}
+
+TEST_P(RenderEngineTest, textureCache_reimportsEvictedTexture) {
+    if (!GetParam()->apiSupported()) {
+        GTEST_SKIP();
+    }
+    initializeRenderEngine(textureCacheBudgetFor(1));
+
+    const auto red = allocateAndFillSourceBuffer(kTextureCacheSourceSize, kTextureCacheSourceSize,
+                                                 ubyte4(255, 0, 0, 255));
+    for (size_t i = 0; i < kTextureCacheFramesInFlight; i++) {
+        drawTextureCacheFrame(nullptr);
+    }
+    const auto other = allocateSourceBuffer(kTextureCacheSourceSize, kTextureCacheSourceSize);
+    ASSERT_THAT(dumpRenderEngine(), ::testing::HasSubstr(evictedTextureLine(red)));
+
+    // The evicted texture is imported again while its buffer is still mapped.
+    drawTextureCacheFrame(red);
+    expectBufferColor(fullscreenRect(), 255, 0, 0, 255);
+    const std::string dump = dumpRenderEngine();
+    EXPECT_THAT(dump, ::testing::HasSubstr(" 1 misses"));
+    EXPECT_THAT(dump, ::testing::Not(::testing::HasSubstr(evictedTextureLine(red))));
+}
+
+TEST_P(RenderEngineTest, textureCache_dumpsCounters) {
+    if (!GetParam()->apiSupported()) {
+        GTEST_SKIP();
+    }
+    initializeRenderEngine();
+
+    const auto source = allocateSourceBuffer(kTextureCacheSourceSize, kTextureCacheSourceSize);
+    drawTextureCacheFrame(source);
+
+    // The output buffer and the source are both hits.
+    const std::string dump = dumpRenderEngine();
+    EXPECT_THAT(dump, ::testing::HasSubstr("2 hits, 0 misses, 0 evictions\n"));
+    EXPECT_THAT(dump,
+                ::testing::HasSubstr(base::StringPrintf("renderengine/texture_cache/0x%" PRIx64,
+                                                        source->getBuffer()->getId())));
+}
+
 TEST_P(RenderEngineTest, testRoundedCornersCrop) {
     if (!GetParam()->apiSupported()) {
         GTEST_SKIP();
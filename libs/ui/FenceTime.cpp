@@ -21,8 +21,10 @@
 #include <cutils/compiler.h>  // For CC_[UN]LIKELY
 #include <utils/Log.h>
 #include <inttypes.h>
+#include <poll.h>
 #include <stdlib.h>
 
+#include <array>
 #include <memory>
 
 namespace android {
@@ -87,7 +89,7 @@ void FenceTime::applyTrustedSnapshot(const Snapshot& src) {
 
     std::lock_guard<std::mutex> lock(mMutex);
     mFence.clear();
-    mSignalTime.store(src.signalTime, std::memory_order_relaxed);
+    mSignalTime.store(src.signalTime, std::memory_order_release);
 }
 
 bool FenceTime::isValid() const {
@@ -136,21 +138,26 @@ nsecs_t FenceTime::getSignalTime() {
     // reference is removed by another thread. This prevents the
     // fence from being destroyed until the end of this method, where
     // we conveniently do not have the lock held.
-    sp<Fence> fence;
-    {
-        // With the lock acquired this time, see if we have the cached
-        // value or if we need to poll the fence.
-        std::lock_guard<std::mutex> lock(mMutex);
-        if (!mFence.get()) {
-            // Another thread set the signal time just before we added the
-            // reference to mFence.
-            return mSignalTime.load(std::memory_order_relaxed);
-        }
-        fence = mFence;
+    sp<Fence> fence = getPendingFence();
+    if (!fence.get()) {
+        // Another thread set the signal time just before we added the
+        // reference to mFence.
+        return mSignalTime.load(std::memory_order_relaxed);
     }
 
+    return updateSignalTime(fence);
+}
+
+sp<Fence> FenceTime::getPendingFence() const {
+    // With the lock acquired this time, see if we have the cached
+    // value or if we need to poll the fence.
+    std::lock_guard<std::mutex> lock(mMutex);
+    return mFence;
+}
+
+nsecs_t FenceTime::updateSignalTime(const sp<Fence>& fence) {
     // Make the system call without the lock held.
-    signalTime = fence->getSignalTime();
+    nsecs_t signalTime = fence->getSignalTime();
 
     // Allow tests to override SIGNAL_TIME_INVALID behavior, since tests
     // use invalid underlying Fences without real file descriptors.
@@ -165,12 +172,76 @@ nsecs_t FenceTime::getSignalTime() {
     if (signalTime != Fence::SIGNAL_TIME_PENDING) {
         std::lock_guard<std::mutex> lock(mMutex);
         mFence.clear();
-        mSignalTime.store(signalTime, std::memory_order_relaxed);
+        mSignalTime.store(signalTime, std::memory_order_release);
     }
 
     return signalTime;
 }
 
+size_t FenceTime::resolveSignalTimes(
+        const std::vector<std::shared_ptr<FenceTime>>& fenceTimes) {
+    // Each pass polls up to this many fences, so that no allocation is needed.
+    constexpr size_t kMaxPollFds = 32;
+    std::array<pollfd, kMaxPollFds> pollFds;
+    std::array<FenceTime*, kMaxPollFds> pending;
+    std::array<sp<Fence>, kMaxPollFds> pendingFences;
+    size_t pendingCount = 0;
+    size_t resolvedCount = 0;
+
+    auto resolvePending = [&]() {
+        // A fence signaled if its file descriptor is readable. Only those are
+        // queried with sync_file_info, which takes two ioctls and an
+        // allocation per fence.
+        const int ready = poll(pollFds.data(), pendingCount, 0);
+        for (size_t i = 0; i < pendingCount; i++) {
+            if (ready < 0 || pollFds[i].revents != 0) {
+                if (pending[i]->updateSignalTime(pendingFences[i]) !=
+                        Fence::SIGNAL_TIME_PENDING) {
+                    resolvedCount++;
+                }
+            }
+            pendingFences[i].clear();
+        }
+        pendingCount = 0;
+    };
+
+    for (const auto& fenceTime : fenceTimes) {
+        if (!fenceTime) {
+            continue;
+        }
+        if (fenceTime->mSignalTime.load(std::memory_order_acquire) !=
+                Fence::SIGNAL_TIME_PENDING) {
+            resolvedCount++;
+            continue;
+        }
+        sp<Fence> fence = fenceTime->getPendingFence();
+        if (!fence.get()) {
+            resolvedCount++;
+            continue;
+        }
+        if (fence->get() < 0) {
+            // There is nothing to poll, e.g. for the fences of tests.
+            if (fenceTime->updateSignalTime(fence) != Fence::SIGNAL_TIME_PENDING) {
+                resolvedCount++;
+            }
+            continue;
+        }
+
+        pollFds[pendingCount].fd = fence->get();
+        pollFds[pendingCount].events = POLLIN;
+        pollFds[pendingCount].revents = 0;
+        pending[pendingCount] = fenceTime.get();
+        pendingFences[pendingCount] = std::move(fence);
+        if (++pendingCount == kMaxPollFds) {
+            resolvePending();
+        }
+    }
+    if (pendingCount > 0) {
+        resolvePending();
+    }
+    return resolvedCount;
+}
+
 nsecs_t FenceTime::getCachedSignalTime() const {
     // memory_order_acquire since we don't have a lock fallback path
     // that will do an acquire.
@@ -209,7 +280,7 @@ void FenceTime::signalForTest(nsecs_t signalTime) {
     // be good enough.
     std::lock_guard<std::mutex> lock(mMutex);
     mFence.clear();
-    mSignalTime.store(signalTime, std::memory_order_relaxed);
+    mSignalTime.store(signalTime, std::memory_order_release);
 }
 
 // ============================================================================
@@ -301,24 +372,44 @@ void FenceTimeline::push(const std::shared_ptr<FenceTime>& fence) {
             // we are removing it from the timeline.
             front->getSignalTime();
         }
-        mQueue.pop();
+        mQueue.pop_front();
     }
-    mQueue.push(fence);
+    mQueue.push_back(fence);
 }
 
 void FenceTimeline::updateSignalTimes() {
     std::lock_guard<std::mutex> lock(mMutex);
+    popResolvedLocked();
+    if (mQueue.empty()) {
+        return;
+    }
+
+    // Resolve the whole queue with a single poll. The fences are expected to
+    // signal in order, but the ones after the first pending fence that did
+    // signal are cached too, and are popped once the ones before them are.
+    mPending.clear();
+    for (const auto& weakFence : mQueue) {
+        if (std::shared_ptr<FenceTime> fence = weakFence.lock()) {
+            mPending.push_back(std::move(fence));
+        }
+    }
+    FenceTime::resolveSignalTimes(mPending);
+    // Do not keep the FenceTimes alive.
+    mPending.clear();
+
+    popResolvedLocked();
+}
+
+void FenceTimeline::popResolvedLocked() {
     while (!mQueue.empty()) {
         std::shared_ptr<FenceTime> fence = mQueue.front().lock();
         if (!fence) {
             // The shared_ptr no longer exists and no one cares about the
             // timestamp anymore.
-            mQueue.pop();
-            continue;
-        } else if (fence->getSignalTime() != Fence::SIGNAL_TIME_PENDING) {
+            mQueue.pop_front();
+        } else if (fence->getCachedSignalTime() != Fence::SIGNAL_TIME_PENDING) {
             // The fence has signaled and we've removed the sp<Fence> ref.
-            mQueue.pop();
-            continue;
+            mQueue.pop_front();
         } else {
             // The fence didn't signal yet. Break since the later ones
             // shouldn't have signaled either.
@@ -725,6 +725,15 @@ int Gralloc5Mapper::unlock(buffer_handle_t bufferHandle) const {
     return fence;
 }
 
+status_t Gralloc5Mapper::rereadLockedBuffer(buffer_handle_t bufferHandle) const {
+    AIMapper_Error error = mMapper->v5.rereadLockedBuffer(bufferHandle);
+    if (error != AIMAPPER_ERROR_NONE) {
+        ALOGW("rereadLockedBuffer failed with error %d", error);
+        return static_cast<status_t>(error);
+    }
+    return OK;
+}
+
 status_t Gralloc5Mapper::isSupported(uint32_t width, uint32_t height, PixelFormat format,
                                      uint32_t layerCount, uint64_t usage,
                                      bool *outSupported) const {
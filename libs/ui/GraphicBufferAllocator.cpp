@@ -23,10 +23,15 @@
 #include <limits.h>
 #include <stdio.h>
 
+#include <algorithm>
+#include <iterator>
+
 #include <grallocusage/GrallocUsageConversion.h>
 
 #include <android-base/stringprintf.h>
+#include <hardware/gralloc.h>
 #include <log/log.h>
+#include <math/HashCombine.h>
 #include <utils/Singleton.h>
 #include <utils/Trace.h>
 
@@ -44,6 +49,17 @@ using base::StringAppendF;
 
 ANDROID_SINGLETON_STATIC_INSTANCE( GraphicBufferAllocator )
 
+namespace {
+
+// Bounds the hit and miss statistics that the pool keeps for keys without pooled buffers.
+constexpr size_t kMaxPoolKeys = 64;
+
+bool isPoolableUsage(uint64_t usage) {
+    return (usage & GRALLOC_USAGE_PROTECTED) == 0;
+}
+
+} // namespace
+
 Mutex GraphicBufferAllocator::sLock;
 KeyedVector<buffer_handle_t,
     GraphicBufferAllocator::alloc_rec_t> GraphicBufferAllocator::sAllocList;
@@ -72,7 +88,13 @@ GraphicBufferAllocator::GraphicBufferAllocator() : mMapper(GraphicBufferMapper::
                         mMapper.getMapperVersion());
 }
 
-GraphicBufferAllocator::~GraphicBufferAllocator() {}
+GraphicBufferAllocator::~GraphicBufferAllocator() {
+    trimPool();
+}
+
+size_t GraphicBufferAllocator::pool_key_hash_t::operator()(const pool_key_t& key) const {
+    return hashCombine(key.width, key.height, key.format, key.layerCount, key.usage);
+}
 
 uint64_t GraphicBufferAllocator::getTotalSize() const {
     Mutex::Autolock _l(sLock);
@@ -104,6 +126,26 @@ void GraphicBufferAllocator::dump(std::string& result, bool less) const {
     StringAppendF(&result, "Total allocated by GraphicBufferAllocator (estimate): %.2f KB\n",
                   static_cast<double>(total) / 1024.0);
 
+    if (mPoolMaxBuffers != 0) {
+        StringAppendF(&result,
+                      "GraphicBufferAllocator pool: %zu buffers (%.2f KiB), limits %zu buffers, "
+                      "%.2f KiB, %" PRId64 " ms\n",
+                      mPooledCount, static_cast<double>(mPooledBytes) / 1024.0, mPoolMaxBuffers,
+                      static_cast<double>(mPoolMaxBytes) / 1024.0, ns2ms(mPoolMaxAge));
+        StringAppendF(&result, "%18s | %6s | %8s | %10s | %6s | %8s | %8s | %s\n", "W x H",
+                      "Layers", "Format", "Usage", "Pooled", "Hits", "Misses", "Hit rate");
+        for (const auto& [key, entry] : mPool) {
+            const uint64_t lookups = entry.hits + entry.misses;
+            const double hitRate =
+                    lookups ? static_cast<double>(entry.hits) * 100.0 / lookups : 0.0;
+            StringAppendF(&result,
+                          "%8u x %7u | %6u | %8X | 0x%8" PRIx64 " | %6zu | %8" PRIu64
+                          " | %8" PRIu64 " | %.1f%%\n",
+                          key.width, key.height, key.layerCount, key.format, key.usage,
+                          entry.buffers.size(), entry.hits, entry.misses, hitRate);
+        }
+    }
+
     result.append(mAllocator->dumpDebugInfo(less));
 }
 
@@ -134,6 +176,15 @@ auto GraphicBufferAllocator::allocate(const AllocationRequest& request) -> Alloc
         return AllocationResult(BAD_VALUE);
     }
 
+    const bool poolable = request.poolable && request.importBuffer && request.extras.empty();
+    if (poolable) {
+        AllocationResult pooled(NO_ERROR);
+        if (takeFromPool({width, height, request.format, request.layerCount, request.usage},
+                         request.requestorName, &pooled.handle, &pooled.stride)) {
+            return pooled;
+        }
+    }
+
     auto result = mAllocator->allocate(request);
     if (result.status == UNKNOWN_TRANSACTION) {
         if (!request.extras.empty()) {
@@ -181,6 +232,7 @@ auto GraphicBufferAllocator::allocate(const AllocationRequest& request) -> Alloc
     rec.usage = request.usage;
     rec.size = bufSize;
     rec.requestorName = request.requestorName;
+    rec.poolable = poolable && isPoolableUsage(request.usage);
     list.add(result.handle, rec);
 
     return result;
@@ -247,6 +299,7 @@ status_t GraphicBufferAllocator::allocateHelper(uint32_t width, uint32_t height,
     rec.usage = usage;
     rec.size = bufSize;
     rec.requestorName = std::move(requestorName);
+    rec.poolable = false;
     list.add(*handle, rec);
 
     return NO_ERROR;
@@ -280,15 +333,149 @@ status_t GraphicBufferAllocator::free(buffer_handle_t handle)
 {
     ATRACE_CALL();
 
+    if (!returnToPool(handle)) {
+        releaseBuffers({handle});
+    }
+
+    return NO_ERROR;
+}
+
+void GraphicBufferAllocator::setPoolLimits(size_t maxBuffers, uint64_t maxBytes,
+                                           std::chrono::nanoseconds maxAge) {
+    std::vector<buffer_handle_t> evicted;
+    {
+        Mutex::Autolock _l(sLock);
+        mPoolMaxBuffers = maxBuffers;
+        mPoolMaxBytes = maxBytes;
+        mPoolMaxAge = maxAge.count();
+        evicted = evictFromPoolLocked(maxBytes);
+        if (maxBuffers == 0) {
+            mPool.clear();
+        }
+    }
+    releaseBuffers(evicted);
+}
+
+void GraphicBufferAllocator::trimPool(uint64_t maxBytes) {
+    ATRACE_CALL();
+    std::vector<buffer_handle_t> evicted;
+    {
+        Mutex::Autolock _l(sLock);
+        evicted = evictFromPoolLocked(std::min(maxBytes, mPoolMaxBytes));
+    }
+    releaseBuffers(evicted);
+}
+
+bool GraphicBufferAllocator::takeFromPool(const pool_key_t& key, const std::string& requestorName,
+                                          buffer_handle_t* handle, uint32_t* stride) {
+    std::vector<buffer_handle_t> evicted;
+    bool hit = false;
+    {
+        Mutex::Autolock _l(sLock);
+        if (mPoolMaxBuffers == 0) {
+            return false;
+        }
+        // Expired buffers are not handed out, even if they match.
+        evicted = evictFromPoolLocked(mPoolMaxBytes);
+
+        if (mPool.size() >= kMaxPoolKeys && mPool.count(key) == 0) {
+            for (auto it = mPool.begin(); it != mPool.end();) {
+                it = it->second.buffers.empty() ? mPool.erase(it) : std::next(it);
+            }
+        }
+        pool_entry_t& entry = mPool[key];
+        if (entry.buffers.empty()) {
+            entry.misses++;
+        } else {
+            // The most recently freed buffer is the most likely to still be cached.
+            const pooled_buffer_t buffer = entry.buffers.back();
+            entry.buffers.pop_back();
+            mPooledCount--;
+            mPooledBytes -= buffer.size;
+
+            alloc_rec_t& rec = sAllocList.editValueFor(buffer.handle);
+            rec.requestorName = requestorName;
+            *handle = buffer.handle;
+            *stride = rec.stride;
+            entry.hits++;
+            hit = true;
+        }
+    }
+    releaseBuffers(evicted);
+    return hit;
+}
+
+bool GraphicBufferAllocator::returnToPool(buffer_handle_t handle) {
+    std::vector<buffer_handle_t> evicted;
+    {
+        Mutex::Autolock _l(sLock);
+        if (mPoolMaxBuffers == 0) {
+            return false;
+        }
+        const ssize_t index = sAllocList.indexOfKey(handle);
+        if (index < 0) {
+            return false;
+        }
+        const alloc_rec_t& rec = sAllocList.valueAt(index);
+        if (!rec.poolable || rec.size > mPoolMaxBytes) {
+            return false;
+        }
+
+        const pool_key_t key{rec.width, rec.height, rec.format, rec.layerCount, rec.usage};
+        mPool[key].buffers.push_back({handle, rec.size, systemTime(SYSTEM_TIME_MONOTONIC)});
+        mPooledCount++;
+        mPooledBytes += rec.size;
+        evicted = evictFromPoolLocked(mPoolMaxBytes);
+    }
+    releaseBuffers(evicted);
+    return true;
+}
+
+std::vector<buffer_handle_t> GraphicBufferAllocator::evictFromPoolLocked(uint64_t maxBytes) {
+    std::vector<buffer_handle_t> evicted;
+    const nsecs_t now = systemTime(SYSTEM_TIME_MONOTONIC);
+    while (mPooledCount > 0) {
+        pool_entry_t* oldest = nullptr;
+        for (auto& [key, entry] : mPool) {
+            if (!entry.buffers.empty() &&
+                (!oldest ||
+                 entry.buffers.front().freedTime < oldest->buffers.front().freedTime)) {
+                oldest = &entry;
+            }
+        }
+        const pooled_buffer_t& buffer = oldest->buffers.front();
+        const bool withinLimits = mPooledCount <= mPoolMaxBuffers && mPooledBytes <= maxBytes;
+        if (withinLimits && now - buffer.freedTime <= mPoolMaxAge) {
+            break;
+        }
+        evicted.push_back(buffer.handle);
+        mPooledCount--;
+        mPooledBytes -= buffer.size;
+        oldest->buffers.pop_front();
+    }
+    return evicted;
+}
+
+void GraphicBufferAllocator::releaseBuffers(const std::vector<buffer_handle_t>& handles) {
+    if (handles.empty()) {
+        return;
+    }
+
     // We allocated a buffer from the allocator and imported it into the
     // mapper to get the handle.  We just need to free the handle now.
-    mMapper.freeBuffer(handle);
+    for (buffer_handle_t handle : handles) {
+        releaseBuffer(handle);
+    }
 
     Mutex::Autolock _l(sLock);
     KeyedVector<buffer_handle_t, alloc_rec_t>& list(sAllocList);
-    list.removeItem(handle);
+    for (buffer_handle_t handle : handles) {
+        list.removeItem(handle);
+    }
+}
 
-    return NO_ERROR;
+void GraphicBufferAllocator::releaseBuffer(buffer_handle_t handle) {
+    mMapper.freeBuffer(handle);
 }
 
 bool GraphicBufferAllocator::supportsAdditionalOptions() const {
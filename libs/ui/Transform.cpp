@@ -19,6 +19,9 @@
 
 #include <math.h>
 
+#include <algorithm>
+#include <cmath>
+
 #include <android-base/stringprintf.h>
 #include <cutils/compiler.h>
 #include <ui/Region.h>
@@ -43,6 +46,101 @@ Transform::~Transform() = default;
 
 static const float EPSILON = 0.0f;
 
+namespace {
+
+// The transforms that map rects to rects. Their matrices have exact zeros where type() found them,
+// so the bounds of a transformed rect only depend on two of its corners and on the non-zero
+// coefficients of the matrix.
+enum class RectKind { TRANSLATE, SCALE, ROT_90, GENERAL };
+
+RectKind getRectKind(uint32_t type) {
+    if (type & Transform::UNKNOWN) {
+        return RectKind::GENERAL;
+    }
+    if ((type >> 8) & Transform::ROT_90) {
+        return RectKind::ROT_90;
+    }
+    if (type & (Transform::ROTATE | Transform::SCALE)) {
+        return RectKind::SCALE;
+    }
+    return RectKind::TRANSLATE;
+}
+
+// The coefficients that Transform::transform(const vec2&) uses:
+//   x' = a*x + b*y + tx
+//   y' = c*x + d*y + ty
+struct Coefficients {
+    float a, b, c, d, tx, ty;
+};
+
+// Returns the same bounds as the general path, for finite coordinates. The terms with a zero
+// coefficient only add zeros there, and the tie-breaking of std::min and std::max over the corners
+// lt, rt, lb and rb is kept by comparing the first of them first. The products are assigned before
+// they are added, so that they are not contracted into fused multiply-adds that the general path
+// does not use either.
+template <RectKind kind>
+FloatRect transformRectBounds(const Coefficients& m, float left, float top, float right, float bottom) {
+    static_assert(kind != RectKind::GENERAL);
+    float x0, x1, y0, y1;
+    if constexpr (kind == RectKind::TRANSLATE) {
+        x0 = left + m.tx;
+        x1 = right + m.tx;
+        y0 = top + m.ty;
+        y1 = bottom + m.ty;
+    } else if constexpr (kind == RectKind::SCALE) {
+        const float l = m.a * left;
+        const float r = m.a * right;
+        const float t = m.d * top;
+        const float b = m.d * bottom;
+        x0 = l + m.tx;
+        x1 = r + m.tx;
+        y0 = t + m.ty;
+        y1 = b + m.ty;
+    } else {
+        // x' only depends on y, and y' only on x.
+        const float t = m.b * top;
+        const float b = m.b * bottom;
+        const float l = m.c * left;
+        const float r = m.c * right;
+        x0 = t + m.tx;
+        x1 = b + m.tx;
+        y0 = l + m.ty;
+        y1 = r + m.ty;
+    }
+    return FloatRect(std::min(x0, x1), std::min(y0, y1), std::max(x0, x1), std::max(y0, y1));
+}
+
+Rect roundBounds(const FloatRect& bounds, bool roundOutwards) {
+    Rect r;
+    if (roundOutwards) {
+        r.left   = static_cast<int32_t>(floorf(bounds.left));
+        r.top    = static_cast<int32_t>(floorf(bounds.top));
+        r.right  = static_cast<int32_t>(ceilf(bounds.right));
+        r.bottom = static_cast<int32_t>(ceilf(bounds.bottom));
+    } else {
+        r.left   = static_cast<int32_t>(floorf(bounds.left + 0.5f));
+        r.top    = static_cast<int32_t>(floorf(bounds.top + 0.5f));
+        r.right  = static_cast<int32_t>(floorf(bounds.right + 0.5f));
+        r.bottom = static_cast<int32_t>(floorf(bounds.bottom + 0.5f));
+    }
+    return r;
+}
+
+template <RectKind kind>
+void transformRectsOfKind(const Coefficients& m, const Rect* rects, Rect* out, size_t count,
+                          bool roundOutwards) {
+    for (size_t i = 0; i < count; i++) {
+        const Rect& rect = rects[i];
+        out[i] = roundBounds(transformRectBounds<kind>(m, static_cast<float>(rect.left),
+                                                       static_cast<float>(rect.top),
+                                                       static_cast<float>(rect.right),
+                                                       static_cast<float>(rect.bottom)),
+                             roundOutwards);
+    }
+}
+
+} // namespace
+
 bool Transform::isZero(float f) {
     return fabs(f) <= EPSILON;
 }
@@ -67,17 +165,33 @@ Transform Transform::operator*(const Transform& rhs) const {
     if (rhs.mType == IDENTITY)
         return r;
 
-    // TODO: we could use mType to optimize the matrix multiply
     const mat33& A(mMatrix);
     const mat33& B(rhs.mMatrix);
           mat33& D(r.mMatrix);
-    for (size_t i = 0; i < 3; i++) {
-        const float v0 = A[0][i];
-        const float v1 = A[1][i];
-        const float v2 = A[2][i];
-        D[0][i] = v0*B[0][0] + v1*B[0][1] + v2*B[0][2];
-        D[1][i] = v0*B[1][0] + v1*B[1][1] + v2*B[1][2];
-        D[2][i] = v0*B[2][0] + v1*B[2][1] + v2*B[2][2];
+    if (getRectKind(type()) != RectKind::GENERAL && getRectKind(rhs.type()) != RectKind::GENERAL &&
+        isAffine() && rhs.isAffine()) {
+        // Without skew or perspective, the third column is < 0 , 0 , 1 > and only contributes
+        // the translation of A. Each of the sums below has at most one non-zero product, so the
+        // result is the same as the full multiply for finite matrices.
+        for (size_t i = 0; i < 2; i++) {
+            const float v0 = A[0][i];
+            const float v1 = A[1][i];
+            D[0][i] = v0*B[0][0] + v1*B[0][1];
+            D[1][i] = v0*B[1][0] + v1*B[1][1];
+            D[2][i] = v0*B[2][0] + v1*B[2][1] + A[2][i];
+        }
+        D[0][2] = 0.0f;
+        D[1][2] = 0.0f;
+        D[2][2] = 1.0f;
+    } else {
+        for (size_t i = 0; i < 3; i++) {
+            const float v0 = A[0][i];
+            const float v1 = A[1][i];
+            const float v2 = A[2][i];
+            D[0][i] = v0*B[0][0] + v1*B[0][1] + v2*B[0][2];
+            D[1][i] = v0*B[1][0] + v1*B[1][1] + v2*B[1][2];
+            D[2][i] = v0*B[2][0] + v1*B[2][1] + v2*B[2][2];
+        }
     }
     r.mType |= rhs.mType;
 
@@ -252,37 +366,42 @@ Rect Transform::makeBounds(int w, int h) const {
 }
 
 Rect Transform::transform(const Rect& bounds, bool roundOutwards) const {
-    Rect r;
-    vec2 lt( bounds.left,  bounds.top    );
-    vec2 rt( bounds.right, bounds.top    );
-    vec2 lb( bounds.left,  bounds.bottom );
-    vec2 rb( bounds.right, bounds.bottom );
-
-    lt = transform(lt);
-    rt = transform(rt);
-    lb = transform(lb);
-    rb = transform(rb);
+    return roundBounds(transformBounds(static_cast<float>(bounds.left),
+                                       static_cast<float>(bounds.top),
+                                       static_cast<float>(bounds.right),
+                                       static_cast<float>(bounds.bottom)),
+                       roundOutwards);
+}
 
-    if (roundOutwards) {
-        r.left   = static_cast<int32_t>(floorf(std::min({lt[0], rt[0], lb[0], rb[0]})));
-        r.top    = static_cast<int32_t>(floorf(std::min({lt[1], rt[1], lb[1], rb[1]})));
-        r.right  = static_cast<int32_t>(ceilf(std::max({lt[0], rt[0], lb[0], rb[0]})));
-        r.bottom = static_cast<int32_t>(ceilf(std::max({lt[1], rt[1], lb[1], rb[1]})));
-    } else {
-        r.left   = static_cast<int32_t>(floorf(std::min({lt[0], rt[0], lb[0], rb[0]}) + 0.5f));
-        r.top    = static_cast<int32_t>(floorf(std::min({lt[1], rt[1], lb[1], rb[1]}) + 0.5f));
-        r.right  = static_cast<int32_t>(floorf(std::max({lt[0], rt[0], lb[0], rb[0]}) + 0.5f));
-        r.bottom = static_cast<int32_t>(floorf(std::max({lt[1], rt[1], lb[1], rb[1]}) + 0.5f));
+FloatRect Transform::transform(const FloatRect& bounds) const {
+    // The fast paths drop terms that are only zero for finite coordinates.
+    if (CC_UNLIKELY(!std::isfinite(bounds.left + bounds.top + bounds.right + bounds.bottom))) {
+        return transformCorners(bounds.left, bounds.top, bounds.right, bounds.bottom);
     }
+    return transformBounds(bounds.left, bounds.top, bounds.right, bounds.bottom);
+}
 
-    return r;
+FloatRect Transform::transformBounds(float left, float top, float right, float bottom) const {
+    const mat33& M(mMatrix);
+    const Coefficients m{M[0][0], M[1][0], M[0][1], M[1][1], M[2][0], M[2][1]};
+    switch (getRectKind(type())) {
+        case RectKind::TRANSLATE:
+            return transformRectBounds<RectKind::TRANSLATE>(m, left, top, right, bottom);
+        case RectKind::SCALE:
+            return transformRectBounds<RectKind::SCALE>(m, left, top, right, bottom);
+        case RectKind::ROT_90:
+            return transformRectBounds<RectKind::ROT_90>(m, left, top, right, bottom);
+        case RectKind::GENERAL:
+            break;
+    }
+    return transformCorners(left, top, right, bottom);
 }
 
-FloatRect Transform::transform(const FloatRect& bounds) const {
-    vec2 lt(bounds.left, bounds.top);
-    vec2 rt(bounds.right, bounds.top);
-    vec2 lb(bounds.left, bounds.bottom);
-    vec2 rb(bounds.right, bounds.bottom);
+FloatRect Transform::transformCorners(float left, float top, float right, float bottom) const {
+    vec2 lt(left, top);
+    vec2 rt(right, top);
+    vec2 lb(left, bottom);
+    vec2 rb(right, bottom);
 
     lt = transform(lt);
     rt = transform(rt);
@@ -298,6 +417,46 @@ FloatRect Transform::transform(const FloatRect& bounds) const {
     return r;
 }
 
+void Transform::transformPoints(const vec2* points, vec2* out, size_t count) const {
+    // Same arithmetic as transform(const vec2&), on coefficients that the compiler can keep in
+    // registers, so that the loop is vectorized.
+    const mat33& M(mMatrix);
+    const float a = M[0][0], b = M[1][0], tx = M[2][0];
+    const float c = M[0][1], d = M[1][1], ty = M[2][1];
+    for (size_t i = 0; i < count; i++) {
+        const float x = points[i][0];
+        const float y = points[i][1];
+        out[i][0] = a*x + b*y + tx;
+        out[i][1] = c*x + d*y + ty;
+    }
+}
+
+void Transform::transformRects(const Rect* rects, Rect* out, size_t count,
+                               bool roundOutwards) const {
+    const mat33& M(mMatrix);
+    const Coefficients m{M[0][0], M[1][0], M[0][1], M[1][1], M[2][0], M[2][1]};
+    switch (getRectKind(type())) {
+        case RectKind::TRANSLATE:
+            transformRectsOfKind<RectKind::TRANSLATE>(m, rects, out, count, roundOutwards);
+            break;
+        case RectKind::SCALE:
+            transformRectsOfKind<RectKind::SCALE>(m, rects, out, count, roundOutwards);
+            break;
+        case RectKind::ROT_90:
+            transformRectsOfKind<RectKind::ROT_90>(m, rects, out, count, roundOutwards);
+            break;
+        case RectKind::GENERAL:
+            for (size_t i = 0; i < count; i++) {
+                out[i] = roundBounds(transformCorners(static_cast<float>(rects[i].left),
+                                                      static_cast<float>(rects[i].top),
+                                                      static_cast<float>(rects[i].right),
+                                                      static_cast<float>(rects[i].bottom)),
+                                     roundOutwards);
+            }
+            break;
+    }
+}
+
 Region Transform::transform(const Region& reg) const {
     Region out;
     if (CC_UNLIKELY(type() > TRANSLATE)) {
@@ -414,6 +573,10 @@ Transform Transform::inverse() const {
     return result;
 }
 
+bool Transform::isAffine() const {
+    return mMatrix[0][2] == 0.0f && mMatrix[1][2] == 0.0f && mMatrix[2][2] == 1.0f;
+}
+
 uint32_t Transform::getType() const {
     return type() & 0xFF;
 }
@@ -23,9 +23,11 @@
 #include <utils/Timers.h>
 
 #include <atomic>
+#include <deque>
 #include <mutex>
 #include <queue>
 #include <unordered_map>
+#include <vector>
 
 namespace android {
 
@@ -109,6 +111,14 @@ public:
     // Gets the cached timestamp without attempting to query the Fence.
     nsecs_t getCachedSignalTime() const;
 
+    // Resolves the signal times of several FenceTimes at once. The fences
+    // that are still pending are polled together, and only the ones that
+    // signaled are queried for their signal time, which is then cached as if
+    // getSignalTime() had been called. Null entries are ignored.
+    // Returns the number of FenceTimes whose signal time is known.
+    static size_t resolveSignalTimes(
+            const std::vector<std::shared_ptr<FenceTime>>& fenceTimes);
+
     // Returns a snapshot of the FenceTime in its current state.
     Snapshot getSnapshot() const;
 
@@ -126,6 +136,14 @@ private:
     // never return SIGNAL_TIME_INVALID and isValid will always return true.
     FenceTime(const sp<Fence>& fence, bool forceValidForTest);
 
+    // Returns the fence if the signal time is still pending, or nullptr if it
+    // is known.
+    sp<Fence> getPendingFence() const;
+
+    // Queries the signal time of the fence returned by getPendingFence() and
+    // caches it if it is no longer pending.
+    nsecs_t updateSignalTime(const sp<Fence>& fence);
+
     enum class State {
         VALID,
         INVALID,
@@ -136,7 +154,8 @@ private:
 
     // mMutex guards mFence and mSignalTime.
     // mSignalTime is also atomic since it is sometimes read outside the lock
-    // for quick checks.
+    // for quick checks. It is stored with release semantics, so that readers
+    // of the cached value do not need the lock.
     mutable std::mutex mMutex;
     sp<Fence> mFence{Fence::NO_FENCE};
     std::atomic<nsecs_t> mSignalTime{Fence::SIGNAL_TIME_INVALID};
@@ -158,6 +177,9 @@ using FenceTimePtr = std::shared_ptr<FenceTime>;
 // if FenceTimeline did nothing. i.e. they should eventually call
 // Fence::getSignalTime(), not only Fence::getCachedSignalTime().
 //
+// updateSignalTimes() resolves the pending fences of the timeline with
+// FenceTime::resolveSignalTimes(), so that a single poll() covers all of them.
+//
 // push() and updateSignalTimes() are safe to call simultaneously from
 // different threads.
 class FenceTimeline {
@@ -168,8 +190,15 @@ public:
     void updateSignalTimes();
 
 private:
+    // Pops the entries at the front of the queue that no longer need to be
+    // resolved.
+    void popResolvedLocked() REQUIRES(mMutex);
+
     mutable std::mutex mMutex;
-    std::queue<std::weak_ptr<FenceTime>> mQueue GUARDED_BY(mMutex);
+    std::deque<std::weak_ptr<FenceTime>> mQueue GUARDED_BY(mMutex);
+    // The FenceTimes of the queue while they are being resolved. Kept as a
+    // member so that its storage is reused.
+    std::vector<std::shared_ptr<FenceTime>> mPending GUARDED_BY(mMutex);
 };
 
 // Used by test code to create or get FenceTimes for a given Fence.
@@ -72,6 +72,14 @@ public:
     // owned by the caller
     virtual int unlock(buffer_handle_t bufferHandle) const = 0;
 
+    // rereadLockedBuffer makes the CPU mapping of a buffer that is still
+    // locked observe the writes that were made to the buffer since it was
+    // locked, without unlocking it. Not all mappers support it, in which case
+    // INVALID_OPERATION is returned.
+    virtual status_t rereadLockedBuffer(buffer_handle_t /*bufferHandle*/) const {
+        return INVALID_OPERATION;
+    }
+
     // isSupported queries whether or not a buffer with the given width, height,
     // format, layer count, and usage can be allocated on the device.  If
     // *outSupported is set to true, a buffer with the given specifications may be successfully
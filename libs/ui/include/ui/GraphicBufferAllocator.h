@@ -20,8 +20,11 @@
 
 #include <stdint.h>
 
+#include <chrono>
+#include <deque>
 #include <memory>
 #include <string>
+#include <unordered_map>
 #include <vector>
 
 #include <cutils/native_handle.h>
@@ -32,6 +35,7 @@
 #include <utils/KeyedVector.h>
 #include <utils/Mutex.h>
 #include <utils/Singleton.h>
+#include <utils/Timers.h>
 
 namespace android {
 
@@ -57,6 +61,9 @@ public:
         uint64_t usage;
         std::string requestorName;
         std::vector<AdditionalOptions> extras;
+        // Whether free() may return the buffer to the pool, see setPoolLimits(). Only set this
+        // for buffers that never leave the calling process.
+        bool poolable = false;
     };
 
     struct AllocationResult {
@@ -102,6 +109,27 @@ public:
 
     status_t free(buffer_handle_t handle);
 
+    /**
+     * Configures a pool of freed buffers, from which allocate() returns a buffer of the same
+     * width, height, format, layer count and usage instead of allocating a new one. The pool holds
+     * at most maxBuffers buffers and maxBytes bytes, and frees the buffers that it held for longer
+     * than maxAge. It is disabled while maxBuffers is 0, which is the default.
+     *
+     * Only buffers allocated with AllocationRequest::poolable set are pooled, and only such
+     * requests are served from the pool. Pooled buffers must never have been shared with another
+     * process: a process that still holds the buffer would see, and could write, the contents of
+     * its next owner. A recycled buffer also keeps the contents that its previous owner left in
+     * it. Buffers with protected usage and buffers allocated with additional options are never
+     * pooled.
+     */
+    void setPoolLimits(size_t maxBuffers, uint64_t maxBytes, std::chrono::nanoseconds maxAge);
+
+    /**
+     * Frees pooled buffers, the least recently freed first, until the pool holds at most maxBytes.
+     * Meant to be called when the system is low on memory.
+     */
+    void trimPool(uint64_t maxBytes = 0);
+
     uint64_t getTotalSize() const;
 
     void dump(std::string& res, bool less = true) const;
@@ -119,21 +147,73 @@ protected:
         uint64_t usage;
         size_t size;
         std::string requestorName;
+        bool poolable;
+    };
+
+    struct pool_key_t {
+        uint32_t width;
+        uint32_t height;
+        PixelFormat format;
+        uint32_t layerCount;
+        uint64_t usage;
+
+        bool operator==(const pool_key_t& other) const {
+            return width == other.width && height == other.height && format == other.format &&
+                    layerCount == other.layerCount && usage == other.usage;
+        }
+    };
+
+    struct pool_key_hash_t {
+        size_t operator()(const pool_key_t& key) const;
+    };
+
+    struct pooled_buffer_t {
+        buffer_handle_t handle;
+        size_t size;
+        nsecs_t freedTime;
+    };
+
+    struct pool_entry_t {
+        // The least recently freed buffer first.
+        std::deque<pooled_buffer_t> buffers;
+        uint64_t hits = 0;
+        uint64_t misses = 0;
     };
 
     status_t allocateHelper(uint32_t w, uint32_t h, PixelFormat format, uint32_t layerCount,
                             uint64_t usage, buffer_handle_t* handle, uint32_t* stride,
                             std::string requestorName, bool importBuffer);
 
+    // Takes a buffer of the given key out of the pool, and counts the hit or miss.
+    bool takeFromPool(const pool_key_t& key, const std::string& requestorName,
+                      buffer_handle_t* handle, uint32_t* stride);
+    // Returns false if the buffer was not pooled and must be released by the caller.
+    bool returnToPool(buffer_handle_t handle);
+    // Removes the oldest buffers from the pool until it is within its limits and holds at most
+    // maxBytes. The caller must release the returned buffers.
+    std::vector<buffer_handle_t> evictFromPoolLocked(uint64_t maxBytes);
+    void releaseBuffers(const std::vector<buffer_handle_t>& handles);
+
+    // Frees the imported handle of a buffer. Virtual for testing.
+    virtual void releaseBuffer(buffer_handle_t handle);
+
     static Mutex sLock;
     static KeyedVector<buffer_handle_t, alloc_rec_t> sAllocList;
 
     friend class Singleton<GraphicBufferAllocator>;
     GraphicBufferAllocator();
-    ~GraphicBufferAllocator();
+    virtual ~GraphicBufferAllocator();
 
     GraphicBufferMapper& mMapper;
     std::unique_ptr<const GrallocAllocator> mAllocator;
+
+    // The pool is guarded by sLock, as it shares the records of its buffers with sAllocList.
+    std::unordered_map<pool_key_t, pool_entry_t, pool_key_hash_t> mPool;
+    size_t mPooledCount = 0;
+    uint64_t mPooledBytes = 0;
+    size_t mPoolMaxBuffers = 0;
+    uint64_t mPoolMaxBytes = 0;
+    nsecs_t mPoolMaxAge = 0;
 };
 
 // ---------------------------------------------------------------------------
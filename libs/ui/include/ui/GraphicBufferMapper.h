@@ -119,6 +119,13 @@ public:
         return result;
     }
 
+    // Makes the CPU mapping of a locked buffer observe the writes that were
+    // made to it since it was locked, e.g. by the producer of the next frame
+    // in a buffer that a consumer keeps locked. Returns INVALID_OPERATION if
+    // the mapper does not support it, in which case the buffer must be unlocked
+    // and locked again instead.
+    status_t rereadLockedBuffer(buffer_handle_t handle);
+
     status_t isSupported(uint32_t width, uint32_t height, android::PixelFormat format,
                          uint32_t layerCount, uint64_t usage, bool* outSupported);
 
@@ -103,6 +103,12 @@ public:
     vec2 transform(const vec2& v) const;
     vec3 transform(const vec3& v) const;
 
+    // Transforms count points or rects into out, with the same results as transforming them one
+    // at a time. The transform is classified once for the whole batch.
+    void transformPoints(const vec2* points, vec2* out, size_t count) const;
+    void transformRects(const Rect* rects, Rect* out, size_t count,
+                        bool roundOutwards = false) const;
+
     // Expands from the internal 3x3 matrix to an equivalent 4x4 matrix
     mat4 asMatrix4() const;
 
@@ -125,6 +131,12 @@ private:
     enum { UNKNOWN_TYPE = 0x80000000 };
 
     uint32_t type() const;
+    // Whether the third column of the matrix is < 0 , 0 , 1 >, i.e. there is no perspective.
+    bool isAffine() const;
+    // The bounds of a transformed rect, from its two relevant corners for transforms that
+    // preserve rects, or from all four corners otherwise.
+    FloatRect transformBounds(float left, float top, float right, float bottom) const;
+    FloatRect transformCorners(float left, float top, float right, float bottom) const;
     static bool absIsOne(float f);
     static bool isZero(float f);
 
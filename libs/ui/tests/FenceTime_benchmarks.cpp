@@ -0,0 +1,113 @@
+/*
+ * Copyright 2024 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include <benchmark/benchmark.h>
+#include <ui/FenceTime.h>
+
+#include <memory>
+#include <optional>
+#include <vector>
+
+#include "SwSyncTimeline.h"
+
+namespace android {
+
+namespace {
+
+// Creates a new timeline with the given number of fences, of which the first half signaled.
+class HalfSignaledFences {
+public:
+    explicit HalfSignaledFences(size_t count) {
+        if (!mTimeline.isValid()) {
+            return;
+        }
+        for (size_t i = 0; i < count; i++) {
+            mFenceTimes.push_back(
+                    std::make_shared<FenceTime>(mTimeline.createFence(static_cast<uint32_t>(i + 1))));
+        }
+        mTimeline.advance(static_cast<uint32_t>(count / 2));
+    }
+
+    bool isValid() const { return mTimeline.isValid(); }
+    const std::vector<std::shared_ptr<FenceTime>>& getFenceTimes() const { return mFenceTimes; }
+
+private:
+    SwSyncTimeline mTimeline;
+    std::vector<std::shared_ptr<FenceTime>> mFenceTimes;
+};
+
+} // namespace
+
+// Resolves the fences one by one, as the timelines did.
+static void BM_FenceTimeGetSignalTime(benchmark::State& state) {
+    const size_t count = static_cast<size_t>(state.range(0));
+    std::optional<HalfSignaledFences> fences;
+    for (auto _ : state) {
+        state.PauseTiming();
+        fences.emplace(count);
+        if (!fences->isValid()) {
+            state.SkipWithError("sw_sync is not available");
+            break;
+        }
+        state.ResumeTiming();
+        for (const auto& fenceTime : fences->getFenceTimes()) {
+            benchmark::DoNotOptimize(fenceTime->getSignalTime());
+        }
+    }
+}
+BENCHMARK(BM_FenceTimeGetSignalTime)->Arg(8)->Arg(32)->Arg(64);
+
+static void BM_FenceTimeResolveSignalTimes(benchmark::State& state) {
+    const size_t count = static_cast<size_t>(state.range(0));
+    std::optional<HalfSignaledFences> fences;
+    for (auto _ : state) {
+        state.PauseTiming();
+        fences.emplace(count);
+        if (!fences->isValid()) {
+            state.SkipWithError("sw_sync is not available");
+            break;
+        }
+        state.ResumeTiming();
+        if (FenceTime::resolveSignalTimes(fences->getFenceTimes()) != count / 2) {
+            state.SkipWithError("Unexpected number of signaled fences");
+            break;
+        }
+    }
+}
+BENCHMARK(BM_FenceTimeResolveSignalTimes)->Arg(8)->Arg(32)->Arg(64);
+
+static void BM_FenceTimelineUpdateSignalTimes(benchmark::State& state) {
+    const size_t count = static_cast<size_t>(state.range(0));
+    std::optional<HalfSignaledFences> fences;
+    std::optional<FenceTimeline> timeline;
+    for (auto _ : state) {
+        state.PauseTiming();
+        fences.emplace(count);
+        if (!fences->isValid()) {
+            state.SkipWithError("sw_sync is not available");
+            break;
+        }
+        timeline.emplace();
+        for (const auto& fenceTime : fences->getFenceTimes()) {
+            timeline->push(fenceTime);
+        }
+        state.ResumeTiming();
+        timeline->updateSignalTimes();
+    }
+}
+BENCHMARK(BM_FenceTimelineUpdateSignalTimes)->Arg(8)->Arg(32)->Arg(64);
+
+} // namespace android
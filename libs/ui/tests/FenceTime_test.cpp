@@ -0,0 +1,146 @@
+/*
+ * Copyright 2024 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include <ui/FenceTime.h>
+#include <ui/MockFence.h>
+#include <utils/Timers.h>
+
+#include <gmock/gmock.h>
+#include <gtest/gtest.h>
+
+#include <memory>
+#include <vector>
+
+#include "SwSyncTimeline.h"
+
+namespace android {
+
+using testing::Return;
+
+namespace {
+
+// More than the number of fences that resolveSignalTimes polls at once.
+constexpr size_t FENCE_COUNT = 70;
+
+void expectSignaledBetween(const sp<Fence>& fence, const FenceTime& fenceTime, nsecs_t before,
+                           nsecs_t after) {
+    const nsecs_t signalTime = fenceTime.getCachedSignalTime();
+    EXPECT_EQ(fence->getSignalTime(), signalTime);
+    EXPECT_GE(signalTime, before);
+    EXPECT_LE(signalTime, after);
+}
+
+} // namespace
+
+class FenceTimeResolveSignalTimesTest : public testing::Test {
+protected:
+    void SetUp() override {
+        if (!mSignaledTimeline.isValid() || !mPendingTimeline.isValid()) {
+            GTEST_SKIP() << "sw_sync is not available";
+        }
+    }
+
+    SwSyncTimeline mSignaledTimeline;
+    SwSyncTimeline mPendingTimeline;
+};
+
+TEST_F(FenceTimeResolveSignalTimesTest, ResolvesOnlySignaledFences) {
+    // Alternate between the two timelines, so that each poll covers both signaled and pending
+    // fences.
+    std::vector<sp<Fence>> fences;
+    std::vector<std::shared_ptr<FenceTime>> fenceTimes;
+    for (size_t i = 0; i < FENCE_COUNT; i++) {
+        SwSyncTimeline& timeline = i % 2 == 0 ? mSignaledTimeline : mPendingTimeline;
+        fences.push_back(timeline.createFence(static_cast<uint32_t>(i / 2 + 1)));
+        ASSERT_TRUE(fences.back()->isValid());
+        fenceTimes.push_back(std::make_shared<FenceTime>(fences.back()));
+    }
+
+    const nsecs_t beforeSignal = systemTime(SYSTEM_TIME_MONOTONIC);
+    mSignaledTimeline.advance(FENCE_COUNT);
+    const nsecs_t afterSignal = systemTime(SYSTEM_TIME_MONOTONIC);
+
+    ASSERT_EQ(FENCE_COUNT / 2, FenceTime::resolveSignalTimes(fenceTimes));
+    for (size_t i = 0; i < FENCE_COUNT; i++) {
+        SCOPED_TRACE(i);
+        if (i % 2 == 0) {
+            expectSignaledBetween(fences[i], *fenceTimes[i], beforeSignal, afterSignal);
+        } else {
+            EXPECT_EQ(Fence::SIGNAL_TIME_PENDING, fenceTimes[i]->getCachedSignalTime());
+        }
+    }
+
+    const nsecs_t beforePendingSignal = systemTime(SYSTEM_TIME_MONOTONIC);
+    mPendingTimeline.advance(FENCE_COUNT);
+    const nsecs_t afterPendingSignal = systemTime(SYSTEM_TIME_MONOTONIC);
+
+    ASSERT_EQ(FENCE_COUNT, FenceTime::resolveSignalTimes(fenceTimes));
+    for (size_t i = 0; i < FENCE_COUNT; i++) {
+        SCOPED_TRACE(i);
+        if (i % 2 == 0) {
+            expectSignaledBetween(fences[i], *fenceTimes[i], beforeSignal, afterSignal);
+        } else {
+            expectSignaledBetween(fences[i], *fenceTimes[i], beforePendingSignal,
+                                  afterPendingSignal);
+        }
+    }
+}
+
+TEST_F(FenceTimeResolveSignalTimesTest, ResolvesFencesWithAndWithoutFds) {
+    FenceToFenceTimeMap fenceMap;
+    const auto signaledMockFence = sp<mock::MockFence>::make();
+    EXPECT_CALL(*signaledMockFence, getSignalTime).WillRepeatedly(Return(1234));
+    const auto pendingMockFence = sp<mock::MockFence>::make();
+    EXPECT_CALL(*pendingMockFence, getSignalTime)
+            .WillRepeatedly(Return(Fence::SIGNAL_TIME_PENDING));
+    const auto [signaledTestFence, signaledTestFenceTime] = fenceMap.makePendingFenceForTest();
+    const auto [pendingTestFence, pendingTestFenceTime] = fenceMap.makePendingFenceForTest();
+
+    const sp<Fence> signaledFence = mSignaledTimeline.createFence(1);
+    const sp<Fence> pendingFence = mPendingTimeline.createFence(1);
+    ASSERT_TRUE(signaledFence->isValid());
+    ASSERT_TRUE(pendingFence->isValid());
+
+    const std::vector<std::shared_ptr<FenceTime>> fenceTimes = {
+            fenceMap.createFenceTimeForTest(signaledMockFence),
+            fenceMap.createFenceTimeForTest(pendingMockFence),
+            signaledTestFenceTime,
+            pendingTestFenceTime,
+            std::make_shared<FenceTime>(signaledFence),
+            std::make_shared<FenceTime>(pendingFence),
+            std::make_shared<FenceTime>(5678),
+            FenceTime::NO_FENCE,
+            nullptr,
+    };
+
+    fenceMap.signalAllForTest(signaledTestFence, 4321);
+    const nsecs_t beforeSignal = systemTime(SYSTEM_TIME_MONOTONIC);
+    mSignaledTimeline.advance(1);
+    const nsecs_t afterSignal = systemTime(SYSTEM_TIME_MONOTONIC);
+
+    // The null entry is ignored, and the signal time of the invalid fence is known.
+    ASSERT_EQ(5u, FenceTime::resolveSignalTimes(fenceTimes));
+    EXPECT_EQ(1234, fenceTimes[0]->getCachedSignalTime());
+    EXPECT_EQ(Fence::SIGNAL_TIME_PENDING, fenceTimes[1]->getCachedSignalTime());
+    EXPECT_EQ(4321, fenceTimes[2]->getCachedSignalTime());
+    EXPECT_EQ(Fence::SIGNAL_TIME_PENDING, fenceTimes[3]->getCachedSignalTime());
+    expectSignaledBetween(signaledFence, *fenceTimes[4], beforeSignal, afterSignal);
+    EXPECT_EQ(Fence::SIGNAL_TIME_PENDING, fenceTimes[5]->getCachedSignalTime());
+    EXPECT_EQ(5678, fenceTimes[6]->getCachedSignalTime());
+    EXPECT_EQ(Fence::SIGNAL_TIME_INVALID, fenceTimes[7]->getCachedSignalTime());
+}
+
+} // namespace android
@@ -20,12 +20,17 @@
 #include <ui/GraphicBufferAllocator.h>
 #include <ui/PixelFormat.h>
 
+#include <gmock/gmock.h>
 #include <gtest/gtest.h>
 
 #include "mock/MockGrallocAllocator.h"
 
 #include <algorithm>
+#include <chrono>
 #include <limits>
+#include <string>
+#include <thread>
+#include <vector>
 
 namespace android {
 
@@ -35,10 +40,20 @@ constexpr uint32_t kTestWidth = 1024;
 constexpr uint32_t kTestHeight = 1;
 constexpr uint32_t kTestLayerCount = 1;
 constexpr uint64_t kTestUsage = GraphicBuffer::USAGE_SW_WRITE_OFTEN;
+constexpr uint64_t kTestPoolMaxBytes = 64 * 1024 * 1024;
+constexpr std::chrono::nanoseconds kTestPoolMaxAge = std::chrono::seconds(10);
+
+buffer_handle_t makeTestHandle(uintptr_t id) {
+    // The handles are never dereferenced, as the buffers are neither allocated nor freed.
+    return reinterpret_cast<buffer_handle_t>(0x10000 + id);
+}
 
 } // namespace
 
 using ::testing::DoAll;
+using ::testing::ElementsAre;
+using ::testing::HasSubstr;
+using ::testing::IsEmpty;
 using ::testing::Return;
 using ::testing::SetArgPointee;
 
@@ -47,6 +62,21 @@ public:
     TestableGraphicBufferAllocator() {
         mAllocator = std::make_unique<const mock::MockGrallocAllocator>();
     }
+    ~TestableGraphicBufferAllocator() override { trimPool(); }
+
+    // Expects one allocation per handle, in order.
+    void setUpAllocateExpectations(const std::vector<buffer_handle_t>& handles) {
+        auto& expectation =
+                EXPECT_CALL(*(reinterpret_cast<const mock::MockGrallocAllocator*>(
+                                    mAllocator.get())),
+                            allocate)
+                        .Times(static_cast<int>(handles.size()));
+        for (buffer_handle_t handle : handles) {
+            expectation.WillOnce(DoAll(SetArgPointee<6>(kTestWidth), SetArgPointee<7>(handle),
+                                       Return(NO_ERROR)));
+        }
+    }
+    const std::vector<buffer_handle_t>& getReleasedBuffers() const { return mReleasedBuffers; }
     void setUpAllocateExpectations(status_t err, uint32_t stride) {
         std::cout << "Setting expected stride to " << stride << std::endl;
         EXPECT_CALL(*(reinterpret_cast<const mock::MockGrallocAllocator*>(mAllocator.get())),
@@ -54,6 +84,12 @@ public:
                 .WillOnce(DoAll(SetArgPointee<6>(stride), Return(err)));
     }
     std::unique_ptr<const GrallocAllocator>& getAllocator() { return mAllocator; }
+
+protected:
+    void releaseBuffer(buffer_handle_t handle) override { mReleasedBuffers.push_back(handle); }
+
+private:
+    std::vector<buffer_handle_t> mReleasedBuffers;
 };
 
 class GraphicBufferAllocatorTest : public testing::Test {
@@ -62,6 +98,23 @@ public:
     const TestableGraphicBufferAllocator& getAllocator() { return mAllocator; }
 
 protected:
+    buffer_handle_t allocate(uint64_t usage = kTestUsage, uint32_t width = kTestWidth,
+                             bool poolable = true) {
+        auto result = mAllocator.allocate(GraphicBufferAllocator::AllocationRequest{
+                .importBuffer = true,
+                .width = width,
+                .height = kTestHeight,
+                .format = PIXEL_FORMAT_RGBA_8888,
+                .layerCount = kTestLayerCount,
+                .usage = usage,
+                .requestorName = "GraphicBufferAllocatorTest",
+                .poolable = poolable,
+        });
+        EXPECT_EQ(NO_ERROR, result.status);
+        EXPECT_EQ(kTestWidth, result.stride);
+        return result.handle;
+    }
+
     TestableGraphicBufferAllocator mAllocator;
 };
 
@@ -113,4 +166,114 @@ TEST_F(GraphicBufferAllocatorTest, AllocateLargeStride) {
     ASSERT_EQ(NO_ERROR, err);
     ASSERT_EQ(expectedStride, stride);
 }
+
+TEST_F(GraphicBufferAllocatorTest, PoolDisabledByDefault) {
+    mAllocator.setUpAllocateExpectations({makeTestHandle(1), makeTestHandle(2)});
+    buffer_handle_t handle = allocate();
+    ASSERT_EQ(NO_ERROR, mAllocator.free(handle));
+    EXPECT_THAT(mAllocator.getReleasedBuffers(), ElementsAre(makeTestHandle(1)));
+
+    EXPECT_EQ(makeTestHandle(2), allocate());
+}
+
+TEST_F(GraphicBufferAllocatorTest, PoolReusesFreedBuffer) {
+    mAllocator.setPoolLimits(4, kTestPoolMaxBytes, kTestPoolMaxAge);
+    mAllocator.setUpAllocateExpectations({makeTestHandle(1), makeTestHandle(2)});
+
+    buffer_handle_t handle = allocate();
+    ASSERT_EQ(NO_ERROR, mAllocator.free(handle));
+    EXPECT_THAT(mAllocator.getReleasedBuffers(), IsEmpty());
+
+    // The same key is a hit, another usage is a miss.
+    EXPECT_EQ(makeTestHandle(1), allocate());
+    EXPECT_EQ(makeTestHandle(2), allocate(kTestUsage | GraphicBuffer::USAGE_HW_TEXTURE));
+    EXPECT_THAT(mAllocator.getReleasedBuffers(), IsEmpty());
+}
+
+TEST_F(GraphicBufferAllocatorTest, PoolEvictsLeastRecentlyFreedBuffer) {
+    mAllocator.setPoolLimits(2, kTestPoolMaxBytes, kTestPoolMaxAge);
+    mAllocator.setUpAllocateExpectations(
+            {makeTestHandle(1), makeTestHandle(2), makeTestHandle(3)});
+    std::vector<buffer_handle_t> handles = {allocate(), allocate(kTestUsage, kTestWidth / 2),
+                                            allocate()};
+    for (buffer_handle_t handle : handles) {
+        ASSERT_EQ(NO_ERROR, mAllocator.free(handle));
+    }
+    EXPECT_THAT(mAllocator.getReleasedBuffers(), ElementsAre(makeTestHandle(1)));
+
+    // The byte limit evicts buffers as well.
+    mAllocator.setPoolLimits(2, kTestWidth * 4, kTestPoolMaxAge);
+    EXPECT_THAT(mAllocator.getReleasedBuffers(),
+                ElementsAre(makeTestHandle(1), makeTestHandle(2)));
+}
+
+TEST_F(GraphicBufferAllocatorTest, PoolFreesExpiredBuffers) {
+    mAllocator.setPoolLimits(4, kTestPoolMaxBytes, std::chrono::milliseconds(1));
+    mAllocator.setUpAllocateExpectations({makeTestHandle(1), makeTestHandle(2)});
+    ASSERT_EQ(NO_ERROR, mAllocator.free(allocate()));
+
+    std::this_thread::sleep_for(std::chrono::milliseconds(10));
+    EXPECT_EQ(makeTestHandle(2), allocate());
+    EXPECT_THAT(mAllocator.getReleasedBuffers(), ElementsAre(makeTestHandle(1)));
+}
+
+TEST_F(GraphicBufferAllocatorTest, PoolTrim) {
+    mAllocator.setPoolLimits(4, kTestPoolMaxBytes, kTestPoolMaxAge);
+    mAllocator.setUpAllocateExpectations(
+            {makeTestHandle(1), makeTestHandle(2), makeTestHandle(3)});
+    buffer_handle_t first = allocate();
+    buffer_handle_t second = allocate();
+    ASSERT_EQ(NO_ERROR, mAllocator.free(first));
+    ASSERT_EQ(NO_ERROR, mAllocator.free(second));
+
+    mAllocator.trimPool(kTestWidth * 4);
+    EXPECT_THAT(mAllocator.getReleasedBuffers(), ElementsAre(makeTestHandle(1)));
+    mAllocator.trimPool();
+    EXPECT_THAT(mAllocator.getReleasedBuffers(),
+                ElementsAre(makeTestHandle(1), makeTestHandle(2)));
+
+    EXPECT_EQ(makeTestHandle(3), allocate());
+}
+
+TEST_F(GraphicBufferAllocatorTest, PoolSkipsProtectedBuffers) {
+    mAllocator.setPoolLimits(4, kTestPoolMaxBytes, kTestPoolMaxAge);
+    mAllocator.setUpAllocateExpectations({makeTestHandle(1)});
+    ASSERT_EQ(NO_ERROR, mAllocator.free(allocate(kTestUsage | GraphicBuffer::USAGE_PROTECTED)));
+    EXPECT_THAT(mAllocator.getReleasedBuffers(), ElementsAre(makeTestHandle(1)));
+}
+
+TEST_F(GraphicBufferAllocatorTest, PoolSkipsBuffersAllocatedWithoutFlag) {
+    mAllocator.setPoolLimits(4, kTestPoolMaxBytes, kTestPoolMaxAge);
+    mAllocator.setUpAllocateExpectations(
+            {makeTestHandle(1), makeTestHandle(2), makeTestHandle(3), makeTestHandle(4)});
+    ASSERT_EQ(NO_ERROR, mAllocator.free(allocate(kTestUsage, kTestWidth, false)));
+    EXPECT_THAT(mAllocator.getReleasedBuffers(), ElementsAre(makeTestHandle(1)));
+
+    buffer_handle_t handle = nullptr;
+    uint32_t stride = 0;
+    ASSERT_EQ(NO_ERROR,
+              mAllocator.allocate(kTestWidth, kTestHeight, PIXEL_FORMAT_RGBA_8888, kTestLayerCount,
+                                  kTestUsage, &handle, &stride, "GraphicBufferAllocatorTest"));
+    ASSERT_EQ(NO_ERROR, mAllocator.free(handle));
+    EXPECT_THAT(mAllocator.getReleasedBuffers(),
+                ElementsAre(makeTestHandle(1), makeTestHandle(2)));
+
+    // A pooled buffer is not handed out to a request without the flag.
+    ASSERT_EQ(NO_ERROR, mAllocator.free(allocate()));
+    EXPECT_EQ(makeTestHandle(4), allocate(kTestUsage, kTestWidth, false));
+    EXPECT_THAT(mAllocator.getReleasedBuffers(),
+                ElementsAre(makeTestHandle(1), makeTestHandle(2)));
+}
+
+TEST_F(GraphicBufferAllocatorTest, PoolDumpsHitRate) {
+    mAllocator.setPoolLimits(4, kTestPoolMaxBytes, kTestPoolMaxAge);
+    mAllocator.setUpAllocateExpectations({makeTestHandle(1)});
+    ASSERT_EQ(NO_ERROR, mAllocator.free(allocate()));
+    allocate();
+
+    std::string dump;
+    mAllocator.dump(dump);
+    EXPECT_THAT(dump, HasSubstr("GraphicBufferAllocator pool: 0 buffers"));
+    EXPECT_THAT(dump, HasSubstr("50.0%"));
+}
 } // namespace android
@@ -0,0 +1,70 @@
+/*
+ * Copyright 2024 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#pragma once
+
+#include <android-base/unique_fd.h>
+#include <fcntl.h>
+#include <linux/types.h>
+#include <sys/ioctl.h>
+#include <ui/Fence.h>
+
+#include <cstring>
+
+namespace android {
+
+// The sw_sync interface of the kernel, which is not part of its UAPI headers.
+// It needs CONFIG_SW_SYNC, which is also available on Linux hosts.
+struct sw_sync_create_fence_data {
+    __u32 value;
+    char name[32];
+    __s32 fence;
+};
+
+#define SW_SYNC_IOC_CREATE_FENCE _IOWR('W', 0, struct sw_sync_create_fence_data)
+#define SW_SYNC_IOC_INC _IOW('W', 1, __u32)
+
+// A software sync timeline, whose fences signal when the timeline is advanced past their value.
+class SwSyncTimeline {
+public:
+    SwSyncTimeline() {
+        for (const char* path : {"/sys/kernel/debug/sync/sw_sync", "/dev/sw_sync"}) {
+            mFd.reset(open(path, O_RDWR | O_CLOEXEC));
+            if (mFd.ok()) {
+                break;
+            }
+        }
+    }
+
+    bool isValid() const { return mFd.ok(); }
+
+    sp<Fence> createFence(uint32_t value) {
+        sw_sync_create_fence_data data{};
+        data.value = value;
+        strlcpy(data.name, "SwSyncTimeline", sizeof(data.name));
+        if (ioctl(mFd.get(), SW_SYNC_IOC_CREATE_FENCE, &data) != 0) {
+            return Fence::NO_FENCE;
+        }
+        return sp<Fence>::make(data.fence);
+    }
+
+    void advance(uint32_t count) { ioctl(mFd.get(), SW_SYNC_IOC_INC, &count); }
+
+private:
+    base::unique_fd mFd;
+};
+
+} // namespace android
@@ -0,0 +1,162 @@
+/*
+ * Copyright 2024 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include <benchmark/benchmark.h>
+#include <ui/Region.h>
+#include <ui/Transform.h>
+
+#include <cmath>
+#include <vector>
+
+namespace android::ui {
+
+namespace {
+
+// The kinds of transforms that layers usually have, by benchmark argument.
+enum TransformKind : int64_t { TRANSLATE, SCALE, ROT_90, ROTATE };
+
+Transform makeTransform(int64_t kind) {
+    Transform t;
+    switch (kind) {
+        case TRANSLATE:
+            t.set(12.f, 34.f);
+            break;
+        case SCALE:
+            t.set(1.5f, 0.f, 0.f, 1.5f);
+            t.set(12.f, 34.f);
+            break;
+        case ROT_90:
+            t = Transform(Transform::ROT_90, 1080, 2340);
+            break;
+        case ROTATE:
+            t.set(std::cos(0.5f), -std::sin(0.5f), std::sin(0.5f), std::cos(0.5f));
+            t.set(12.f, 34.f);
+            break;
+    }
+    t.getType();
+    return t;
+}
+
+std::vector<Rect> makeRects(size_t count) {
+    std::vector<Rect> rects;
+    rects.reserve(count);
+    for (size_t i = 0; i < count; i++) {
+        const int32_t offset = static_cast<int32_t>(i) * 7;
+        rects.emplace_back(offset, offset * 2, offset + 100, offset * 2 + 50);
+    }
+    return rects;
+}
+
+void addKinds(benchmark::internal::Benchmark* b) {
+    b->ArgNames({"kind"});
+    for (const int64_t kind : {TRANSLATE, SCALE, ROT_90, ROTATE}) {
+        b->Arg(kind);
+    }
+}
+
+} // namespace
+
+static void BM_TransformRect(benchmark::State& state) {
+    const Transform t = makeTransform(state.range(0));
+    Rect rect(10, 20, 1000, 2000);
+    for (auto _ : state) {
+        benchmark::DoNotOptimize(rect);
+        benchmark::DoNotOptimize(t.transform(rect));
+    }
+}
+BENCHMARK(BM_TransformRect)->Apply(addKinds);
+
+static void BM_TransformFloatRect(benchmark::State& state) {
+    const Transform t = makeTransform(state.range(0));
+    FloatRect rect(10.5f, 20.5f, 1000.5f, 2000.5f);
+    for (auto _ : state) {
+        benchmark::DoNotOptimize(rect);
+        benchmark::DoNotOptimize(t.transform(rect));
+    }
+}
+BENCHMARK(BM_TransformFloatRect)->Apply(addKinds);
+
+static void BM_TransformRegion(benchmark::State& state) {
+    const Transform t = makeTransform(state.range(0));
+    Region region;
+    for (const Rect& rect : makeRects(16)) {
+        region.orSelf(rect);
+    }
+    for (auto _ : state) {
+        benchmark::DoNotOptimize(t.transform(region));
+    }
+}
+BENCHMARK(BM_TransformRegion)->Apply(addKinds);
+
+static void BM_TransformMultiply(benchmark::State& state) {
+    const Transform parent = makeTransform(state.range(0));
+    Transform child;
+    child.set(5.f, 6.f);
+    for (auto _ : state) {
+        benchmark::DoNotOptimize(child);
+        benchmark::DoNotOptimize(parent * child);
+    }
+}
+BENCHMARK(BM_TransformMultiply)->Apply(addKinds);
+
+static void BM_TransformInverse(benchmark::State& state) {
+    const Transform t = makeTransform(state.range(0));
+    for (auto _ : state) {
+        benchmark::DoNotOptimize(t.inverse());
+    }
+}
+BENCHMARK(BM_TransformInverse)->Apply(addKinds);
+
+// Transforms 64 rects one at a time and as a batch.
+static void BM_TransformRectsOneByOne(benchmark::State& state) {
+    const Transform t = makeTransform(state.range(0));
+    const std::vector<Rect> rects = makeRects(64);
+    std::vector<Rect> out(rects.size());
+    for (auto _ : state) {
+        for (size_t i = 0; i < rects.size(); i++) {
+            out[i] = t.transform(rects[i]);
+        }
+        benchmark::DoNotOptimize(out.data());
+    }
+}
+BENCHMARK(BM_TransformRectsOneByOne)->Apply(addKinds);
+
+static void BM_TransformRects(benchmark::State& state) {
+    const Transform t = makeTransform(state.range(0));
+    const std::vector<Rect> rects = makeRects(64);
+    std::vector<Rect> out(rects.size());
+    for (auto _ : state) {
+        t.transformRects(rects.data(), out.data(), rects.size());
+        benchmark::DoNotOptimize(out.data());
+    }
+}
+BENCHMARK(BM_TransformRects)->Apply(addKinds);
+
+static void BM_TransformPoints(benchmark::State& state) {
+    const Transform t = makeTransform(state.range(0));
+    std::vector<vec2> points;
+    for (size_t i = 0; i < 256; i++) {
+        points.emplace_back(static_cast<float>(i), static_cast<float>(i) * 0.5f);
+    }
+    std::vector<vec2> out(points.size());
+    for (auto _ : state) {
+        t.transformPoints(points.data(), out.data(), points.size());
+        benchmark::DoNotOptimize(out.data());
+    }
+}
+BENCHMARK(BM_TransformPoints)->Apply(addKinds);
+
+} // namespace android::ui
@@ -18,8 +18,94 @@
 
 #include <gtest/gtest.h>
 
+#include <algorithm>
+#include <array>
+#include <cmath>
+#include <limits>
+#include <vector>
+
 namespace android::ui {
 
+namespace {
+
+std::vector<Transform> makeTestTransforms() {
+    std::vector<Transform> transforms(1);
+
+    Transform translate;
+    translate.set(12.25f, -7.5f);
+    transforms.push_back(translate);
+
+    Transform scale;
+    scale.set(1.5f, 0.f, 0.f, 0.75f);
+    scale.set(-3.f, 40.5f);
+    transforms.push_back(scale);
+
+    for (const auto flags : {Transform::FLIP_H, Transform::FLIP_V, Transform::ROT_90,
+                             Transform::ROT_180, Transform::ROT_270}) {
+        transforms.emplace_back(flags, 1080, 2340);
+    }
+
+    Transform rotateScale;
+    rotateScale.set(0.f, -2.f, 0.5f, 0.f);
+    rotateScale.set(100.125f, 3.f);
+    transforms.push_back(rotateScale);
+
+    Transform skew;
+    skew.set(1.f, 0.25f, 0.5f, 1.f);
+    transforms.push_back(skew);
+
+    Transform rotate;
+    rotate.set(std::cos(0.5f), -std::sin(0.5f), std::sin(0.5f), std::cos(0.5f));
+    rotate.set(-20.f, 60.f);
+    transforms.push_back(rotate);
+
+    return transforms;
+}
+
+// The bounds of the four transformed corners, which is how Transform transformed every rect
+// before it had fast paths for the transforms that preserve rects.
+FloatRect referenceTransform(const Transform& t, const FloatRect& r) {
+    const vec2 lt = t.transform(r.left, r.top);
+    const vec2 rt = t.transform(r.right, r.top);
+    const vec2 lb = t.transform(r.left, r.bottom);
+    const vec2 rb = t.transform(r.right, r.bottom);
+    return FloatRect(std::min({lt[0], rt[0], lb[0], rb[0]}), std::min({lt[1], rt[1], lb[1], rb[1]}),
+                     std::max({lt[0], rt[0], lb[0], rb[0]}),
+                     std::max({lt[1], rt[1], lb[1], rb[1]}));
+}
+
+Rect referenceTransform(const Transform& t, const Rect& r, bool roundOutwards) {
+    const FloatRect bounds = referenceTransform(t, r.toFloatRect());
+    if (roundOutwards) {
+        return Rect(static_cast<int32_t>(floorf(bounds.left)),
+                    static_cast<int32_t>(floorf(bounds.top)),
+                    static_cast<int32_t>(ceilf(bounds.right)),
+                    static_cast<int32_t>(ceilf(bounds.bottom)));
+    }
+    return Rect(static_cast<int32_t>(floorf(bounds.left + 0.5f)),
+                static_cast<int32_t>(floorf(bounds.top + 0.5f)),
+                static_cast<int32_t>(floorf(bounds.right + 0.5f)),
+                static_cast<int32_t>(floorf(bounds.bottom + 0.5f)));
+}
+
+// The full 3x3 matrix multiply.
+Transform referenceMultiply(const Transform& a, const Transform& b) {
+    std::array<float, 9> matrix;
+    for (size_t i = 0; i < 3; i++) {
+        for (size_t j = 0; j < 3; j++) {
+            matrix[3 * i + j] = a[0][i] * b[j][0] + a[1][i] * b[j][1] + a[2][i] * b[j][2];
+        }
+    }
+    Transform result;
+    result.set(matrix);
+    return result;
+}
+
+const std::vector<Rect> kTestRects = {Rect(0, 0, 1080, 2340), Rect(-15, 7, 33, 2),
+                                      Rect(101, -50, 101, 20), Rect(-3000, -3000, -1, 5)};
+
+} // namespace
+
 TEST(TransformTest, inverseRotation_hasCorrectType) {
     const auto testRotationFlagsForInverse = [](Transform::RotationFlags rotation,
                                                 Transform::RotationFlags expectedInverse,
@@ -46,4 +132,71 @@ TEST(TransformTest, inverseRotation_hasCorrectType) {
     testRotationFlagsForInverse(Transform::FLIP_V, Transform::FLIP_V, false);
 }
 
+TEST(TransformTest, transformRect_matchesCorners) {
+    for (const Transform& t : makeTestTransforms()) {
+        for (const Rect& r : kTestRects) {
+            EXPECT_EQ(referenceTransform(t, r, false), t.transform(r));
+            EXPECT_EQ(referenceTransform(t, r, true), t.transform(r, true));
+            EXPECT_EQ(referenceTransform(t, r.toFloatRect()), t.transform(r.toFloatRect()));
+        }
+        const FloatRect fractional(-0.75f, 10.5f, 33.25f, 1e7f);
+        EXPECT_EQ(referenceTransform(t, fractional), t.transform(fractional));
+    }
+}
+
+TEST(TransformTest, transformFloatRect_nonFiniteMatchesCorners) {
+    constexpr float kInfinity = std::numeric_limits<float>::infinity();
+    const auto sameFloat = [](float a, float b) {
+        return (std::isnan(a) && std::isnan(b)) || a == b;
+    };
+    const FloatRect infinite(-kInfinity, -kInfinity, kInfinity, kInfinity);
+    for (const Transform& t : makeTestTransforms()) {
+        const FloatRect expected = referenceTransform(t, infinite);
+        const FloatRect result = t.transform(infinite);
+        EXPECT_TRUE(sameFloat(expected.left, result.left));
+        EXPECT_TRUE(sameFloat(expected.top, result.top));
+        EXPECT_TRUE(sameFloat(expected.right, result.right));
+        EXPECT_TRUE(sameFloat(expected.bottom, result.bottom));
+    }
+}
+
+TEST(TransformTest, transformRects_matchesTransformRect) {
+    for (const Transform& t : makeTestTransforms()) {
+        for (const bool roundOutwards : {false, true}) {
+            std::vector<Rect> out(kTestRects.size());
+            t.transformRects(kTestRects.data(), out.data(), kTestRects.size(), roundOutwards);
+            for (size_t i = 0; i < kTestRects.size(); i++) {
+                EXPECT_EQ(t.transform(kTestRects[i], roundOutwards), out[i]);
+            }
+        }
+    }
+}
+
+TEST(TransformTest, transformPoints_matchesTransformPoint) {
+    const std::vector<vec2> points = {{0.f, 0.f}, {-1.5f, 2.25f}, {1080.f, 2340.f}, {1e6f, -3.f}};
+    for (const Transform& t : makeTestTransforms()) {
+        std::vector<vec2> out(points.size());
+        t.transformPoints(points.data(), out.data(), points.size());
+        for (size_t i = 0; i < points.size(); i++) {
+            EXPECT_EQ(t.transform(points[i]), out[i]);
+        }
+    }
+}
+
+TEST(TransformTest, multiply_matchesFullMultiply) {
+    const auto transforms = makeTestTransforms();
+    for (const Transform& a : transforms) {
+        // Transforms with skew are still composed with the full multiply.
+        if (!a.preserveRects()) continue;
+        for (const Transform& b : transforms) {
+            if (!b.preserveRects()) continue;
+            const Transform expected = referenceMultiply(a, b);
+            const Transform result = a * b;
+            EXPECT_EQ(expected, result);
+            EXPECT_EQ(expected.getType(), result.getType());
+            EXPECT_EQ(expected.getOrientation(), result.getOrientation());
+        }
+    }
+}
+
 } // namespace android::ui
@@ -206,6 +206,16 @@ NotifyMotionArgs removePointerIds(const NotifyMotionArgs& args,
     return newArgs;
 }
 
+// Return true if any of the pointers in the provided NotifyMotionArgs is a stylus.
+static bool hasStylusPointer(const NotifyMotionArgs& args) {
+    for (uint32_t i = 0; i < args.getPointerCount(); i++) {
+        if (isStylusToolType(args.pointerProperties[i].toolType)) {
+            return true;
+        }
+    }
+    return false;
+}
+
 /**
  * Remove stylus pointers from the provided NotifyMotionArgs.
  *
@@ -287,6 +297,10 @@ std::vector<NotifyMotionArgs> cancelSuppressedPointers(
         const NotifyMotionArgs& args, const std::set<int32_t>& oldSuppressedPointerIds,
         const std::set<int32_t>& newSuppressedPointerIds) {
     LOG_ALWAYS_FATAL_IF(args.getPointerCount() == 0, "0 pointers in %s", args.dump().c_str());
+    if (oldSuppressedPointerIds.empty() && newSuppressedPointerIds.empty()) {
+        // Nothing to remove or cancel.
+        return {args};
+    }
 
     // First, let's remove the old suppressed pointers. They've already been canceled previously.
     NotifyMotionArgs oldArgs = removePointerIds(args, oldSuppressedPointerIds);
@@ -499,26 +513,22 @@ void SlotState::update(const NotifyMotionArgs& args) {
 }
 
 size_t SlotState::findUnusedSlot() const {
-    size_t unusedSlot = 0;
-    // Since the collection is ordered, we can rely on the in-order traversal
-    for (const auto& [slot, trackingId] : mPointerIdsBySlot) {
-        if (unusedSlot != slot) {
-            break;
-        }
-        unusedSlot++;
-    }
-    return unusedSlot;
+    LOG_ALWAYS_FATAL_IF(mUsedSlots.isFull(), "No unused slot");
+    return mUsedSlots.firstUnmarkedBit();
 }
 
 void SlotState::processPointerId(int pointerId, int32_t actionMasked) {
+    LOG_ALWAYS_FATAL_IF(pointerId < 0 || pointerId > MAX_POINTER_ID, "Invalid pointer id %d",
+                        pointerId);
     switch (MotionEvent::getActionMasked(actionMasked)) {
         case AMOTION_EVENT_ACTION_DOWN:
         case AMOTION_EVENT_ACTION_POINTER_DOWN:
         case AMOTION_EVENT_ACTION_HOVER_ENTER: {
             // New pointer going down
             size_t newSlot = findUnusedSlot();
-            mPointerIdsBySlot[newSlot] = pointerId;
-            mSlotsByPointerId[pointerId] = newSlot;
+            mUsedSlots.markBit(newSlot);
+            mPointerIds.markBit(pointerId);
+            mSlotsByPointerId[pointerId] = static_cast<uint8_t>(newSlot);
             return;
         }
         case AMOTION_EVENT_ACTION_MOVE:
@@ -529,12 +539,10 @@ void SlotState::processPointerId(int pointerId, int32_t actionMasked) {
         case AMOTION_EVENT_ACTION_POINTER_UP:
         case AMOTION_EVENT_ACTION_UP:
         case AMOTION_EVENT_ACTION_HOVER_EXIT: {
-            auto it = mSlotsByPointerId.find(pointerId);
-            LOG_ALWAYS_FATAL_IF(it == mSlotsByPointerId.end());
-            size_t slot = it->second;
+            LOG_ALWAYS_FATAL_IF(!mPointerIds.hasBit(pointerId));
             // Erase this pointer from both collections
-            mPointerIdsBySlot.erase(slot);
-            mSlotsByPointerId.erase(pointerId);
+            mUsedSlots.clearBit(mSlotsByPointerId[pointerId]);
+            mPointerIds.clearBit(pointerId);
             return;
         }
     }
@@ -543,18 +551,24 @@ void SlotState::processPointerId(int pointerId, int32_t actionMasked) {
 }
 
 std::optional<size_t> SlotState::getSlotForPointerId(int32_t pointerId) const {
-    auto it = mSlotsByPointerId.find(pointerId);
-    if (it == mSlotsByPointerId.end()) {
+    if (pointerId < 0 || pointerId > MAX_POINTER_ID || !mPointerIds.hasBit(pointerId)) {
         return std::nullopt;
     }
-    return it->second;
+    return mSlotsByPointerId[pointerId];
 }
 
 std::string SlotState::dump() const {
+    std::map<int32_t /*pointerId*/, size_t /*slot*/> slotsByPointerId;
+    std::map<size_t /*slot*/, int32_t /*pointerId */> pointerIdsBySlot;
+    for (BitSet32 idBits(mPointerIds); !idBits.isEmpty();) {
+        const int32_t pointerId = idBits.clearFirstMarkedBit();
+        slotsByPointerId[pointerId] = mSlotsByPointerId[pointerId];
+        pointerIdsBySlot[mSlotsByPointerId[pointerId]] = pointerId;
+    }
     std::string out = "mSlotsByPointerId:\n";
-    out += addLinePrefix(dumpMap(mSlotsByPointerId), "  ") + "\n";
+    out += addLinePrefix(dumpMap(slotsByPointerId), "  ") + "\n";
     out += "mPointerIdsBySlot:\n";
-    out += addLinePrefix(dumpMap(mPointerIdsBySlot), "  ") + "\n";
+    out += addLinePrefix(dumpMap(pointerIdsBySlot), "  ") + "\n";
     return out;
 }
 
@@ -588,66 +602,75 @@ std::vector<::ui::InProgressTouchEvdev> getTouches(const NotifyMotionArgs& args,
                                                    const SlotState& oldSlotState,
                                                    const SlotState& newSlotState) {
     std::vector<::ui::InProgressTouchEvdev> touches;
+    getTouches(args, deviceInfo, oldSlotState, newSlotState, touches);
+    return touches;
+}
+
+void getTouches(const NotifyMotionArgs& args, const AndroidPalmFilterDeviceInfo& deviceInfo,
+                const SlotState& oldSlotState, const SlotState& newSlotState,
+                std::vector<::ui::InProgressTouchEvdev>& outTouches) {
+    // The touches that are already in the vector are overwritten in place. The fields that are not
+    // written below keep the default values that they were constructed with.
+    outTouches.resize(args.getPointerCount());
 
     for (size_t i = 0; i < args.getPointerCount(); i++) {
         const int32_t pointerId = args.pointerProperties[i].id;
-        touches.emplace_back(::ui::InProgressTouchEvdev());
-        touches.back().major = args.pointerCoords[i].getAxisValue(AMOTION_EVENT_AXIS_TOUCH_MAJOR);
-        touches.back().minor = args.pointerCoords[i].getAxisValue(AMOTION_EVENT_AXIS_TOUCH_MINOR);
+        ::ui::InProgressTouchEvdev& touch = outTouches[i];
+        touch.major = args.pointerCoords[i].getAxisValue(AMOTION_EVENT_AXIS_TOUCH_MAJOR);
+        touch.minor = args.pointerCoords[i].getAxisValue(AMOTION_EVENT_AXIS_TOUCH_MINOR);
         // The field 'tool_type' is not used for palm rejection
 
         // Whether there is new information for the touch.
-        touches.back().altered = true;
+        touch.altered = true;
 
         // Whether the touch was cancelled. Touch events should be ignored till a
         // new touch is initiated.
-        touches.back().was_cancelled = false;
+        touch.was_cancelled = false;
 
         // Whether the touch is going to be canceled.
-        touches.back().cancelled = false;
+        touch.cancelled = false;
 
         // Whether the touch is delayed at first appearance. Will not be reported yet.
-        touches.back().delayed = false;
+        touch.delayed = false;
 
         // Whether the touch was delayed before.
-        touches.back().was_delayed = false;
+        touch.was_delayed = false;
 
         // Whether the touch is held until end or no longer held.
-        touches.back().held = false;
+        touch.held = false;
 
         // Whether this touch was held before being sent.
-        touches.back().was_held = false;
+        touch.was_held = false;
 
         const int32_t resolvedAction = resolveActionForPointer(i, args.action);
         const bool isDown = resolvedAction == AMOTION_EVENT_ACTION_POINTER_DOWN ||
                 resolvedAction == AMOTION_EVENT_ACTION_DOWN;
-        touches.back().was_touching = !isDown;
+        touch.was_touching = !isDown;
 
         const bool isUpOrCancel = resolvedAction == AMOTION_EVENT_ACTION_CANCEL ||
                 resolvedAction == AMOTION_EVENT_ACTION_UP ||
                 resolvedAction == AMOTION_EVENT_ACTION_POINTER_UP;
 
-        touches.back().x = args.pointerCoords[i].getAxisValue(AMOTION_EVENT_AXIS_X);
-        touches.back().y = args.pointerCoords[i].getAxisValue(AMOTION_EVENT_AXIS_Y);
+        touch.x = args.pointerCoords[i].getAxisValue(AMOTION_EVENT_AXIS_X);
+        touch.y = args.pointerCoords[i].getAxisValue(AMOTION_EVENT_AXIS_Y);
 
         std::optional<size_t> slot = newSlotState.getSlotForPointerId(pointerId);
         if (!slot) {
             slot = oldSlotState.getSlotForPointerId(pointerId);
         }
         LOG_ALWAYS_FATAL_IF(!slot, "Could not find slot for pointer %d", pointerId);
-        touches.back().slot = *slot;
-        touches.back().tracking_id = (!isUpOrCancel) ? pointerId : -1;
-        touches.back().touching = !isUpOrCancel;
+        touch.slot = *slot;
+        touch.tracking_id = (!isUpOrCancel) ? pointerId : -1;
+        touch.touching = !isUpOrCancel;
 
         // The fields 'radius_x' and 'radius_x' are not used for palm rejection
-        touches.back().pressure = args.pointerCoords[i].getAxisValue(AMOTION_EVENT_AXIS_PRESSURE);
-        touches.back().tool_code = getLinuxToolCode(args.pointerProperties[i].toolType);
+        touch.pressure = args.pointerCoords[i].getAxisValue(AMOTION_EVENT_AXIS_PRESSURE);
+        touch.tool_code = getLinuxToolCode(args.pointerProperties[i].toolType);
         // The field 'orientation' is not used for palm rejection
         // The fields 'tilt_x' and 'tilt_y' are not used for palm rejection
         // The field 'reported_tool_type' is not used for palm rejection
-        touches.back().stylus_button = false;
+        touch.stylus_button = false;
     }
-    return touches;
 }
 
 std::set<int32_t> PalmRejector::detectPalmPointers(const NotifyMotionArgs& args) {
@@ -659,19 +682,18 @@ std::set<int32_t> PalmRejector::detectPalmPointers(const NotifyMotionArgs& args)
     SlotState oldSlotState = mSlotState;
     mSlotState.update(args);
 
-    std::vector<::ui::InProgressTouchEvdev> touches =
-            getTouches(args, mDeviceInfo, oldSlotState, mSlotState);
+    getTouches(args, mDeviceInfo, oldSlotState, mSlotState, mTouches);
     ::base::TimeTicks chromeTimestamp = toChromeTimestamp(args.eventTime);
 
     if (DEBUG_MODEL) {
         std::stringstream touchesStream;
-        for (const ::ui::InProgressTouchEvdev& touch : touches) {
+        for (const ::ui::InProgressTouchEvdev& touch : mTouches) {
             touchesStream << touch.tracking_id << " : " << touch << "\n";
         }
         ALOGD("Filter: touches = %s", touchesStream.str().c_str());
     }
 
-    mPalmDetectionFilter->Filter(touches, chromeTimestamp, &slotsToHold, &slotsToSuppress);
+    mPalmDetectionFilter->Filter(mTouches, chromeTimestamp, &slotsToHold, &slotsToSuppress);
 
     ALOGD_IF(DEBUG_MODEL, "Response: slotsToHold = %s, slotsToSuppress = %s",
              slotsToHold.to_string().c_str(), slotsToSuppress.to_string().c_str());
@@ -713,8 +735,11 @@ std::vector<NotifyMotionArgs> PalmRejector::processMotion(const NotifyMotionArgs
     std::set<int32_t> oldSuppressedIds;
     std::swap(oldSuppressedIds, mSuppressedPointerIds);
 
-    std::optional<NotifyMotionArgs> touchOnlyArgs = removeStylusPointerIds(args);
-    if (touchOnlyArgs) {
+    if (!hasStylusPointer(args)) {
+        // Avoid copying the args for the common case of a touch-only event.
+        mSuppressedPointerIds = detectPalmPointers(args);
+    } else if (std::optional<NotifyMotionArgs> touchOnlyArgs = removeStylusPointerIds(args);
+               touchOnlyArgs) {
         mSuppressedPointerIds = detectPalmPointers(*touchOnlyArgs);
     } else {
         // This is a stylus-only event.
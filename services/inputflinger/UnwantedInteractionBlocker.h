@@ -16,10 +16,12 @@
 
 #pragma once
 
+#include <array>
 #include <map>
 #include <set>
 
 #include <android-base/thread_annotations.h>
+#include <utils/BitSet.h>
 #include "include/UnwantedInteractionBlockerInterface.h"
 #include "ui/events/ozone/evdev/touch_filter/neural_stylus_palm_detection_filter_util.h"
 #include "ui/events/ozone/evdev/touch_filter/palm_detection_filter.h"
@@ -139,15 +141,14 @@ public:
 private:
     // Process a pointer with the provided action, and return the slot associated with it
     void processPointerId(int32_t pointerId, int32_t action);
-    // The map from tracking id to slot state. Since the PalmRejectionFilter works close to the
+    // The mapping from pointer id to slot. Since the PalmRejectionFilter works close to the
     // evdev level, the only way to tell it about UP or CANCEL events is by sending tracking id = -1
     // to the appropriate touch slot. So we need to reconstruct the original slot.
-    // The two collections below must always be in-sync.
-    // Use std::map instead of std::unordered_map because we rely on these collections being
-    // ordered. It also has better space efficiency than unordered_map because we only have a few
-    // pointers most of the time.
-    std::map<int32_t /*pointerId*/, size_t /*slot*/> mSlotsByPointerId;
-    std::map<size_t /*slot*/, int32_t /*pointerId */> mPointerIdsBySlot;
+    // The state is stored in fixed-size arrays rather than in maps, because it is copied for every
+    // event that goes to the palm rejection model. The collections below must always be in-sync.
+    BitSet32 mPointerIds;
+    std::array<uint8_t, MAX_POINTER_ID + 1> mSlotsByPointerId{};
+    BitSet32 mUsedSlots;
 
     size_t findUnusedSlot() const;
 };
@@ -161,6 +162,15 @@ std::vector<::ui::InProgressTouchEvdev> getTouches(const NotifyMotionArgs& args,
                                                    const SlotState& oldSlotState,
                                                    const SlotState& newSlotState);
 
+/**
+ * Same as above, but update the touches of the provided vector in place, so that the same storage
+ * can be used for every event of a device. Only the fields that are used by the palm rejection
+ * model are written, so the vector must only contain touches that were produced by this function.
+ */
+void getTouches(const NotifyMotionArgs& args, const AndroidPalmFilterDeviceInfo& deviceInfo,
+                const SlotState& oldSlotState, const SlotState& newSlotState,
+                std::vector<::ui::InProgressTouchEvdev>& outTouches);
+
 class PalmRejector {
 public:
     explicit PalmRejector(const AndroidPalmFilterDeviceInfo& info,
@@ -190,6 +200,9 @@ private:
 
     // Used to help convert an Android touch stream to Linux input stream.
     SlotState mSlotState;
+    // The touches that are sent to the palm rejection model. Kept across events, so that its
+    // storage is reused.
+    std::vector<::ui::InProgressTouchEvdev> mTouches;
 };
 
 } // namespace android
@@ -0,0 +1,171 @@
+/*
+ * Copyright (C) 2024 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "EvemuRecording.h"
+
+#include <fstream>
+#include <sstream>
+
+namespace android {
+
+namespace {
+
+bool testBit(const std::vector<uint8_t>& bits, int32_t bit) {
+    if (bit < 0 || static_cast<size_t>(bit / 8) >= bits.size()) {
+        return false;
+    }
+    return (bits[bit / 8] & (1 << (bit % 8))) != 0;
+}
+
+// Appends the hexadecimal bytes that remain in the stream to the given bitmask.
+bool readBytes(std::istream& stream, std::vector<uint8_t>& outBits) {
+    unsigned int byte;
+    while (stream >> std::hex >> byte) {
+        if (byte > 0xff) {
+            return false;
+        }
+        outBits.push_back(static_cast<uint8_t>(byte));
+    }
+    return stream.eof();
+}
+
+// Parses a timestamp of the form "<seconds>.<microseconds>".
+bool parseTime(const std::string& text, nsecs_t& outTime) {
+    const size_t dot = text.find('.');
+    if (dot == std::string::npos || dot == 0 || text.size() - dot - 1 != 6) {
+        return false;
+    }
+    char* end;
+    const long long seconds = strtoll(text.c_str(), &end, 10);
+    if (end != text.c_str() + dot) {
+        return false;
+    }
+    const long long micros = strtoll(text.c_str() + dot + 1, &end, 10);
+    if (*end != '\0' || seconds < 0 || micros < 0) {
+        return false;
+    }
+    outTime = s2ns(seconds) + us2ns(micros);
+    return true;
+}
+
+} // namespace
+
+bool EvemuRecording::hasProperty(int32_t property) const {
+    return testBit(properties, property);
+}
+
+bool EvemuRecording::hasCode(int32_t type, int32_t code) const {
+    auto it = codes.find(type);
+    return it != codes.end() && testBit(it->second, code);
+}
+
+std::vector<int32_t> EvemuRecording::getCodes(int32_t type) const {
+    std::vector<int32_t> result;
+    auto it = codes.find(type);
+    if (it != codes.end()) {
+        for (size_t code = 0; code < it->second.size() * 8; code++) {
+            if (testBit(it->second, code)) {
+                result.push_back(code);
+            }
+        }
+    }
+    return result;
+}
+
+base::Result<EvemuRecording> EvemuRecording::parse(std::istream& stream) {
+    EvemuRecording recording;
+    std::string line;
+    for (size_t lineNumber = 1; std::getline(stream, line); lineNumber++) {
+        if (line.empty() || line[0] == '#') {
+            continue;
+        }
+        if (line.size() < 2 || line[1] != ':') {
+            return base::Errorf("line %zu: unexpected line '%s'", lineNumber, line.c_str());
+        }
+        std::istringstream fields(line.substr(2));
+        bool valid = true;
+        switch (line[0]) {
+            case 'N': {
+                recording.name = line.size() > 3 ? line.substr(3) : "";
+                break;
+            }
+            case 'I': {
+                unsigned int bus, vendor, product, version;
+                valid = static_cast<bool>(fields >> std::hex >> bus >> vendor >> product >> version);
+                recording.bus = bus;
+                recording.vendor = vendor;
+                recording.product = product;
+                recording.version = version;
+                break;
+            }
+            case 'P': {
+                valid = readBytes(fields, recording.properties);
+                break;
+            }
+            case 'B': {
+                unsigned int type;
+                valid = static_cast<bool>(fields >> std::hex >> type) &&
+                        readBytes(fields, recording.codes[type]);
+                break;
+            }
+            case 'A': {
+                AbsoluteAxis axis;
+                unsigned int code;
+                valid = static_cast<bool>(fields >> std::hex >> code >> std::dec >> axis.minValue >>
+                                          axis.maxValue >> axis.fuzz >> axis.flat >>
+                                          axis.resolution);
+                axis.code = code;
+                recording.axes.push_back(axis);
+                break;
+            }
+            case 'E': {
+                std::string time;
+                unsigned int type, code;
+                Event event;
+                valid = static_cast<bool>(fields >> time >> std::hex >> type >> code >> std::dec >>
+                                          event.value) &&
+                        parseTime(time, event.when);
+                event.type = type;
+                event.code = code;
+                recording.events.push_back(event);
+                break;
+            }
+            default: {
+                // Ignore the lines that are not needed to replay the recording (such as the
+                // states of the LEDs and switches that newer versions of the format have).
+                break;
+            }
+        }
+        if (!valid) {
+            return base::Errorf("line %zu: malformed line '%s'", lineNumber, line.c_str());
+        }
+    }
+    return recording;
+}
+
+base::Result<EvemuRecording> EvemuRecording::load(const std::string& path) {
+    std::ifstream stream(path);
+    if (!stream) {
+        return base::Errorf("could not open '%s'", path.c_str());
+    }
+    base::Result<EvemuRecording> recording = parse(stream);
+    if (!recording.ok()) {
+        return base::Errorf("%s: %s", path.c_str(), recording.error().message().c_str());
+    }
+    return recording;
+}
+
+} // namespace android
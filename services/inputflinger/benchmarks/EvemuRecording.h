@@ -0,0 +1,71 @@
+/*
+ * Copyright (C) 2024 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#pragma once
+
+#include <android-base/result.h>
+#include <utils/Timers.h>
+
+#include <cstdint>
+#include <istream>
+#include <map>
+#include <string>
+#include <vector>
+
+namespace android {
+
+/**
+ * A recording of an input device in the format written by evemu-record (see cmds/evemu-record):
+ * the description of the device, followed by the evdev events that it produced.
+ */
+struct EvemuRecording {
+    struct AbsoluteAxis {
+        int32_t code;
+        int32_t minValue;
+        int32_t maxValue;
+        int32_t fuzz;
+        int32_t flat;
+        int32_t resolution;
+    };
+
+    struct Event {
+        // The time of the event, relative to the start of the recording.
+        nsecs_t when;
+        int32_t type;
+        int32_t code;
+        int32_t value;
+    };
+
+    std::string name;
+    uint16_t bus = 0;
+    uint16_t vendor = 0;
+    uint16_t product = 0;
+    uint16_t version = 0;
+    std::vector<uint8_t> properties;
+    std::map<int32_t /*type*/, std::vector<uint8_t>> codes;
+    std::vector<AbsoluteAxis> axes;
+    std::vector<Event> events;
+
+    bool hasProperty(int32_t property) const;
+    bool hasCode(int32_t type, int32_t code) const;
+    /* Returns the codes of the given event type that the device supports, in increasing order. */
+    std::vector<int32_t> getCodes(int32_t type) const;
+
+    static base::Result<EvemuRecording> parse(std::istream& stream);
+    static base::Result<EvemuRecording> load(const std::string& path);
+};
+
+} // namespace android
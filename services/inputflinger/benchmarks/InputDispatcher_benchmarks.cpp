@@ -23,6 +23,27 @@
 #include "../tests/FakeInputDispatcherPolicy.h"
 #include "../tests/FakeWindows.h"
 
+#include <atomic>
+#include <cstdlib>
+
+// Count the allocations made by the whole process, so that the benchmarks can report how many
+// allocations are needed to dispatch an event. This includes the allocations made when the fake
+// windows consume the events.
+static std::atomic<size_t> sAllocationCount{0};
+
+void* operator new(size_t size) {
+    sAllocationCount.fetch_add(1, std::memory_order_relaxed);
+    void* ptr = malloc(size);
+    if (ptr == nullptr) {
+        abort();
+    }
+    return ptr;
+}
+
+void operator delete(void* ptr) noexcept {
+    free(ptr);
+}
+
 using android::base::Result;
 using android::gui::WindowInfo;
 using android::os::IInputConstants;
@@ -100,6 +121,18 @@ static NotifyMotionArgs generateMotionArgs() {
     return args;
 }
 
+static NotifyMotionArgs generateStylusHoverArgs(int32_t action, float x, float y) {
+    NotifyMotionArgs args = generateMotionArgs();
+    args.source = AINPUT_SOURCE_TOUCHSCREEN | AINPUT_SOURCE_STYLUS;
+    args.action = action;
+    args.pointerProperties[0].toolType = ToolType::STYLUS;
+    args.pointerCoords[0].setAxisValue(AMOTION_EVENT_AXIS_X, x);
+    args.pointerCoords[0].setAxisValue(AMOTION_EVENT_AXIS_Y, y);
+    args.downTime = 0;
+    args.eventTime = now();
+    return args;
+}
+
 static void benchmarkNotifyMotion(benchmark::State& state) {
     // Create dispatcher
     FakeInputDispatcherPolicy fakePolicy;
@@ -116,6 +149,7 @@ static void benchmarkNotifyMotion(benchmark::State& state) {
 
     NotifyMotionArgs motionArgs = generateMotionArgs();
 
+    const size_t allocationCountBefore = sAllocationCount.load();
     for (auto _ : state) {
         // Send ACTION_DOWN
         motionArgs.action = AMOTION_EVENT_ACTION_DOWN;
@@ -131,6 +165,10 @@ static void benchmarkNotifyMotion(benchmark::State& state) {
         window->consumeMotionEvent();
         window->consumeMotionEvent();
     }
+    const size_t allocationCount = sAllocationCount.load() - allocationCountBefore;
+    // Two events are dispatched per iteration.
+    state.counters["allocations/event"] =
+            benchmark::Counter(static_cast<double>(allocationCount) / (2 * state.iterations()));
 
     dispatcher->stop();
 }
@@ -195,11 +233,65 @@ static void benchmarkOnWindowInfosChanged(benchmark::State& state) {
     dispatcher->stop();
 }
 
+/**
+ * Measure the cost of dispatching a hover move when there are many windows on the display. The
+ * windows are laid out in a grid on top of a full-screen window, and the stylus hovers over a part
+ * of the full-screen window that isn't covered by any of the other windows, so every window has to
+ * be considered when looking for the hovered window.
+ */
+static void benchmarkHoverMoveWithWindows(benchmark::State& state) {
+    const int32_t windowCount = static_cast<int32_t>(state.range(0));
+    FakeInputDispatcherPolicy fakePolicy;
+    auto dispatcher = std::make_unique<InputDispatcher>(fakePolicy);
+    dispatcher->setInputDispatchMode(/*enabled*/ true, /*frozen*/ false);
+    dispatcher->start();
+
+    std::shared_ptr<FakeApplicationHandle> application = std::make_shared<FakeApplicationHandle>();
+    std::vector<sp<FakeWindowHandle>> windows;
+    std::vector<gui::WindowInfo> windowInfos;
+    constexpr int32_t kColumns = 20;
+    constexpr int32_t kWindowSize = 50;
+    for (int32_t i = 0; i < windowCount; i++) {
+        sp<FakeWindowHandle> window =
+                sp<FakeWindowHandle>::make(application, dispatcher,
+                                           "Fake Window " + std::to_string(i), DISPLAY_ID);
+        const int32_t left = (i % kColumns) * kWindowSize;
+        const int32_t top = (i / kColumns) * kWindowSize;
+        window->setFrame(Rect(left, top, left + kWindowSize - 1, top + kWindowSize - 1));
+        windowInfos.push_back(*window->getInfo());
+        windows.push_back(window);
+    }
+    sp<FakeWindowHandle> background =
+            sp<FakeWindowHandle>::make(application, dispatcher, "Background Window", DISPLAY_ID);
+    background->setFrame(Rect(0, 0, kColumns * kWindowSize, 2000));
+    windowInfos.push_back(*background->getInfo());
+
+    gui::DisplayInfo displayInfo;
+    displayInfo.displayId = DISPLAY_ID;
+    dispatcher->onWindowInfosChanged({windowInfos, {displayInfo}, /*vsyncId=*/0, /*timestamp=*/0});
+
+    // Hover over the gap between the last two windows of the first row.
+    const float x = kColumns * kWindowSize - kWindowSize - 0.5f;
+    const float y = 10;
+    dispatcher->notifyMotion(generateStylusHoverArgs(AMOTION_EVENT_ACTION_HOVER_ENTER, x, y));
+    background->consumeMotionEvent();
+
+    for (auto _ : state) {
+        dispatcher->notifyMotion(generateStylusHoverArgs(AMOTION_EVENT_ACTION_HOVER_MOVE, x, y));
+        background->consumeMotionEvent();
+    }
+
+    dispatcher->notifyMotion(generateStylusHoverArgs(AMOTION_EVENT_ACTION_HOVER_EXIT, x, y));
+    background->consumeMotionEvent();
+    dispatcher->stop();
+}
+
 } // namespace
 
 BENCHMARK(benchmarkNotifyMotion);
 BENCHMARK(benchmarkInjectMotion);
 BENCHMARK(benchmarkOnWindowInfosChanged);
+BENCHMARK(benchmarkHoverMoveWithWindows)->Arg(10)->Arg(100)->Arg(500);
 
 } // namespace android::inputdispatcher
 
@@ -0,0 +1,448 @@
+/*
+ * Copyright (C) 2024 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include <benchmark/benchmark.h>
+
+#include <android-base/file.h>
+#include <input/InputEventLabels.h>
+#include <linux/input-event-codes.h>
+#include <utils/Timers.h>
+
+#include <InputReader.h>
+#include "../PointerChoreographer.h"
+#include "../UnwantedInteractionBlocker.h"
+#include "../tests/FakeEventHub.h"
+#include "../tests/FakeInputReaderPolicy.h"
+#include "../tests/FakePointerController.h"
+#include "EvemuRecording.h"
+
+#include <algorithm>
+#include <atomic>
+#include <cstdlib>
+#include <memory>
+#include <optional>
+#include <vector>
+
+// Count the allocations made by the whole process, so that the benchmarks can report how many
+// allocations each stage of the pipeline makes per event.
+static std::atomic<size_t> sAllocationCount{0};
+
+void* operator new(size_t size) {
+    sAllocationCount.fetch_add(1, std::memory_order_relaxed);
+    void* ptr = malloc(size);
+    if (ptr == nullptr) {
+        abort();
+    }
+    return ptr;
+}
+
+void operator delete(void* ptr) noexcept {
+    free(ptr);
+}
+
+namespace android {
+
+namespace {
+
+// The EventHub id of the replayed device.
+constexpr int32_t EVENTHUB_ID = 1;
+
+constexpr ui::LogicalDisplayId DISPLAY_ID = ui::LogicalDisplayId::DEFAULT;
+constexpr int32_t DISPLAY_WIDTH = 1080;
+constexpr int32_t DISPLAY_HEIGHT = 2400;
+const std::string DISPLAY_UNIQUE_ID = "local:0";
+
+/**
+ * Measures the time spent in, and the allocations made by, the listener that it wraps, including
+ * the listeners that come after it in the pipeline.
+ */
+class StageTimer : public InputListenerInterface {
+public:
+    explicit StageTimer(InputListenerInterface& innerListener) : mInnerListener(innerListener) {}
+
+    void notifyInputDevicesChanged(const NotifyInputDevicesChangedArgs& args) override {
+        measure([&]() { mInnerListener.notifyInputDevicesChanged(args); });
+    }
+    void notifyConfigurationChanged(const NotifyConfigurationChangedArgs& args) override {
+        measure([&]() { mInnerListener.notifyConfigurationChanged(args); });
+    }
+    void notifyKey(const NotifyKeyArgs& args) override {
+        measure([&]() { mInnerListener.notifyKey(args); });
+    }
+    void notifyMotion(const NotifyMotionArgs& args) override {
+        measure([&]() { mInnerListener.notifyMotion(args); });
+    }
+    void notifySwitch(const NotifySwitchArgs& args) override {
+        measure([&]() { mInnerListener.notifySwitch(args); });
+    }
+    void notifySensor(const NotifySensorArgs& args) override {
+        measure([&]() { mInnerListener.notifySensor(args); });
+    }
+    void notifyVibratorState(const NotifyVibratorStateArgs& args) override {
+        measure([&]() { mInnerListener.notifyVibratorState(args); });
+    }
+    void notifyDeviceReset(const NotifyDeviceResetArgs& args) override {
+        measure([&]() { mInnerListener.notifyDeviceReset(args); });
+    }
+    void notifyPointerCaptureChanged(const NotifyPointerCaptureChangedArgs& args) override {
+        measure([&]() { mInnerListener.notifyPointerCaptureChanged(args); });
+    }
+
+    nsecs_t getTime() const { return mTime; }
+    size_t getAllocationCount() const { return mAllocationCount; }
+
+    void reset() {
+        mTime = 0;
+        mAllocationCount = 0;
+    }
+
+private:
+    InputListenerInterface& mInnerListener;
+    nsecs_t mTime = 0;
+    size_t mAllocationCount = 0;
+
+    template <typename F>
+    void measure(F notifyInnerListener) {
+        const size_t allocationCount = sAllocationCount.load(std::memory_order_relaxed);
+        const nsecs_t start = systemTime(SYSTEM_TIME_MONOTONIC);
+        notifyInnerListener();
+        mTime += systemTime(SYSTEM_TIME_MONOTONIC) - start;
+        mAllocationCount += sAllocationCount.load(std::memory_order_relaxed) - allocationCount;
+    }
+};
+
+// The end of the pipeline, in place of the InputDispatcher.
+class NullListener : public InputListenerInterface {
+public:
+    void notifyInputDevicesChanged(const NotifyInputDevicesChangedArgs&) override {}
+    void notifyConfigurationChanged(const NotifyConfigurationChangedArgs&) override {}
+    void notifyKey(const NotifyKeyArgs&) override {}
+    void notifyMotion(const NotifyMotionArgs&) override {}
+    void notifySwitch(const NotifySwitchArgs&) override {}
+    void notifySensor(const NotifySensorArgs&) override {}
+    void notifyVibratorState(const NotifyVibratorStateArgs&) override {}
+    void notifyDeviceReset(const NotifyDeviceResetArgs&) override {}
+    void notifyPointerCaptureChanged(const NotifyPointerCaptureChangedArgs&) override {}
+};
+
+class FakePointerChoreographerPolicy : public PointerChoreographerPolicyInterface {
+public:
+    std::shared_ptr<PointerControllerInterface> createPointerController(
+            PointerControllerInterface::ControllerType) override {
+        return std::make_shared<FakePointerController>();
+    }
+    void notifyPointerDisplayIdChanged(ui::LogicalDisplayId, const FloatPoint&) override {}
+    bool isInputMethodConnectionActive() override { return false; }
+};
+
+// A PointerChoreographer that does not register for window info updates.
+class BenchmarkPointerChoreographer : public PointerChoreographer {
+public:
+    BenchmarkPointerChoreographer(InputListenerInterface& listener,
+                                  PointerChoreographerPolicyInterface& policy)
+          : PointerChoreographer(
+                    listener, policy,
+                    [](const sp<gui::WindowInfosListener>&) {
+                        return std::vector<gui::WindowInfo>{};
+                    },
+                    [](const sp<gui::WindowInfosListener>&) {}) {}
+};
+
+class BenchmarkInputReader : public InputReader {
+public:
+    using InputReader::InputReader;
+    using InputReader::loopOnce;
+};
+
+// Returns the classes that EventHub would assign to the recorded device. Only the classes of the
+// devices that are benchmarked are supported.
+ftl::Flags<InputDeviceClass> getDeviceClasses(const EvemuRecording& recording) {
+    ftl::Flags<InputDeviceClass> classes;
+    std::vector<int32_t> keys = recording.getCodes(EV_KEY);
+    const bool haveKeyboardKeys =
+            std::any_of(keys.begin(), keys.end(),
+                        [](int32_t key) { return key < BTN_MISC || key >= BTN_WHEEL; });
+    if (haveKeyboardKeys) {
+        classes |= InputDeviceClass::KEYBOARD;
+        if (recording.hasCode(EV_KEY, KEY_Q)) {
+            classes |= InputDeviceClass::ALPHAKEY;
+        }
+    }
+    if (recording.hasCode(EV_KEY, BTN_MOUSE) && recording.hasCode(EV_REL, REL_X) &&
+        recording.hasCode(EV_REL, REL_Y)) {
+        classes |= InputDeviceClass::CURSOR;
+    }
+    if (recording.hasCode(EV_ABS, ABS_MT_POSITION_X) &&
+        recording.hasCode(EV_ABS, ABS_MT_POSITION_Y)) {
+        classes |= InputDeviceClass::TOUCH | InputDeviceClass::TOUCH_MT;
+        if (recording.hasProperty(INPUT_PROP_POINTER) &&
+            std::none_of(keys.begin(), keys.end(),
+                         [](int32_t key) { return key >= BTN_TOOL_PEN && key < BTN_TOOL_FINGER; })) {
+            classes |= InputDeviceClass::TOUCHPAD;
+        }
+    } else if (recording.hasCode(EV_KEY, BTN_TOUCH) && recording.hasCode(EV_ABS, ABS_X) &&
+               recording.hasCode(EV_ABS, ABS_Y)) {
+        classes |= InputDeviceClass::TOUCH;
+    }
+    return classes;
+}
+
+sp<FakeInputReaderPolicy> createFakePolicy() {
+    sp<FakeInputReaderPolicy> policy = sp<FakeInputReaderPolicy>::make();
+    policy->addDisplayViewport(DISPLAY_ID, DISPLAY_WIDTH, DISPLAY_HEIGHT, ui::ROTATION_0,
+                               /*isActive=*/true, DISPLAY_UNIQUE_ID,
+                               /*physicalPort=*/std::nullopt, ViewportType::INTERNAL);
+    policy->setDefaultPointerDisplayId(DISPLAY_ID);
+    return policy;
+}
+
+// Adds the recorded device to the given FakeEventHub, as EventHub would have opened it.
+void addRecordedDevice(FakeEventHub& eventHub, const EvemuRecording& recording) {
+    const ftl::Flags<InputDeviceClass> classes = getDeviceClasses(recording);
+    eventHub.addDevice(EVENTHUB_ID, recording.name, classes, recording.bus);
+    for (const EvemuRecording::AbsoluteAxis& axis : recording.axes) {
+        eventHub.addAbsoluteAxis(EVENTHUB_ID, axis.code, axis.minValue, axis.maxValue, axis.flat,
+                                 axis.fuzz, axis.resolution);
+    }
+    if (classes.test(InputDeviceClass::KEYBOARD)) {
+        // Map the keys with their Linux names, in place of a key layout file.
+        for (int32_t scanCode : recording.getCodes(EV_KEY)) {
+            const std::string label =
+                    InputEventLookup::getLinuxEvdevLabel(EV_KEY, scanCode, 1).code;
+            std::optional<int> keyCode = label.starts_with("KEY_")
+                    ? InputEventLookup::getKeyCodeByLabel(label.substr(4).c_str())
+                    : std::nullopt;
+            eventHub.addKey(EVENTHUB_ID, scanCode, /*usageCode=*/0,
+                            keyCode.value_or(AKEYCODE_UNKNOWN), /*flags=*/0);
+        }
+    }
+    if (recording.hasProperty(INPUT_PROP_DIRECT)) {
+        eventHub.addConfigurationProperty(EVENTHUB_ID, "touch.deviceType", "touchScreen");
+    }
+}
+
+/**
+ * The part of the input pipeline that runs on the InputReader thread:
+ *   EventHub -> InputReader -> UnwantedInteractionBlocker -> PointerChoreographer
+ * with a FakeEventHub that replays a recording, and timers between the stages.
+ */
+class ReaderPipeline {
+public:
+    explicit ReaderPipeline(const EvemuRecording& recording)
+          : mFakeEventHub(std::make_shared<FakeEventHub>()),
+            mFakePolicy(createFakePolicy()),
+            mChoreographer(mSink, mChoreographerPolicy),
+            mChoreographerTimer(mChoreographer),
+            mBlocker(mChoreographerTimer),
+            mBlockerTimer(mBlocker) {
+        std::optional<DisplayViewport> viewport =
+                mFakePolicy->getDisplayViewportByType(ViewportType::INTERNAL);
+        mChoreographer.setDisplayViewports({*viewport});
+        mChoreographer.setDefaultMouseDisplayId(DISPLAY_ID);
+
+        addRecordedDevice(*mFakeEventHub, recording);
+        mReader = std::make_unique<BenchmarkInputReader>(mFakeEventHub, mFakePolicy,
+                                                         mBlockerTimer);
+        mFakeEventHub->finishDeviceScan();
+        mReader->loopOnce();
+        resetTimers();
+    }
+
+    void enqueueEvent(nsecs_t when, const EvemuRecording::Event& event) {
+        mFakeEventHub->enqueueEvent(when, /*readTime=*/when, EVENTHUB_ID, event.type, event.code,
+                                    event.value);
+    }
+
+    void loopOnce() {
+        const size_t allocationCount = sAllocationCount.load(std::memory_order_relaxed);
+        const nsecs_t start = systemTime(SYSTEM_TIME_MONOTONIC);
+        mReader->loopOnce();
+        mTime += systemTime(SYSTEM_TIME_MONOTONIC) - start;
+        mAllocationCount += sAllocationCount.load(std::memory_order_relaxed) - allocationCount;
+    }
+
+    void resetTimers() {
+        mTime = 0;
+        mAllocationCount = 0;
+        mBlockerTimer.reset();
+        mChoreographerTimer.reset();
+    }
+
+    // The time spent in InputReader (including the FakeEventHub), without the later stages.
+    nsecs_t getReaderTime() const { return mTime - mBlockerTimer.getTime(); }
+    size_t getReaderAllocationCount() const {
+        return mAllocationCount - mBlockerTimer.getAllocationCount();
+    }
+    nsecs_t getBlockerTime() const {
+        return mBlockerTimer.getTime() - mChoreographerTimer.getTime();
+    }
+    size_t getBlockerAllocationCount() const {
+        return mBlockerTimer.getAllocationCount() - mChoreographerTimer.getAllocationCount();
+    }
+    nsecs_t getChoreographerTime() const { return mChoreographerTimer.getTime(); }
+    size_t getChoreographerAllocationCount() const {
+        return mChoreographerTimer.getAllocationCount();
+    }
+
+private:
+    std::shared_ptr<FakeEventHub> mFakeEventHub;
+    sp<FakeInputReaderPolicy> mFakePolicy;
+    FakePointerChoreographerPolicy mChoreographerPolicy;
+    NullListener mSink;
+    BenchmarkPointerChoreographer mChoreographer;
+    StageTimer mChoreographerTimer;
+    UnwantedInteractionBlocker mBlocker;
+    StageTimer mBlockerTimer;
+    std::unique_ptr<BenchmarkInputReader> mReader;
+    nsecs_t mTime = 0;
+    size_t mAllocationCount = 0;
+};
+
+/**
+ * Replays the given recording in a loop, one evdev report (the events up to and including a
+ * SYN_REPORT) per iteration, and reports the time spent in each stage per evdev event.
+ */
+void benchmarkReplay(benchmark::State& state, const char* recordingName) {
+    base::Result<EvemuRecording> recording =
+            EvemuRecording::load(base::GetExecutableDirectory() + "/data/" + recordingName);
+    if (!recording.ok()) {
+        state.SkipWithError(recording.error().message().c_str());
+        return;
+    }
+    const std::vector<EvemuRecording::Event>& events = recording->events;
+    if (events.empty()) {
+        state.SkipWithError("The recording has no events");
+        return;
+    }
+    ReaderPipeline pipeline(*recording);
+
+    // Each replay of the recording starts one frame after the end of the previous one, so that
+    // the event times keep increasing.
+    const nsecs_t replayDuration = events.back().when + ms2ns(8);
+    nsecs_t replayStart = systemTime(SYSTEM_TIME_MONOTONIC);
+    size_t next = 0;
+    size_t eventCount = 0;
+    for (auto _ : state) {
+        do {
+            pipeline.enqueueEvent(replayStart + events[next].when, events[next]);
+            eventCount++;
+        } while (!(events[next].type == EV_SYN && events[next].code == SYN_REPORT) &&
+                 ++next < events.size());
+        if (++next >= events.size()) {
+            next = 0;
+            replayStart += replayDuration;
+        }
+        pipeline.loopOnce();
+    }
+
+    const auto perEvent = [eventCount](double total) {
+        return benchmark::Counter(eventCount > 0 ? total / eventCount : 0);
+    };
+    state.counters["reader_ns"] = perEvent(pipeline.getReaderTime());
+    state.counters["blocker_ns"] = perEvent(pipeline.getBlockerTime());
+    state.counters["choreographer_ns"] = perEvent(pipeline.getChoreographerTime());
+    state.counters["reader_allocs"] = perEvent(pipeline.getReaderAllocationCount());
+    state.counters["blocker_allocs"] = perEvent(pipeline.getBlockerAllocationCount());
+    state.counters["choreographer_allocs"] = perEvent(pipeline.getChoreographerAllocationCount());
+    state.SetItemsProcessed(eventCount);
+}
+
+// Collects the output of InputReader.
+class CollectingListener : public NullListener {
+public:
+    void notifyInputDevicesChanged(const NotifyInputDevicesChangedArgs& args) override {
+        inputDevices = args.inputDeviceInfos;
+    }
+    void notifyMotion(const NotifyMotionArgs& args) override { motions.push_back(args); }
+
+    std::vector<InputDeviceInfo> inputDevices;
+    std::vector<NotifyMotionArgs> motions;
+};
+
+// Reads the whole recording with InputReader.
+void readRecording(const EvemuRecording& recording, CollectingListener& listener) {
+    std::shared_ptr<FakeEventHub> eventHub = std::make_shared<FakeEventHub>();
+    addRecordedDevice(*eventHub, recording);
+    BenchmarkInputReader reader(eventHub, createFakePolicy(), listener);
+    eventHub->finishDeviceScan();
+    reader.loopOnce();
+    const nsecs_t start = systemTime(SYSTEM_TIME_MONOTONIC);
+    for (const EvemuRecording::Event& event : recording.events) {
+        eventHub->enqueueEvent(start + event.when, /*readTime=*/start + event.when, EVENTHUB_ID,
+                               event.type, event.code, event.value);
+        if (event.type == EV_SYN && event.code == SYN_REPORT) {
+            reader.loopOnce();
+        }
+    }
+    reader.loopOnce();
+}
+
+/**
+ * Sends the motions that InputReader produces for a recording to the palm rejection model of
+ * UnwantedInteractionBlocker, one motion per iteration.
+ */
+void benchmarkPalmRejection(benchmark::State& state, const char* recordingName) {
+    base::Result<EvemuRecording> recording =
+            EvemuRecording::load(base::GetExecutableDirectory() + "/data/" + recordingName);
+    if (!recording.ok()) {
+        state.SkipWithError(recording.error().message().c_str());
+        return;
+    }
+    CollectingListener listener;
+    readRecording(*recording, listener);
+    std::optional<AndroidPalmFilterDeviceInfo> deviceInfo;
+    for (const InputDeviceInfo& info : listener.inputDevices) {
+        deviceInfo = createPalmFilterDeviceInfo(info);
+    }
+    std::vector<NotifyMotionArgs>& motions = listener.motions;
+    if (!deviceInfo || motions.empty()) {
+        state.SkipWithError("The recording is not from a touchscreen");
+        return;
+    }
+    PalmRejector palmRejector(*deviceInfo);
+
+    const nsecs_t replayDuration = motions.back().eventTime - motions.front().downTime + ms2ns(8);
+    size_t next = 0;
+    size_t allocationCount = 0;
+    for (auto _ : state) {
+        const size_t allocationCountBefore = sAllocationCount.load(std::memory_order_relaxed);
+        benchmark::DoNotOptimize(palmRejector.processMotion(motions[next]));
+        allocationCount += sAllocationCount.load(std::memory_order_relaxed) - allocationCountBefore;
+        if (++next >= motions.size()) {
+            // Replay the motions later in time, so that the event times keep increasing.
+            state.PauseTiming();
+            for (NotifyMotionArgs& motion : motions) {
+                motion.downTime += replayDuration;
+                motion.eventTime += replayDuration;
+            }
+            next = 0;
+            state.ResumeTiming();
+        }
+    }
+    state.counters["allocs"] =
+            benchmark::Counter(allocationCount, benchmark::Counter::kAvgIterations);
+}
+
+} // namespace
+
+BENCHMARK_CAPTURE(benchmarkReplay, touchscreen, "touchscreen.evemu");
+BENCHMARK_CAPTURE(benchmarkReplay, touchpad, "touchpad.evemu");
+BENCHMARK_CAPTURE(benchmarkReplay, keyboard, "keyboard.evemu");
+BENCHMARK_CAPTURE(benchmarkPalmRejection, touchscreen, "touchscreen.evemu");
+
+} // namespace android
+
+BENCHMARK_MAIN();
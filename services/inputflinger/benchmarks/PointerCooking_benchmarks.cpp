@@ -0,0 +1,91 @@
+/*
+ * Copyright (C) 2024 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include <benchmark/benchmark.h>
+
+#include <PointerCooking.h>
+
+namespace android {
+
+namespace {
+
+// A touch calibration and a display transform that are not identities, so that none of the
+// arithmetic is optimized away.
+const TouchAffineTransformation CALIBRATION(1.02f, 0.01f, -3.5f, -0.02f, 0.98f, 4.25f);
+
+ui::Transform createRawToDisplay() {
+    ui::Transform scale;
+    scale.set(0.24f, 0, 0, 0.8f);
+    ui::Transform rotate(ui::Transform::ROT_90, 1080, 2400);
+    return rotate * scale;
+}
+
+RawPointerData createRawPointerData(uint32_t pointerCount) {
+    RawPointerData data;
+    data.pointerCount = pointerCount;
+    for (uint32_t i = 0; i < pointerCount; i++) {
+        RawPointerData::Pointer& pointer = data.pointers[i];
+        pointer.id = i;
+        pointer.x = 100 + 250 * i;
+        pointer.y = 3000 - 200 * i;
+        pointer.pressure = 40 + i;
+        pointer.distance = 0;
+        data.markIdBit(i, /*isHovering=*/false);
+    }
+    return data;
+}
+
+// Cooks the coordinates and the pressure of every pointer on its own, as TouchInputMapper used to.
+void benchmarkCookPerPointer(benchmark::State& state) {
+    const RawPointerData data = createRawPointerData(state.range(0));
+    const ui::Transform rawToDisplay = createRawToDisplay();
+    const float pressureScale = 1.0f / 255;
+    for (auto _ : state) {
+        for (uint32_t i = 0; i < data.pointerCount; i++) {
+            const RawPointerData::Pointer& in = data.pointers[i];
+            float x = in.x;
+            float y = in.y;
+            CALIBRATION.applyTo(x, y);
+            vec2 transformed = rawToDisplay.transform(x, y);
+            float pressure = in.pressure * pressureScale;
+            benchmark::DoNotOptimize(transformed);
+            benchmark::DoNotOptimize(pressure);
+        }
+    }
+    state.SetItemsProcessed(state.iterations() * data.pointerCount);
+}
+
+// Cooks the coordinates and the pressure of all the pointers with a PointerCookingBatch.
+void benchmarkCookBatch(benchmark::State& state) {
+    const RawPointerData data = createRawPointerData(state.range(0));
+    const ui::Transform rawToDisplay = createRawToDisplay();
+    const float pressureScale = 1.0f / 255;
+    PointerCookingBatch batch;
+    for (auto _ : state) {
+        batch.load(data);
+        batch.transformCoordinates(CALIBRATION, rawToDisplay);
+        batch.scalePressure(pressureScale);
+        benchmark::DoNotOptimize(batch);
+    }
+    state.SetItemsProcessed(state.iterations() * data.pointerCount);
+}
+
+} // namespace
+
+BENCHMARK(benchmarkCookPerPointer)->DenseRange(1, MAX_POINTERS, 3);
+BENCHMARK(benchmarkCookBatch)->DenseRange(1, MAX_POINTERS, 3);
+
+} // namespace android
@@ -0,0 +1,99 @@
+/*
+ * Copyright (C) 2024 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#define LOG_TAG "AsyncTimelineProcessor"
+#include "AsyncTimelineProcessor.h"
+
+#include <pthread.h>
+
+#include <android-base/stringprintf.h>
+#include <log/log.h>
+
+using android::base::StringPrintf;
+
+namespace android::inputdispatcher {
+
+AsyncTimelineProcessor::AsyncTimelineProcessor(InputEventTimelineProcessor& processor,
+                                               size_t capacity)
+      : mProcessor(processor), mSlots(capacity) {
+    LOG_ALWAYS_FATAL_IF(capacity == 0);
+    mThread = std::thread(&AsyncTimelineProcessor::processTimelines, this);
+#if defined(__linux__)
+    // Set the thread name for debugging
+    pthread_setname_np(mThread.native_handle(), "InputLatency");
+#endif
+}
+
+AsyncTimelineProcessor::~AsyncTimelineProcessor() {
+    mExiting.store(true);
+    wake();
+    mThread.join();
+}
+
+void AsyncTimelineProcessor::processTimeline(const InputEventTimeline& timeline) {
+    const size_t tail = mTail.load(std::memory_order_relaxed);
+    if (tail - mHead.load(std::memory_order_acquire) == mSlots.size()) {
+        mDroppedCount.fetch_add(1, std::memory_order_relaxed);
+        return;
+    }
+    mSlots[tail % mSlots.size()].emplace(timeline);
+    // Publishing the timeline and checking whether the background thread sleeps must not be
+    // reordered, so that the background thread cannot go to sleep while a timeline is queued.
+    mTail.store(tail + 1);
+    wake();
+}
+
+void AsyncTimelineProcessor::wake() {
+    if (mSleeping.exchange(false)) {
+        mSleeping.notify_one();
+    }
+}
+
+void AsyncTimelineProcessor::processTimelines() {
+    size_t head = mHead.load(std::memory_order_relaxed);
+    while (true) {
+        while (head != mTail.load(std::memory_order_acquire)) {
+            std::optional<InputEventTimeline>& slot = mSlots[head % mSlots.size()];
+            mProcessor.processTimeline(*slot);
+            slot.reset();
+            head++;
+            mHead.store(head, std::memory_order_release);
+        }
+        if (mExiting.load()) {
+            return;
+        }
+        mSleeping.store(true);
+        if (head != mTail.load() || mExiting.load()) {
+            // A timeline was queued, or exit was requested, after the queue was drained.
+            mSleeping.store(false);
+            continue;
+        }
+        mSleeping.wait(true);
+    }
+}
+
+std::string AsyncTimelineProcessor::dump(const char* prefix) const {
+    // Read the head first: it never passes the tail.
+    const size_t head = mHead.load();
+    const size_t tail = mTail.load();
+    return StringPrintf("%sAsyncTimelineProcessor:\n", prefix) +
+            StringPrintf("%s  Pending timelines: %zu (capacity %zu)\n", prefix, tail - head,
+                         mSlots.size()) +
+            StringPrintf("%s  Dropped timelines: %zu\n", prefix,
+                         mDroppedCount.load(std::memory_order_relaxed));
+}
+
+} // namespace android::inputdispatcher
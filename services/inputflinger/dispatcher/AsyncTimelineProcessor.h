@@ -0,0 +1,74 @@
+/*
+ * Copyright (C) 2024 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#pragma once
+
+#include <atomic>
+#include <optional>
+#include <string>
+#include <thread>
+#include <vector>
+
+#include "InputEventTimeline.h"
+
+namespace android::inputdispatcher {
+
+/**
+ * Forwards timelines to another InputEventTimelineProcessor on a background thread.
+ *
+ * LatencyTracker reports mature timelines from the dispatcher thread while it holds the dispatcher
+ * lock. Processing them (updating the latency sketches, and reporting slow events to statsd) does
+ * not need to happen there. The timelines are passed to the background thread through a
+ * fixed-size, lock-free, single-producer single-consumer queue, so reporting a timeline never
+ * blocks the dispatcher. If the background thread falls behind and the queue is full, the timeline
+ * is dropped.
+ *
+ * processTimeline may be called from any thread, but the calls must not be concurrent. The wrapped
+ * processor is only called from the background thread. When the AsyncTimelineProcessor is
+ * destroyed, the queued timelines are processed before the background thread exits.
+ */
+class AsyncTimelineProcessor final : public InputEventTimelineProcessor {
+public:
+    explicit AsyncTimelineProcessor(InputEventTimelineProcessor& processor,
+                                    size_t capacity = DEFAULT_CAPACITY);
+    ~AsyncTimelineProcessor() override;
+
+    void processTimeline(const InputEventTimeline& timeline) override;
+
+    std::string dump(const char* prefix) const;
+
+    static constexpr size_t DEFAULT_CAPACITY = 512;
+
+private:
+    InputEventTimelineProcessor& mProcessor;
+
+    // The queue. mHead is only written by the background thread, and mTail by the producer.
+    std::vector<std::optional<InputEventTimeline>> mSlots;
+    std::atomic<size_t> mHead = 0;
+    std::atomic<size_t> mTail = 0;
+    // How many timelines were dropped because the queue was full. Only written by the producer.
+    std::atomic<size_t> mDroppedCount = 0;
+
+    // Set by the background thread before it waits for new timelines.
+    std::atomic<bool> mSleeping = false;
+    std::atomic<bool> mExiting = false;
+    std::thread mThread;
+
+    void processTimelines();
+    void wake();
+};
+
+} // namespace android::inputdispatcher
@@ -192,8 +192,8 @@ MotionEntry::MotionEntry(int32_t id, std::shared_ptr<InjectionState> injectionSt
                          int32_t buttonState, MotionClassification classification,
                          int32_t edgeFlags, float xPrecision, float yPrecision,
                          float xCursorPosition, float yCursorPosition, nsecs_t downTime,
-                         const std::vector<PointerProperties>& pointerProperties,
-                         const std::vector<PointerCoords>& pointerCoords)
+                         std::span<const PointerProperties> pointerProperties,
+                         std::span<const PointerCoords> pointerCoords)
       : EventEntry(id, Type::MOTION, eventTime, policyFlags),
         deviceId(deviceId),
         source(source),
@@ -210,9 +210,16 @@ MotionEntry::MotionEntry(int32_t id, std::shared_ptr<InjectionState> injectionSt
         xCursorPosition(xCursorPosition),
         yCursorPosition(yCursorPosition),
         downTime(downTime),
-        pointerProperties(pointerProperties),
-        pointerCoords(pointerCoords) {
+        pointerProperties(EntryVectorPool<PointerProperties>::obtain()),
+        pointerCoords(EntryVectorPool<PointerCoords>::obtain()) {
     EventEntry::injectionState = std::move(injectionState);
+    this->pointerProperties.assign(pointerProperties.begin(), pointerProperties.end());
+    this->pointerCoords.assign(pointerCoords.begin(), pointerCoords.end());
+}
+
+MotionEntry::~MotionEntry() {
+    EntryVectorPool<PointerProperties>::recycle(std::move(pointerProperties));
+    EntryVectorPool<PointerCoords>::recycle(std::move(pointerCoords));
 }
 
 std::string MotionEntry::getDescription() const {
@@ -16,6 +16,7 @@
 
 #pragma once
 
+#include "EntryPool.h"
 #include "InjectionState.h"
 #include "InputTargetFlags.h"
 #include "trace/EventTrackerInterface.h"
@@ -26,6 +27,7 @@
 #include <utils/Timers.h>
 #include <functional>
 #include <ostream>
+#include <span>
 #include <string>
 
 namespace android::inputdispatcher {
@@ -148,6 +150,11 @@ struct KeyEntry : EventEntry {
              uint32_t policyFlags, int32_t action, int32_t flags, int32_t keyCode, int32_t scanCode,
              int32_t metaState, int32_t repeatCount, nsecs_t downTime);
     std::string getDescription() const override;
+
+    static void* operator new(size_t size) { return EntryPool<KeyEntry>::allocate(size); }
+    static void operator delete(void* ptr, size_t size) {
+        EntryPool<KeyEntry>::deallocate(ptr, size);
+    }
 };
 
 std::ostream& operator<<(std::ostream& out, const KeyEntry& motionEntry);
@@ -174,15 +181,22 @@ struct MotionEntry : EventEntry {
 
     size_t getPointerCount() const { return pointerProperties.size(); }
 
+    // The pointers are copied into vectors whose storage is recycled along with the entry.
     MotionEntry(int32_t id, std::shared_ptr<InjectionState> injectionState, nsecs_t eventTime,
                 int32_t deviceId, uint32_t source, ui::LogicalDisplayId displayId,
                 uint32_t policyFlags, int32_t action, int32_t actionButton, int32_t flags,
                 int32_t metaState, int32_t buttonState, MotionClassification classification,
                 int32_t edgeFlags, float xPrecision, float yPrecision, float xCursorPosition,
                 float yCursorPosition, nsecs_t downTime,
-                const std::vector<PointerProperties>& pointerProperties,
-                const std::vector<PointerCoords>& pointerCoords);
+                std::span<const PointerProperties> pointerProperties,
+                std::span<const PointerCoords> pointerCoords);
+    ~MotionEntry() override;
     std::string getDescription() const override;
+
+    static void* operator new(size_t size) { return EntryPool<MotionEntry>::allocate(size); }
+    static void operator delete(void* ptr, size_t size) {
+        EntryPool<MotionEntry>::deallocate(ptr, size);
+    }
 };
 
 std::ostream& operator<<(std::ostream& out, const MotionEntry& motionEntry);
@@ -251,6 +265,11 @@ struct DispatchEntry {
 
     inline bool isSplit() const { return targetFlags.test(InputTargetFlags::SPLIT); }
 
+    static void* operator new(size_t size) { return EntryPool<DispatchEntry>::allocate(size); }
+    static void operator delete(void* ptr, size_t size) {
+        EntryPool<DispatchEntry>::deallocate(ptr, size);
+    }
+
 private:
     static volatile int32_t sNextSeqAtomic;
 
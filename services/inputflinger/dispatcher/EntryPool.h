@@ -0,0 +1,164 @@
+/*
+ * Copyright (C) 2024 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#pragma once
+
+#include <android-base/thread_annotations.h>
+#include <cstddef>
+#include <mutex>
+#include <new>
+#include <vector>
+
+namespace android::inputdispatcher {
+
+/**
+ * A cache of memory blocks for objects of type T.
+ *
+ * The dispatcher creates an entry for every inbound event and for every target of every event, and
+ * destroys them as soon as the event is finished. Types that are allocated this often use the pool
+ * through their class-specific operator new / operator delete, so that the memory of a finished
+ * entry is reused for the next one instead of going back to the system allocator.
+ *
+ * Entries may be released from any thread (they are reference counted), so the pool is guarded by
+ * a mutex. At most MaxCachedBlocks free blocks are kept; any block beyond that is returned to the
+ * system. Allocations of a different size (for example, of a subclass of T) are not pooled.
+ */
+template <typename T, size_t MaxCachedBlocks = 128>
+class EntryPool {
+public:
+    static void* allocate(size_t size) {
+        if (size == sizeof(T)) {
+            if (void* block = getInstance().pop(); block != nullptr) {
+                return block;
+            }
+        }
+        return ::operator new(size);
+    }
+
+    static void deallocate(void* block, size_t size) {
+        if (block == nullptr) {
+            return;
+        }
+        if (size == sizeof(T) && getInstance().push(block)) {
+            return;
+        }
+        ::operator delete(block);
+    }
+
+    // The number of free blocks currently held by the pool.
+    static size_t getCachedBlockCount() {
+        EntryPool& pool = getInstance();
+        std::scoped_lock lock(pool.mLock);
+        return pool.mCount;
+    }
+
+private:
+    // A free block holds a pointer to the next free block.
+    struct FreeBlock {
+        FreeBlock* next;
+    };
+    static_assert(sizeof(T) >= sizeof(FreeBlock));
+
+    std::mutex mLock;
+    FreeBlock* mHead GUARDED_BY(mLock) = nullptr;
+    size_t mCount GUARDED_BY(mLock) = 0;
+
+    // The pool is intentionally never destroyed, so that entries that are released during static
+    // destruction can still be returned to it.
+    static EntryPool& getInstance() {
+        static EntryPool* sInstance = new EntryPool();
+        return *sInstance;
+    }
+
+    void* pop() {
+        std::scoped_lock lock(mLock);
+        FreeBlock* block = mHead;
+        if (block != nullptr) {
+            mHead = block->next;
+            mCount--;
+        }
+        return block;
+    }
+
+    bool push(void* block) {
+        std::scoped_lock lock(mLock);
+        if (mCount >= MaxCachedBlocks) {
+            return false;
+        }
+        mHead = new (block) FreeBlock{mHead};
+        mCount++;
+        return true;
+    }
+};
+
+/**
+ * A cache of the storage of the std::vector members of pooled entries.
+ *
+ * EntryPool only reuses the memory of an entry itself. The vectors that an entry owns are destroyed
+ * along with it, so an entry that keeps its per-event data in vectors hands their storage to this
+ * pool when it is destroyed, and takes it back when it is created. At most MaxCachedVectors
+ * vectors are kept; any vector beyond that is freed.
+ */
+template <typename T, size_t MaxCachedVectors = 128>
+class EntryVectorPool {
+public:
+    // Returns an empty vector. Its storage is that of the most recently recycled vector, if any.
+    static std::vector<T> obtain() {
+        EntryVectorPool& pool = getInstance();
+        std::scoped_lock lock(pool.mLock);
+        if (pool.mVectors.empty()) {
+            return {};
+        }
+        std::vector<T> vector = std::move(pool.mVectors.back());
+        pool.mVectors.pop_back();
+        return vector;
+    }
+
+    // Keeps the storage of the given vector for a later call to obtain().
+    static void recycle(std::vector<T>&& vector) {
+        if (vector.capacity() == 0) {
+            return;
+        }
+        vector.clear();
+        EntryVectorPool& pool = getInstance();
+        std::scoped_lock lock(pool.mLock);
+        if (pool.mVectors.size() < MaxCachedVectors) {
+            pool.mVectors.push_back(std::move(vector));
+        }
+    }
+
+    // The number of vectors currently held by the pool.
+    static size_t getCachedVectorCount() {
+        EntryVectorPool& pool = getInstance();
+        std::scoped_lock lock(pool.mLock);
+        return pool.mVectors.size();
+    }
+
+private:
+    std::mutex mLock;
+    // Reserved up front, so that recycling a vector never allocates.
+    std::vector<std::vector<T>> mVectors GUARDED_BY(mLock);
+
+    EntryVectorPool() { mVectors.reserve(MaxCachedVectors); }
+
+    // Never destroyed, for the same reason as the EntryPool.
+    static EntryVectorPool& getInstance() {
+        static EntryVectorPool* sInstance = new EntryVectorPool();
+        return *sInstance;
+    }
+};
+
+} // namespace android::inputdispatcher
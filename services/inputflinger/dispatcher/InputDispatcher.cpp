@@ -45,6 +45,7 @@
 #include <cstddef>
 #include <ctime>
 #include <queue>
+#include <set>
 #include <sstream>
 
 #include "../InputDeviceMetricsSource.h"
@@ -123,6 +124,21 @@ const std::unique_ptr<trace::EventTrackerInterface>& getTraceTracker(const Event
     }
 }
 
+// Helper to get the device id of a key or motion entry.
+DeviceId getDeviceId(const EventEntry& entry) {
+    switch (entry.type) {
+        case EventEntry::Type::MOTION: {
+            return static_cast<const MotionEntry&>(entry).deviceId;
+        }
+        case EventEntry::Type::KEY: {
+            return static_cast<const KeyEntry&>(entry).deviceId;
+        }
+        default: {
+            return VIRTUAL_KEYBOARD_ID;
+        }
+    }
+}
+
 // Temporarily releases a held mutex for the lifetime of the instance.
 // Named to match std::scoped_lock
 class scoped_unlock {
@@ -154,6 +170,13 @@ constexpr std::chrono::milliseconds SLOW_INTERCEPTION_THRESHOLD = 50ms;
 // Number of recent events to keep for debugging purposes.
 constexpr size_t RECENT_QUEUE_MAX_SIZE = 10;
 
+// Maximum number of events that are written to a connection with a single system call.
+constexpr size_t MAX_PUBLISH_BATCH_SIZE = 8;
+
+// Number of motion events that can be in flight to a window through its motion sample ring. Once
+// the ring is full, motion events are sent over the socket.
+constexpr uint32_t MOTION_SAMPLE_RING_CAPACITY = 32;
+
 // Event log tags. See EventLogTags.logtags for reference.
 constexpr int LOGTAG_INPUT_INTERACTION = 62000;
 constexpr int LOGTAG_INPUT_FOCUS = 62001;
@@ -464,7 +487,7 @@ std::unique_ptr<DispatchEntry> createDispatchEntry(const IdGenerator& idGenerato
                                           motionEntry.xPrecision, motionEntry.yPrecision,
                                           motionEntry.xCursorPosition, motionEntry.yCursorPosition,
                                           motionEntry.downTime, motionEntry.pointerProperties,
-                                          pointerCoords);
+                                          std::move(pointerCoords));
     if (tracer) {
         combinedMotionEntry->traceTracker =
                 tracer->traceDerivedEvent(*combinedMotionEntry, *motionEntry.traceTracker);
@@ -921,11 +944,13 @@ InputDispatcher::InputDispatcher(InputDispatcherPolicyInterface& policy,
         mDispatchFrozen(false),
         mInputFilterEnabled(false),
         mMaximumObscuringOpacityForTouch(1.0f),
+        mPerDisplayDispatchEnabled(false),
         mFocusedDisplayId(ui::LogicalDisplayId::DEFAULT),
         mWindowTokenWithPointerCapture(nullptr),
         mAwaitedApplicationDisplayId(ui::LogicalDisplayId::INVALID),
         mLatencyAggregator(),
-        mLatencyTracker(&mLatencyAggregator) {
+        mLatencyAggregatorProcessor(mLatencyAggregator),
+        mLatencyTracker(&mLatencyAggregatorProcessor) {
     mLooper = sp<Looper>::make(false);
     mReporter = createInputReporter();
 
@@ -1140,22 +1165,44 @@ void InputDispatcher::dispatchOnceInnerLocked(nsecs_t& nextWakeupTime) {
     // Now we have an event to dispatch.
     // All events are eventually dequeued and processed this way, even if we intend to drop them.
     ALOG_ASSERT(mPendingEvent != nullptr);
+    if (mNextUnblockedEvent == mPendingEvent) {
+        mNextUnblockedEvent = nullptr;
+    }
+
+    DropReason dropReason = DropReason::NOT_DROPPED;
+    if (dispatchInboundEventLocked(currentTime, mPendingEvent, dropReason, nextWakeupTime)) {
+        mLastDropReason = dropReason;
+        releasePendingEventLocked();
+        nextWakeupTime = LLONG_MIN; // force next poll to wake up immediately
+    } else if (mPerDisplayDispatchEnabled) {
+        // The pending event is waiting for its display. Don't let that delay the other displays.
+        dispatchEventsForUnblockedDisplaysLocked(currentTime, nextWakeupTime);
+    }
+}
+
+/**
+ * Dispatch a single event that was taken out of the inbound queue.
+ *
+ * Returns true if the event is done: it was either dispatched or dropped, and the caller should
+ * release it. Returns false if the event has to wait, in which case it should be retried later.
+ * The reason for dropping the event, if any, is returned in outDropReason.
+ */
+bool InputDispatcher::dispatchInboundEventLocked(nsecs_t currentTime,
+                                                 const std::shared_ptr<const EventEntry>& entry,
+                                                 DropReason& outDropReason,
+                                                 nsecs_t& nextWakeupTime) {
     bool done = false;
     DropReason dropReason = DropReason::NOT_DROPPED;
-    if (!(mPendingEvent->policyFlags & POLICY_FLAG_PASS_TO_USER)) {
+    if (!(entry->policyFlags & POLICY_FLAG_PASS_TO_USER)) {
         dropReason = DropReason::POLICY;
     } else if (!mDispatchEnabled) {
         dropReason = DropReason::DISABLED;
     }
 
-    if (mNextUnblockedEvent == mPendingEvent) {
-        mNextUnblockedEvent = nullptr;
-    }
-
-    switch (mPendingEvent->type) {
+    switch (entry->type) {
         case EventEntry::Type::CONFIGURATION_CHANGED: {
             const ConfigurationChangedEntry& typedEntry =
-                    static_cast<const ConfigurationChangedEntry&>(*mPendingEvent);
+                    static_cast<const ConfigurationChangedEntry&>(*entry);
             done = dispatchConfigurationChangedLocked(currentTime, typedEntry);
             dropReason = DropReason::NOT_DROPPED; // configuration changes are never dropped
             break;
@@ -1163,7 +1210,7 @@ void InputDispatcher::dispatchOnceInnerLocked(nsecs_t& nextWakeupTime) {
 
         case EventEntry::Type::DEVICE_RESET: {
             const DeviceResetEntry& typedEntry =
-                    static_cast<const DeviceResetEntry&>(*mPendingEvent);
+                    static_cast<const DeviceResetEntry&>(*entry);
             done = dispatchDeviceResetLocked(currentTime, typedEntry);
             dropReason = DropReason::NOT_DROPPED; // device resets are never dropped
             break;
@@ -1171,7 +1218,7 @@ void InputDispatcher::dispatchOnceInnerLocked(nsecs_t& nextWakeupTime) {
 
         case EventEntry::Type::FOCUS: {
             std::shared_ptr<const FocusEntry> typedEntry =
-                    std::static_pointer_cast<const FocusEntry>(mPendingEvent);
+                    std::static_pointer_cast<const FocusEntry>(entry);
             dispatchFocusLocked(currentTime, typedEntry);
             done = true;
             dropReason = DropReason::NOT_DROPPED; // focus events are never dropped
@@ -1179,7 +1226,7 @@ void InputDispatcher::dispatchOnceInnerLocked(nsecs_t& nextWakeupTime) {
         }
 
         case EventEntry::Type::TOUCH_MODE_CHANGED: {
-            const auto typedEntry = std::static_pointer_cast<const TouchModeEntry>(mPendingEvent);
+            const auto typedEntry = std::static_pointer_cast<const TouchModeEntry>(entry);
             dispatchTouchModeChangeLocked(currentTime, typedEntry);
             done = true;
             dropReason = DropReason::NOT_DROPPED; // touch mode events are never dropped
@@ -1188,7 +1235,7 @@ void InputDispatcher::dispatchOnceInnerLocked(nsecs_t& nextWakeupTime) {
 
         case EventEntry::Type::POINTER_CAPTURE_CHANGED: {
             const auto typedEntry =
-                    std::static_pointer_cast<const PointerCaptureChangedEntry>(mPendingEvent);
+                    std::static_pointer_cast<const PointerCaptureChangedEntry>(entry);
             dispatchPointerCaptureChangedLocked(currentTime, typedEntry, dropReason);
             done = true;
             break;
@@ -1196,7 +1243,7 @@ void InputDispatcher::dispatchOnceInnerLocked(nsecs_t& nextWakeupTime) {
 
         case EventEntry::Type::DRAG: {
             std::shared_ptr<const DragEntry> typedEntry =
-                    std::static_pointer_cast<const DragEntry>(mPendingEvent);
+                    std::static_pointer_cast<const DragEntry>(entry);
             dispatchDragLocked(currentTime, typedEntry);
             done = true;
             break;
@@ -1204,7 +1251,7 @@ void InputDispatcher::dispatchOnceInnerLocked(nsecs_t& nextWakeupTime) {
 
         case EventEntry::Type::KEY: {
             std::shared_ptr<const KeyEntry> keyEntry =
-                    std::static_pointer_cast<const KeyEntry>(mPendingEvent);
+                    std::static_pointer_cast<const KeyEntry>(entry);
             if (dropReason == DropReason::NOT_DROPPED && isStaleEvent(currentTime, *keyEntry)) {
                 dropReason = DropReason::STALE;
             }
@@ -1217,7 +1264,7 @@ void InputDispatcher::dispatchOnceInnerLocked(nsecs_t& nextWakeupTime) {
 
         case EventEntry::Type::MOTION: {
             std::shared_ptr<const MotionEntry> motionEntry =
-                    std::static_pointer_cast<const MotionEntry>(mPendingEvent);
+                    std::static_pointer_cast<const MotionEntry>(entry);
             if (dropReason == DropReason::NOT_DROPPED && isStaleEvent(currentTime, *motionEntry)) {
                 // The event is stale. However, only drop stale events if there isn't an ongoing
                 // gesture. That would allow us to complete the processing of the current stroke.
@@ -1242,7 +1289,7 @@ void InputDispatcher::dispatchOnceInnerLocked(nsecs_t& nextWakeupTime) {
 
         case EventEntry::Type::SENSOR: {
             std::shared_ptr<const SensorEntry> sensorEntry =
-                    std::static_pointer_cast<const SensorEntry>(mPendingEvent);
+                    std::static_pointer_cast<const SensorEntry>(entry);
 
             //  Sensor timestamps use SYSTEM_TIME_BOOTTIME time base, so we can't use
             // 'currentTime' here, get SYSTEM_TIME_BOOTTIME instead.
@@ -1258,18 +1305,72 @@ void InputDispatcher::dispatchOnceInnerLocked(nsecs_t& nextWakeupTime) {
 
     if (done) {
         if (dropReason != DropReason::NOT_DROPPED) {
-            dropInboundEventLocked(*mPendingEvent, dropReason);
+            dropInboundEventLocked(*entry, dropReason);
         }
-        mLastDropReason = dropReason;
 
         if (mTracer) {
-            if (auto& traceTracker = getTraceTracker(*mPendingEvent); traceTracker != nullptr) {
+            if (auto& traceTracker = getTraceTracker(*entry); traceTracker != nullptr) {
                 mTracer->eventProcessingComplete(*traceTracker, currentTime);
             }
         }
+    }
+    outDropReason = dropReason;
+    return done;
+}
 
-        releasePendingEventLocked();
-        nextWakeupTime = LLONG_MIN; // force next poll to wake up immediately
+/**
+ * Dispatch the pointer events that are queued behind the pending event, as long as they target a
+ * display that isn't blocked.
+ *
+ * The pending event, and any event that is left in the queue, blocks its display and its device,
+ * so that the events of a given display or device are still dispatched in order. Pointer events
+ * are always dispatched immediately (they never wait for a focused window), which is what makes
+ * it safe to take them out of the queue. Any other kind of event acts as a barrier, because it
+ * could affect all displays. Cross-display operations, like drag and drop and pointer capture,
+ * use the regular, in-order path.
+ */
+void InputDispatcher::dispatchEventsForUnblockedDisplaysLocked(nsecs_t currentTime,
+                                                               nsecs_t& nextWakeupTime) {
+    if (mDragState != nullptr || mCurrentPointerCaptureRequest.isEnable() ||
+        mNextUnblockedEvent != nullptr) {
+        return;
+    }
+    if (mPendingEvent->type != EventEntry::Type::KEY &&
+        mPendingEvent->type != EventEntry::Type::MOTION) {
+        return;
+    }
+
+    std::set<ui::LogicalDisplayId> blockedDisplays{getTargetDisplayId(*mPendingEvent)};
+    std::set<DeviceId> blockedDevices{getDeviceId(*mPendingEvent)};
+    for (auto it = mInboundQueue.begin(); it != mInboundQueue.end();) {
+        const std::shared_ptr<const EventEntry> entry = *it;
+        if (entry->type != EventEntry::Type::KEY && entry->type != EventEntry::Type::MOTION) {
+            break;
+        }
+        const ui::LogicalDisplayId displayId = getTargetDisplayId(*entry);
+        const DeviceId deviceId = getDeviceId(*entry);
+        const bool isPointerEvent = entry->type == EventEntry::Type::MOTION &&
+                isFromSource(static_cast<const MotionEntry&>(*entry).source,
+                             AINPUT_SOURCE_CLASS_POINTER);
+        if (!isPointerEvent || displayId == ui::LogicalDisplayId::INVALID ||
+            blockedDisplays.contains(displayId) || blockedDevices.contains(deviceId)) {
+            blockedDisplays.insert(displayId);
+            blockedDevices.insert(deviceId);
+            it++;
+            continue;
+        }
+
+        it = mInboundQueue.erase(it);
+        traceInboundQueueLengthLocked();
+        if (entry->policyFlags & POLICY_FLAG_PASS_TO_USER) {
+            pokeUserActivityLocked(*entry);
+        }
+        DropReason dropReason = DropReason::NOT_DROPPED;
+        const bool done =
+                dispatchInboundEventLocked(currentTime, entry, dropReason, nextWakeupTime);
+        LOG_ALWAYS_FATAL_IF(!done, "Pointer event %s was not dispatched",
+                            entry->getDescription().c_str());
+        releaseInboundEventLocked(entry);
     }
 }
 
@@ -1291,6 +1392,11 @@ bool InputDispatcher::shouldPruneInboundQueueLocked(const MotionEntry& motionEnt
     // the touch into the other window.
     if (isPointerDownEvent && mAwaitedFocusedApplication != nullptr) {
         const ui::LogicalDisplayId displayId = motionEntry.displayId;
+        if (mPerDisplayDispatchEnabled && displayId != mAwaitedApplicationDisplayId) {
+            // The touch doesn't have to wait for the blocked display, so there's no need to drop
+            // the events of that display.
+            return false;
+        }
         const auto [x, y] = resolveTouchedPosition(motionEntry);
         const bool isStylus = isPointerFromStylus(motionEntry, /*pointerIndex=*/0);
         sp<WindowInfoHandle> touchedWindowHandle =
@@ -1419,7 +1525,8 @@ sp<WindowInfoHandle> InputDispatcher::findTouchedWindowAtLocked(ui::LogicalDispl
                                                                 bool ignoreDragWindow) const {
     // Traverse windows from front to back to find touched window.
     const auto& windowHandles = getWindowHandlesLocked(displayId);
-    for (const sp<WindowInfoHandle>& windowHandle : windowHandles) {
+    for (uint32_t position : getWindowSpatialIndexLocked(displayId).candidatesAt(x, y)) {
+        const sp<WindowInfoHandle>& windowHandle = windowHandles[position];
         if (ignoreDragWindow && haveSameToken(windowHandle, mDragState->dragWindow)) {
             continue;
         }
@@ -1466,7 +1573,8 @@ std::vector<sp<WindowInfoHandle>> InputDispatcher::findTouchedSpyWindowsAtLocked
     // Traverse windows from front to back and gather the touched spy windows.
     std::vector<sp<WindowInfoHandle>> spyWindows;
     const auto& windowHandles = getWindowHandlesLocked(displayId);
-    for (const sp<WindowInfoHandle>& windowHandle : windowHandles) {
+    for (uint32_t position : getWindowSpatialIndexLocked(displayId).candidatesAt(x, y)) {
+        const sp<WindowInfoHandle>& windowHandle = windowHandles[position];
         const WindowInfo& info = *windowHandle->getInfo();
 
         if (!windowAcceptsTouchAt(info, displayId, x, y, isStylus, getTransformLocked(displayId))) {
@@ -3142,8 +3250,11 @@ InputDispatcher::TouchOcclusionInfo InputDispatcher::computeTouchOcclusionInfoLo
     info.obscuringOpacity = 0;
     info.obscuringUid = gui::Uid::INVALID;
     std::map<gui::Uid, float> opacityByUid;
-    for (const sp<WindowInfoHandle>& otherHandle : windowHandles) {
-        if (windowHandle == otherHandle) {
+    const WindowSpatialIndex& spatialIndex = getWindowSpatialIndexLocked(displayId);
+    const std::optional<uint32_t> windowPosition = spatialIndex.positionOf(windowHandle);
+    for (uint32_t position : spatialIndex.candidatesAt(x, y)) {
+        const sp<WindowInfoHandle>& otherHandle = windowHandles[position];
+        if (windowPosition && position >= *windowPosition) {
             break; // All future windows are below us. Exit early.
         }
         const WindowInfo* otherInfo = otherHandle->getInfo();
@@ -3221,8 +3332,11 @@ bool InputDispatcher::isWindowObscuredAtPointLocked(const sp<WindowInfoHandle>&
                                                     float x, float y) const {
     ui::LogicalDisplayId displayId = windowHandle->getInfo()->displayId;
     const std::vector<sp<WindowInfoHandle>>& windowHandles = getWindowHandlesLocked(displayId);
-    for (const sp<WindowInfoHandle>& otherHandle : windowHandles) {
-        if (windowHandle == otherHandle) {
+    const WindowSpatialIndex& spatialIndex = getWindowSpatialIndexLocked(displayId);
+    const std::optional<uint32_t> windowPosition = spatialIndex.positionOf(windowHandle);
+    for (uint32_t position : spatialIndex.candidatesAt(x, y)) {
+        const sp<WindowInfoHandle>& otherHandle = windowHandles[position];
+        if (windowPosition && position >= *windowPosition) {
             break; // All future windows are below us. Exit early.
         }
         const WindowInfo* otherInfo = otherHandle->getInfo();
@@ -3778,6 +3892,94 @@ status_t InputDispatcher::publishMotionEvent(Connection& connection,
                                 motionEntry.pointerProperties.data(), usingCoords);
 }
 
+status_t InputDispatcher::stageEventLocked(nsecs_t currentTime,
+                                          const std::shared_ptr<Connection>& connection,
+                                          DispatchEntry& dispatchEntry) {
+    dispatchEntry.deliveryTime = currentTime;
+    const std::chrono::nanoseconds timeout = getDispatchingTimeoutLocked(connection);
+    dispatchEntry.timeoutTime = currentTime + timeout.count();
+
+    // Publish the event.
+    status_t status;
+    const EventEntry& eventEntry = *(dispatchEntry.eventEntry);
+    switch (eventEntry.type) {
+        case EventEntry::Type::KEY: {
+            const KeyEntry& keyEntry = static_cast<const KeyEntry&>(eventEntry);
+            std::array<uint8_t, 32> hmac = getSignature(keyEntry, dispatchEntry);
+            if (DEBUG_OUTBOUND_EVENT_DETAILS) {
+                LOG(INFO) << "Publishing " << dispatchEntry << " to "
+                          << connection->getInputChannelName();
+            }
+
+            // Publish the key event.
+            status = connection->inputPublisher
+                             .publishKeyEvent(dispatchEntry.seq, keyEntry.id,
+                                              keyEntry.deviceId, keyEntry.source,
+                                              keyEntry.displayId, std::move(hmac),
+                                              keyEntry.action, dispatchEntry.resolvedFlags,
+                                              keyEntry.keyCode, keyEntry.scanCode,
+                                              keyEntry.metaState, keyEntry.repeatCount,
+                                              keyEntry.downTime, keyEntry.eventTime);
+            break;
+        }
+
+        case EventEntry::Type::MOTION: {
+            if (DEBUG_OUTBOUND_EVENT_DETAILS) {
+                LOG(INFO) << "Publishing " << dispatchEntry << " to "
+                          << connection->getInputChannelName();
+            }
+            status = publishMotionEvent(*connection, dispatchEntry);
+            break;
+        }
+
+        case EventEntry::Type::FOCUS: {
+            const FocusEntry& focusEntry = static_cast<const FocusEntry&>(eventEntry);
+            status = connection->inputPublisher.publishFocusEvent(dispatchEntry.seq,
+                                                                  focusEntry.id,
+                                                                  focusEntry.hasFocus);
+            break;
+        }
+
+        case EventEntry::Type::TOUCH_MODE_CHANGED: {
+            const TouchModeEntry& touchModeEntry =
+                    static_cast<const TouchModeEntry&>(eventEntry);
+            status = connection->inputPublisher
+                             .publishTouchModeEvent(dispatchEntry.seq, touchModeEntry.id,
+                                                    touchModeEntry.inTouchMode);
+
+            break;
+        }
+
+        case EventEntry::Type::POINTER_CAPTURE_CHANGED: {
+            const auto& captureEntry =
+                    static_cast<const PointerCaptureChangedEntry&>(eventEntry);
+            status =
+                    connection->inputPublisher
+                            .publishCaptureEvent(dispatchEntry.seq, captureEntry.id,
+                                                 captureEntry.pointerCaptureRequest.isEnable());
+            break;
+        }
+
+        case EventEntry::Type::DRAG: {
+            const DragEntry& dragEntry = static_cast<const DragEntry&>(eventEntry);
+            status = connection->inputPublisher.publishDragEvent(dispatchEntry.seq,
+                                                                 dragEntry.id, dragEntry.x,
+                                                                 dragEntry.y,
+                                                                 dragEntry.isExiting);
+            break;
+        }
+
+        case EventEntry::Type::CONFIGURATION_CHANGED:
+        case EventEntry::Type::DEVICE_RESET:
+        case EventEntry::Type::SENSOR: {
+            LOG_ALWAYS_FATAL("Should never start dispatch cycles for %s events",
+                             ftl::enum_string(eventEntry.type).c_str());
+            return BAD_VALUE;
+        }
+    }
+    return status;
+}
+
 void InputDispatcher::startDispatchCycleLocked(nsecs_t currentTime,
                                                const std::shared_ptr<Connection>& connection) {
     ATRACE_NAME_IF(ATRACE_ENABLED(),
@@ -3788,97 +3990,47 @@ void InputDispatcher::startDispatchCycleLocked(nsecs_t currentTime,
     }
 
     while (connection->status == Connection::Status::NORMAL && !connection->outboundQueue.empty()) {
-        std::unique_ptr<DispatchEntry>& dispatchEntry = connection->outboundQueue.front();
-        dispatchEntry->deliveryTime = currentTime;
-        const std::chrono::nanoseconds timeout = getDispatchingTimeoutLocked(connection);
-        dispatchEntry->timeoutTime = currentTime + timeout.count();
-
-        // Publish the event.
-        status_t status;
-        const EventEntry& eventEntry = *(dispatchEntry->eventEntry);
-        switch (eventEntry.type) {
-            case EventEntry::Type::KEY: {
-                const KeyEntry& keyEntry = static_cast<const KeyEntry&>(eventEntry);
-                std::array<uint8_t, 32> hmac = getSignature(keyEntry, *dispatchEntry);
-                if (DEBUG_OUTBOUND_EVENT_DETAILS) {
-                    LOG(INFO) << "Publishing " << *dispatchEntry << " to "
-                              << connection->getInputChannelName();
-                }
-
-                // Publish the key event.
-                status = connection->inputPublisher
-                                 .publishKeyEvent(dispatchEntry->seq, keyEntry.id,
-                                                  keyEntry.deviceId, keyEntry.source,
-                                                  keyEntry.displayId, std::move(hmac),
-                                                  keyEntry.action, dispatchEntry->resolvedFlags,
-                                                  keyEntry.keyCode, keyEntry.scanCode,
-                                                  keyEntry.metaState, keyEntry.repeatCount,
-                                                  keyEntry.downTime, keyEntry.eventTime);
-                if (mTracer) {
-                    ensureEventTraced(keyEntry);
-                    mTracer->traceEventDispatch(*dispatchEntry, *keyEntry.traceTracker);
-                }
-                break;
-            }
-
-            case EventEntry::Type::MOTION: {
-                if (DEBUG_OUTBOUND_EVENT_DETAILS) {
-                    LOG(INFO) << "Publishing " << *dispatchEntry << " to "
-                              << connection->getInputChannelName();
-                }
-                const MotionEntry& motionEntry = static_cast<const MotionEntry&>(eventEntry);
-                status = publishMotionEvent(*connection, *dispatchEntry);
-                if (mTracer) {
-                    ensureEventTraced(motionEntry);
-                    mTracer->traceEventDispatch(*dispatchEntry, *motionEntry.traceTracker);
+        // Stage a batch of events from the front of the outbound queue, and write all of them to
+        // the channel at once.
+        const size_t batchSize =
+                std::min(connection->outboundQueue.size(), MAX_PUBLISH_BATCH_SIZE);
+        size_t stagedCount = 0;
+        status_t status = OK;
+        connection->inputPublisher.beginBatch();
+        while (status == OK && stagedCount < batchSize) {
+            status = stageEventLocked(currentTime, connection,
+                                      *connection->outboundQueue[stagedCount]);
+            if (status == OK) {
+                stagedCount++;
+            }
+        }
+        size_t publishedCount = 0;
+        const status_t publishStatus = connection->inputPublisher.flushBatch(publishedCount);
+        if (publishStatus != OK) {
+            // An event that was staged could not be published. This error takes precedence,
+            // since the event comes before the one that could not be staged, if any.
+            status = publishStatus;
+        }
+
+        // Re-enqueue the published events on the wait queue. Only these are traced, since the
+        // events that were not published are staged and published again later.
+        for (size_t i = 0; i < publishedCount; i++) {
+            std::unique_ptr<DispatchEntry>& dispatchEntry = connection->outboundQueue.front();
+            if (mTracer) {
+                const EventEntry& eventEntry = *dispatchEntry->eventEntry;
+                if (eventEntry.type == EventEntry::Type::KEY ||
+                    eventEntry.type == EventEntry::Type::MOTION) {
+                    mTracer->traceEventDispatch(*dispatchEntry, *getTraceTracker(eventEntry));
                 }
-                break;
-            }
-
-            case EventEntry::Type::FOCUS: {
-                const FocusEntry& focusEntry = static_cast<const FocusEntry&>(eventEntry);
-                status = connection->inputPublisher.publishFocusEvent(dispatchEntry->seq,
-                                                                      focusEntry.id,
-                                                                      focusEntry.hasFocus);
-                break;
-            }
-
-            case EventEntry::Type::TOUCH_MODE_CHANGED: {
-                const TouchModeEntry& touchModeEntry =
-                        static_cast<const TouchModeEntry&>(eventEntry);
-                status = connection->inputPublisher
-                                 .publishTouchModeEvent(dispatchEntry->seq, touchModeEntry.id,
-                                                        touchModeEntry.inTouchMode);
-
-                break;
             }
-
-            case EventEntry::Type::POINTER_CAPTURE_CHANGED: {
-                const auto& captureEntry =
-                        static_cast<const PointerCaptureChangedEntry&>(eventEntry);
-                status =
-                        connection->inputPublisher
-                                .publishCaptureEvent(dispatchEntry->seq, captureEntry.id,
-                                                     captureEntry.pointerCaptureRequest.isEnable());
-                break;
-            }
-
-            case EventEntry::Type::DRAG: {
-                const DragEntry& dragEntry = static_cast<const DragEntry&>(eventEntry);
-                status = connection->inputPublisher.publishDragEvent(dispatchEntry->seq,
-                                                                     dragEntry.id, dragEntry.x,
-                                                                     dragEntry.y,
-                                                                     dragEntry.isExiting);
-                break;
-            }
-
-            case EventEntry::Type::CONFIGURATION_CHANGED:
-            case EventEntry::Type::DEVICE_RESET:
-            case EventEntry::Type::SENSOR: {
-                LOG_ALWAYS_FATAL("Should never start dispatch cycles for %s events",
-                                 ftl::enum_string(eventEntry.type).c_str());
-                return;
+            const nsecs_t timeoutTime = dispatchEntry->timeoutTime;
+            connection->waitQueue.emplace_back(std::move(dispatchEntry));
+            connection->outboundQueue.pop_front();
+            traceOutboundQueueLength(*connection);
+            if (connection->responsive) {
+                mAnrTracker.insert(timeoutTime, connection->getToken());
             }
+            traceWaitQueueLength(*connection);
         }
 
         // Check the result.
@@ -3910,16 +4062,6 @@ void InputDispatcher::startDispatchCycleLocked(nsecs_t currentTime,
             }
             return;
         }
-
-        // Re-enqueue the event on the wait queue.
-        const nsecs_t timeoutTime = dispatchEntry->timeoutTime;
-        connection->waitQueue.emplace_back(std::move(dispatchEntry));
-        connection->outboundQueue.erase(connection->outboundQueue.begin());
-        traceOutboundQueueLength(*connection);
-        if (connection->responsive) {
-            mAnrTracker.insert(timeoutTime, connection->getToken());
-        }
-        traceWaitQueueLength(*connection);
     }
 }
 
@@ -4378,7 +4520,7 @@ void InputDispatcher::synthesizePointerDownEventsForConnectionLocked(
 std::unique_ptr<MotionEntry> InputDispatcher::splitMotionEvent(
         const MotionEntry& originalMotionEntry, std::bitset<MAX_POINTER_ID + 1> pointerIds,
         nsecs_t splitDownTime) {
-    const auto& [action, pointerProperties, pointerCoords] =
+    auto [action, pointerProperties, pointerCoords] =
             MotionEvent::split(originalMotionEntry.action, originalMotionEntry.flags,
                                /*historySize=*/0, originalMotionEntry.pointerProperties,
                                originalMotionEntry.pointerCoords, pointerIds);
@@ -4426,7 +4568,7 @@ std::unique_ptr<MotionEntry> InputDispatcher::splitMotionEvent(
                                           originalMotionEntry.yPrecision,
                                           originalMotionEntry.xCursorPosition,
                                           originalMotionEntry.yCursorPosition, splitDownTime,
-                                          pointerProperties, pointerCoords);
+                                          std::move(pointerProperties), std::move(pointerCoords));
     if (mTracer) {
         splitMotionEntry->traceTracker =
                 mTracer->traceDerivedEvent(*splitMotionEntry, *originalMotionEntry.traceTracker);
@@ -5157,6 +5299,13 @@ const std::vector<sp<WindowInfoHandle>>& InputDispatcher::getWindowHandlesLocked
     return it != mWindowHandlesByDisplay.end() ? it->second : EMPTY_WINDOW_HANDLES;
 }
 
+const WindowSpatialIndex& InputDispatcher::getWindowSpatialIndexLocked(
+        ui::LogicalDisplayId displayId) const {
+    static const WindowSpatialIndex EMPTY_SPATIAL_INDEX;
+    auto it = mWindowSpatialIndexByDisplay.find(displayId);
+    return it != mWindowSpatialIndexByDisplay.end() ? it->second : EMPTY_SPATIAL_INDEX;
+}
+
 sp<WindowInfoHandle> InputDispatcher::getWindowHandleLocked(
         const sp<IBinder>& windowHandleToken, std::optional<ui::LogicalDisplayId> displayId) const {
     if (windowHandleToken == nullptr) {
@@ -5283,6 +5432,7 @@ void InputDispatcher::updateWindowHandlesForDisplayLocked(
     if (windowInfoHandles.empty()) {
         // Remove all handles on a display if there are no windows left.
         mWindowHandlesByDisplay.erase(displayId);
+        mWindowSpatialIndexByDisplay.erase(displayId);
         return;
     }
 
@@ -5329,6 +5479,10 @@ void InputDispatcher::updateWindowHandlesForDisplayLocked(
 
     // Insert or replace
     mWindowHandlesByDisplay[displayId] = newHandles;
+    // The positions stored in the spatial index refer to the new list of handles, so it has to be
+    // rebuilt whenever the list changes.
+    mWindowSpatialIndexByDisplay[displayId].rebuild(mWindowHandlesByDisplay[displayId],
+                                                   getTransformLocked(displayId));
 }
 
 /**
@@ -5664,6 +5818,16 @@ bool InputDispatcher::recentWindowsAreOwnedByLocked(gui::Pid pid, gui::Uid uid)
                         }) != mInteractionConnectionTokens.end();
 }
 
+void InputDispatcher::setPerDisplayDispatchEnabled(bool enabled) {
+    { // acquire lock
+        std::scoped_lock _l(mLock);
+        mPerDisplayDispatchEnabled = enabled;
+    } // release lock
+
+    // Wake up poll loop since the queued events may now be dispatched.
+    mLooper->wake();
+}
+
 void InputDispatcher::setMaximumObscuringOpacityForTouch(float opacity) {
     if (opacity < 0 || opacity > 1) {
         LOG_ALWAYS_FATAL("Maximum obscuring opacity for touch should be >= 0 and <= 1");
@@ -5892,6 +6056,8 @@ std::string InputDispatcher::dumpPointerCaptureStateLocked() const {
 void InputDispatcher::dumpDispatchStateLocked(std::string& dump) const {
     dump += StringPrintf(INDENT "DispatchEnabled: %s\n", toString(mDispatchEnabled));
     dump += StringPrintf(INDENT "DispatchFrozen: %s\n", toString(mDispatchFrozen));
+    dump += StringPrintf(INDENT "PerDisplayDispatchEnabled: %s\n",
+                         toString(mPerDisplayDispatchEnabled));
     dump += StringPrintf(INDENT "InputFilterEnabled: %s\n", toString(mInputFilterEnabled));
     dump += StringPrintf(INDENT "FocusedDisplayId: %s\n", mFocusedDisplayId.toString().c_str());
 
@@ -5940,6 +6106,8 @@ void InputDispatcher::dumpDispatchStateLocked(std::string& dump) const {
             } else {
                 dump += INDENT2 "No DisplayInfo found!\n";
             }
+            dump += StringPrintf(INDENT2 "SpatialIndex: %s\n",
+                                 getWindowSpatialIndexLocked(displayId).dump().c_str());
 
             if (!windowHandles.empty()) {
                 dump += INDENT2 "Windows:\n";
@@ -6059,6 +6227,7 @@ void InputDispatcher::dumpDispatchStateLocked(std::string& dump) const {
     dump += StringPrintf(INDENT2 "KeyRepeatTimeout: %" PRId64 "ms\n",
                          ns2ms(mConfig.keyRepeatTimeout));
     dump += mLatencyTracker.dump(INDENT2);
+    dump += mLatencyAggregatorProcessor.dump(INDENT2);
     dump += mLatencyAggregator.dump(INDENT2);
     dump += INDENT "InputTracer: ";
     dump += mTracer == nullptr ? "Disabled" : "Enabled";
@@ -6090,7 +6259,10 @@ Result<std::unique_ptr<InputChannel>> InputDispatcher::createInputChannel(const
 
     std::unique_ptr<InputChannel> serverChannel;
     std::unique_ptr<InputChannel> clientChannel;
-    status_t result = InputChannel::openInputChannelPair(name, serverChannel, clientChannel);
+    const uint32_t motionSampleRingCapacity =
+            input_flags::enable_motion_sample_ring() ? MOTION_SAMPLE_RING_CAPACITY : 0;
+    status_t result = InputChannel::openInputChannelPair(name, serverChannel, clientChannel,
+                                                         motionSampleRingCapacity);
 
     if (result) {
         return base::Error(result) << "Failed to open input channel pair with name " << name;
@@ -17,6 +17,7 @@
 #pragma once
 
 #include "AnrTracker.h"
+#include "AsyncTimelineProcessor.h"
 #include "CancelationOptions.h"
 #include "DragState.h"
 #include "Entry.h"
@@ -32,6 +33,7 @@
 #include "Monitor.h"
 #include "TouchState.h"
 #include "TouchedWindow.h"
+#include "WindowSpatialIndex.h"
 #include "trace/InputTracerInterface.h"
 #include "trace/InputTracingBackendInterface.h"
 
@@ -123,6 +125,7 @@ public:
     bool setInTouchMode(bool inTouchMode, gui::Pid pid, gui::Uid uid, bool hasPermission,
                         ui::LogicalDisplayId displayId) override;
     void setMaximumObscuringOpacityForTouch(float opacity) override;
+    void setPerDisplayDispatchEnabled(bool enabled) override;
 
     bool transferTouchGesture(const sp<IBinder>& fromToken, const sp<IBinder>& toToken,
                               bool isDragDrop = false) override;
@@ -228,6 +231,12 @@ private:
     void dispatchOnce();
 
     void dispatchOnceInnerLocked(nsecs_t& nextWakeupTime) REQUIRES(mLock);
+    void dispatchEventsForUnblockedDisplaysLocked(nsecs_t currentTime, nsecs_t& nextWakeupTime)
+            REQUIRES(mLock);
+    bool dispatchInboundEventLocked(nsecs_t currentTime,
+                                    const std::shared_ptr<const EventEntry>& entry,
+                                    DropReason& outDropReason, nsecs_t& nextWakeupTime)
+            REQUIRES(mLock);
 
     // Enqueues an inbound event.  Returns true if mLooper->wake() should be called.
     bool enqueueInboundEventLocked(std::unique_ptr<EventEntry> entry) REQUIRES(mLock);
@@ -343,6 +352,9 @@ private:
     bool mDispatchFrozen GUARDED_BY(mLock);
     bool mInputFilterEnabled GUARDED_BY(mLock);
     float mMaximumObscuringOpacityForTouch GUARDED_BY(mLock);
+    // When enabled, an event that is waiting on one display doesn't delay the pointer events of
+    // the other displays.
+    bool mPerDisplayDispatchEnabled GUARDED_BY(mLock);
 
     // This map is not really needed, but it helps a lot with debugging (dumpsys input).
     // In the java layer, touch mode states are spread across multiple DisplayContent objects,
@@ -365,12 +377,18 @@ private:
             mWindowHandlesByDisplay GUARDED_BY(mLock);
     std::unordered_map<ui::LogicalDisplayId /*displayId*/, android::gui::DisplayInfo> mDisplayInfos
             GUARDED_BY(mLock);
+    // Spatial index over the windows of each display, kept in sync with mWindowHandlesByDisplay.
+    std::unordered_map<ui::LogicalDisplayId /*displayId*/, WindowSpatialIndex>
+            mWindowSpatialIndexByDisplay GUARDED_BY(mLock);
     void setInputWindowsLocked(
             const std::vector<sp<android::gui::WindowInfoHandle>>& inputWindowHandles,
             ui::LogicalDisplayId displayId) REQUIRES(mLock);
     // Get a reference to window handles by display, return an empty vector if not found.
     const std::vector<sp<android::gui::WindowInfoHandle>>& getWindowHandlesLocked(
             ui::LogicalDisplayId displayId) const REQUIRES(mLock);
+    // Get a reference to the spatial index of a display, return an empty index if not found.
+    const WindowSpatialIndex& getWindowSpatialIndexLocked(ui::LogicalDisplayId displayId) const
+            REQUIRES(mLock);
     ui::Transform getTransformLocked(ui::LogicalDisplayId displayId) const REQUIRES(mLock);
 
     sp<android::gui::WindowInfoHandle> getWindowHandleLocked(
@@ -608,6 +626,10 @@ private:
                                     std::shared_ptr<const EventEntry>,
                                     const InputTarget& inputTarget) REQUIRES(mLock);
     status_t publishMotionEvent(Connection& connection, DispatchEntry& dispatchEntry) const;
+    // Publish the given event to the connection, as part of the batch started by
+    // startDispatchCycleLocked.
+    status_t stageEventLocked(nsecs_t currentTime, const std::shared_ptr<Connection>& connection,
+                              DispatchEntry& dispatchEntry) REQUIRES(mLock);
     void startDispatchCycleLocked(nsecs_t currentTime,
                                   const std::shared_ptr<Connection>& connection) REQUIRES(mLock);
     void finishDispatchCycleLocked(nsecs_t currentTime,
@@ -694,8 +716,10 @@ private:
     std::tuple<TouchState*, TouchedWindow*, ui::LogicalDisplayId /*displayId*/>
     findTouchStateWindowAndDisplayLocked(const sp<IBinder>& token) REQUIRES(mLock);
 
-    // Statistics gathering.
-    LatencyAggregator mLatencyAggregator GUARDED_BY(mLock);
+    // Statistics gathering. The mature timelines are aggregated on a background thread, so the
+    // aggregator is not guarded by mLock; it is thread-safe.
+    LatencyAggregator mLatencyAggregator;
+    AsyncTimelineProcessor mLatencyAggregatorProcessor;
     LatencyTracker mLatencyTracker GUARDED_BY(mLock);
     void traceInboundQueueLengthLocked() REQUIRES(mLock);
     void traceOutboundQueueLength(const Connection& connection);
@@ -211,6 +211,7 @@ void LatencyAggregator::processSlowEvent(const InputEventTimeline& timeline) {
     static const std::chrono::duration sSlowEventThreshold = getSlowEventMinReportingLatency();
     static const std::chrono::duration sSlowEventReportingInterval =
             getSlowEventMinReportingInterval();
+    std::scoped_lock lock(mLock);
     for (const auto& [token, connectionTimeline] : timeline.connectionTimelines) {
         if (!connectionTimeline.isComplete()) {
             continue;
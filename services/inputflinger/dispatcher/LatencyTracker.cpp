@@ -20,6 +20,8 @@
 
 #include <inttypes.h>
 
+#include <algorithm>
+
 #include <android-base/properties.h>
 #include <android-base/stringprintf.h>
 #include <android/os/IInputConstants.h>
@@ -47,38 +49,157 @@ static bool isMatureEvent(nsecs_t eventTime, nsecs_t now) {
     return age > ANR_TIMEOUT;
 }
 
-/**
- * A multimap allows to have several entries with the same key. This function just erases a specific
- * key-value pair. Equivalent to the imaginary std api std::multimap::erase(key, value).
- */
-template <typename K, typename V>
-static void eraseByValue(std::multimap<K, V>& map, const V& value) {
-    for (auto it = map.begin(); it != map.end();) {
-        if (it->second == value) {
-            it = map.erase(it);
-        } else {
-            it++;
+static nsecs_t getAnrTimeoutNanos() {
+    return std::chrono::duration_cast<std::chrono::nanoseconds>(ANR_TIMEOUT).count();
+}
+
+// Returns the number of the interval of the given duration that contains the given time.
+static int64_t getIntervalNumber(nsecs_t time, nsecs_t duration) {
+    const int64_t number = time / duration;
+    // Round towards negative infinity, so that all intervals have the same duration.
+    return (time % duration < 0) ? number - 1 : number;
+}
+
+LatencyTracker::LatencyTracker(InputEventTimelineProcessor* processor, size_t maxTimelineCount)
+      : mSlots(maxTimelineCount),
+        // Half of the buckets already cover the ANR timeout, so that the events that are not
+        // mature yet never wrap around the ring.
+        mBucketDuration(getAnrTimeoutNanos() / static_cast<nsecs_t>(BUCKET_COUNT / 2) + 1),
+        mTimelineProcessor(processor) {
+    LOG_ALWAYS_FATAL_IF(processor == nullptr);
+    LOG_ALWAYS_FATAL_IF(maxTimelineCount == 0 ||
+                        maxTimelineCount > static_cast<size_t>(INT32_MAX / 2));
+
+    for (size_t i = maxTimelineCount; i > 0; i--) {
+        mSlots[i - 1].next = mFreeSlots;
+        mFreeSlots = static_cast<int32_t>(i - 1);
+    }
+
+    size_t indexSize = 1;
+    uint32_t indexBits = 0;
+    while (indexSize < maxTimelineCount * 2) {
+        indexSize *= 2;
+        indexBits++;
+    }
+    mIndex.assign(indexSize, NO_SLOT);
+    mIndexShift = 32 - indexBits;
+}
+
+size_t LatencyTracker::homeIndexOf(int32_t inputEventId) const {
+    if (mIndexShift == 32) {
+        return 0;
+    }
+    // Fibonacci hashing, computed without overflow.
+    const uint64_t hash = (static_cast<uint64_t>(static_cast<uint32_t>(inputEventId)) *
+                           0x9E3779B1u) &
+            0xFFFFFFFFu;
+    return static_cast<size_t>(hash >> mIndexShift);
+}
+
+int32_t LatencyTracker::findSlot(int32_t inputEventId) const {
+    const size_t mask = mIndex.size() - 1;
+    for (size_t i = homeIndexOf(inputEventId);; i = (i + 1) & mask) {
+        const int32_t slot = mIndex[i];
+        if (slot == NO_SLOT || mSlots[slot].inputEventId == inputEventId) {
+            return slot;
         }
     }
 }
 
-LatencyTracker::LatencyTracker(InputEventTimelineProcessor* processor)
-      : mTimelineProcessor(processor) {
-    LOG_ALWAYS_FATAL_IF(processor == nullptr);
+LatencyTracker::Bucket& LatencyTracker::bucketFor(nsecs_t eventTime) {
+    int64_t number = getIntervalNumber(eventTime, mBucketDuration);
+    if (mTimelineCount == 0) {
+        // Nothing is tracked, so the ring can start at any bucket.
+        mOldestBucket = number;
+    }
+    // Events that are older than the oldest bucket are about to be reported anyway.
+    number = std::max(number, mOldestBucket);
+    LOG_ALWAYS_FATAL_IF(number - mOldestBucket >= static_cast<int64_t>(BUCKET_COUNT),
+                        "Event time %" PRId64 " is too far ahead of the tracked events",
+                        eventTime);
+    return getBucket(number);
+}
+
+LatencyTracker::Bucket& LatencyTracker::getBucket(int64_t number) {
+    const int64_t count = static_cast<int64_t>(BUCKET_COUNT);
+    return mBuckets[((number % count) + count) % count];
+}
+
+void LatencyTracker::addTimeline(int32_t inputEventId, InputEventTimeline timeline) {
+    if (mFreeSlots == NO_SLOT) {
+        mDroppedTimelineCount++;
+        return;
+    }
+    Bucket& bucket = bucketFor(timeline.eventTime);
+    const int32_t slot = mFreeSlots;
+    Slot& entry = mSlots[slot];
+    mFreeSlots = entry.next;
+
+    // Keep the bucket ordered by eventTime. Events mostly arrive in order, so start from the back.
+    int32_t previous = bucket.tail;
+    while (previous != NO_SLOT && mSlots[previous].timeline->eventTime > timeline.eventTime) {
+        previous = mSlots[previous].previous;
+    }
+    const int32_t next = previous == NO_SLOT ? bucket.head : mSlots[previous].next;
+    entry.timeline.emplace(std::move(timeline));
+    entry.inputEventId = inputEventId;
+    entry.bucket = static_cast<size_t>(&bucket - mBuckets.data());
+    entry.previous = previous;
+    entry.next = next;
+    (previous == NO_SLOT ? bucket.head : mSlots[previous].next) = slot;
+    (next == NO_SLOT ? bucket.tail : mSlots[next].previous) = slot;
+
+    const size_t mask = mIndex.size() - 1;
+    size_t i = homeIndexOf(inputEventId);
+    while (mIndex[i] != NO_SLOT) {
+        i = (i + 1) & mask;
+    }
+    mIndex[i] = slot;
+    mTimelineCount++;
+}
+
+void LatencyTracker::removeTimeline(int32_t slot) {
+    Slot& entry = mSlots[slot];
+    Bucket& bucket = mBuckets[entry.bucket];
+    (entry.previous == NO_SLOT ? bucket.head : mSlots[entry.previous].next) = entry.next;
+    (entry.next == NO_SLOT ? bucket.tail : mSlots[entry.next].previous) = entry.previous;
+
+    // Remove the slot from the index, and shift back the entries that follow it in the same probe
+    // sequence, so that lookups never need to skip over deleted entries.
+    const size_t mask = mIndex.size() - 1;
+    size_t hole = homeIndexOf(entry.inputEventId);
+    while (mIndex[hole] != slot) {
+        hole = (hole + 1) & mask;
+    }
+    for (size_t i = (hole + 1) & mask; mIndex[i] != NO_SLOT; i = (i + 1) & mask) {
+        const size_t home = homeIndexOf(mSlots[mIndex[i]].inputEventId);
+        // The entry can move into the hole if its home is not cyclically within (hole, i].
+        const bool homeBetween = hole < i ? (home > hole && home <= i) : (home > hole || home <= i);
+        if (!homeBetween) {
+            mIndex[hole] = mIndex[i];
+            hole = i;
+        }
+    }
+    mIndex[hole] = NO_SLOT;
+
+    entry.timeline.reset();
+    entry.previous = NO_SLOT;
+    entry.next = mFreeSlots;
+    mFreeSlots = slot;
+    mTimelineCount--;
 }
 
 void LatencyTracker::trackListener(int32_t inputEventId, bool isDown, nsecs_t eventTime,
                                    nsecs_t readTime, DeviceId deviceId,
                                    const std::set<InputDeviceUsageSource>& sources) {
     reportAndPruneMatureRecords(eventTime);
-    const auto it = mTimelines.find(inputEventId);
-    if (it != mTimelines.end()) {
+    const int32_t slot = findSlot(inputEventId);
+    if (slot != NO_SLOT) {
         // Input event ids are randomly generated, so it's possible that two events have the same
         // event id. Drop this event, and also drop the existing event because the apps would
         // confuse us by reporting the rest of the timeline for one of them. This should happen
         // rarely, so we won't lose much data
-        mTimelines.erase(it);
-        eraseByValue(mEventTimes, inputEventId);
+        removeTimeline(slot);
         return;
     }
 
@@ -101,24 +222,23 @@ void LatencyTracker::trackListener(int32_t inputEventId, bool isDown, nsecs_t ev
         return;
     }
 
-    mTimelines.emplace(inputEventId,
-                       InputEventTimeline(isDown, eventTime, readTime, identifier->vendor,
-                                          identifier->product, sources));
-    mEventTimes.emplace(eventTime, inputEventId);
+    addTimeline(inputEventId,
+                InputEventTimeline(isDown, eventTime, readTime, identifier->vendor,
+                                   identifier->product, sources));
 }
 
 void LatencyTracker::trackFinishedEvent(int32_t inputEventId, const sp<IBinder>& connectionToken,
                                         nsecs_t deliveryTime, nsecs_t consumeTime,
                                         nsecs_t finishTime) {
-    const auto it = mTimelines.find(inputEventId);
-    if (it == mTimelines.end()) {
+    const int32_t slot = findSlot(inputEventId);
+    if (slot == NO_SLOT) {
         // This could happen if we erased this event when duplicate events were detected. It's
         // also possible that an app sent a bad (or late) 'Finish' signal, since it's free to do
         // anything in its process. Just drop the report and move on.
         return;
     }
 
-    InputEventTimeline& timeline = it->second;
+    InputEventTimeline& timeline = *mSlots[slot].timeline;
     const auto connectionIt = timeline.connectionTimelines.find(connectionToken);
     if (connectionIt == timeline.connectionTimelines.end()) {
         // Most likely case: app calls 'finishInputEvent' before it reports the graphics timeline
@@ -141,15 +261,15 @@ void LatencyTracker::trackFinishedEvent(int32_t inputEventId, const sp<IBinder>&
 void LatencyTracker::trackGraphicsLatency(
         int32_t inputEventId, const sp<IBinder>& connectionToken,
         std::array<nsecs_t, GraphicsTimeline::SIZE> graphicsTimeline) {
-    const auto it = mTimelines.find(inputEventId);
-    if (it == mTimelines.end()) {
+    const int32_t slot = findSlot(inputEventId);
+    if (slot == NO_SLOT) {
         // This could happen if we erased this event when duplicate events were detected. It's
         // also possible that an app sent a bad (or late) 'Timeline' signal, since it's free to do
         // anything in its process. Just drop the report and move on.
         return;
     }
 
-    InputEventTimeline& timeline = it->second;
+    InputEventTimeline& timeline = *mSlots[slot].timeline;
     const auto connectionIt = timeline.connectionTimelines.find(connectionToken);
     if (connectionIt == timeline.connectionTimelines.end()) {
         timeline.connectionTimelines.emplace(connectionToken, std::move(graphicsTimeline));
@@ -171,29 +291,44 @@ void LatencyTracker::trackGraphicsLatency(
  * 'trackListener' should happen soon after the event occurs.
  */
 void LatencyTracker::reportAndPruneMatureRecords(nsecs_t newEventTime) {
-    while (!mEventTimes.empty()) {
-        const auto& [oldestEventTime, oldestInputEventId] = *mEventTimes.begin();
-        if (isMatureEvent(oldestEventTime, /*now=*/newEventTime)) {
-            // Report and drop this event
-            const auto it = mTimelines.find(oldestInputEventId);
-            LOG_ALWAYS_FATAL_IF(it == mTimelines.end(),
-                                "Event %" PRId32 " is in mEventTimes, but not in mTimelines",
-                                oldestInputEventId);
-            const InputEventTimeline& timeline = it->second;
-            mTimelineProcessor->processTimeline(timeline);
-            mTimelines.erase(it);
-            mEventTimes.erase(mEventTimes.begin());
-        } else {
+    if (mTimelineCount == 0) {
+        return;
+    }
+    // All the events in the buckets that end before the cutoff bucket are mature.
+    const int64_t cutoffBucket =
+            getIntervalNumber(newEventTime - getAnrTimeoutNanos(), mBucketDuration);
+    for (size_t i = 0; i < BUCKET_COUNT && mOldestBucket < cutoffBucket; i++) {
+        Bucket& bucket = getBucket(mOldestBucket);
+        while (bucket.head != NO_SLOT) {
+            mTimelineProcessor->processTimeline(*mSlots[bucket.head].timeline);
+            removeTimeline(bucket.head);
+        }
+        mOldestBucket++;
+    }
+    // If all the buckets have been visited, all the events have been reported.
+    mOldestBucket = std::max(mOldestBucket, cutoffBucket);
+
+    // The oldest remaining bucket may still start with mature events.
+    if (mTimelineCount == 0) {
+        return;
+    }
+    Bucket& bucket = getBucket(mOldestBucket);
+    while (bucket.head != NO_SLOT) {
+        const InputEventTimeline& timeline = *mSlots[bucket.head].timeline;
+        if (!isMatureEvent(timeline.eventTime, /*now=*/newEventTime)) {
             // If the oldest event does not need to be pruned, no events should be pruned.
             return;
         }
+        mTimelineProcessor->processTimeline(timeline);
+        removeTimeline(bucket.head);
     }
 }
 
 std::string LatencyTracker::dump(const char* prefix) const {
     return StringPrintf("%sLatencyTracker:\n", prefix) +
-            StringPrintf("%s  mTimelines.size() = %zu\n", prefix, mTimelines.size()) +
-            StringPrintf("%s  mEventTimes.size() = %zu\n", prefix, mEventTimes.size());
+            StringPrintf("%s  mTimelineCount = %zu (capacity %zu)\n", prefix, mTimelineCount,
+                         mSlots.size()) +
+            StringPrintf("%s  mDroppedTimelineCount = %zu\n", prefix, mDroppedTimelineCount);
 }
 
 void LatencyTracker::setInputDevices(const std::vector<InputDeviceInfo>& inputDevices) {
@@ -18,8 +18,9 @@
 
 #include "../InputDeviceMetricsSource.h"
 
-#include <map>
-#include <unordered_map>
+#include <array>
+#include <optional>
+#include <vector>
 
 #include <binder/IBinder.h>
 #include <input/Input.h>
@@ -41,8 +42,11 @@ public:
     /**
      * Create a LatencyTracker.
      * param reportingFunction: the function that will be called in order to report full latency.
+     * param maxTimelineCount: the maximum number of events that are tracked at the same time.
+     * Events that are received while the tracker is full are not tracked.
      */
-    LatencyTracker(InputEventTimelineProcessor* processor);
+    LatencyTracker(InputEventTimelineProcessor* processor,
+                   size_t maxTimelineCount = DEFAULT_MAX_TIMELINE_COUNT);
     /**
      * Start keeping track of an event identified by inputEventId. This must be called first.
      * If duplicate events are encountered (events that have the same eventId), none of them will be
@@ -62,27 +66,75 @@ public:
     std::string dump(const char* prefix) const;
     void setInputDevices(const std::vector<InputDeviceInfo>& inputDevices);
 
+    // Enough for several high-rate input devices over the ANR timeout.
+    static constexpr size_t DEFAULT_MAX_TIMELINE_COUNT = 4096;
+
 private:
+    static constexpr int32_t NO_SLOT = -1;
+    // The number of expiry buckets. Together, they cover more than the ANR timeout.
+    static constexpr size_t BUCKET_COUNT = 32;
+
     /**
-     * A collection of InputEventTimelines keyed by inputEventId. An InputEventTimeline is first
-     * created when 'trackListener' is called.
+     * A slot of the timeline table. The slots are allocated once, when the tracker is created, and
+     * are reused for the following events.
+     */
+    struct Slot {
+        std::optional<InputEventTimeline> timeline;
+        int32_t inputEventId = 0;
+        // Neighbours of this slot in the list of its expiry bucket, ordered by eventTime. The next
+        // slot also links the free slots together.
+        int32_t previous = NO_SLOT;
+        int32_t next = NO_SLOT;
+        // Position of the expiry bucket of this slot in mBuckets.
+        size_t bucket = 0;
+    };
+
+    /**
+     * The events whose eventTime falls within the same interval of mBucketDuration. When the
+     * oldest events become mature, whole buckets can be reported without looking at the others.
+     */
+    struct Bucket {
+        int32_t head = NO_SLOT;
+        int32_t tail = NO_SLOT;
+    };
+
+    /**
+     * The timeline table. An InputEventTimeline is first created when 'trackListener' is called.
      * When either 'trackFinishedEvent' or 'trackGraphicsLatency' is called for this input event,
      * the corresponding InputEventTimeline will be updated for that token.
      */
-    std::unordered_map<int32_t /*inputEventId*/, InputEventTimeline> mTimelines;
+    std::vector<Slot> mSlots;
+    int32_t mFreeSlots = NO_SLOT;
+    size_t mTimelineCount = 0;
+    // How many events could not be tracked because the table was full.
+    size_t mDroppedTimelineCount = 0;
+
+    /**
+     * Open-addressing index of the occupied slots, keyed by inputEventId. Its size is a power of
+     * two, at least twice the number of slots, so that the probe sequences stay short.
+     */
+    std::vector<int32_t> mIndex;
+    uint32_t mIndexShift;
+
     /**
-     * The collection of eventTimes will help us quickly find the events that we should prune
-     * from the 'mTimelines'. Since 'mTimelines' is keyed by inputEventId, it would be inefficient
-     * to walk through it directly to find the oldest input events to get rid of.
-     * There is a 1:1 mapping between 'mTimelines' and 'mEventTimes'.
-     * We are using 'multimap' instead of 'map' because there could be more than 1 event with the
-     * same eventTime.
+     * The expiry buckets, used as a ring. mOldestBucket is the number of the oldest bucket that may
+     * hold events; the buckets that follow it cover the later intervals. Events that are older
+     * than the oldest bucket are kept at the front of it, since they will be reported first.
      */
-    std::multimap<nsecs_t /*eventTime*/, int32_t /*inputEventId*/> mEventTimes;
+    std::array<Bucket, BUCKET_COUNT> mBuckets;
+    int64_t mOldestBucket = 0;
+    const nsecs_t mBucketDuration;
 
     InputEventTimelineProcessor* mTimelineProcessor;
     std::vector<InputDeviceInfo> mInputDevices;
     void reportAndPruneMatureRecords(nsecs_t newEventTime);
+
+    size_t homeIndexOf(int32_t inputEventId) const;
+    int32_t findSlot(int32_t inputEventId) const;
+    void addTimeline(int32_t inputEventId, InputEventTimeline timeline);
+    void removeTimeline(int32_t slot);
+    Bucket& bucketFor(nsecs_t eventTime);
+    Bucket& getBucket(int64_t number);
 };
 
 } // namespace android::inputdispatcher
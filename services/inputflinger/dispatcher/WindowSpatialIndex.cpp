@@ -0,0 +1,205 @@
+/*
+ * Copyright (C) 2024 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "WindowSpatialIndex.h"
+
+#include <android-base/stringprintf.h>
+#include <algorithm>
+#include <cinttypes>
+#include <cmath>
+
+using android::base::StringAppendF;
+using android::gui::WindowInfo;
+using android::gui::WindowInfoHandle;
+
+namespace android::inputdispatcher {
+
+namespace {
+
+// Rect::isEmpty computes the width and height in int32_t, which overflows for the bounds of
+// windows that span more than INT32_MAX pixels on an axis.
+bool isEmpty(const Rect& bounds) {
+    return bounds.right <= bounds.left || bounds.bottom <= bounds.top;
+}
+
+// Returns the bounds that the dispatcher may use to hit test the given window, in the logical
+// display space. This must cover both the touchable region (used to find the touched window) and
+// the frame (used to compute the touch occlusion).
+Rect getHitTestBounds(const WindowInfo& info, const ui::Transform& displayTransform) {
+    Rect bounds = displayTransform.transform(info.touchableRegion).getBounds();
+    const Rect frame = displayTransform.transform(info.frame);
+    if (isEmpty(bounds)) {
+        return isEmpty(frame) ? Rect::EMPTY_RECT : frame;
+    }
+    if (!isEmpty(frame)) {
+        bounds.left = std::min(bounds.left, frame.left);
+        bounds.top = std::min(bounds.top, frame.top);
+        bounds.right = std::max(bounds.right, frame.right);
+        bounds.bottom = std::max(bounds.bottom, frame.bottom);
+    }
+    return bounds;
+}
+
+int64_t divideRoundUp(int64_t value, int64_t divisor) {
+    return (value + divisor - 1) / divisor;
+}
+
+} // namespace
+
+void WindowSpatialIndex::clear() {
+    mDisplayTransform.reset();
+    mBounds = Rect::EMPTY_RECT;
+    mColumns = 0;
+    mRows = 0;
+    mCellWidth = 1;
+    mCellHeight = 1;
+    mCellOffsets.clear();
+    mCellWindows.clear();
+    mPositionByWindow.clear();
+    mWindowCount = 0;
+}
+
+void WindowSpatialIndex::rebuild(const std::vector<sp<WindowInfoHandle>>& windowHandles,
+                                 const ui::Transform& displayTransform) {
+    clear();
+    mDisplayTransform = displayTransform;
+    mWindowCount = windowHandles.size();
+
+    std::vector<Rect> windowBounds;
+    windowBounds.reserve(windowHandles.size());
+    for (uint32_t i = 0; i < windowHandles.size(); i++) {
+        mPositionByWindow.emplace(windowHandles[i].get(), i);
+        const Rect bounds = getHitTestBounds(*windowHandles[i]->getInfo(), displayTransform);
+        windowBounds.push_back(bounds);
+        if (isEmpty(bounds)) {
+            continue;
+        }
+        if (isEmpty(mBounds)) {
+            mBounds = bounds;
+        } else {
+            mBounds.left = std::min(mBounds.left, bounds.left);
+            mBounds.top = std::min(mBounds.top, bounds.top);
+            mBounds.right = std::max(mBounds.right, bounds.right);
+            mBounds.bottom = std::max(mBounds.bottom, bounds.bottom);
+        }
+    }
+    if (isEmpty(mBounds)) {
+        return;
+    }
+
+    // Use roughly sqrt(n) cells per axis, so that the cost of a query grows with the number of
+    // windows that overlap the location rather than with the total number of windows.
+    // The bounds of the windows come from the clients, and may span the whole int32_t range on
+    // either axis, so the sizes are computed in int64_t.
+    const auto cellsPerAxis =
+            std::clamp(static_cast<int64_t>(std::ceil(std::sqrt(windowHandles.size()))),
+                       int64_t{1}, int64_t{MAX_CELLS_PER_AXIS});
+    const int64_t width = static_cast<int64_t>(mBounds.right) - mBounds.left;
+    const int64_t height = static_cast<int64_t>(mBounds.bottom) - mBounds.top;
+    mCellWidth = std::max(divideRoundUp(width, cellsPerAxis), int64_t{1});
+    mCellHeight = std::max(divideRoundUp(height, cellsPerAxis), int64_t{1});
+    mColumns = static_cast<int32_t>(
+            std::clamp(divideRoundUp(width, mCellWidth), int64_t{1}, int64_t{MAX_CELLS_PER_AXIS}));
+    mRows = static_cast<int32_t>(
+            std::clamp(divideRoundUp(height, mCellHeight), int64_t{1}, int64_t{MAX_CELLS_PER_AXIS}));
+
+    // Two passes: count the windows of each cell, then fill them in. Windows are visited front to
+    // back, so each cell ends up sorted in z order.
+    const size_t cellCount = static_cast<size_t>(mColumns) * mRows;
+    mCellOffsets.assign(cellCount + 1, 0);
+    auto forEachCell = [this](const Rect& bounds, auto&& fn) {
+        const int32_t firstColumn = columnOf(bounds.left);
+        const int32_t lastColumn = columnOf(static_cast<int64_t>(bounds.right) - 1);
+        const int32_t firstRow = rowOf(bounds.top);
+        const int32_t lastRow = rowOf(static_cast<int64_t>(bounds.bottom) - 1);
+        for (int32_t row = firstRow; row <= lastRow; row++) {
+            for (int32_t column = firstColumn; column <= lastColumn; column++) {
+                fn(static_cast<size_t>(row) * mColumns + column);
+            }
+        }
+    };
+    for (const Rect& bounds : windowBounds) {
+        if (!isEmpty(bounds)) {
+            forEachCell(bounds, [this](size_t cell) { mCellOffsets[cell + 1]++; });
+        }
+    }
+    for (size_t cell = 0; cell < cellCount; cell++) {
+        mCellOffsets[cell + 1] += mCellOffsets[cell];
+    }
+    mCellWindows.resize(mCellOffsets[cellCount]);
+    std::vector<uint32_t> cursors(mCellOffsets.begin(), mCellOffsets.end() - 1);
+    for (uint32_t i = 0; i < windowBounds.size(); i++) {
+        if (!isEmpty(windowBounds[i])) {
+            forEachCell(windowBounds[i],
+                        [this, &cursors, i](size_t cell) { mCellWindows[cursors[cell]++] = i; });
+        }
+    }
+}
+
+std::optional<size_t> WindowSpatialIndex::cellAt(int32_t x, int32_t y) const {
+    if (mCellOffsets.empty() || x < mBounds.left || x >= mBounds.right || y < mBounds.top ||
+        y >= mBounds.bottom) {
+        return std::nullopt;
+    }
+    return static_cast<size_t>(rowOf(y)) * mColumns + columnOf(x);
+}
+
+int32_t WindowSpatialIndex::columnOf(int64_t x) const {
+    return static_cast<int32_t>(std::clamp((x - mBounds.left) / mCellWidth, int64_t{0},
+                                           static_cast<int64_t>(mColumns) - 1));
+}
+
+int32_t WindowSpatialIndex::rowOf(int64_t y) const {
+    return static_cast<int32_t>(std::clamp((y - mBounds.top) / mCellHeight, int64_t{0},
+                                           static_cast<int64_t>(mRows) - 1));
+}
+
+std::span<const uint32_t> WindowSpatialIndex::candidatesAt(float x, float y) const {
+    // Perform the lookup in the logical display space, the same way the hit test does.
+    const vec2 p = mDisplayTransform.transform(x, y);
+    const float px = std::floor(p.x);
+    const float py = std::floor(p.y);
+    if (!(px >= mBounds.left && px < mBounds.right && py >= mBounds.top && py < mBounds.bottom)) {
+        return {};
+    }
+    const std::optional<size_t> cell = cellAt(static_cast<int32_t>(px), static_cast<int32_t>(py));
+    if (!cell) {
+        return {};
+    }
+    return std::span<const uint32_t>(mCellWindows)
+            .subspan(mCellOffsets[*cell], mCellOffsets[*cell + 1] - mCellOffsets[*cell]);
+}
+
+std::optional<uint32_t> WindowSpatialIndex::positionOf(
+        const sp<WindowInfoHandle>& windowHandle) const {
+    auto it = mPositionByWindow.find(windowHandle.get());
+    if (it == mPositionByWindow.end()) {
+        return std::nullopt;
+    }
+    return it->second;
+}
+
+std::string WindowSpatialIndex::dump() const {
+    std::string dump;
+    StringAppendF(&dump,
+                  "windows=%zu, bounds=[%d,%d][%d,%d], grid=%dx%d, cell=%" PRId64 "x%" PRId64
+                  ", entries=%zu",
+                  mWindowCount, mBounds.left, mBounds.top, mBounds.right, mBounds.bottom, mColumns,
+                  mRows, mCellWidth, mCellHeight, mCellWindows.size());
+    return dump;
+}
+
+} // namespace android::inputdispatcher
@@ -0,0 +1,89 @@
+/*
+ * Copyright (C) 2024 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#pragma once
+
+#include <gui/WindowInfo.h>
+#include <ui/Rect.h>
+#include <ui/Transform.h>
+#include <cstdint>
+#include <optional>
+#include <span>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+namespace android::inputdispatcher {
+
+/**
+ * A uniform grid over the windows of a single display, used to narrow down the set of windows
+ * that have to be hit tested for a given location.
+ *
+ * The index is built from the z-ordered list of window handles of a display. Each window is
+ * inserted into every cell overlapped by the bounds of its touchable region or its frame, in the
+ * logical display space. A query returns the positions (in the original z-ordered list) of the
+ * windows that may contain the location, sorted front to back. The result is a superset of the
+ * windows that actually contain the location: the caller is still responsible for performing the
+ * exact hit test, as well as all of the flag and trust checks.
+ */
+class WindowSpatialIndex {
+public:
+    WindowSpatialIndex() = default;
+
+    // Rebuild the index from the given windows, ordered front to back. The display transform is
+    // used to convert the window bounds and the queried locations into the logical display space.
+    void rebuild(const std::vector<sp<gui::WindowInfoHandle>>& windowHandles,
+                 const ui::Transform& displayTransform);
+    void clear();
+
+    // Returns the positions of the windows that may contain the given location, in z order. The
+    // location is in the display space, the same space that is used for the hit test.
+    std::span<const uint32_t> candidatesAt(float x, float y) const;
+
+    // Returns the position of the given window in the z-ordered list that the index was built
+    // from, or std::nullopt if the window is not part of the index.
+    std::optional<uint32_t> positionOf(const sp<gui::WindowInfoHandle>& windowHandle) const;
+
+    size_t size() const { return mWindowCount; }
+    std::string dump() const;
+
+private:
+    // The grid never exceeds this number of cells on either axis. Windows are usually much
+    // larger than the cells, so a finer grid would mostly grow the memory usage.
+    static constexpr int32_t MAX_CELLS_PER_AXIS = 32;
+
+    ui::Transform mDisplayTransform;
+    // The union of the bounds of all indexed windows, in the logical display space.
+    Rect mBounds = Rect::EMPTY_RECT;
+    int32_t mColumns = 0;
+    int32_t mRows = 0;
+    // A cell may be wider than INT32_MAX if the windows span the whole int32_t range.
+    int64_t mCellWidth = 1;
+    int64_t mCellHeight = 1;
+    // For every cell, the positions of the windows that overlap it. The positions are stored in a
+    // single array; mCellOffsets[i] and mCellOffsets[i + 1] delimit the windows of cell i.
+    std::vector<uint32_t> mCellOffsets;
+    std::vector<uint32_t> mCellWindows;
+    std::unordered_map<const gui::WindowInfoHandle*, uint32_t> mPositionByWindow;
+    size_t mWindowCount = 0;
+
+    std::optional<size_t> cellAt(int32_t x, int32_t y) const;
+    // The column and row of the grid that contain the given coordinate, clamped to the grid.
+    int32_t columnOf(int64_t x) const;
+    int32_t rowOf(int64_t y) const;
+};
+
+} // namespace android::inputdispatcher
@@ -140,6 +140,15 @@ public:
      */
     virtual void setMaximumObscuringOpacityForTouch(float opacity) = 0;
 
+    /**
+     * Sets whether events are dispatched independently for each display.
+     *
+     * When enabled, an event that is waiting on one display (for example, a key waiting for the
+     * focused window of that display) doesn't delay the dispatch of pointer events to the other
+     * displays. Events are still dispatched in order for each display and for each device.
+     */
+    virtual void setPerDisplayDispatchEnabled(bool enabled) = 0;
+
     /**
      * Transfers a touch gesture from one window to another window. Transferring touch will not
      * have any effect on the focused window.
@@ -81,6 +81,9 @@ static constexpr int32_t FF_WEAK_MAGNITUDE_CHANNEL_IDX = 1;
 
 static constexpr size_t EVENT_BUFFER_SIZE = 256;
 
+// The smallest read buffer of a device holds one batch of the events returned by getEvents().
+static_assert(EventHub::MIN_DEVICE_READ_BUFFER_SIZE == EVENT_BUFFER_SIZE);
+
 // Mapping for input battery class node IDs lookup.
 // https://www.kernel.org/doc/Documentation/power/power_supply_class.txt
 static const std::unordered_map<std::string, InputBatteryClass> BATTERY_CLASSES =
@@ -540,7 +543,9 @@ EventHub::Device::Device(int fd, int32_t id, std::string path, InputDeviceIdenti
         controllerNumber(0),
         enabled(true),
         isVirtual(fd < 0),
-        currentFrameDropped(false) {}
+        currentFrameDropped(false),
+        readBufferSize(MIN_DEVICE_READ_BUFFER_SIZE),
+        underusedReadCount(0) {}
 
 EventHub::Device::~Device() {
     close();
@@ -770,6 +775,21 @@ status_t EventHub::Device::mapLed(int32_t led, int32_t* outScanCode) const {
     return NAME_NOT_FOUND;
 }
 
+void EventHub::Device::updateReadBufferSize(size_t eventsRead) {
+    if (eventsRead == readBufferSize) {
+        // The kernel may have more events queued for this device. Read more of them at a time.
+        readBufferSize = std::min(readBufferSize * 2, MAX_DEVICE_READ_BUFFER_SIZE);
+        underusedReadCount = 0;
+    } else if (eventsRead < readBufferSize / 4 && readBufferSize > MIN_DEVICE_READ_BUFFER_SIZE) {
+        if (++underusedReadCount >= READ_BUFFER_SHRINK_THRESHOLD) {
+            readBufferSize = std::max(readBufferSize / 2, MIN_DEVICE_READ_BUFFER_SIZE);
+            underusedReadCount = 0;
+        }
+    } else {
+        underusedReadCount = 0;
+    }
+}
+
 void EventHub::Device::trackInputEvent(const struct input_event& event) {
     switch (event.type) {
         case EV_KEY: {
@@ -977,6 +997,15 @@ InputDeviceIdentifier EventHub::getDeviceIdentifier(int32_t deviceId) const {
     return device != nullptr ? device->identifier : InputDeviceIdentifier();
 }
 
+std::optional<size_t> EventHub::getDeviceReadBufferSize(int32_t deviceId) const {
+    std::scoped_lock _l(mLock);
+    Device* device = getDeviceLocked(deviceId);
+    if (device == nullptr) {
+        return std::nullopt;
+    }
+    return device->readBufferSize;
+}
+
 ftl::Flags<InputDeviceClass> EventHub::getDeviceClasses(int32_t deviceId) const {
     std::scoped_lock _l(mLock);
     Device* device = getDeviceLocked(deviceId);
@@ -1848,8 +1877,6 @@ std::optional<int32_t> EventHub::getBatteryStatus(int32_t deviceId, int32_t batt
 std::vector<RawEvent> EventHub::getEvents(int timeoutMillis) {
     std::scoped_lock _l(mLock);
 
-    std::array<input_event, EVENT_BUFFER_SIZE> readBuffer;
-
     std::vector<RawEvent> events;
     bool awoken = false;
     for (;;) {
@@ -1992,14 +2019,16 @@ std::vector<RawEvent> EventHub::getEvents(int timeoutMillis) {
             }
             // This must be an input event
             if (eventItem.events & EPOLLIN) {
-                int32_t readSize =
-                        read(device->fd, readBuffer.data(),
-                             sizeof(decltype(readBuffer)::value_type) * readBuffer.size());
+                if (mReadBuffer.size() < device->readBufferSize) {
+                    mReadBuffer.resize(device->readBufferSize);
+                }
+                int32_t readSize = read(device->fd, mReadBuffer.data(),
+                                        sizeof(struct input_event) * device->readBufferSize);
                 if (readSize == 0 || (readSize < 0 && errno == ENODEV)) {
                     // Device was removed before INotify noticed.
                     ALOGW("could not get event, removed? (fd: %d size: %" PRId32
                           " capacity: %zu errno: %d)\n",
-                          device->fd, readSize, readBuffer.size(), errno);
+                          device->fd, readSize, device->readBufferSize, errno);
                     deviceChanged = true;
                     closeDeviceLocked(*device);
                 } else if (readSize < 0) {
@@ -2010,14 +2039,17 @@ std::vector<RawEvent> EventHub::getEvents(int timeoutMillis) {
                     ALOGE("could not get event (wrong size: %d)", readSize);
                 } else {
                     const int32_t deviceId = device->id == mBuiltInKeyboardId ? 0 : device->id;
+                    // All of the events were read by the same syscall.
+                    const nsecs_t readTime = systemTime(SYSTEM_TIME_MONOTONIC);
 
                     const size_t count = size_t(readSize) / sizeof(struct input_event);
+                    device->updateReadBufferSize(count);
                     for (size_t i = 0; i < count; i++) {
-                        struct input_event& iev = readBuffer[i];
+                        struct input_event& iev = mReadBuffer[i];
                         device->trackInputEvent(iev);
                         events.push_back({
                                 .when = processEventTimestamp(iev),
-                                .readTime = systemTime(SYSTEM_TIME_MONOTONIC),
+                                .readTime = readTime,
                                 .deviceId = deviceId,
                                 .type = iev.type,
                                 .code = iev.code,
@@ -2886,6 +2918,7 @@ void EventHub::dump(std::string& dump) const {
             }
             dump += StringPrintf(INDENT3 "ConfigurationFile: %s\n",
                                  device->configurationFile.c_str());
+            dump += StringPrintf(INDENT3 "ReadBufferSize: %zu\n", device->readBufferSize);
             dump += StringPrintf(INDENT3 "VideoDevice: %s\n",
                                  device->videoDevice ? device->videoDevice->dump().c_str()
                                                      : "<none>");
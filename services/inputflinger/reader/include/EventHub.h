@@ -612,6 +612,19 @@ public:
 
     ~EventHub() override;
 
+    // Bounds of the number of input_events that are read from a device at a time. The read buffer
+    // of a device grows while its reads fill the buffer, so that high-rate devices are drained
+    // with fewer reads, and shrinks back once the device slows down.
+    static constexpr size_t MIN_DEVICE_READ_BUFFER_SIZE = 256;
+    static constexpr size_t MAX_DEVICE_READ_BUFFER_SIZE = 8 * MIN_DEVICE_READ_BUFFER_SIZE;
+    // Number of consecutive reads that use less than a quarter of the read buffer of a device
+    // before the buffer shrinks.
+    static constexpr uint32_t READ_BUFFER_SHRINK_THRESHOLD = 64;
+
+    // Returns the number of input_events that are currently read from the given device at a time,
+    // or std::nullopt if there is no such device. Used by tests.
+    std::optional<size_t> getDeviceReadBufferSize(int32_t deviceId) const;
+
 private:
     // Holds information about the sysfs device associated with the Device.
     struct AssociatedDevice {
@@ -699,6 +712,12 @@ private:
         bool currentFrameDropped;
         void trackInputEvent(const struct input_event& event);
         void readDeviceState();
+
+        // Maximum number of input_events to read from the device at a time.
+        size_t readBufferSize;
+        // Number of consecutive reads that used only a small part of the read buffer.
+        uint32_t underusedReadCount;
+        void updateReadBufferSize(size_t eventsRead);
     };
 
     /**
@@ -809,6 +828,10 @@ private:
     // Maximum number of signalled FDs to handle at a time.
     static const int EPOLL_MAX_EVENTS = 16;
 
+    // Buffer that the input_events of a device are read into. It is as large as the largest read
+    // buffer of the devices.
+    std::vector<struct input_event> mReadBuffer;
+
     // The array of pending epoll events and the index of the next event to be handled.
     struct epoll_event mPendingEventItems[EPOLL_MAX_EVENTS];
     size_t mPendingEventCount;
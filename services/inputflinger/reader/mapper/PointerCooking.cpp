@@ -0,0 +1,73 @@
+/*
+ * Copyright 2024 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+// clang-format off
+#include "../Macros.h"
+// clang-format on
+
+#include "PointerCooking.h"
+
+namespace android {
+
+void PointerCookingBatch::load(const RawPointerData& data) {
+    count = data.pointerCount;
+    for (uint32_t i = 0; i < count; i++) {
+        const RawPointerData::Pointer& in = data.pointers[i];
+        x[i] = in.x;
+        y[i] = in.y;
+        pressure[i] = in.pressure;
+        distance[i] = in.distance;
+    }
+}
+
+void PointerCookingBatch::transformCoordinates(const TouchAffineTransformation& calibration,
+                                               const ui::Transform& rawToDisplay) {
+    // The same operations, in the same order, as TouchAffineTransformation::applyTo.
+    for (uint32_t i = 0; i < count; i++) {
+        const float rawX = x[i];
+        const float rawY = y[i];
+        x[i] = rawX * calibration.x_scale + rawY * calibration.x_ymix + calibration.x_offset;
+        y[i] = rawX * calibration.y_xmix + rawY * calibration.y_scale + calibration.y_offset;
+    }
+
+    // The same operations, in the same order, as ui::Transform::transform(vec2).
+    const float m00 = rawToDisplay[0][0];
+    const float m01 = rawToDisplay[0][1];
+    const float m10 = rawToDisplay[1][0];
+    const float m11 = rawToDisplay[1][1];
+    const float m20 = rawToDisplay[2][0];
+    const float m21 = rawToDisplay[2][1];
+    for (uint32_t i = 0; i < count; i++) {
+        const float calibratedX = x[i];
+        const float calibratedY = y[i];
+        x[i] = m00 * calibratedX + m10 * calibratedY + m20;
+        y[i] = m01 * calibratedX + m11 * calibratedY + m21;
+    }
+}
+
+void PointerCookingBatch::scalePressure(float scale) {
+    for (uint32_t i = 0; i < count; i++) {
+        pressure[i] *= scale;
+    }
+}
+
+void PointerCookingBatch::scaleDistance(float scale) {
+    for (uint32_t i = 0; i < count; i++) {
+        distance[i] *= scale;
+    }
+}
+
+} // namespace android
@@ -0,0 +1,61 @@
+/*
+ * Copyright 2024 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#pragma once
+
+#include <array>
+#include <cstdint>
+
+#include <input/Input.h>
+#include <ui/Transform.h>
+
+#include "InputReaderBase.h"
+#include "TouchInputMapper.h"
+
+namespace android {
+
+/**
+ * The axes of all the pointers of a RawPointerData that are cooked with the same arithmetic for
+ * every pointer, laid out as a structure of arrays.
+ *
+ * TouchInputMapper cooks up to MAX_POINTERS pointers per sync. Cooking the coordinates, pressure
+ * and distance one axis at a time, over contiguous arrays, lets the compiler vectorize the loops;
+ * the rest of the cooking depends on the calibration of each axis and stays per pointer.
+ */
+struct PointerCookingBatch {
+    uint32_t count = 0;
+    std::array<float, MAX_POINTERS> x;
+    std::array<float, MAX_POINTERS> y;
+    std::array<float, MAX_POINTERS> pressure;
+    std::array<float, MAX_POINTERS> distance;
+
+    /* Loads the raw axes of the pointers of the given data. */
+    void load(const RawPointerData& data);
+
+    /* Applies the touch calibration, then the transform from the raw coordinates to the display,
+     * to the coordinates of all the pointers. The results are the same as those of
+     * TouchAffineTransformation::applyTo followed by ui::Transform::transform. */
+    void transformCoordinates(const TouchAffineTransformation& calibration,
+                              const ui::Transform& rawToDisplay);
+
+    /* Multiplies the pressure of all the pointers by the given scale. */
+    void scalePressure(float scale);
+
+    /* Multiplies the distance of all the pointers by the given scale. */
+    void scaleDistance(float scale);
+};
+
+} // namespace android
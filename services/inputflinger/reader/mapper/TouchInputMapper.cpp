@@ -41,6 +41,7 @@
 
 #include "CursorButtonAccumulator.h"
 #include "CursorScrollAccumulator.h"
+#include "PointerCooking.h"
 #include "TouchButtonAccumulator.h"
 #include "TouchCursorInputMapperCommon.h"
 #include "ui/Rotation.h"
@@ -2239,6 +2240,22 @@ void TouchInputMapper::cookPointerData() {
         mCurrentCookedState.buttonState = mCurrentRawState.buttonState;
     }
 
+    // Cook the axes that get the same treatment for every pointer for all the pointers at once.
+    PointerCookingBatch batch;
+    batch.load(mCurrentRawState.rawPointerData);
+    batch.transformCoordinates(mAffineTransform, mRawToDisplay);
+    const bool hasCalibratedPressure =
+            mCalibration.pressureCalibration == Calibration::PressureCalibration::PHYSICAL ||
+            mCalibration.pressureCalibration == Calibration::PressureCalibration::AMPLITUDE;
+    if (hasCalibratedPressure) {
+        batch.scalePressure(mPressureScale);
+    }
+    const bool hasScaledDistance =
+            mCalibration.distanceCalibration == Calibration::DistanceCalibration::SCALED;
+    if (hasScaledDistance) {
+        batch.scaleDistance(mDistanceScale);
+    }
+
     // Walk through the the active pointers and map device coordinates onto
     // display coordinates and adjust for display orientation.
     for (uint32_t i = 0; i < currentPointerCount; i++) {
@@ -2326,16 +2343,7 @@ void TouchInputMapper::cookPointerData() {
         }
 
         // Pressure
-        float pressure;
-        switch (mCalibration.pressureCalibration) {
-            case Calibration::PressureCalibration::PHYSICAL:
-            case Calibration::PressureCalibration::AMPLITUDE:
-                pressure = in.pressure * mPressureScale;
-                break;
-            default:
-                pressure = in.isHovering ? 0 : 1;
-                break;
-        }
+        const float pressure = hasCalibratedPressure ? batch.pressure[i] : (in.isHovering ? 0 : 1);
 
         // Tilt and Orientation
         float tilt;
@@ -2377,21 +2385,13 @@ void TouchInputMapper::cookPointerData() {
         }
 
         // Distance
-        float distance;
-        switch (mCalibration.distanceCalibration) {
-            case Calibration::DistanceCalibration::SCALED:
-                distance = in.distance * mDistanceScale;
-                break;
-            default:
-                distance = 0;
-        }
+        const float distance = hasScaledDistance ? batch.distance[i] : 0;
 
-        // Adjust X,Y coords for device calibration and convert to the natural display coordinates.
-        vec2 transformed = {in.x, in.y};
-        mAffineTransform.applyTo(transformed.x /*byRef*/, transformed.y /*byRef*/);
-        transformed = mRawToDisplay.transform(transformed);
+        // The X,Y coords, adjusted for device calibration and converted to the natural display
+        // coordinates.
+        const vec2 transformed = {batch.x[i], batch.y[i]};
 
-        // Write output coords.
+        // Write output coords, in the order of the axes, so that every value is appended.
         PointerCoords& out = mCurrentCookedState.cookedPointerData.pointerCoords[i];
         out.clear();
         out.setAxisValue(AMOTION_EVENT_AXIS_X, transformed.x);
@@ -2400,11 +2400,11 @@ void TouchInputMapper::cookPointerData() {
         out.setAxisValue(AMOTION_EVENT_AXIS_SIZE, size);
         out.setAxisValue(AMOTION_EVENT_AXIS_TOUCH_MAJOR, touchMajor);
         out.setAxisValue(AMOTION_EVENT_AXIS_TOUCH_MINOR, touchMinor);
-        out.setAxisValue(AMOTION_EVENT_AXIS_ORIENTATION, orientation);
-        out.setAxisValue(AMOTION_EVENT_AXIS_TILT, tilt);
-        out.setAxisValue(AMOTION_EVENT_AXIS_DISTANCE, distance);
         out.setAxisValue(AMOTION_EVENT_AXIS_TOOL_MAJOR, toolMajor);
         out.setAxisValue(AMOTION_EVENT_AXIS_TOOL_MINOR, toolMinor);
+        out.setAxisValue(AMOTION_EVENT_AXIS_ORIENTATION, orientation);
+        out.setAxisValue(AMOTION_EVENT_AXIS_DISTANCE, distance);
+        out.setAxisValue(AMOTION_EVENT_AXIS_TILT, tilt);
 
         // Write output relative fields if applicable.
         uint32_t id = in.id;
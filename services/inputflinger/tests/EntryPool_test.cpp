@@ -0,0 +1,151 @@
+/*
+ * Copyright (C) 2024 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "../dispatcher/Entry.h"
+#include "../dispatcher/EntryPool.h"
+
+#include <gtest/gtest.h>
+
+// atest inputflinger_tests:EntryPoolTest
+
+namespace android::inputdispatcher {
+
+namespace {
+
+constexpr size_t MAX_CACHED_BLOCKS = 2;
+
+// Every test uses its own pool, so that the tests do not depend on the order in which they run.
+template <int Tag>
+struct PooledEntry {
+    int64_t values[4];
+
+    static void* operator new(size_t size) {
+        return EntryPool<PooledEntry, MAX_CACHED_BLOCKS>::allocate(size);
+    }
+    static void operator delete(void* ptr, size_t size) {
+        EntryPool<PooledEntry, MAX_CACHED_BLOCKS>::deallocate(ptr, size);
+    }
+
+    static size_t getCachedBlockCount() {
+        return EntryPool<PooledEntry, MAX_CACHED_BLOCKS>::getCachedBlockCount();
+    }
+};
+
+// Frees the vectors that the other tests left in the pool.
+template <typename T>
+void drainVectorPool() {
+    while (EntryVectorPool<T>::getCachedVectorCount() > 0) {
+        EntryVectorPool<T>::obtain();
+    }
+}
+
+std::unique_ptr<MotionEntry> createMotionEntry(size_t pointerCount) {
+    std::vector<PointerProperties> pointerProperties(pointerCount);
+    std::vector<PointerCoords> pointerCoords(pointerCount);
+    for (size_t i = 0; i < pointerCount; i++) {
+        pointerProperties[i].id = static_cast<int32_t>(i);
+        pointerProperties[i].toolType = ToolType::FINGER;
+        pointerCoords[i].setAxisValue(AMOTION_EVENT_AXIS_X, 10.f * i);
+        pointerCoords[i].setAxisValue(AMOTION_EVENT_AXIS_Y, 20.f * i);
+    }
+    return std::make_unique<MotionEntry>(/*id=*/1, /*injectionState=*/nullptr, /*eventTime=*/0,
+                                         /*deviceId=*/1, AINPUT_SOURCE_TOUCHSCREEN,
+                                         ui::LogicalDisplayId::DEFAULT, /*policyFlags=*/0,
+                                         AMOTION_EVENT_ACTION_MOVE, /*actionButton=*/0,
+                                         /*flags=*/0, /*metaState=*/0, /*buttonState=*/0,
+                                         MotionClassification::NONE, /*edgeFlags=*/0,
+                                         /*xPrecision=*/1, /*yPrecision=*/1,
+                                         AMOTION_EVENT_INVALID_CURSOR_POSITION,
+                                         AMOTION_EVENT_INVALID_CURSOR_POSITION, /*downTime=*/0,
+                                         pointerProperties, pointerCoords);
+}
+
+} // namespace
+
+TEST(EntryPoolTest, ReleasedBlockIsReused) {
+    using Entry = PooledEntry<0>;
+    ASSERT_EQ(0u, Entry::getCachedBlockCount());
+
+    Entry* entry = new Entry();
+    void* block = entry;
+    delete entry;
+    ASSERT_EQ(1u, Entry::getCachedBlockCount());
+
+    entry = new Entry();
+    ASSERT_EQ(block, entry);
+    ASSERT_EQ(0u, Entry::getCachedBlockCount());
+    delete entry;
+    ASSERT_EQ(1u, Entry::getCachedBlockCount());
+}
+
+TEST(EntryPoolTest, KeepsAtMostMaxCachedBlocks) {
+    using Entry = PooledEntry<1>;
+    std::vector<Entry*> entries;
+    for (size_t i = 0; i < MAX_CACHED_BLOCKS + 2; i++) {
+        entries.push_back(new Entry());
+    }
+    for (Entry* entry : entries) {
+        delete entry;
+    }
+    ASSERT_EQ(MAX_CACHED_BLOCKS, Entry::getCachedBlockCount());
+}
+
+TEST(EntryPoolTest, BlocksOfOtherSizesAreNotPooled) {
+    using Entry = PooledEntry<2>;
+    struct LargerEntry : Entry {
+        int64_t moreValues[4];
+    };
+    LargerEntry* entry = new LargerEntry();
+    delete entry;
+    ASSERT_EQ(0u, Entry::getCachedBlockCount());
+}
+
+TEST(EntryVectorPoolTest, RecycledVectorKeepsItsStorage) {
+    drainVectorPool<int32_t>();
+    std::vector<int32_t> vector(10, 1);
+    const int32_t* storage = vector.data();
+    const size_t capacity = vector.capacity();
+
+    EntryVectorPool<int32_t>::recycle(std::move(vector));
+    ASSERT_EQ(1u, EntryVectorPool<int32_t>::getCachedVectorCount());
+
+    std::vector<int32_t> obtained = EntryVectorPool<int32_t>::obtain();
+    ASSERT_EQ(0u, EntryVectorPool<int32_t>::getCachedVectorCount());
+    ASSERT_TRUE(obtained.empty());
+    ASSERT_EQ(capacity, obtained.capacity());
+    ASSERT_EQ(storage, obtained.data());
+}
+
+TEST(EntryVectorPoolTest, MotionEntryReusesPointerStorage) {
+    drainVectorPool<PointerProperties>();
+    drainVectorPool<PointerCoords>();
+
+    std::unique_ptr<MotionEntry> entry = createMotionEntry(/*pointerCount=*/2);
+    const PointerProperties* properties = entry->pointerProperties.data();
+    const PointerCoords* coords = entry->pointerCoords.data();
+    entry.reset();
+    ASSERT_EQ(1u, EntryVectorPool<PointerProperties>::getCachedVectorCount());
+    ASSERT_EQ(1u, EntryVectorPool<PointerCoords>::getCachedVectorCount());
+
+    entry = createMotionEntry(/*pointerCount=*/2);
+    ASSERT_EQ(properties, entry->pointerProperties.data());
+    ASSERT_EQ(coords, entry->pointerCoords.data());
+    ASSERT_EQ(2u, entry->getPointerCount());
+    ASSERT_EQ(1, entry->pointerProperties[1].id);
+    ASSERT_EQ(20.f, entry->pointerCoords[1].getY());
+}
+
+} // namespace android::inputdispatcher
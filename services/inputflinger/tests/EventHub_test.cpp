@@ -32,7 +32,10 @@ using android::EventHubInterface;
 using android::InputDeviceIdentifier;
 using android::RawEvent;
 using android::sp;
+using android::Point;
+using android::Rect;
 using android::UinputHomeKey;
+using android::UinputTouchScreen;
 using std::chrono_literals::operator""ms;
 using std::chrono_literals::operator""s;
 
@@ -62,7 +65,7 @@ static void dumpEvents(const std::vector<RawEvent>& events) {
 // --- EventHubTest ---
 class EventHubTest : public testing::Test {
 protected:
-    std::unique_ptr<EventHubInterface> mEventHub;
+    std::unique_ptr<EventHub> mEventHub;
     // We are only going to emulate a single input device currently.
     std::unique_ptr<UinputHomeKey> mKeyboard;
     int32_t mDeviceId;
@@ -86,9 +89,10 @@ protected:
     }
 
     /**
-     * Return the device id of the created device.
+     * Return the device id of the created device. If expectedName is not set, the created device
+     * is expected to be another instance of the test keyboard.
      */
-    int32_t waitForDeviceCreation();
+    int32_t waitForDeviceCreation(std::optional<std::string> expectedName = std::nullopt);
     void waitForDeviceClose(int32_t deviceId);
     void consumeInitialDeviceAddedEvents();
     void assertNoMoreEvents();
@@ -149,7 +153,7 @@ void EventHubTest::consumeInitialDeviceAddedEvents() {
     EXPECT_EQ(EventHubInterface::FINISHED_DEVICE_SCAN, events[events.size() - 1].type);
 }
 
-int32_t EventHubTest::waitForDeviceCreation() {
+int32_t EventHubTest::waitForDeviceCreation(std::optional<std::string> expectedName) {
     // Wait a little longer than usual, to ensure input device has time to be created
     std::vector<RawEvent> events = getEvents(2);
     if (events.size() != 2) {
@@ -160,7 +164,7 @@ int32_t EventHubTest::waitForDeviceCreation() {
     EXPECT_EQ(static_cast<int32_t>(EventHubInterface::DEVICE_ADDED), deviceAddedEvent.type);
     InputDeviceIdentifier identifier = mEventHub->getDeviceIdentifier(deviceAddedEvent.deviceId);
     const int32_t deviceId = deviceAddedEvent.deviceId;
-    EXPECT_EQ(identifier.name, mKeyboard->getName());
+    EXPECT_EQ(identifier.name, expectedName.value_or(mKeyboard->getName()));
     const RawEvent& finishedDeviceScanEvent = events[1];
     EXPECT_EQ(static_cast<int32_t>(EventHubInterface::FINISHED_DEVICE_SCAN),
               finishedDeviceScanEvent.type);
@@ -218,6 +222,98 @@ TEST_F(EventHubTest, InputEvent_TimestampIsMonotonic) {
     }
 }
 
+/**
+ * Ensure that a burst of input_events that are queued by the kernel before EventHub gets to read
+ * them is reported completely, and in order.
+ */
+TEST_F(EventHubTest, InputEvent_BurstIsReadInOrder) {
+    constexpr size_t KEY_PRESS_COUNT = 12;
+    for (size_t i = 0; i < KEY_PRESS_COUNT; i++) {
+        ASSERT_NO_FATAL_FAILURE(mKeyboard->pressAndReleaseHomeKey());
+    }
+
+    const size_t expectedEventCount = KEY_PRESS_COUNT * 4;
+    std::vector<RawEvent> events = getEvents(expectedEventCount);
+    ASSERT_EQ(expectedEventCount, events.size())
+            << "Expected to receive 2 keys and 2 syncs per key press";
+    for (size_t i = 0; i < events.size(); i += 2) {
+        SCOPED_TRACE("event " + std::to_string(i));
+        const RawEvent& keyEvent = events[i];
+        EXPECT_EQ(mDeviceId, keyEvent.deviceId);
+        EXPECT_EQ(EV_KEY, keyEvent.type);
+        EXPECT_EQ(KEY_HOME, keyEvent.code);
+        // Presses and releases alternate.
+        EXPECT_EQ((i / 2) % 2 == 0 ? 1 : 0, keyEvent.value);
+        const RawEvent& syncEvent = events[i + 1];
+        EXPECT_EQ(EV_SYN, syncEvent.type);
+        EXPECT_EQ(SYN_REPORT, syncEvent.code);
+        EXPECT_LE(keyEvent.when, syncEvent.when);
+    }
+}
+
+/**
+ * Ensure that a burst that does not fit in the initial read buffer of a device is reported
+ * completely and in order, that the read buffer grows while the reads fill it, and that it shrinks
+ * back once the device goes quiet.
+ */
+TEST_F(EventHubTest, InputEvent_LargeBurstGrowsAndShrinksReadBuffer) {
+    constexpr size_t MIN_READ_BUFFER_SIZE = EventHub::MIN_DEVICE_READ_BUFFER_SIZE;
+
+    // The kernel buffers far fewer events for a keyboard than for a multi-touch device, so use a
+    // touch screen to queue a burst that is larger than the initial read buffer.
+    std::unique_ptr<UinputTouchScreen> touchScreen =
+            createUinputDevice<UinputTouchScreen>(Rect(0, 0, 1000, 1000));
+    int32_t touchScreenId;
+    ASSERT_NO_FATAL_FAILURE(touchScreenId =
+                                    waitForDeviceCreation(UinputTouchScreen::DEVICE_NAME));
+    ASSERT_EQ(MIN_READ_BUFFER_SIZE, mEventHub->getDeviceReadBufferSize(touchScreenId));
+
+    // Every move changes both axes, so that the kernel does not drop any of the events.
+    constexpr size_t MOVE_COUNT = 100;
+    for (size_t i = 0; i < MOVE_COUNT; i++) {
+        const int32_t position = static_cast<int32_t>(i) + 1;
+        touchScreen->sendMove(Point(position, position));
+        touchScreen->sendSync();
+    }
+
+    const size_t expectedEventCount = MOVE_COUNT * 3;
+    ASSERT_GT(expectedEventCount, MIN_READ_BUFFER_SIZE);
+    std::vector<RawEvent> events = getEvents(expectedEventCount);
+    ASSERT_EQ(expectedEventCount, events.size())
+            << "Expected to receive 2 axes and 1 sync per move";
+    for (size_t i = 0; i < MOVE_COUNT; i++) {
+        SCOPED_TRACE("move " + std::to_string(i));
+        const int32_t position = static_cast<int32_t>(i) + 1;
+        const RawEvent& xEvent = events[i * 3];
+        EXPECT_EQ(touchScreenId, xEvent.deviceId);
+        EXPECT_EQ(EV_ABS, xEvent.type);
+        EXPECT_EQ(ABS_MT_POSITION_X, xEvent.code);
+        EXPECT_EQ(position, xEvent.value);
+        const RawEvent& yEvent = events[i * 3 + 1];
+        EXPECT_EQ(EV_ABS, yEvent.type);
+        EXPECT_EQ(ABS_MT_POSITION_Y, yEvent.code);
+        EXPECT_EQ(position, yEvent.value);
+        const RawEvent& syncEvent = events[i * 3 + 2];
+        EXPECT_EQ(EV_SYN, syncEvent.type);
+        EXPECT_EQ(SYN_REPORT, syncEvent.code);
+        EXPECT_LE(xEvent.when, syncEvent.when);
+    }
+    // The first read filled the initial buffer, so the buffer grew for the rest of the burst.
+    ASSERT_EQ(MIN_READ_BUFFER_SIZE * 2, mEventHub->getDeviceReadBufferSize(touchScreenId));
+
+    // Reads of a single move each use far less than a quarter of the grown buffer.
+    for (size_t i = 0; i < EventHub::READ_BUFFER_SHRINK_THRESHOLD; i++) {
+        const int32_t position = static_cast<int32_t>(MOVE_COUNT + i) + 1;
+        touchScreen->sendMove(Point(position, position));
+        touchScreen->sendSync();
+        ASSERT_EQ(3U, getEvents(3).size());
+    }
+    ASSERT_EQ(MIN_READ_BUFFER_SIZE, mEventHub->getDeviceReadBufferSize(touchScreenId));
+
+    touchScreen.reset();
+    waitForDeviceClose(touchScreenId);
+}
+
 // --- BitArrayTest ---
 class BitArrayTest : public testing::Test {
 protected:
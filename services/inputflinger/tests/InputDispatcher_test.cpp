@@ -8873,6 +8873,60 @@ TEST_F(InputDispatcherFocusOnTwoDisplaysTest, WhenDropMotionEvent_OnlyCancelCorr
     windowInSecondary->assertNoEvents();
 }
 
+/**
+ * When per-display dispatch is enabled, a key that is waiting for a focused window on one display
+ * should not delay the touches on another display. The touches on the blocked display should still
+ * wait behind the key.
+ */
+TEST_F(InputDispatcherFocusOnTwoDisplaysTest, PerDisplayDispatchSkipsBlockedDisplay) {
+    static constexpr DeviceId TOUCHSCREEN_ON_SECOND_DISPLAY_ID = 3;
+    mDispatcher->setPerDisplayDispatchEnabled(true);
+
+    // Remove the focused window of the primary display, so that a key on it has to wait.
+    windowInPrimary->setFocusable(false);
+    mDispatcher->onWindowInfosChanged(
+            {{*windowInPrimary->getInfo(), *windowInSecondary->getInfo()}, {}, 0, 0});
+    windowInPrimary->consumeFocusEvent(false);
+
+    mDispatcher->notifyKey(KeyArgsBuilder(ACTION_DOWN, AINPUT_SOURCE_KEYBOARD)
+                                   .displayId(ui::LogicalDisplayId::DEFAULT)
+                                   .build());
+    mDispatcher->notifyMotion(
+            MotionArgsBuilder(ACTION_DOWN, AINPUT_SOURCE_TOUCHSCREEN)
+                    .deviceId(SECOND_DEVICE_ID)
+                    .pointer(PointerBuilder(/*id=*/0, ToolType::FINGER).x(100).y(200))
+                    .displayId(ui::LogicalDisplayId::DEFAULT)
+                    .build());
+    mDispatcher->notifyMotion(
+            MotionArgsBuilder(ACTION_DOWN, AINPUT_SOURCE_TOUCHSCREEN)
+                    .deviceId(TOUCHSCREEN_ON_SECOND_DISPLAY_ID)
+                    .pointer(PointerBuilder(/*id=*/0, ToolType::FINGER).x(100).y(200))
+                    .displayId(SECOND_DISPLAY_ID)
+                    .build());
+    mDispatcher->notifyMotion(
+            MotionArgsBuilder(ACTION_UP, AINPUT_SOURCE_TOUCHSCREEN)
+                    .deviceId(TOUCHSCREEN_ON_SECOND_DISPLAY_ID)
+                    .pointer(PointerBuilder(/*id=*/0, ToolType::FINGER).x(100).y(200))
+                    .displayId(SECOND_DISPLAY_ID)
+                    .build());
+
+    // The touch on the second display goes through, even though the key is still waiting.
+    windowInSecondary->consumeMotionEvent(
+            AllOf(WithMotionAction(ACTION_DOWN), WithDisplayId(SECOND_DISPLAY_ID)));
+    windowInSecondary->consumeMotionEvent(
+            AllOf(WithMotionAction(ACTION_UP), WithDisplayId(SECOND_DISPLAY_ID)));
+    windowInPrimary->assertNoEvents();
+
+    // Once the focused application goes away, the key is dropped and the touch on the primary
+    // display is dispatched.
+    mDispatcher->setFocusedApplication(ui::LogicalDisplayId::DEFAULT, nullptr);
+    windowInPrimary->consumeMotionEvent(
+            AllOf(WithMotionAction(ACTION_DOWN), WithDisplayId(ui::LogicalDisplayId::DEFAULT)));
+    windowInPrimary->assertNoEvents();
+    windowInSecondary->assertNoEvents();
+    mFakePolicy->assertNotifyAnrWasNotCalled();
+}
+
 class InputFilterTest : public InputDispatcherTest {
 protected:
     void testNotifyMotion(ui::LogicalDisplayId displayId, bool expectToBeFiltered,
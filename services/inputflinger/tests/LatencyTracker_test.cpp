@@ -14,6 +14,7 @@
  * limitations under the License.
  */
 
+#include "../dispatcher/AsyncTimelineProcessor.h"
 #include "../dispatcher/LatencyTracker.h"
 #include "../InputDeviceMetricsSource.h"
 
@@ -92,6 +93,11 @@ protected:
     }
     void TearDown() override {}
 
+    void trackListener(int32_t inputEventId, nsecs_t eventTime) {
+        mTracker->trackListener(inputEventId, /*isDown=*/false, eventTime, /*readTime=*/eventTime,
+                                DEVICE_ID, {InputDeviceUsageSource::UNKNOWN});
+    }
+
     void triggerEventReporting(nsecs_t lastEventTime);
 
     void assertReceivedTimeline(const InputEventTimeline& timeline);
@@ -106,6 +112,8 @@ private:
     void processTimeline(const InputEventTimeline& timeline) override {
         mReceivedTimelines.push_back(timeline);
     }
+
+protected:
     std::deque<InputEventTimeline> mReceivedTimelines;
 };
 
@@ -366,4 +374,92 @@ TEST_F(LatencyTrackerTest, TrackListenerCheck_DeviceInfoFieldsInputEventTimeline
     assertReceivedTimeline(timeline);
 }
 
+/**
+ * Events that are not received in the order of their eventTime are still only reported once they
+ * are mature.
+ */
+TEST_F(LatencyTrackerTest, EventsOutOfOrder_AreReportedWhenMature) {
+    trackListener(/*inputEventId=*/2, /*eventTime=*/30);
+    trackListener(/*inputEventId=*/3, /*eventTime=*/10);
+    trackListener(/*inputEventId=*/4, /*eventTime=*/20);
+
+    triggerEventReporting(/*eventTime=*/20);
+    ASSERT_EQ(2u, mReceivedTimelines.size());
+    ASSERT_EQ(10, mReceivedTimelines[0].eventTime);
+    ASSERT_EQ(20, mReceivedTimelines[1].eventTime);
+    mReceivedTimelines.clear();
+
+    triggerEventReporting(/*eventTime=*/30);
+    ASSERT_EQ(1u, mReceivedTimelines.size());
+    ASSERT_EQ(30, mReceivedTimelines[0].eventTime);
+}
+
+/**
+ * Events that span several ANR timeouts are reported in the order of their eventTime, as soon as
+ * they are mature.
+ */
+TEST_F(LatencyTrackerTest, EventsOverSeveralTimeouts_AreReportedInOrder) {
+    const nsecs_t interval = std::chrono::nanoseconds(ANR_TIMEOUT).count() / 10;
+    constexpr int32_t eventCount = 100;
+    for (int32_t i = 0; i < eventCount; i++) {
+        trackListener(/*inputEventId=*/i + 1, /*eventTime=*/i * interval);
+    }
+
+    // The events that are more than 10 intervals older than the last one are mature.
+    ASSERT_EQ(static_cast<size_t>(eventCount - 11), mReceivedTimelines.size());
+    for (size_t i = 0; i < mReceivedTimelines.size(); i++) {
+        ASSERT_EQ(static_cast<nsecs_t>(i) * interval, mReceivedTimelines[i].eventTime);
+    }
+}
+
+/**
+ * When the tracker is full, new events are not tracked until older events are reported.
+ */
+TEST_F(LatencyTrackerTest, WhenTrackerIsFull_NewEventsAreDropped) {
+    mTracker = std::make_unique<LatencyTracker>(this, /*maxTimelineCount=*/2);
+    setDefaultInputDeviceInfo(*mTracker);
+
+    trackListener(/*inputEventId=*/2, /*eventTime=*/10);
+    trackListener(/*inputEventId=*/3, /*eventTime=*/20);
+    trackListener(/*inputEventId=*/4, /*eventTime=*/30);
+
+    triggerEventReporting(/*eventTime=*/30);
+    ASSERT_EQ(2u, mReceivedTimelines.size());
+    ASSERT_EQ(10, mReceivedTimelines[0].eventTime);
+    ASSERT_EQ(20, mReceivedTimelines[1].eventTime);
+}
+
+// --- AsyncTimelineProcessorTest ---
+
+class TimelineCollector : public InputEventTimelineProcessor {
+public:
+    void processTimeline(const InputEventTimeline& timeline) override {
+        timelines.push_back(timeline);
+    }
+    std::vector<InputEventTimeline> timelines;
+};
+
+/**
+ * All the timelines that are queued are forwarded in order, at the latest when the processor is
+ * destroyed.
+ */
+TEST(AsyncTimelineProcessorTest, ForwardsTimelinesInOrder) {
+    TimelineCollector collector;
+    constexpr size_t timelineCount = 10;
+    {
+        AsyncTimelineProcessor processor(collector, /*capacity=*/timelineCount);
+        for (size_t i = 0; i < timelineCount; i++) {
+            processor.processTimeline(InputEventTimeline(/*isDown=*/false,
+                                                         /*eventTime=*/static_cast<nsecs_t>(i),
+                                                         /*readTime=*/0, /*vendorId=*/0,
+                                                         /*productId=*/0,
+                                                         {InputDeviceUsageSource::UNKNOWN}));
+        }
+    }
+    ASSERT_EQ(timelineCount, collector.timelines.size());
+    for (size_t i = 0; i < timelineCount; i++) {
+        ASSERT_EQ(static_cast<nsecs_t>(i), collector.timelines[i].eventTime);
+    }
+}
+
 } // namespace android::inputdispatcher
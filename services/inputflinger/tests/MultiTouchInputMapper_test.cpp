@@ -273,4 +273,49 @@ TEST_F(MultiTouchInputMapperUnitTest, MultiFingerGestureWithUnexpectedReset) {
                         VariantWith<NotifyMotionArgs>(WithMotionAction(AMOTION_EVENT_ACTION_UP))));
 }
 
+// The pointers of a touch are cooked together. The coordinates of a pointer must not depend on the
+// other pointers that are down at the same time.
+TEST_F(MultiTouchInputMapperUnitTest, CookedCoordinatesDoNotDependOnPointerCount) {
+    const std::array<Point, SLOT_COUNT> positions = {Point{0, 0}, Point{1999, 999},
+                                                     Point{123, 456}, Point{1001, 3},
+                                                     Point{777, 888}};
+    std::list<NotifyArgs> args;
+
+    // Touch each position on its own.
+    std::vector<PointerCoords> singleCoords;
+    for (const Point& position : positions) {
+        processKey(BTN_TOUCH, 1);
+        processSlot(0);
+        processPosition(position.x, position.y);
+        processId(/*id=*/1);
+        args = processSync();
+        ASSERT_THAT(args,
+                    ElementsAre(VariantWith<NotifyMotionArgs>(
+                            WithMotionAction(AMOTION_EVENT_ACTION_DOWN))));
+        singleCoords.push_back(std::get<NotifyMotionArgs>(args.back()).pointerCoords[0]);
+
+        processKey(BTN_TOUCH, 0);
+        processId(-1);
+        args = processSync();
+        ASSERT_THAT(args,
+                    ElementsAre(VariantWith<NotifyMotionArgs>(
+                            WithMotionAction(AMOTION_EVENT_ACTION_UP))));
+    }
+
+    // Touch all the positions at once.
+    processKey(BTN_TOUCH, 1);
+    for (int32_t slot = 0; slot < SLOT_COUNT; slot++) {
+        processSlot(slot);
+        processPosition(positions[slot].x, positions[slot].y);
+        processId(/*id=*/slot + 1);
+    }
+    args = processSync();
+    ASSERT_EQ(static_cast<size_t>(SLOT_COUNT), args.size());
+    const NotifyMotionArgs& motionArgs = std::get<NotifyMotionArgs>(args.back());
+    ASSERT_EQ(static_cast<uint32_t>(SLOT_COUNT), motionArgs.getPointerCount());
+    for (int32_t slot = 0; slot < SLOT_COUNT; slot++) {
+        ASSERT_EQ(singleCoords[slot], motionArgs.pointerCoords[slot]) << "slot " << slot;
+    }
+}
+
 } // namespace android
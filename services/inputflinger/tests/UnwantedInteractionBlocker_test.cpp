@@ -400,6 +400,55 @@ TEST(GetTouchesTest, ConvertDownEvent) {
     ASSERT_EQ(expected, touches[0]) << touches[0];
 }
 
+/**
+ * Convert a stream of events into the same vector of touches, as the PalmRejector does. The touches
+ * should be identical to the ones that are converted into a new vector for every event.
+ */
+TEST(GetTouchesTest, ReusedTouchesMatchNewTouches) {
+    const std::vector<NotifyMotionArgs> stream = {
+            generateMotionArgs(/*downTime=*/0, /*eventTime=*/0, DOWN, {{1, 2, 3}}),
+            generateMotionArgs(/*downTime=*/0, /*eventTime=*/1, POINTER_1_DOWN,
+                               {{1, 2, 3}, {4, 5, 6}}),
+            generateMotionArgs(/*downTime=*/0, /*eventTime=*/2, MOVE, {{2, 3, 4}, {5, 6, 7}}),
+            generateMotionArgs(/*downTime=*/0, /*eventTime=*/3, POINTER_1_UP,
+                               {{2, 3, 4}, {5, 6, 7}}),
+            generateMotionArgs(/*downTime=*/0, /*eventTime=*/4, MOVE, {{3, 4, 5}}),
+            generateMotionArgs(/*downTime=*/0, /*eventTime=*/5, UP, {{3, 4, 5}}),
+    };
+    AndroidPalmFilterDeviceInfo deviceInfo = generatePalmFilterDeviceInfo();
+    SlotState slotState;
+    std::vector<::ui::InProgressTouchEvdev> reusedTouches;
+    for (const NotifyMotionArgs& args : stream) {
+        SlotState oldSlotState = slotState;
+        slotState.update(args);
+        getTouches(args, deviceInfo, oldSlotState, slotState, reusedTouches);
+        ASSERT_EQ(getTouches(args, deviceInfo, oldSlotState, slotState), reusedTouches)
+                << args.dump();
+    }
+}
+
+/**
+ * When a pointer goes up, its slot is given to the next pointer that goes down.
+ */
+TEST(SlotStateTest, LowestUnusedSlotIsReused) {
+    SlotState slotState;
+    slotState.update(generateMotionArgs(/*downTime=*/0, /*eventTime=*/0, DOWN, {{1, 2, 3}}));
+    slotState.update(generateMotionArgs(/*downTime=*/0, /*eventTime=*/1, POINTER_1_DOWN,
+                                        {{1, 2, 3}, {4, 5, 6}}));
+    ASSERT_EQ(0u, slotState.getSlotForPointerId(0));
+    ASSERT_EQ(1u, slotState.getSlotForPointerId(1));
+
+    slotState.update(generateMotionArgs(/*downTime=*/0, /*eventTime=*/2, POINTER_0_UP,
+                                        {{1, 2, 3}, {4, 5, 6}}));
+    ASSERT_EQ(std::nullopt, slotState.getSlotForPointerId(0));
+    ASSERT_EQ(1u, slotState.getSlotForPointerId(1));
+
+    slotState.update(generateMotionArgs(/*downTime=*/0, /*eventTime=*/3, POINTER_0_DOWN,
+                                        {{1, 2, 3}, {4, 5, 6}}));
+    ASSERT_EQ(0u, slotState.getSlotForPointerId(0));
+    ASSERT_EQ(1u, slotState.getSlotForPointerId(1));
+}
+
 // --- UnwantedInteractionBlockerTest ---
 
 class UnwantedInteractionBlockerTest : public testing::Test {
@@ -0,0 +1,187 @@
+/*
+ * Copyright (C) 2024 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#include "../dispatcher/WindowSpatialIndex.h"
+
+#include <gmock/gmock.h>
+#include <gtest/gtest.h>
+#include <limits>
+
+// atest inputflinger_tests:WindowSpatialIndexTest
+
+using android::gui::WindowInfoHandle;
+using testing::ElementsAre;
+using testing::IsEmpty;
+
+namespace android::inputdispatcher {
+
+namespace {
+
+class FakeWindowHandle : public WindowInfoHandle {
+public:
+    FakeWindowHandle(const Rect& frame) {
+        mInfo.frame = frame;
+        mInfo.touchableRegion = Region(frame);
+    }
+
+    FakeWindowHandle(const Rect& frame, const Region& touchableRegion) {
+        mInfo.frame = frame;
+        mInfo.touchableRegion = touchableRegion;
+    }
+};
+
+std::vector<uint32_t> candidatesAt(const WindowSpatialIndex& index, float x, float y) {
+    std::span<const uint32_t> candidates = index.candidatesAt(x, y);
+    return std::vector<uint32_t>(candidates.begin(), candidates.end());
+}
+
+bool frameContains(const sp<WindowInfoHandle>& window, int32_t x, int32_t y) {
+    const Rect& frame = window->getInfo()->frame;
+    return x >= frame.left && x < frame.right && y >= frame.top && y < frame.bottom;
+}
+
+} // namespace
+
+TEST(WindowSpatialIndexTest, EmptyIndexHasNoCandidates) {
+    WindowSpatialIndex index;
+    ASSERT_THAT(candidatesAt(index, 10, 10), IsEmpty());
+
+    index.rebuild({}, ui::Transform());
+    ASSERT_THAT(candidatesAt(index, 10, 10), IsEmpty());
+}
+
+TEST(WindowSpatialIndexTest, CandidatesAreInZOrder) {
+    std::vector<sp<WindowInfoHandle>> windows;
+    windows.push_back(sp<FakeWindowHandle>::make(Rect(0, 0, 100, 100)));
+    windows.push_back(sp<FakeWindowHandle>::make(Rect(200, 200, 300, 300)));
+    windows.push_back(sp<FakeWindowHandle>::make(Rect(0, 0, 1000, 1000)));
+
+    WindowSpatialIndex index;
+    index.rebuild(windows, ui::Transform());
+
+    ASSERT_THAT(candidatesAt(index, 50, 50), ElementsAre(0u, 2u));
+    ASSERT_THAT(candidatesAt(index, 250, 250), ElementsAre(1u, 2u));
+    ASSERT_THAT(candidatesAt(index, 900, 900), ElementsAre(2u));
+    ASSERT_THAT(candidatesAt(index, 1000, 1000), IsEmpty());
+    ASSERT_THAT(candidatesAt(index, -1, 50), IsEmpty());
+}
+
+TEST(WindowSpatialIndexTest, CandidatesCoverTouchableRegionAndFrame) {
+    std::vector<sp<WindowInfoHandle>> windows;
+    // The touchable region extends outside of the frame.
+    windows.push_back(
+            sp<FakeWindowHandle>::make(Rect(0, 0, 100, 100), Region(Rect(0, 0, 500, 500))));
+    // An empty touchable region still occludes touches with its frame.
+    windows.push_back(sp<FakeWindowHandle>::make(Rect(400, 400, 600, 600), Region()));
+
+    WindowSpatialIndex index;
+    index.rebuild(windows, ui::Transform());
+
+    ASSERT_THAT(candidatesAt(index, 300, 300), ElementsAre(0u));
+    ASSERT_THAT(candidatesAt(index, 450, 450), ElementsAre(0u, 1u));
+    ASSERT_THAT(candidatesAt(index, 550, 550), ElementsAre(1u));
+}
+
+TEST(WindowSpatialIndexTest, QueriesUseDisplayTransform) {
+    std::vector<sp<WindowInfoHandle>> windows;
+    // The window is at the top left of the logical display.
+    windows.push_back(sp<FakeWindowHandle>::make(Rect(0, 0, 100, 100)));
+
+    // The logical display is translated by 1000 pixels from the display.
+    ui::Transform displayTransform;
+    displayTransform.set(-1000, -1000);
+    WindowSpatialIndex index;
+    index.rebuild(windows, displayTransform);
+
+    ASSERT_THAT(candidatesAt(index, 1050, 1050), ElementsAre(0u));
+    ASSERT_THAT(candidatesAt(index, 50, 50), IsEmpty());
+}
+
+TEST(WindowSpatialIndexTest, PositionOf) {
+    std::vector<sp<WindowInfoHandle>> windows;
+    windows.push_back(sp<FakeWindowHandle>::make(Rect(0, 0, 100, 100)));
+    windows.push_back(sp<FakeWindowHandle>::make(Rect(0, 0, 100, 100)));
+    sp<WindowInfoHandle> otherWindow = sp<FakeWindowHandle>::make(Rect(0, 0, 100, 100));
+
+    WindowSpatialIndex index;
+    index.rebuild(windows, ui::Transform());
+
+    ASSERT_EQ(0u, index.positionOf(windows[0]));
+    ASSERT_EQ(1u, index.positionOf(windows[1]));
+    ASSERT_EQ(std::nullopt, index.positionOf(otherWindow));
+}
+
+TEST(WindowSpatialIndexTest, WindowsWithExtremeBounds) {
+    std::vector<sp<WindowInfoHandle>> windows;
+    windows.push_back(sp<FakeWindowHandle>::make(Rect(0, 0, 100, 100)));
+    // The touchable region spans the whole int32_t range on both axes, which is wider than
+    // INT32_MAX.
+    constexpr int32_t kMin = std::numeric_limits<int32_t>::min();
+    constexpr int32_t kMax = std::numeric_limits<int32_t>::max();
+    windows.push_back(
+            sp<FakeWindowHandle>::make(Rect(), Region(Rect(kMin, kMin, kMax, kMax))));
+    windows.push_back(sp<FakeWindowHandle>::make(Rect(-1'000'000'000, 0, 2'000'000'000, 100)));
+
+    WindowSpatialIndex index;
+    index.rebuild(windows, ui::Transform());
+
+    // The grid is coarse, so only keep the candidates that are actually touched.
+    auto touchedAt = [&](int32_t x, int32_t y) {
+        std::vector<uint32_t> touched;
+        for (uint32_t i : candidatesAt(index, x, y)) {
+            if (windows[i]->getInfo()->touchableRegion.contains(x, y)) {
+                touched.push_back(i);
+            }
+        }
+        return touched;
+    };
+    ASSERT_THAT(touchedAt(50, 50), ElementsAre(0u, 1u, 2u));
+    ASSERT_THAT(touchedAt(1'500'000'000, 50), ElementsAre(1u, 2u));
+    ASSERT_THAT(touchedAt(-2'000'000'000, -2'000'000'000), ElementsAre(1u));
+    ASSERT_THAT(touchedAt(2'000'000'000, 2'000'000'000), ElementsAre(1u));
+}
+
+TEST(WindowSpatialIndexTest, ManyWindowsMatchLinearScan) {
+    std::vector<sp<WindowInfoHandle>> windows;
+    for (int32_t i = 0; i < 500; i++) {
+        const int32_t left = (i * 37) % 1000;
+        const int32_t top = (i * 53) % 2000;
+        const Rect frame(left, top, left + 10 + i % 200, top + 10 + i % 300);
+        windows.push_back(sp<FakeWindowHandle>::make(frame));
+    }
+    WindowSpatialIndex index;
+    index.rebuild(windows, ui::Transform());
+
+    for (int32_t y = 0; y < 2400; y += 17) {
+        for (int32_t x = 0; x < 1300; x += 13) {
+            std::vector<uint32_t> expected;
+            for (uint32_t i = 0; i < windows.size(); i++) {
+                if (frameContains(windows[i], x, y)) {
+                    expected.push_back(i);
+                }
+            }
+            std::vector<uint32_t> actual;
+            for (uint32_t i : candidatesAt(index, x, y)) {
+                if (frameContains(windows[i], x, y)) {
+                    actual.push_back(i);
+                }
+            }
+            ASSERT_EQ(expected, actual) << "at (" << x << ", " << y << ")";
+        }
+    }
+}
+
+} // namespace android::inputdispatcher
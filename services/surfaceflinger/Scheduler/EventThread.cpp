@@ -241,6 +241,15 @@ binder::Status EventThreadConnection::getLatestVsyncEventData(
     return binder::Status::ok();
 }
 
+binder::Status EventThreadConnection::getVsyncTimeline(os::ParcelFileDescriptor* outFd) {
+    base::unique_fd fd = mEventThread->getVsyncTimelineFd();
+    if (!fd.ok()) {
+        return binder::Status::fromStatusT(NAME_NOT_FOUND);
+    }
+    *outFd = os::ParcelFileDescriptor(std::move(fd));
+    return binder::Status::ok();
+}
+
 binder::Status EventThreadConnection::getSchedulingPolicy(gui::SchedulingPolicy* outPolicy) {
     return gui::getSchedulingPolicy(outPolicy);
 }
@@ -284,6 +293,7 @@ EventThread::EventThread(const char* name, std::shared_ptr<scheduler::VsyncSched
         mVsyncSchedule(std::move(vsyncSchedule)),
         mVsyncRegistration(mVsyncSchedule->getDispatch(), createDispatchCallback(), name),
         mTokenManager(tokenManager),
+        mVsyncTimeline(gui::VsyncTimeline::create(base::StringPrintf("VsyncTimeline-%s", name))),
         mCallback(callback) {
     mThread = std::thread([this]() NO_THREAD_SAFETY_ANALYSIS {
         std::unique_lock<std::mutex> lock(mMutex);
@@ -319,6 +329,7 @@ void EventThread::setDuration(std::chrono::nanoseconds workDuration,
     std::lock_guard<std::mutex> lock(mMutex);
     mWorkDuration = workDuration;
     mReadyDuration = readyDuration;
+    invalidateVsyncTimelineLocked();
 
     mVsyncRegistration.update({.workDuration = mWorkDuration.get().count(),
                                .readyDuration = mReadyDuration.count(),
@@ -411,6 +422,10 @@ VsyncEventData EventThread::getLatestVsyncEventData(const sp<EventThreadConnecti
     return vsyncEventData;
 }
 
+base::unique_fd EventThread::getVsyncTimelineFd() const {
+    return mVsyncTimeline ? mVsyncTimeline->dupFd() : base::unique_fd();
+}
+
 void EventThread::enableSyntheticVsync(bool enable) {
     std::lock_guard<std::mutex> lock(mMutex);
     if (!mVSyncState || mVSyncState->synthetic == enable) {
@@ -418,6 +433,7 @@ void EventThread::enableSyntheticVsync(bool enable) {
     }
 
     mVSyncState->synthetic = enable;
+    invalidateVsyncTimelineLocked();
     mCondition.notify_all();
 }
 
@@ -450,6 +466,7 @@ void EventThread::onModeChanged(const scheduler::FrameRateMode& mode) {
     std::lock_guard<std::mutex> lock(mMutex);
 
     mPendingEvents.push_back(makeModeChanged(mode));
+    invalidateVsyncTimelineLocked();
     mCondition.notify_all();
 }
 
@@ -483,6 +500,7 @@ void EventThread::threadMain(std::unique_lock<std::mutex>& lock) {
         if (!mPendingEvents.empty()) {
             event = mPendingEvents.front();
             mPendingEvents.pop_front();
+            mDispatchBuckets.clear();
 
             if (event->header.type == DisplayEventReceiver::DISPLAY_EVENT_HOTPLUG) {
                 if (event->hotplug.connectionError == 0) {
@@ -491,6 +509,7 @@ void EventThread::threadMain(std::unique_lock<std::mutex>& lock) {
                     } else if (!event->hotplug.connected && mVSyncState &&
                                mVSyncState->displayId == event->header.displayId) {
                         mVSyncState.reset();
+                        invalidateVsyncTimelineLocked();
                     }
                 } else {
                     // Ignore vsync stuff on an error.
@@ -574,14 +593,24 @@ bool EventThread::shouldConsumeEvent(const DisplayEventReceiver::Event& event,
     const auto throttleVsync = [&]() REQUIRES(mMutex) {
         const auto& vsyncData = event.vsync.vsyncData;
         if (connection->frameRate.isValid()) {
-            return !mVsyncSchedule->getTracker()
-                            .isVSyncInPhase(vsyncData.preferredExpectedPresentationTime(),
-                                            connection->frameRate);
+            const auto [it, inserted] = mDispatchBuckets.inPhaseByFrameRate.try_emplace(
+                    connection->frameRate.getPeriodNsecs());
+            if (inserted) {
+                it->second = mVsyncSchedule->getTracker()
+                                     .isVSyncInPhase(vsyncData.preferredExpectedPresentationTime(),
+                                                     connection->frameRate);
+            }
+            return !it->second;
         }
 
-        const auto expectedPresentTime =
-                TimePoint::fromNs(event.vsync.vsyncData.preferredExpectedPresentationTime());
-        return mCallback.throttleVsync(expectedPresentTime, connection->mOwnerUid);
+        const auto [it, inserted] =
+                mDispatchBuckets.throttleByUid.try_emplace(connection->mOwnerUid);
+        if (inserted) {
+            const auto expectedPresentTime =
+                    TimePoint::fromNs(vsyncData.preferredExpectedPresentationTime());
+            it->second = mCallback.throttleVsync(expectedPresentTime, connection->mOwnerUid);
+        }
+        return it->second;
     };
 
     switch (event.header.type) {
@@ -704,20 +733,23 @@ void EventThread::dispatchEvent(const DisplayEventReceiver::Event& event,
     /* QTI_BEGIN */
     const uint8_t num_attempts = 3;
     /* QTI_END */
+    const bool isVsync = event.header.type == DisplayEventReceiver::DISPLAY_EVENT_VSYNC;
+    if (isVsync) {
+        // Clients only use the published timelines if they received vsync events with the same
+        // frame interval, so publish the ones of the display's frame interval, which applies to
+        // every client without a frame rate override.
+        publishVsyncTimelineLocked(
+                getVsyncEventForFrameIntervalLocked(event, mCallback.getDisplayVsyncPeriod().ns())
+                        .vsync.vsyncData);
+    }
     for (const auto& consumer : consumers) {
-        DisplayEventReceiver::Event copy = event;
-        if (event.header.type == DisplayEventReceiver::DISPLAY_EVENT_VSYNC) {
-            const Period frameInterval = mCallback.getVsyncPeriod(consumer->mOwnerUid);
-            copy.vsync.vsyncData.frameInterval = frameInterval.ns();
-            generateFrameTimeline(copy.vsync.vsyncData, frameInterval.ns(), copy.header.timestamp,
-                                  event.vsync.vsyncData.preferredExpectedPresentationTime(),
-                                  event.vsync.vsyncData.preferredDeadlineTimestamp());
-        }
+        const DisplayEventReceiver::Event& consumerEvent =
+                isVsync ? getVsyncEventLocked(event, consumer->mOwnerUid) : event;
         /* QTI_BEGIN */
         bool qtiNeedsRetry = true;
         for (uint8_t attempt = 0; qtiNeedsRetry && (attempt < num_attempts); attempt++) {
             /* QTI_END */
-            switch (consumer->postEvent(copy)) {
+            switch (consumer->postEvent(consumerEvent)) {
                 case NO_ERROR:
                     /* QTI_BEGIN */ qtiNeedsRetry = false; /* QTI_END */
                     break;
@@ -745,6 +777,53 @@ void EventThread::dispatchEvent(const DisplayEventReceiver::Event& event,
     }
 }
 
+const DisplayEventReceiver::Event& EventThread::getVsyncEventLocked(
+        const DisplayEventReceiver::Event& event, uid_t uid) {
+    auto intervalIt = mDispatchBuckets.frameIntervalByUid.find(uid);
+    if (intervalIt == mDispatchBuckets.frameIntervalByUid.end()) {
+        intervalIt =
+                mDispatchBuckets.frameIntervalByUid.emplace(uid, mCallback.getVsyncPeriod(uid).ns())
+                        .first;
+    }
+    return getVsyncEventForFrameIntervalLocked(event, intervalIt->second);
+}
+
+const DisplayEventReceiver::Event& EventThread::getVsyncEventForFrameIntervalLocked(
+        const DisplayEventReceiver::Event& event, nsecs_t frameInterval) {
+    const auto [it, inserted] =
+            mDispatchBuckets.vsyncEventByFrameInterval.try_emplace(frameInterval, event);
+    if (inserted) {
+        VsyncEventData& vsyncData = it->second.vsync.vsyncData;
+        vsyncData.frameInterval = frameInterval;
+        generateFrameTimeline(vsyncData, frameInterval, event.header.timestamp,
+                              event.vsync.vsyncData.preferredExpectedPresentationTime(),
+                              event.vsync.vsyncData.preferredDeadlineTimestamp());
+    }
+    return it->second;
+}
+
+void EventThread::publishVsyncTimelineLocked(const VsyncEventData& vsyncData) {
+    if (!mVsyncTimeline) {
+        return;
+    }
+    // Reading the timeline locally would not notify SurfaceFlinger of the expected present time,
+    // and synthetic vsyncs are not worth publishing.
+    if (FlagManager::getInstance().vrr_config() || (mVSyncState && mVSyncState->synthetic)) {
+        mVsyncTimeline->invalidate();
+        return;
+    }
+    mVsyncTimeline->publish({.vsyncPeriod = mVsyncSchedule->period().ns(),
+                             .workDuration = mWorkDuration.get().count(),
+                             .readyDuration = mReadyDuration.count(),
+                             .vsyncData = vsyncData});
+}
+
+void EventThread::invalidateVsyncTimelineLocked() {
+    if (mVsyncTimeline) {
+        mVsyncTimeline->invalidate();
+    }
+}
+
 void EventThread::dump(std::string& result) const {
     std::lock_guard<std::mutex> lock(mMutex);
 
@@ -801,6 +880,7 @@ scheduler::VSyncCallbackRegistration EventThread::onNewVsyncScheduleInternal(
     std::lock_guard<std::mutex> lock(mMutex);
     const bool reschedule = mVsyncRegistration.cancel() == scheduler::CancelResult::Cancelled;
     mVsyncSchedule = std::move(schedule);
+    invalidateVsyncTimelineLocked();
     auto oldRegistration =
             std::exchange(mVsyncRegistration,
                           scheduler::VSyncCallbackRegistration(mVsyncSchedule->getDispatch(),
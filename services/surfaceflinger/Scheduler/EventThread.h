@@ -19,6 +19,7 @@
 #include <android-base/thread_annotations.h>
 #include <android/gui/BnDisplayEventConnection.h>
 #include <gui/DisplayEventReceiver.h>
+#include <gui/VsyncTimeline.h>
 #include <private/gui/BitTube.h>
 #include <sys/types.h>
 #include <utils/Errors.h>
@@ -27,9 +28,11 @@
 #include <condition_variable>
 #include <cstdint>
 #include <deque>
+#include <memory>
 #include <mutex>
 #include <optional>
 #include <thread>
+#include <unordered_map>
 #include <vector>
 
 #include "DisplayHardware/DisplayMode.h"
@@ -78,6 +81,7 @@ public:
     binder::Status setVsyncRate(int rate) override;
     binder::Status requestNextVsync() override; // asynchronous
     binder::Status getLatestVsyncEventData(ParcelableVsyncEventData* outVsyncEventData) override;
+    binder::Status getVsyncTimeline(os::ParcelFileDescriptor* outFd) override;
     binder::Status getSchedulingPolicy(gui::SchedulingPolicy* outPolicy) override;
 
     VSyncRequest vsyncRequest = VSyncRequest::None;
@@ -129,6 +133,9 @@ public:
     virtual void requestNextVsync(const sp<EventThreadConnection>& connection) = 0;
     virtual VsyncEventData getLatestVsyncEventData(const sp<EventThreadConnection>& connection,
                                                    nsecs_t now) const = 0;
+    // Returns the shared memory in which the vsync timeline is published, or an invalid file
+    // descriptor if there is none.
+    virtual base::unique_fd getVsyncTimelineFd() const = 0;
 
     virtual void onNewVsyncSchedule(std::shared_ptr<scheduler::VsyncSchedule>) = 0;
 
@@ -141,6 +148,8 @@ struct IEventThreadCallback {
 
     virtual bool throttleVsync(TimePoint, uid_t) = 0;
     virtual Period getVsyncPeriod(uid_t) = 0;
+    // The frame interval of the display, without the frame rate overrides of any uid.
+    virtual Period getDisplayVsyncPeriod() = 0;
     virtual void resync() = 0;
     virtual void onExpectedPresentTimePosted(TimePoint) = 0;
 };
@@ -162,6 +171,7 @@ public:
     void requestNextVsync(const sp<EventThreadConnection>& connection) override;
     VsyncEventData getLatestVsyncEventData(const sp<EventThreadConnection>& connection,
                                            nsecs_t now) const override;
+    base::unique_fd getVsyncTimelineFd() const override;
 
     void enableSyntheticVsync(bool) override;
 
@@ -195,10 +205,17 @@ private:
                             const sp<EventThreadConnection>& connection) const REQUIRES(mMutex);
     void dispatchEvent(const DisplayEventReceiver::Event& event,
                        const DisplayEventConsumers& consumers) REQUIRES(mMutex);
+    const DisplayEventReceiver::Event& getVsyncEventLocked(const DisplayEventReceiver::Event& event,
+                                                           uid_t uid) REQUIRES(mMutex);
+    const DisplayEventReceiver::Event& getVsyncEventForFrameIntervalLocked(
+            const DisplayEventReceiver::Event& event, nsecs_t frameInterval) REQUIRES(mMutex);
 
     void removeDisplayEventConnectionLocked(const wp<EventThreadConnection>& connection)
             REQUIRES(mMutex);
 
+    void publishVsyncTimelineLocked(const VsyncEventData&) REQUIRES(mMutex);
+    void invalidateVsyncTimelineLocked() REQUIRES(mMutex);
+
     void onVsync(nsecs_t vsyncTime, nsecs_t wakeupTime, nsecs_t readyTime);
 
     int64_t generateToken(nsecs_t timestamp, nsecs_t deadlineTimestamp,
@@ -223,6 +240,10 @@ private:
     scheduler::VSyncCallbackRegistration mVsyncRegistration GUARDED_BY(mMutex);
     frametimeline::TokenManager* const mTokenManager;
 
+    // Frame timelines of the last dispatched VSYNC event, which clients read without a binder
+    // call. Only written with mMutex held.
+    const std::unique_ptr<gui::VsyncTimeline> mVsyncTimeline;
+
     IEventThreadCallback& mCallback;
 
     std::thread mThread;
@@ -232,6 +253,25 @@ private:
     std::vector<wp<EventThreadConnection>> mDisplayEventConnections GUARDED_BY(mMutex);
     std::deque<DisplayEventReceiver::Event> mPendingEvents GUARDED_BY(mMutex);
 
+    // Answers for the event that is being dispatched. Connections with the same uid, frame rate or
+    // frame interval get the same answers, so the scheduler is queried and the frame timelines are
+    // generated once per bucket rather than once per connection. Cleared for every event.
+    struct DispatchBuckets {
+        std::unordered_map<uid_t, bool> throttleByUid;
+        std::unordered_map<nsecs_t /*frame rate period*/, bool> inPhaseByFrameRate;
+        std::unordered_map<uid_t, nsecs_t> frameIntervalByUid;
+        std::unordered_map<nsecs_t /*frame interval*/, DisplayEventReceiver::Event>
+                vsyncEventByFrameInterval;
+
+        void clear() {
+            throttleByUid.clear();
+            inPhaseByFrameRate.clear();
+            frameIntervalByUid.clear();
+            vsyncEventByFrameInterval.clear();
+        }
+    };
+    mutable DispatchBuckets mDispatchBuckets GUARDED_BY(mMutex);
+
     // VSYNC state of connected display.
     struct VSyncState {
         explicit VSyncState(PhysicalDisplayId displayId) : displayId(displayId) {}
@@ -308,7 +308,7 @@ bool Scheduler::throttleVsync(android::TimePoint expectedPresentTime, uid_t uid)
     return !isVsyncValid(expectedPresentTime, uid);
 }
 
-Period Scheduler::getVsyncPeriod(uid_t uid) {
+std::pair<Fps, Period> Scheduler::getPacesetterFrameInterval() {
     const auto [refreshRate, period] = [this] {
         std::scoped_lock lock(mDisplayLock);
         const auto pacesetterOpt = pacesetterDisplayLocked();
@@ -321,7 +321,15 @@ Period Scheduler::getVsyncPeriod(uid_t uid) {
         return std::make_pair(refreshRate, numPeriod * pacesetter.schedulePtr->period());
     }();
 
-    const Period currentPeriod = period != Period::zero() ? period : refreshRate.getPeriod();
+    return {refreshRate, period != Period::zero() ? period : refreshRate.getPeriod()};
+}
+
+Period Scheduler::getDisplayVsyncPeriod() {
+    return getPacesetterFrameInterval().second;
+}
+
+Period Scheduler::getVsyncPeriod(uid_t uid) {
+    const auto [refreshRate, currentPeriod] = getPacesetterFrameInterval();
 
     const auto frameRate = getFrameRateOverride(uid);
     if (!frameRate.has_value()) {
@@ -477,10 +477,14 @@ private:
 
     void dispatchCachedReportedMode() REQUIRES(mPolicyLock) EXCLUDES(mDisplayLock);
 
+    // The render rate of the pacesetter display, and the frame interval that it implies.
+    std::pair<Fps, Period> getPacesetterFrameInterval() EXCLUDES(mDisplayLock);
+
     // IEventThreadCallback overrides
     bool throttleVsync(TimePoint, uid_t) override;
     // Get frame interval
     Period getVsyncPeriod(uid_t) override EXCLUDES(mDisplayLock);
+    Period getDisplayVsyncPeriod() override EXCLUDES(mDisplayLock);
     void resync() override EXCLUDES(mDisplayLock);
     void onExpectedPresentTimePosted(TimePoint expectedPresentTime) override EXCLUDES(mDisplayLock);
 
@@ -896,6 +896,10 @@ void SurfaceFlinger::init() FTL_FAKE_GUARD(kMainThreadContext) {
                            .setEnableProtectedContext(enable_protected_contents(false))
                            .setPrecacheToneMapperShaderOnly(false)
                            .setBlurAlgorithm(chooseBlurAlgorithm(mSupportsBlur))
+                           .setTextureCacheBudget(
+                                   base::GetUintProperty<size_t>(
+                                           PROPERTY_DEBUG_RENDERENGINE_TEXTURE_CACHE_BUDGET_MB, 0) *
+                                   1024 * 1024)
                            .setContextPriority(
                                    useContextPriority
                                            ? renderengine::RenderEngine::ContextPriority::REALTIME
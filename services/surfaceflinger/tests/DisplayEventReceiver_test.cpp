@@ -16,6 +16,9 @@
 
 #include <gtest/gtest.h>
 #include <gui/DisplayEventReceiver.h>
+#include <poll.h>
+
+#include <cstdlib>
 
 namespace android {
 
@@ -23,6 +26,24 @@ class DisplayEventReceiverTest : public ::testing::Test {
 public:
     void SetUp() override { EXPECT_EQ(NO_ERROR, mDisplayEventReceiver.initCheck()); }
 
+    // Returns true once a vsync event was received, or false after a second without one.
+    bool waitForVsyncEvent() {
+        struct pollfd pfd = {.fd = mDisplayEventReceiver.getFd(), .events = POLLIN};
+        while (poll(&pfd, 1, 1000 /* ms */) == 1) {
+            constexpr size_t kEventBufferSize = 8;
+            DisplayEventReceiver::Event events[kEventBufferSize];
+            ssize_t n;
+            while ((n = mDisplayEventReceiver.getEvents(events, kEventBufferSize)) > 0) {
+                for (ssize_t i = 0; i < n; i++) {
+                    if (events[i].header.type == DisplayEventReceiver::DISPLAY_EVENT_VSYNC) {
+                        return true;
+                    }
+                }
+            }
+        }
+        return false;
+    }
+
     DisplayEventReceiver mDisplayEventReceiver;
 };
 
@@ -57,4 +78,68 @@ TEST_F(DisplayEventReceiverTest, getLatestVsyncEventData) {
     }
 }
 
+TEST_F(DisplayEventReceiverTest, vsyncTimelineMatchesVsyncEventData) {
+    VsyncEventData vsyncEventData;
+    EXPECT_EQ(NOT_ENOUGH_DATA,
+              mDisplayEventReceiver.readVsyncTimeline(systemTime(), &vsyncEventData))
+            << "The vsync timeline should not be used before a vsync event is received";
+
+    ASSERT_EQ(NO_ERROR, mDisplayEventReceiver.requestNextVsync());
+    ASSERT_TRUE(waitForVsyncEvent());
+
+    const nsecs_t now = systemTime();
+    if (mDisplayEventReceiver.readVsyncTimeline(now, &vsyncEventData) != NO_ERROR) {
+        GTEST_SKIP() << "The vsync timeline is not published";
+    }
+
+    // A receiver that has not received any vsync event gets the data from SurfaceFlinger.
+    DisplayEventReceiver otherReceiver;
+    ASSERT_EQ(NO_ERROR, otherReceiver.initCheck());
+    ParcelableVsyncEventData parcelableVsyncEventData;
+    ASSERT_EQ(NO_ERROR, otherReceiver.getLatestVsyncEventData(&parcelableVsyncEventData));
+    const VsyncEventData& expected = parcelableVsyncEventData.vsync;
+
+    // SurfaceFlinger computed its preferred frame timeline a little later, so it may have moved
+    // to the next vsync in the meantime.
+    VsyncEventData laterVsyncEventData;
+    const bool hasLaterVsyncEventData =
+            mDisplayEventReceiver.readVsyncTimeline(systemTime(), &laterVsyncEventData) ==
+            NO_ERROR;
+
+    EXPECT_EQ(expected.frameInterval, vsyncEventData.frameInterval);
+    ASSERT_GT(vsyncEventData.frameTimelinesLength, 0u);
+    ASSERT_LE(static_cast<int64_t>(vsyncEventData.frameTimelinesLength),
+              VsyncEventData::kFrameTimelinesCapacity);
+    ASSERT_LT(vsyncEventData.preferredFrameTimelineIndex, vsyncEventData.frameTimelinesLength);
+    for (size_t i = 0; i < vsyncEventData.frameTimelinesLength; i++) {
+        const auto& frameTimeline = vsyncEventData.frameTimelines[i];
+        EXPECT_NE(gui::FrameTimelineInfo::INVALID_VSYNC_ID, frameTimeline.vsyncId);
+        EXPECT_GT(frameTimeline.deadlineTimestamp, now)
+                << "Deadline timestamp should be greater than frame time";
+        EXPECT_GT(frameTimeline.expectedPresentationTime, frameTimeline.deadlineTimestamp)
+                << "Expected vsync timestamp should be greater than deadline";
+        if (i > 0) {
+            EXPECT_EQ(vsyncEventData.frameInterval,
+                      frameTimeline.expectedPresentationTime -
+                              vsyncEventData.frameTimelines[i - 1].expectedPresentationTime)
+                    << "Frame timeline " << i << " is not one frame interval after the previous";
+        }
+    }
+
+    // The predictions of the vsync tracker can be refined between the two reads, by much less
+    // than a frame interval.
+    const auto isNear = [&](const VsyncEventData& data) {
+        const nsecs_t tolerance = expected.frameInterval / 2;
+        return std::abs(data.preferredExpectedPresentationTime() -
+                        expected.preferredExpectedPresentationTime()) < tolerance &&
+                std::abs(data.preferredDeadlineTimestamp() -
+                         expected.preferredDeadlineTimestamp()) < tolerance;
+    };
+    EXPECT_TRUE(isNear(vsyncEventData) ||
+                (hasLaterVsyncEventData && isNear(laterVsyncEventData)))
+            << "Preferred expected presentation time "
+            << vsyncEventData.preferredExpectedPresentationTime() << " does not match "
+            << expected.preferredExpectedPresentationTime();
+}
+
 } // namespace android
@@ -21,8 +21,11 @@
 #undef LOG_TAG
 #define LOG_TAG "LibSurfaceFlingerUnittests"
 
+#include <com_android_graphics_surfaceflinger_flags.h>
+#include <common/test/FlagUtils.h>
 #include <gmock/gmock.h>
 #include <gtest/gtest.h>
+#include <gui/VsyncTimeline.h>
 #include <log/log.h>
 #include <scheduler/VsyncConfig.h>
 #include <utils/Errors.h>
@@ -84,6 +87,7 @@ protected:
     // IEventThreadCallback overrides
     bool throttleVsync(TimePoint, uid_t) override;
     Period getVsyncPeriod(uid_t) override;
+    Period getDisplayVsyncPeriod() override;
     void resync() override;
     void onExpectedPresentTimePosted(TimePoint) override;
 
@@ -146,6 +150,8 @@ protected:
     std::unique_ptr<frametimeline::impl::TokenManager> mTokenManager;
 
     std::chrono::nanoseconds mVsyncPeriod;
+    // The frame interval of mConnection, if it has a frame rate override.
+    std::optional<std::chrono::nanoseconds> mConnectionVsyncPeriod;
 
     static constexpr uid_t mConnectionUid = 443;
     static constexpr uid_t mThrottledConnectionUid = 177;
@@ -187,7 +193,14 @@ bool EventThreadTest::throttleVsync(android::TimePoint expectedVsyncTimestamp, u
     return (uid == mThrottledConnectionUid);
 }
 
-Period EventThreadTest::getVsyncPeriod(uid_t) {
+Period EventThreadTest::getVsyncPeriod(uid_t uid) {
+    if (uid == mConnectionUid && mConnectionVsyncPeriod) {
+        return *mConnectionVsyncPeriod;
+    }
+    return mVsyncPeriod;
+}
+
+Period EventThreadTest::getDisplayVsyncPeriod() {
     return mVsyncPeriod;
 }
 
@@ -481,6 +494,28 @@ TEST_F(EventThreadTest, requestNextVsyncEventFrameTimelinesValidLength) {
     expectVsyncEventDataFrameTimelinesValidLength(vsyncEventData);
 }
 
+TEST_F(EventThreadTest, vsyncTimelineUsesDisplayFrameInterval) {
+    SET_FLAG_FOR_TEST(com::android::graphics::surfaceflinger::flags::vrr_config, false);
+    setupEventThread();
+    mConnectionVsyncPeriod = VSYNC_PERIOD * 2;
+
+    // The only consumer of the vsync event has a frame rate override.
+    mThread->requestNextVsync(mConnection);
+    expectVSyncCallbackScheduleReceived(true);
+    onVSyncEvent(123, 456, 789);
+
+    auto args = mConnectionEventCallRecorder.waitForCall();
+    ASSERT_TRUE(args.has_value());
+    EXPECT_EQ((VSYNC_PERIOD * 2).count(), std::get<0>(args.value()).vsync.vsyncData.frameInterval);
+
+    // The published timelines are the ones of the display's frame interval.
+    const auto timeline = gui::VsyncTimeline::map(mThread->getVsyncTimelineFd());
+    ASSERT_NE(nullptr, timeline);
+    gui::VsyncTimeline::Snapshot snapshot;
+    ASSERT_EQ(OK, timeline->read(&snapshot));
+    EXPECT_EQ(VSYNC_PERIOD.count(), snapshot.vsyncData.frameInterval);
+}
+
 TEST_F(EventThreadTest, getLatestVsyncEventData) {
     setupEventThread();
 
@@ -593,6 +628,38 @@ TEST_F(EventThreadTest, setVsyncRateOnePostsAllEventsToThatConnection) {
     expectOnExpectedPresentTimePosted(777);
 }
 
+TEST_F(EventThreadTest, connectionsWithSameUidShareVsyncEvent) {
+    setupEventThread();
+
+    ConnectionEventRecorder secondConnectionEventRecorder{0};
+    sp<MockEventThreadConnection> secondConnection =
+            createConnection(secondConnectionEventRecorder);
+    mThread->setVsyncRate(1, mConnection);
+    mThread->setVsyncRate(1, secondConnection);
+
+    // EventThread should enable vsync callbacks.
+    expectVSyncCallbackScheduleReceived(true);
+
+    // The throttler is asked once for the uid of both connections.
+    onVSyncEvent(123, 456, 789);
+    expectThrottleVsyncReceived(456, mConnectionUid);
+    EXPECT_FALSE(mThrottleVsyncCallRecorder.waitForUnexpectedCall().has_value());
+
+    // Both connections get the same frame timelines.
+    auto firstArgs = mConnectionEventCallRecorder.waitForCall();
+    auto secondArgs = secondConnectionEventRecorder.waitForCall();
+    ASSERT_TRUE(firstArgs.has_value());
+    ASSERT_TRUE(secondArgs.has_value());
+    const VsyncEventData& first = std::get<0>(firstArgs.value()).vsync.vsyncData;
+    const VsyncEventData& second = std::get<0>(secondArgs.value()).vsync.vsyncData;
+    ASSERT_EQ(first.frameTimelinesLength, second.frameTimelinesLength);
+    EXPECT_EQ(first.preferredFrameTimelineIndex, second.preferredFrameTimelineIndex);
+    for (size_t i = 0; i < first.frameTimelinesLength; i++) {
+        EXPECT_EQ(first.frameTimelines[i].vsyncId, second.frameTimelines[i].vsyncId)
+                << "Vsync ID differs for frame timeline " << i;
+    }
+}
+
 TEST_F(EventThreadTest, setVsyncRateTwoPostsEveryOtherEventToThatConnection) {
     setupEventThread();
 
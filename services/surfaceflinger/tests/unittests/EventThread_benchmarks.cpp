@@ -0,0 +1,177 @@
+/*
+ * Copyright 2024 The Android Open Source Project
+ *
+ * Licensed under the Apache License, Version 2.0 (the "License");
+ * you may not use this file except in compliance with the License.
+ * You may obtain a copy of the License at
+ *
+ *      http://www.apache.org/licenses/LICENSE-2.0
+ *
+ * Unless required by applicable law or agreed to in writing, software
+ * distributed under the License is distributed on an "AS IS" BASIS,
+ * WITHOUT WARRANTIES OR CONDITIONS OF ANY KIND, either express or implied.
+ * See the License for the specific language governing permissions and
+ * limitations under the License.
+ */
+
+#undef LOG_TAG
+#define LOG_TAG "LibSurfaceFlingerBenchmarks"
+
+#include <benchmark/benchmark.h>
+#include <gmock/gmock.h>
+#include <private/gui/BitTube.h>
+
+#include <atomic>
+#include <chrono>
+#include <deque>
+#include <iterator>
+#include <thread>
+#include <vector>
+
+#include "FrameTimeline.h"
+#include "Scheduler/EventThread.h"
+#include "mock/MockVSyncDispatch.h"
+#include "mock/MockVSyncTracker.h"
+
+using namespace std::chrono_literals;
+
+using testing::_;
+using testing::NiceMock;
+using testing::Return;
+
+namespace android {
+
+namespace {
+
+constexpr PhysicalDisplayId DISPLAY_ID = PhysicalDisplayId::fromPort(111u);
+constexpr std::chrono::nanoseconds VSYNC_PERIOD = 16ms;
+constexpr std::chrono::nanoseconds READY_DURATION = 3ms;
+// Apps often have a few receivers each, e.g. for their Choreographers and render threads.
+constexpr size_t RECEIVERS_PER_UID = 4;
+constexpr uid_t FIRST_APP_UID = 10000;
+
+class BenchmarkVsyncSchedule : public scheduler::VsyncSchedule {
+public:
+    BenchmarkVsyncSchedule(TrackerPtr tracker, DispatchPtr dispatch)
+          : VsyncSchedule(DISPLAY_ID, std::move(tracker), std::move(dispatch), nullptr) {}
+};
+
+// Counts the events that were written to the receive channel of the connection.
+class CountingConnection : public EventThreadConnection {
+public:
+    CountingConnection(impl::EventThread* eventThread, uid_t callingUid,
+                       std::atomic<size_t>& postedEvents)
+          : EventThreadConnection(eventThread, callingUid), mPostedEvents(postedEvents) {}
+
+    status_t postEvent(const DisplayEventReceiver::Event& event) override {
+        const status_t status = EventThreadConnection::postEvent(event);
+        mPostedEvents.fetch_add(1, std::memory_order_release);
+        return status;
+    }
+
+private:
+    std::atomic<size_t>& mPostedEvents;
+};
+
+// An EventThread whose vsync callbacks are invoked by the benchmark, and whose connections write
+// to real BitTubes.
+class EventThreadFanOut : public IEventThreadCallback {
+public:
+    explicit EventThreadFanOut(size_t connectionCount) {
+        auto tracker = std::make_shared<NiceMock<mock::VSyncTracker>>();
+        ON_CALL(*tracker, currentPeriod()).WillByDefault(Return(VSYNC_PERIOD.count()));
+        auto dispatch = std::make_shared<NiceMock<mock::VSyncDispatch>>();
+        ON_CALL(*dispatch, registerCallback(_, _))
+                .WillByDefault([this](scheduler::VSyncDispatch::Callback callback, std::string) {
+                    mVsyncCallback = std::move(callback);
+                    return scheduler::VSyncDispatch::CallbackToken(0);
+                });
+        ON_CALL(*dispatch, schedule(_, _))
+                .WillByDefault(Return(scheduler::ScheduleResult{TimePoint::fromNs(0),
+                                                                TimePoint::fromNs(0)}));
+        mVsyncSchedule = std::make_shared<BenchmarkVsyncSchedule>(tracker, dispatch);
+
+        mThread = std::make_unique<impl::EventThread>("EventThreadBenchmark", mVsyncSchedule,
+                                                      &mTokenManager, *this, 0ms,
+                                                      READY_DURATION);
+        for (size_t i = 0; i < connectionCount; i++) {
+            const uid_t uid = FIRST_APP_UID + static_cast<uid_t>(i / RECEIVERS_PER_UID);
+            auto connection = sp<CountingConnection>::make(mThread.get(), uid, mPostedEvents);
+            auto& channel = mChannels.emplace_back();
+            connection->stealReceiveChannel(&channel);
+            mThread->setVsyncRate(1, connection);
+            mConnections.push_back(std::move(connection));
+        }
+
+        // Every connection receives the hotplug event, after which vsyncs are delivered.
+        mThread->onHotplugReceived(DISPLAY_ID, true);
+        waitForPostedEvents(connectionCount);
+        drain();
+    }
+
+    ~EventThreadFanOut() override {
+        mThread.reset();
+        mConnections.clear();
+    }
+
+    // Signals a vsync and waits for the event to be written to every connection.
+    std::chrono::nanoseconds dispatchVsync() {
+        const size_t target = mPostedEvents.load(std::memory_order_acquire) + mConnections.size();
+        const auto start = std::chrono::steady_clock::now();
+        const nsecs_t now = systemTime();
+        const nsecs_t vsyncTime = now + VSYNC_PERIOD.count();
+        mVsyncCallback(vsyncTime, now, vsyncTime - READY_DURATION.count());
+        waitForPostedEvents(target);
+        return std::chrono::steady_clock::now() - start;
+    }
+
+    // Reads the pending events of every connection, so that their channels do not fill up.
+    void drain() {
+        DisplayEventReceiver::Event events[8];
+        for (auto& channel : mChannels) {
+            while (DisplayEventReceiver::getEvents(&channel, events, std::size(events)) > 0) {
+            }
+        }
+    }
+
+    // IEventThreadCallback overrides
+    bool throttleVsync(TimePoint, uid_t) override { return false; }
+    Period getVsyncPeriod(uid_t) override { return Period::fromNs(VSYNC_PERIOD.count()); }
+    Period getDisplayVsyncPeriod() override { return Period::fromNs(VSYNC_PERIOD.count()); }
+    void resync() override {}
+    void onExpectedPresentTimePosted(TimePoint) override {}
+
+private:
+    void waitForPostedEvents(size_t count) {
+        while (mPostedEvents.load(std::memory_order_acquire) < count) {
+            std::this_thread::yield();
+        }
+    }
+
+    scheduler::VSyncDispatch::Callback mVsyncCallback;
+    std::shared_ptr<scheduler::VsyncSchedule> mVsyncSchedule;
+    frametimeline::impl::TokenManager mTokenManager;
+    std::unique_ptr<impl::EventThread> mThread;
+
+    std::atomic<size_t> mPostedEvents = 0;
+    std::vector<sp<CountingConnection>> mConnections;
+    std::deque<gui::BitTube> mChannels;
+};
+
+} // namespace
+
+// The time from a vsync callback until the VSYNC event has been written to every connection, for
+// the given number of connections.
+static void BM_EventThreadVsyncFanOut(benchmark::State& state) {
+    EventThreadFanOut fanOut(static_cast<size_t>(state.range(0)));
+    for (auto _ : state) {
+        state.SetIterationTime(std::chrono::duration<double>(fanOut.dispatchVsync()).count());
+        fanOut.drain();
+    }
+    state.counters["per_connection"] =
+            benchmark::Counter(static_cast<double>(state.iterations() * state.range(0)),
+                               benchmark::Counter::kIsRate | benchmark::Counter::kInvert);
+}
+BENCHMARK(BM_EventThreadVsyncFanOut)->Arg(10)->Arg(100)->Arg(1000)->UseManualTime();
+
+} // namespace android